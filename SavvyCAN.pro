@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT = core gui printsupport qml serialbus serialport widgets help network opengl
+QT = core gui printsupport qml serialbus serialport widgets help network opengl concurrent
 
 CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
 
@@ -43,6 +43,18 @@ SOURCES += main.cpp\
     re/dbccomparatorwindow.cpp \
     mainwindow.cpp \
     canframemodel.cpp \
+    canframeview.cpp \
+    canframeindex.cpp \
+    frameselection.cpp \
+    canframestats.cpp \
+    bitactivity.cpp \
+    guirefreshscheduler.cpp \
+    framecaptureobject.cpp \
+    utils/tdigest.cpp \
+    framesearch.cpp \
+    framesearchwindow.cpp \
+    canfilterexpression.cpp \
+    canfilterlistmodel.cpp \
     simplecrypt.cpp \
     triggerdialog.cpp \
     utility.cpp \
@@ -69,19 +81,28 @@ SOURCES += main.cpp\
     re/sniffer/snifferwindow.cpp \
     dbc/dbcmessageeditor.cpp \
     dbc/dbc_classes.cpp \
+    dbc/dbccache.cpp \
+    dbc/dbcsignalcache.cpp \
+    dbc/dbcwriter.cpp \
     dbc/dbchandler.cpp \
     dbc/dbcloadsavewindow.cpp \
     dbc/dbcmaineditor.cpp \
     dbc/dbcnodeeditor.cpp \
     dbc/dbcsignaleditor.cpp \
     dbc/dbcnoderebaseeditor.cpp \
+    re/discretestatecorrelator.cpp \
+    re/discretestatefinder.cpp \
     re/discretestatewindow.cpp \
+    re/filecompareloader.cpp \
     re/filecomparatorwindow.cpp \
+    re/framecomparison.cpp \
     re/flowviewwindow.cpp \
     re/frameinfowindow.cpp \
     re/fuzzingwindow.cpp \
     re/isotp_interpreterwindow.cpp \
     re/rangestatewindow.cpp \
+    re/rangesignalfinder.cpp \
+    re/rangesignalmatrix.cpp \
     re/udsscanwindow.cpp \
     connections/canbus.cpp \
     connections/canconnectionmodel.cpp \
@@ -100,6 +121,8 @@ SOURCES += main.cpp\
     re/sniffer/SnifferDelegate.cpp \
     connections/newconnectiondialog.cpp \
     re/temporalgraphwindow.cpp \
+    re/temporaldensity.cpp \
+    re/graphdecimator.cpp \
     filterutility.cpp \
     pcaplite.cpp
 
@@ -107,6 +130,17 @@ HEADERS  += mainwindow.h \
     can_structs.h \
     canbridgewindow.h \
     canframemodel.h \
+    canframeview.h \
+    canframeindex.h \
+    frameselection.h \
+    canframestats.h \
+    bitactivity.h \
+    guirefreshscheduler.h \
+    framecaptureobject.h \
+    framesearch.h \
+    framesearchwindow.h \
+    canfilterexpression.h \
+    canfilterlistmodel.h \
     connections/canlogserver.h \
     connections/canserver.h \
     connections/lawicel_serial.h \
@@ -152,6 +186,7 @@ HEADERS  += mainwindow.h \
     scriptcontainer.h \
     canfilter.h \
     utils/lfqueue.h \
+    utils/tdigest.h \
     motorcontrollerconfigwindow.h \
     connections/canconnection.h \
     connections/serialbusconnection.h \
@@ -163,19 +198,28 @@ HEADERS  += mainwindow.h \
     re/sniffer/sniffermodel.h \
     re/sniffer/snifferwindow.h \
     dbc/dbc_classes.h \
+    dbc/dbccache.h \
+    dbc/dbcsignalcache.h \
+    dbc/dbcwriter.h \
     dbc/dbchandler.h \
     dbc/dbcloadsavewindow.h \
     dbc/dbcmaineditor.h \
     dbc/dbcsignaleditor.h \
     dbc/dbcmessageeditor.h \
     dbc/dbcnodeeditor.h \
+    re/discretestatecorrelator.h \
+    re/discretestatefinder.h \
     re/discretestatewindow.h \
+    re/filecompareloader.h \
     re/filecomparatorwindow.h \
+    re/framecomparison.h \
     re/flowviewwindow.h \
     re/frameinfowindow.h \
     re/fuzzingwindow.h \
     re/isotp_interpreterwindow.h \
     re/rangestatewindow.h \
+    re/rangesignalfinder.h \
+    re/rangesignalmatrix.h \
     re/udsscanwindow.h \
     connections/canbus.h \
     connections/canconnectionmodel.h \
@@ -195,6 +239,8 @@ HEADERS  += mainwindow.h \
     re/sniffer/SnifferDelegate.h \
     connections/newconnectiondialog.h \
     re/temporalgraphwindow.h \
+    re/temporaldensity.h \
+    re/graphdecimator.h \
     filterutility.h \
     pcaplite.h
 
@@ -229,6 +275,7 @@ FORMS    += ui/candatagrid.ui \
     ui/snifferwindow.ui \
     ui/udsscanwindow.ui \
     ui/bisectwindow.ui \
+    ui/framesearchwindow.ui \
     ui/signalviewerwindow.ui \
     ui/helpwindow.ui \
     ui/newconnectiondialog.ui \
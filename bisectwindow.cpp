@@ -95,17 +95,15 @@ void BisectWindow::updateSectionsText()
 
 void BisectWindow::refreshIDList()
 {
-    int id;
     foundID.clear();
     ui->cbIDLower->clear();
     ui->cbIDUpper->clear();
-    for (int i = 0; i < modelFrames->count(); i++)
+
+    //the shared frame index already knows every ID in the list
+    const CANFrameIndex *index = MainWindow::getReference()->getCANFrameModel()->getFrameIndex(modelFrames);
+    if (index)
     {
-        id = modelFrames->at(i).frameId();
-        if (!foundID.contains(id))
-        {
-            foundID.append(id);
-        }
+        foreach (uint32_t id, index->ids()) foundID.append(id);
     }
 
     std::sort(foundID.begin(), foundID.end());
@@ -119,7 +117,7 @@ void BisectWindow::refreshIDList()
 void BisectWindow::refreshFrameNumbers()
 {
     ui->labelMainListNum->setText(QString::number(modelFrames->count()));
-    ui->labelSplitNum->setText(QString::number(splitFrames.count()));
+    ui->labelSplitNum->setText(QString::number(selectionIsCurrent() ? selection.count() : 0));
     ui->slideFrameNumber->setMaximum(modelFrames->count());
 }
 
@@ -127,10 +125,12 @@ void BisectWindow::updatedFrames(int numFrames)
 {
     if (numFrames == -1) //all frames deleted
     {
+        selection.clear();
         refreshFrameNumbers();
     }
     else if (numFrames == -2) //all new set of frames. Reset
     {
+        selection.clear();
         refreshFrameNumbers();
         refreshIDList();
     }
@@ -140,65 +140,59 @@ void BisectWindow::updatedFrames(int numFrames)
     }
 }
 
+//a selection is only any good while the frame list it was worked out over hasn't been cleared or rewritten
+bool BisectWindow::selectionIsCurrent()
+{
+    if (selection.total() == 0) return false;
+    CANFrameSnapshot now = MainWindow::getReference()->getCANFrameModel()->getFrameSnapshot();
+    return now.generation == selectionSnapshot.generation && now.count >= selectionSnapshot.count;
+}
+
+/*
+ * Works out which rows the split keeps without copying anything. Frame number and percentage splits are just a range
+ * of rows. ID and bus splits mark each frame in a bitmap, spread over all the cores.
+*/
 void BisectWindow::handleCalculateButton()
 {
-    splitFrames.clear();
+    selectionSnapshot = MainWindow::getReference()->getCANFrameModel()->getFrameSnapshot();
+    int total = selectionSnapshot.count;
     bool saveLower = ui->rbLowerSection->isChecked();
     int targetFrameNum = 0;
     if (ui->rbFrameNumber->isChecked() || ui->rbPercentage->isChecked())
     {
         if (ui->rbFrameNumber->isChecked()) targetFrameNum = ui->slideFrameNumber->value();
-        else targetFrameNum = modelFrames->count() * (ui->slidePercentage->value() / 10000.0);
+        else targetFrameNum = total * (ui->slidePercentage->value() / 10000.0);
         qDebug() << "Target frame num " << targetFrameNum;
-        if (saveLower)
-        {
-            for (int i = 0; i < targetFrameNum; i++) splitFrames.append(modelFrames->at(i));
-        }
-        else
-        {
-            for (int i = targetFrameNum; i < modelFrames->count(); i++) splitFrames.append(modelFrames->at(i));
-        }
+        if (saveLower) selection.selectRange(total, 0, targetFrameNum);
+        else selection.selectRange(total, targetFrameNum, total);
     }
     else if (ui->rbIDRange->isChecked())
     {
         uint32_t lowerID = Utility::ParseStringToNum2(ui->cbIDLower->currentText());
         uint32_t upperID = Utility::ParseStringToNum2(ui->cbIDUpper->currentText());
-        for (int i = 0; i < modelFrames->count(); i++)
+        selection.selectMatching(*modelFrames, total, [lowerID, upperID, saveLower](const CANFrame &frame)
         {
-            if (modelFrames->at(i).frameId() >= lowerID && modelFrames->at(i).frameId() <= upperID)
-            {
-                if (saveLower) splitFrames.append(modelFrames->at(i));
-            }
-            else
-            {
-                if (!saveLower) splitFrames.append(modelFrames->at(i));
-            }
-        }
+            bool inside = frame.frameId() >= lowerID && frame.frameId() <= upperID;
+            return inside == saveLower;
+        });
     }
     else if (ui->rbBusNum->isChecked())
     {
         int targetBus = Utility::ParseStringToNum(ui->editBusNum->text());
-        for (int i = 0; i < modelFrames->count(); i++)
+        selection.selectMatching(*modelFrames, total, [targetBus, saveLower](const CANFrame &frame)
         {
-            if (modelFrames->at(i).bus == targetBus)
-            {
-                if (saveLower) splitFrames.append(modelFrames->at(i));
-            }
-            else
-            {
-                if (!saveLower) splitFrames.append(modelFrames->at(i));
-            }
-        }
+            return (frame.bus == targetBus) == saveLower;
+        });
     }
     refreshFrameNumbers();
 }
 
 void BisectWindow::handleReplaceButton()
 {
-    CANFrameModel *model;
-    model = MainWindow::getReference()->getCANFrameModel();
-    model->clearFrames();
-    model->insertFrames(splitFrames);
+    if (!selectionIsCurrent()) return;
+    //the model drops the unselected frames in place rather than being cleared and filled back up
+    MainWindow::getReference()->keepFrames(selection, selectionSnapshot);
+    selection.clear();
     refreshFrameNumbers();
     refreshIDList();
 }
@@ -207,7 +201,13 @@ void BisectWindow::handleSaveButton()
 {
     QMessageBox msg;
     QString filename;
-    if (FrameFileIO::saveFrameFile(filename, &splitFrames))
+    if (!selectionIsCurrent())
+    {
+        msg.setText(tr("The frame list changed since the split was calculated. Calculate it again first."));
+        msg.exec();
+        return;
+    }
+    if (FrameFileIO::saveFrameFile(filename, modelFrames, &selection))
     {
         msg.setText(tr("Successfully saved file"));
     }
@@ -3,6 +3,8 @@
 
 #include <QDialog>
 #include "can_structs.h"
+#include "canframemodel.h"
+#include "frameselection.h"
 
 namespace Ui {
 class BisectWindow;
@@ -35,11 +37,13 @@ private slots:
 private:
     Ui::BisectWindow *ui;
     const QVector<CANFrame> *modelFrames;
-    QVector<CANFrame> splitFrames;
+    FrameSelection selection;       //rows of modelFrames the split keeps
+    CANFrameSnapshot selectionSnapshot; //what modelFrames was when the selection was worked out
     QList<int> foundID;
 
     void refreshIDList();
     void refreshFrameNumbers();
+    bool selectionIsCurrent();
     bool eventFilter(QObject *obj, QEvent *event);
 };
 
@@ -0,0 +1,259 @@
+#include "bitactivity.h"
+#include "canframeindex.h"
+
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cstring>
+#include <vector>
+
+//adds one to the count of every bit set in bits. The carry runs up the planes until it dies out, which is usually
+//after a plane or two and right away for a word with nothing set
+static inline void addToPlanes(uint64_t *planes, uint64_t bits)
+{
+    for (int k = 0; bits && k < 8; k++)
+    {
+        uint64_t carry = planes[k] & bits;
+        planes[k] ^= bits;
+        bits = carry;
+    }
+}
+
+BitActivity::BitActivity()
+{
+    clear();
+}
+
+void BitActivity::clear()
+{
+    id = 0;
+    count = 0;
+    maxLen = 0;
+    pending = 0;
+    memset(first, 0, sizeof(first));
+    memset(last, 0, sizeof(last));
+    memset(seen, 0, sizeof(seen));
+    memset(changed, 0, sizeof(changed));
+    memset(setPlanes, 0, sizeof(setPlanes));
+    memset(flipPlanes, 0, sizeof(flipPlanes));
+    minData.clear();
+    maxData.clear();
+    changedBits.clear();
+    firstData.clear();
+    lastData.clear();
+    bitSetCounts.clear();
+    bitFlipCounts.clear();
+    byteHistogram.clear();
+}
+
+void BitActivity::growTo(int len)
+{
+    if (len <= maxLen) return;
+
+    minData.resize(len);
+    maxData.resize(len);
+    changedBits.resize(len);
+    firstData.resize(len);
+    lastData.resize(len);
+    for (int c = maxLen; c < len; c++)
+    {
+        minData[c] = 0xFF;
+        maxData[c] = 0;
+    }
+    bitSetCounts.resize(len * 8);
+    bitFlipCounts.resize(len * 8);
+    byteHistogram.resize(qMin(len, BIT_ACTIVITY_HISTOGRAM_BYTES) * 256);
+    maxLen = len;
+}
+
+void BitActivity::addFrames(const QVector<CANFrame> &frames)
+{
+    addChunks(frames.count(), [&frames](int i) -> const CANFrame & { return frames[i]; });
+}
+
+void BitActivity::addFrames(const CANFrame *frames, const QVector<int> &rows)
+{
+    addChunks(rows.count(), [frames, &rows](int i) -> const CANFrame & { return frames[rows[i]]; });
+}
+
+void BitActivity::addFrames(const CANFrameRows &rows)
+{
+    addChunks(rows.count(), [&rows](int i) -> const CANFrame & { return rows[i]; });
+}
+
+/*
+ * Packs up to BIT_ACTIVITY_CHUNK frames into the column then runs the counting over it. The byte ranges and value
+ * histograms get done while packing since the bytes are right there. Histogram counts go into four tables taken in
+ * turn so back to back frames with the same value aren't all waiting on the same counter.
+*/
+template <typename Frames>
+void BitActivity::addChunks(int numFrames, const Frames &frameAt)
+{
+    if (numFrames <= 0) return;
+
+    std::vector<uint64_t> column(BIT_ACTIVITY_CHUNK * BIT_ACTIVITY_WORDS);
+    std::vector<uint64_t> present(BIT_ACTIVITY_CHUNK * BIT_ACTIVITY_WORDS);
+    std::vector<uint64_t> hist(4 * BIT_ACTIVITY_HISTOGRAM_BYTES * 256, 0);
+
+    for (int start = 0; start < numFrames; start += BIT_ACTIVITY_CHUNK)
+    {
+        int num = qMin(BIT_ACTIVITY_CHUNK, numFrames - start);
+        int chunkWords = 0;
+        for (int i = 0; i < num; i++)
+        {
+            QByteArray payload = frameAt(start + i).payload();
+            const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+            int len = qMin(static_cast<int>(payload.length()), BIT_ACTIVITY_MAX_BYTES);
+            growTo(len);
+
+            uint64_t *col = &column[i * BIT_ACTIVITY_WORDS];
+            uint64_t *pres = &present[i * BIT_ACTIVITY_WORDS];
+            int words = (len + 7) / 8;
+            for (int w = 0; w < BIT_ACTIVITY_WORDS; w++)
+            {
+                int n = qBound(0, len - w * 8, 8);
+                uint64_t word = 0;
+                if (n == 8) word = qFromLittleEndian<quint64>(data + w * 8);
+                else for (int b = 0; b < n; b++) word |= static_cast<uint64_t>(data[w * 8 + b]) << (8 * b);
+                col[w] = word;
+                pres[w] = (n == 8) ? ~0ULL : ((1ULL << (8 * n)) - 1);
+            }
+            if (words > chunkWords) chunkWords = words;
+
+            uint8_t *minPtr = minData.data();
+            uint8_t *maxPtr = maxData.data();
+            for (int c = 0; c < len; c++)
+            {
+                if (data[c] < minPtr[c]) minPtr[c] = data[c];
+                if (data[c] > maxPtr[c]) maxPtr[c] = data[c];
+            }
+            uint64_t *histPtr = &hist[(i & 3) * BIT_ACTIVITY_HISTOGRAM_BYTES * 256];
+            int histLen = qMin(len, BIT_ACTIVITY_HISTOGRAM_BYTES);
+            for (int c = 0; c < histLen; c++) histPtr[c * 256 + data[c]]++;
+        }
+        addColumn(column.data(), present.data(), num, chunkWords);
+    }
+    flushCounters();
+
+    int histSize = byteHistogram.count();
+    uint64_t *histOut = byteHistogram.data();
+    for (int t = 0; t < 4; t++)
+    {
+        const uint64_t *histPtr = &hist[t * BIT_ACTIVITY_HISTOGRAM_BYTES * 256];
+        for (int i = 0; i < histSize; i++) histOut[i] += histPtr[i];
+    }
+
+    for (int c = 0; c < maxLen; c++)
+    {
+        int shift = 8 * (c % 8);
+        firstData[c] = static_cast<uint8_t>(first[c / 8] >> shift);
+        lastData[c] = static_cast<uint8_t>(last[c / 8] >> shift);
+        changedBits[c] = static_cast<uint8_t>(changed[c / 8] >> shift);
+    }
+}
+
+/*
+ * The counting itself. present says which bytes each frame really had. A byte only counts as flipped against the last
+ * frame that had it, and changed against the first one that did, same as CANIDStats.
+*/
+void BitActivity::addColumn(const uint64_t *column, const uint64_t *present, int num, int words)
+{
+    for (int i = 0; i < num; i++)
+    {
+        const uint64_t *col = column + i * BIT_ACTIVITY_WORDS;
+        const uint64_t *pres = present + i * BIT_ACTIVITY_WORDS;
+        for (int w = 0; w < words; w++)
+        {
+            uint64_t cur = col[w];
+            uint64_t mask = pres[w];
+            uint64_t before = seen[w];
+            uint64_t fresh = mask & ~before;
+            first[w] = (first[w] & ~fresh) | (cur & fresh);
+            changed[w] |= (first[w] ^ cur) & mask;
+            uint64_t flipped = (last[w] ^ cur) & mask & before;
+            last[w] = (last[w] & ~mask) | (cur & mask);
+            seen[w] = before | mask;
+
+            addToPlanes(setPlanes[w], cur);
+            addToPlanes(flipPlanes[w], flipped);
+        }
+        count++;
+        if (++pending == 255) flushCounters();
+    }
+}
+
+//empties the bit sliced counters into the real counts. Plane k is worth 2^k for every bit set in it
+void BitActivity::flushCounters()
+{
+    if (pending == 0) return;
+
+    uint64_t *setPtr = bitSetCounts.data();
+    uint64_t *flipPtr = bitFlipCounts.data();
+    for (int w = 0; w < BIT_ACTIVITY_WORDS; w++)
+    {
+        for (int k = 0; k < 8; k++)
+        {
+            uint64_t bits = setPlanes[w][k];
+            while (bits)
+            {
+                setPtr[w * 64 + qCountTrailingZeroBits(bits)] += 1ULL << k;
+                bits &= bits - 1;
+            }
+            bits = flipPlanes[w][k];
+            while (bits)
+            {
+                flipPtr[w * 64 + qCountTrailingZeroBits(bits)] += 1ULL << k;
+                bits &= bits - 1;
+            }
+            setPlanes[w][k] = 0;
+            flipPlanes[w][k] = 0;
+        }
+    }
+    pending = 0;
+}
+
+uint64_t BitActivity::frameCount() const
+{
+    return count;
+}
+
+int BitActivity::byteCount() const
+{
+    return maxLen;
+}
+
+//fraction of the frames where this bit changed from the frame before
+double BitActivity::flipRatio(int bit) const
+{
+    if (count == 0 || bit < 0 || bit >= bitFlipCounts.count()) return 0.0;
+    return bitFlipCounts[bit] / static_cast<double>(count);
+}
+
+//flip ratio scaled to 0-255 the way CANDataGrid wants it. Any activity at all shows up as at least 1
+void BitActivity::heat(uint8_t *out, int numBits) const
+{
+    for (int bit = 0; bit < numBits; bit++)
+    {
+        double ratio = flipRatio(bit);
+        uint8_t value = static_cast<uint8_t>(ratio * 255);
+        if (value < 1 && ratio > 0.0001) value = 1;
+        out[bit] = value;
+    }
+}
+
+/*
+ * One BitActivity per ID (every bus together) spread across the thread pool. The frames and index have to hold still
+ * until this returns.
+*/
+QVector<BitActivity> BitActivity::forIDs(const QVector<CANFrame> &frames, const CANFrameIndex &index, const QVector<uint32_t> &ids)
+{
+    QVector<BitActivity> out(ids.count());
+    for (int i = 0; i < ids.count(); i++) out[i].id = ids[i];
+
+    const CANFrame *frameData = frames.constData();
+    QtConcurrent::blockingMap(out, [frameData, &index](BitActivity &activity)
+    {
+        activity.addFrames(frameData, index.rowsMatching(activity.id, activity.id, -1));
+    });
+    return out;
+}
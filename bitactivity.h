@@ -0,0 +1,74 @@
+#ifndef BITACTIVITY_H
+#define BITACTIVITY_H
+
+#include <QVector>
+#include "can_structs.h"
+
+class CANFrameIndex;
+class CANFrameRows;
+
+#define BIT_ACTIVITY_MAX_BYTES          64  //CAN-FD. Anything longer only has the first 64 bytes looked at
+#define BIT_ACTIVITY_WORDS              (BIT_ACTIVITY_MAX_BYTES / 8)
+#define BIT_ACTIVITY_HISTOGRAM_BYTES    8   //same as STATS_HISTOGRAM_BYTES
+#define BIT_ACTIVITY_CHUNK              1024 //frames packed into the column at a time
+
+/*
+ * The per bit and per byte payload numbers for a pile of frames of one ID, worked out a 64 bit word at a time
+ * instead of one bit at a time.
+ *
+ * Frames get packed into a column of words, payload byte n in bits 8 * (n % 8) and up of word n / 8, so bit
+ * byte * 8 + bit is numbered the same as everywhere else. What changed from one frame to the next is then just the
+ * XOR of the two words. Counting goes through a positional popcount: every word is added into a stack of bit sliced
+ * counters where plane k holds bit k of 64 separate counts, so adding a word is a handful of ANDs and XORs however
+ * many bits are set. The planes get emptied into the real counts every 255 frames before they can overflow. It's all
+ * plain 64 bit operations, no intrinsics, so it builds the same everywhere SavvyCAN does.
+ *
+ * The numbers come out exactly the same as running CANIDStats::addFrame over the frames, payloads that change
+ * length included.
+*/
+class BitActivity
+{
+public:
+    BitActivity();
+    void clear();
+    void addFrames(const QVector<CANFrame> &frames);
+    void addFrames(const CANFrame *frames, const QVector<int> &rows);
+    void addFrames(const CANFrameRows &rows);
+
+    uint64_t frameCount() const;
+    int byteCount() const;          //longest payload seen
+    double flipRatio(int bit) const;
+    void heat(uint8_t *out, int numBits) const;
+
+    static QVector<BitActivity> forIDs(const QVector<CANFrame> &frames, const CANFrameIndex &index, const QVector<uint32_t> &ids);
+
+    uint32_t id;
+    QVector<uint8_t> minData;
+    QVector<uint8_t> maxData;
+    QVector<uint8_t> changedBits;       //bits that have ever differed from the first value seen for that byte
+    QVector<uint8_t> firstData;
+    QVector<uint8_t> lastData;
+    QVector<uint64_t> bitSetCounts;     //byte * 8 + bit
+    QVector<uint64_t> bitFlipCounts;
+    QVector<uint64_t> byteHistogram;    //byte * 256 + value for the first BIT_ACTIVITY_HISTOGRAM_BYTES bytes
+
+private:
+    template <typename Frames> void addChunks(int count, const Frames &frameAt);
+    void addColumn(const uint64_t *column, const uint64_t *present, int num, int words);
+    void flushCounters();
+    void growTo(int len);
+
+    uint64_t count;
+    int maxLen;
+    //state carried from one frame to the next, one word per 8 payload bytes
+    uint64_t first[BIT_ACTIVITY_WORDS];
+    uint64_t last[BIT_ACTIVITY_WORDS];
+    uint64_t seen[BIT_ACTIVITY_WORDS];      //0xFF in every byte that has shown up at least once
+    uint64_t changed[BIT_ACTIVITY_WORDS];
+    //bit sliced counters, 8 planes a word. Good for 255 adds before they have to be emptied
+    uint64_t setPlanes[BIT_ACTIVITY_WORDS][8];
+    uint64_t flipPlanes[BIT_ACTIVITY_WORDS][8];
+    int pending;
+};
+
+#endif // BITACTIVITY_H
@@ -1,4 +1,5 @@
 #include "blfhandler.h"
+#include "framefileio.h"
 #include <QDebug>
 #include <QFile>
 #include <QString>
@@ -44,7 +45,7 @@ bool BLFHandler::loadBLF(QString filename, QVector<CANFrame>* frames)
     }
     else return false;
 
-    while (!inFile->atEnd())
+    while (!inFile->atEnd() && !FrameFileIO::loadStopped())
     {
         qDebug() << "Position within file: " << inFile->pos();
         inFile->read((char *)&objHeader.base, sizeof(BLF_OBJ_HEADER_BASE));
@@ -120,7 +121,7 @@ bool BLFHandler::loadBLF(QString filename, QVector<CANFrame>* frames)
                             frame.setPayload(bytes);
                             //Should we divide by a thousand or a million? Unsure here. It appears some logs are stamped in microseconds and some in milliseconds?
                             frame.setTimeStamp(QCanBusFrame::TimeStamp(0, obj.header.v1Obj.uncompSize / 1000.0)); //uncompsize field also used for timestamp oddly enough
-                            frames->append(frame);
+                            FrameFileIO::appendLoadedFrame(frames, frame);
                         }
                         else if (obj.header.base.objType == BLF_CAN_MSG2)
                         {
@@ -141,7 +142,7 @@ bool BLFHandler::loadBLF(QString filename, QVector<CANFrame>* frames)
                             frame.setPayload(bytes);
                             //Should we divide by a thousand or a million? Unsure here. It appears some logs are stamped in microseconds and some in milliseconds?
                             frame.setTimeStamp(QCanBusFrame::TimeStamp(0, obj.header.v1Obj.uncompSize / 1000.0)); //uncompsize field also used for timestamp oddly enough
-                            frames->append(frame);
+                            FrameFileIO::appendLoadedFrame(frames, frame);
                         }
                         else
                         {
@@ -5,6 +5,8 @@
 #include "filterutility.h"
 #include "mainwindow.h"
 
+#include <QMessageBox>
+
 CANBridgeWindow::CANBridgeWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::CANBridgeWindow)
@@ -19,6 +21,8 @@ CANBridgeWindow::CANBridgeWindow(const QVector<CANFrame> *frames, QWidget *paren
     connect(ui->cbSide1, &QComboBox::currentTextChanged, this, &CANBridgeWindow::recalcSides);
     connect(ui->cbSide2, &QComboBox::currentTextChanged, this, &CANBridgeWindow::recalcSides);
     connect(MainWindow::getReference(), &MainWindow::framesUpdated, this, &CANBridgeWindow::updatedFrames);
+    connect(ui->lineFilterSide1, &QLineEdit::editingFinished, [this]() { updateSideFilter(1); });
+    connect(ui->lineFilterSide2, &QLineEdit::editingFinished, [this]() { updateSideFilter(2); });
     connect(ui->listSide1, &QListWidget::itemChanged,
         [this] (QListWidgetItem *item)
         {
@@ -79,6 +83,21 @@ void CANBridgeWindow::recalcSides()
     side2BusNum = ui->cbSide2->currentText().toInt();
 }
 
+//a bad expression leaves the old one in effect so forwarding doesn't suddenly open up to everything
+void CANBridgeWindow::updateSideFilter(int side)
+{
+    QLineEdit *edit = (side == 1) ? ui->lineFilterSide1 : ui->lineFilterSide2;
+    CANFilterExpression &filter = (side == 1) ? filterSide1 : filterSide2;
+    if (edit->text().trimmed() == filter.getText()) return;
+
+    CANFilterExpression newFilter;
+    if (!newFilter.compile(edit->text()))
+    {
+        QMessageBox::warning(this, "Bad filter", "Side " + QString::number(side) + " filter: " + newFilter.getLastError());
+        return;
+    }
+    filter = newFilter;
+}
 
 void CANBridgeWindow::updatedFrames(int numFrames)
 {
@@ -95,6 +114,9 @@ void CANBridgeWindow::updatedFrames(int numFrames)
     {
         if (numFrames > modelFrames->count()) return;
 
+        if (filterSide1.needsResolve()) filterSide1.resolveSignals();
+        if (filterSide2.needsResolve()) filterSide2.resolveSignals();
+
         for (int x = modelFrames->count() - numFrames; x < modelFrames->count(); x++)
         {
             CANFrame thisFrame = modelFrames->at(x);
@@ -110,7 +132,7 @@ void CANBridgeWindow::updatedFrames(int numFrames)
                 }
                 if (ui->ckEnableSide1->isChecked()) //if we're enabled to forward traffic on this bus to the other one
                 {
-                    if (foundIDSide1[id]) //and the checkbox for this particular ID is checked
+                    if (foundIDSide1[id] && (filterSide1.isEmpty() || filterSide1.matches(thisFrame))) //and the checkbox for this particular ID is checked
                     {
                         thisFrame.bus = side2BusNum;
                         CANConManager::getInstance()->sendFrame(thisFrame);
@@ -127,7 +149,7 @@ void CANBridgeWindow::updatedFrames(int numFrames)
                 }
                 if (ui->ckEnableSide2->isChecked()) //if we're enabled to forward traffic on this bus to the other one
                 {
-                    if (foundIDSide2[id]) //and the checkbox for this particular ID is checked
+                    if (foundIDSide2[id] && (filterSide2.isEmpty() || filterSide2.matches(thisFrame))) //and the checkbox for this particular ID is checked
                     {
                         thisFrame.bus = side1BusNum;
                         CANConManager::getInstance()->sendFrame(thisFrame);
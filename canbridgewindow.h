@@ -3,6 +3,7 @@
 
 #include <QDialog>
 #include "connections/canconmanager.h"
+#include "canfilterexpression.h"
 
 namespace Ui {
 class CANBridgeWindow;
@@ -21,6 +22,7 @@ public:
 private slots:
     void updatedFrames(int);
     void recalcSides();
+    void updateSideFilter(int side);
 
 private:
     Ui::CANBridgeWindow *ui;
@@ -29,6 +31,8 @@ private:
     QMap<int, bool> foundIDSide2;
     int side1BusNum;
     int side2BusNum;
+    CANFilterExpression filterSide1; //frames coming in on side 1 also have to match this to get sent to side 2
+    CANFilterExpression filterSide2;
 
     void processIncomingFrame(CANFrame *frame);
     bool eventFilter(QObject *obj, QEvent *event);
@@ -0,0 +1,525 @@
+#include "canfilterexpression.h"
+#include "dbc/dbchandler.h"
+
+#include <algorithm>
+#include <cmath>
+
+CANFilterExpression::CANFilterExpression()
+{
+    dbcGeneration = -1;
+    tokenPos = 0;
+}
+
+void CANFilterExpression::clear()
+{
+    code.clear();
+    signalNames.clear();
+    signalTables.clear();
+    text.clear();
+    lastError.clear();
+    dbcGeneration = -1;
+}
+
+bool CANFilterExpression::isEmpty() const
+{
+    return code.isEmpty();
+}
+
+QString CANFilterExpression::getText() const
+{
+    return text;
+}
+
+QString CANFilterExpression::getLastError() const
+{
+    return lastError;
+}
+
+//an empty or all whitespace string compiles fine and matches everything
+bool CANFilterExpression::compile(QString input)
+{
+    clear();
+    text = input.trimmed();
+    if (text.isEmpty()) return true;
+
+    if (!tokenize(text))
+    {
+        code.clear();
+        return false;
+    }
+
+    tokenPos = 0;
+    bool ok = parseOr();
+    if (ok && tokenPos < tokens.count())
+    {
+        lastError = "Didn't expect \"" + tokens[tokenPos] + "\" here";
+        ok = false;
+    }
+    tokens.clear();
+
+    if (ok) ok = resolveSignals();
+
+    if (!ok)
+    {
+        code.clear();
+        signalNames.clear();
+        signalTables.clear();
+    }
+    return ok;
+}
+
+//look up every signal name used in the expression. Has to happen again when the DBC files change, see needsResolve
+bool CANFilterExpression::resolveSignals()
+{
+    DBCHandler *dbcHandler = DBCHandler::getReference();
+    dbcGeneration = dbcHandler->getChangeCounter();
+
+    signalTables.clear();
+    signalTables.resize(signalNames.count());
+    for (int s = 0; s < signalNames.count(); s++)
+    {
+        QHash<uint32_t, DBC_SIGNAL*> &table = signalTables[s];
+        for (int f = 0; f < dbcHandler->getFileCount(); f++)
+        {
+            DBCFile *file = dbcHandler->getFileByIdx(f);
+            for (int m = 0; m < file->messageHandler->getCount(); m++)
+            {
+                DBC_MESSAGE *msg = file->messageHandler->findMsgByIdx(m);
+                DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(signalNames[s]);
+                if (sig == nullptr || sig->valType == STRING) continue;
+                if (!table.contains(msg->ID)) table.insert(msg->ID, sig); //first file loaded wins like everywhere else
+            }
+        }
+        if (table.isEmpty())
+        {
+            lastError = "No numeric signal named " + signalNames[s] + " in the loaded DBC files";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CANFilterExpression::needsResolve() const
+{
+    if (signalNames.isEmpty()) return false;
+    return dbcGeneration != DBCHandler::getReference()->getChangeCounter();
+}
+
+//signal tests read the DBC files so they can only be checked on the GUI thread. Everything else is safe anywhere
+bool CANFilterExpression::usesSignals() const
+{
+    return !signalNames.isEmpty();
+}
+
+bool CANFilterExpression::tokenize(const QString &input)
+{
+    tokens.clear();
+    int i = 0;
+    int len = input.length();
+    while (i < len)
+    {
+        QChar c = input[i];
+        if (c.isSpace())
+        {
+            i++;
+            continue;
+        }
+
+        QString two = input.mid(i, 2);
+        if (two == "&&" || two == "||" || two == "==" || two == "!=" || two == "<=" || two == ">=" || two == "..")
+        {
+            tokens.append(two);
+            i += 2;
+            continue;
+        }
+
+        //a minus sign right after a comparison or range is part of the number
+        bool negative = (c == '-' && i + 1 < len && input[i + 1].isDigit() && !tokens.isEmpty()
+                         && QString("== != < <= > >= = .. in").split(' ').contains(tokens.last()));
+
+        if (c.isDigit() || negative)
+        {
+            int start = i++;
+            while (i < len && (input[i].isLetterOrNumber() || input[i] == '.'))
+            {
+                if (input[i] == '.' && i + 1 < len && input[i + 1] == '.') break; //start of a .. range
+                i++;
+            }
+            tokens.append(input.mid(start, i - start));
+            continue;
+        }
+
+        if (c.isLetter() || c == '_')
+        {
+            int start = i++;
+            while (i < len && (input[i].isLetterOrNumber() || input[i] == '_')) i++;
+            tokens.append(input.mid(start, i - start));
+            continue;
+        }
+
+        if (QString("()[]&!<>=").contains(c))
+        {
+            tokens.append(QString(c));
+            i++;
+            continue;
+        }
+
+        lastError = "Unexpected character '" + QString(c) + "' at position " + QString::number(i + 1);
+        return false;
+    }
+    return true;
+}
+
+QString CANFilterExpression::peek() const
+{
+    if (tokenPos < tokens.count()) return tokens[tokenPos];
+    return QString();
+}
+
+QString CANFilterExpression::next()
+{
+    if (tokenPos < tokens.count()) return tokens[tokenPos++];
+    return QString();
+}
+
+/*
+ * Each level of the grammar emits its operands back to back with a conditional jump after every one but the last.
+ * For "a or b or c" that's: a, jump if true to end, b, jump if true to end, c. Whatever is in the accumulator
+ * when it gets to the end is the answer. "and" is the same with jump if false.
+*/
+bool CANFilterExpression::parseOr()
+{
+    QVector<int> jumps;
+    if (!parseAnd()) return false;
+    while (peek() == "||" || peek().toLower() == "or")
+    {
+        next();
+        Instruction instr = Instruction();
+        instr.code = FC_JUMP_TRUE;
+        jumps.append(code.count());
+        code.append(instr);
+        if (!parseAnd()) return false;
+    }
+    for (int j : jumps) code[j].arg = code.count();
+    return true;
+}
+
+bool CANFilterExpression::parseAnd()
+{
+    QVector<int> jumps;
+    if (!parseNot()) return false;
+    while (peek() == "&&" || peek().toLower() == "and")
+    {
+        next();
+        Instruction instr = Instruction();
+        instr.code = FC_JUMP_FALSE;
+        jumps.append(code.count());
+        code.append(instr);
+        if (!parseNot()) return false;
+    }
+    for (int j : jumps) code[j].arg = code.count();
+    return true;
+}
+
+bool CANFilterExpression::parseNot()
+{
+    if (peek() == "!" || peek().toLower() == "not")
+    {
+        next();
+        if (!parseNot()) return false;
+        Instruction instr = Instruction();
+        instr.code = FC_NOT;
+        code.append(instr);
+        return true;
+    }
+    return parsePrimary();
+}
+
+bool CANFilterExpression::parsePrimary()
+{
+    if (peek() == "(")
+    {
+        next();
+        if (!parseOr()) return false;
+        if (next() != ")")
+        {
+            lastError = "Missing )";
+            return false;
+        }
+        return true;
+    }
+    return parseTest();
+}
+
+bool CANFilterExpression::parseNumber(const QString &token, uint64_t &intVal, double &dblVal, bool &isInteger)
+{
+    bool ok = false;
+    QString lower = token.toLower();
+    isInteger = true;
+    if (lower.startsWith("0x"))
+    {
+        intVal = lower.mid(2).toULongLong(&ok, 16);
+        dblVal = static_cast<double>(intVal);
+    }
+    else if (lower.startsWith("0b"))
+    {
+        intVal = lower.mid(2).toULongLong(&ok, 2);
+        dblVal = static_cast<double>(intVal);
+    }
+    else
+    {
+        dblVal = lower.toDouble(&ok);
+        isInteger = ok && !lower.contains('.') && !lower.contains('e') && dblVal >= 0;
+        intVal = isInteger ? lower.toULongLong() : 0;
+    }
+    if (!ok) lastError = "\"" + token + "\" isn't a number";
+    return ok;
+}
+
+bool CANFilterExpression::parseTest()
+{
+    QString name = next();
+    QString lname = name.toLower();
+    if (name.isEmpty())
+    {
+        lastError = "Expression ends too soon";
+        return false;
+    }
+    if (!(name[0].isLetter() || name[0] == '_'))
+    {
+        lastError = "Expected a field or signal name but got \"" + name + "\"";
+        return false;
+    }
+
+    Instruction instr = Instruction();
+    instr.code = FC_TEST;
+    instr.mask = ~0ull;
+
+    static const QStringList ops = QString("== != < <= > >= = in").split(' ');
+    bool hasComparison = (ops.contains(peek().toLower()) || peek() == "&");
+
+    //flags used on their own
+    if (!hasComparison && (lname == "ext" || lname == "rtr" || lname == "rx" || lname == "tx"))
+    {
+        if (lname == "ext") instr.field = FF_EXT;
+        else if (lname == "rtr") instr.field = FF_RTR;
+        else instr.field = FF_DIR;
+        instr.op = OP_EQUAL;
+        instr.value = (lname == "tx") ? 0 : 1;
+        code.append(instr);
+        return true;
+    }
+
+    if (lname == "id") instr.field = FF_ID;
+    else if (lname == "bus") instr.field = FF_BUS;
+    else if (lname == "dir") instr.field = FF_DIR;
+    else if (lname == "dlc" || lname == "len") instr.field = FF_DLC;
+    else if (lname == "ext") instr.field = FF_EXT;
+    else if (lname == "rtr") instr.field = FF_RTR;
+    else if (lname == "byte" || lname == "bit")
+    {
+        instr.field = (lname == "byte") ? FF_BYTE : FF_BIT;
+        uint64_t pos;
+        double dummy;
+        bool isInt;
+        if (next() != "[" || !parseNumber(next(), pos, dummy, isInt) || !isInt || next() != "]")
+        {
+            lastError = lname + " needs a position like " + lname + "[2]";
+            return false;
+        }
+        if (pos > ((instr.field == FF_BYTE) ? 63 : 511))
+        {
+            lastError = lname + " position " + QString::number(pos) + " is past the end of any frame";
+            return false;
+        }
+        instr.arg = static_cast<int>(pos);
+    }
+    else
+    {
+        instr.field = FF_SIGNAL;
+        int idx = signalNames.indexOf(name);
+        if (idx == -1)
+        {
+            idx = signalNames.count();
+            signalNames.append(name);
+        }
+        instr.arg = idx;
+    }
+
+    if (peek() == "&")
+    {
+        next();
+        double dummy;
+        bool isInt;
+        if (instr.field == FF_SIGNAL)
+        {
+            lastError = "Signals can't be masked, mask the bytes instead";
+            return false;
+        }
+        if (!parseNumber(next(), instr.mask, dummy, isInt) || !isInt)
+        {
+            if (lastError.isEmpty()) lastError = "Mask has to be a whole number";
+            return false;
+        }
+    }
+
+    QString op = next().toLower();
+    if (op == "==" || op == "=") instr.op = OP_EQUAL;
+    else if (op == "!=") instr.op = OP_NOT_EQUAL;
+    else if (op == "<") instr.op = OP_LESS;
+    else if (op == "<=") instr.op = OP_LESS_EQ;
+    else if (op == ">") instr.op = OP_GREATER;
+    else if (op == ">=") instr.op = OP_GREATER_EQ;
+    else if (op == "in") instr.op = OP_RANGE;
+    else
+    {
+        lastError = "Expected a comparison after " + name;
+        return false;
+    }
+
+    //dir compares against rx or tx. Numbers work too, 1 is received
+    if (instr.field == FF_DIR && (peek().toLower() == "rx" || peek().toLower() == "tx"))
+    {
+        if (instr.op == OP_RANGE)
+        {
+            lastError = "dir can only be compared with rx or tx";
+            return false;
+        }
+        instr.value = (next().toLower() == "rx") ? 1 : 0;
+        code.append(instr);
+        return true;
+    }
+
+    bool isInt;
+    if (!parseNumber(next(), instr.value, instr.dValue, isInt)) return false;
+    if (instr.op == OP_RANGE)
+    {
+        bool highInt;
+        if (next() != ".." || !parseNumber(next(), instr.high, instr.dHigh, highInt))
+        {
+            lastError = "Ranges look like " + lname + " in 10..20";
+            return false;
+        }
+        isInt = isInt && highInt;
+    }
+
+    if (!isInt && instr.field != FF_SIGNAL)
+    {
+        lastError = name + " can only be compared to whole numbers";
+        return false;
+    }
+
+    code.append(instr);
+    return true;
+}
+
+template<typename T> bool CANFilterExpression::compare(Op op, T val, T ref, T high)
+{
+    switch (op)
+    {
+    case OP_EQUAL:
+        return val == ref;
+    case OP_NOT_EQUAL:
+        return val != ref;
+    case OP_LESS:
+        return val < ref;
+    case OP_LESS_EQ:
+        return val <= ref;
+    case OP_GREATER:
+        return val > ref;
+    case OP_GREATER_EQ:
+        return val >= ref;
+    case OP_RANGE:
+        return val >= ref && val <= high;
+    }
+    return false;
+}
+
+bool CANFilterExpression::runTest(const Instruction &instr, const CANFrame &frame) const
+{
+    uint64_t val;
+
+    switch (instr.field)
+    {
+    case FF_ID:
+        val = frame.frameId();
+        break;
+    case FF_BUS:
+        val = static_cast<uint64_t>(frame.bus);
+        break;
+    case FF_DIR:
+        val = frame.isReceived ? 1 : 0;
+        break;
+    case FF_DLC:
+        val = static_cast<uint64_t>(frame.payload().length());
+        break;
+    case FF_EXT:
+        val = frame.hasExtendedFrameFormat() ? 1 : 0;
+        break;
+    case FF_RTR:
+        val = (frame.frameType() == QCanBusFrame::RemoteRequestFrame) ? 1 : 0;
+        break;
+    case FF_BYTE:
+    {
+        const QByteArray payload = frame.payload();
+        if (instr.arg >= payload.length()) return false; //frame is too short to have that byte so it can't match
+        val = static_cast<uint8_t>(payload.constData()[instr.arg]);
+        break;
+    }
+    case FF_BIT:
+    {
+        const QByteArray payload = frame.payload();
+        if ((instr.arg / 8) >= payload.length()) return false;
+        val = (static_cast<uint8_t>(payload.constData()[instr.arg / 8]) >> (instr.arg % 8)) & 1;
+        break;
+    }
+    case FF_SIGNAL:
+    {
+        if (frame.frameType() != QCanBusFrame::DataFrame) return false;
+        DBC_SIGNAL *sig = signalTables[instr.arg].value(frame.frameId(), nullptr);
+        if (sig == nullptr || !sig->isPresentIn(frame)) return false;
+        double dVal;
+        if (!sig->decodeValue(frame, dVal)) return false;
+        //decoded values come out of a multiply so let equality have a little slop
+        double slop = 1e-9 * std::max(1.0, std::fabs(instr.dValue));
+        if (instr.op == OP_EQUAL) return std::fabs(dVal - instr.dValue) <= slop;
+        if (instr.op == OP_NOT_EQUAL) return std::fabs(dVal - instr.dValue) > slop;
+        return compare<double>(instr.op, dVal, instr.dValue, instr.dHigh);
+    }
+    default:
+        return false;
+    }
+
+    return compare<uint64_t>(instr.op, val & instr.mask, instr.value, instr.high);
+}
+
+bool CANFilterExpression::matches(const CANFrame &frame) const
+{
+    const Instruction *instrs = code.constData();
+    const int count = code.count();
+    bool acc = true;
+
+    int pc = 0;
+    while (pc < count)
+    {
+        const Instruction &instr = instrs[pc];
+        switch (instr.code)
+        {
+        case FC_TEST:
+            acc = runTest(instr, frame);
+            pc++;
+            break;
+        case FC_JUMP_FALSE:
+            pc = acc ? pc + 1 : instr.arg;
+            break;
+        case FC_JUMP_TRUE:
+            pc = acc ? instr.arg : pc + 1;
+            break;
+        case FC_NOT:
+            acc = !acc;
+            pc++;
+            break;
+        }
+    }
+    return acc;
+}
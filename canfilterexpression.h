@@ -0,0 +1,115 @@
+#ifndef CANFILTEREXPRESSION_H
+#define CANFILTEREXPRESSION_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "can_structs.h"
+
+class DBC_SIGNAL;
+
+/*
+ * A filter written out as text and compiled once into a flat list of instructions. Checking a frame just walks
+ * that list with a single true/false accumulator so it never allocates and is safe to call from any thread
+ * once compiled.
+ *
+ * Syntax:
+ *  tests    - field op value where op is one of == != < <= > >=, or field in low..high
+ *  fields   - id, bus, dlc (or len), dir (compare to rx or tx), ext, rtr, byte[N], bit[N]
+ *             anything else is taken as the name of a signal in the loaded DBC files
+ *  masks    - a field can be masked before it's compared: id & 0x700 == 0x700, byte[2] & 0xF0 == 0x30
+ *  flags    - ext, rtr, rx and tx on their own are true/false tests
+ *  combine  - and/&&, or/||, not/! and parentheses. and binds tighter than or
+ *  numbers  - decimal unless they start with 0x (hex) or 0b (binary). Signal tests can use fractions
+ *
+ * Examples:
+ *  id in 0x700..0x7FF and bus == 0
+ *  (id == 0x7E8 || id == 0x7E0) && byte[0] & 0xF0 == 0x40
+ *  EngineSpeed > 3000 and not rtr
+*/
+class CANFilterExpression
+{
+public:
+    CANFilterExpression();
+    bool compile(QString input);
+    void clear();
+    bool isEmpty() const;
+    bool matches(const CANFrame &frame) const;
+    bool resolveSignals();
+    bool needsResolve() const;
+    bool usesSignals() const;
+    QString getText() const;
+    QString getLastError() const;
+
+private:
+    enum Field
+    {
+        FF_ID,
+        FF_BUS,
+        FF_DIR,
+        FF_DLC,
+        FF_EXT,
+        FF_RTR,
+        FF_BYTE,
+        FF_BIT,
+        FF_SIGNAL
+    };
+
+    enum Op
+    {
+        OP_EQUAL,
+        OP_NOT_EQUAL,
+        OP_LESS,
+        OP_LESS_EQ,
+        OP_GREATER,
+        OP_GREATER_EQ,
+        OP_RANGE
+    };
+
+    enum Code
+    {
+        FC_TEST,        //acc = result of the test
+        FC_JUMP_FALSE,  //skip to target if acc is false (short circuit and)
+        FC_JUMP_TRUE,   //skip to target if acc is true (short circuit or)
+        FC_NOT          //acc = !acc
+    };
+
+    struct Instruction
+    {
+        Code code;
+        Field field;
+        Op op;
+        int arg;        //byte or bit number, index into signalTables for signals, jump target for jumps
+        uint64_t mask;
+        uint64_t value;
+        uint64_t high;  //upper end for in low..high
+        double dValue;  //signal tests compare as doubles
+        double dHigh;
+    };
+
+    QVector<Instruction> code;
+    QVector<QString> signalNames;
+    QVector<QHash<uint32_t, DBC_SIGNAL*>> signalTables; //one per signal test, message ID -> signal
+    QString text;
+    QString lastError;
+    int dbcGeneration;
+
+    //parser state. Only used while compiling
+    QStringList tokens;
+    int tokenPos;
+
+    bool tokenize(const QString &input);
+    QString peek() const;
+    QString next();
+    bool parseOr();
+    bool parseAnd();
+    bool parseNot();
+    bool parsePrimary();
+    bool parseTest();
+    bool parseNumber(const QString &token, uint64_t &intVal, double &dblVal, bool &isInteger);
+    bool runTest(const Instruction &instr, const CANFrame &frame) const;
+    template<typename T> static bool compare(Op op, T val, T ref, T high);
+};
+
+#endif // CANFILTEREXPRESSION_H
@@ -0,0 +1,218 @@
+#include "canfilterlistmodel.h"
+#include "filterutility.h"
+
+#include <QSettings>
+
+//past this many separate spots getting new IDs it's cheaper to let the view start over than to insert each one
+#define MAX_INSERT_RUNS 64
+
+CANFilterListModel::CANFilterListModel(ListType type, QObject *parent)
+    : QAbstractListModel(parent)
+{
+    listType = type;
+    showCounts = false;
+}
+
+int CANFilterListModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return entries.count();
+}
+
+QVariant CANFilterListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= entries.count()) return QVariant();
+    const Entry &entry = entries[index.row()];
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        if (!showCounts) return entry.label;
+        return entry.label + "  " + QString::number(entry.count) + " @ "
+               + QString::number(entry.rate, 'f', (entry.rate < 10.0) ? 1 : 0) + "/s";
+    case Qt::ToolTipRole:
+        if (entry.tooltip.isEmpty()) return QVariant();
+        return entry.tooltip;
+    case Qt::CheckStateRole:
+        return entry.checked ? Qt::Checked : Qt::Unchecked;
+    case Qt::UserRole:
+        return entry.id;
+    }
+    return QVariant();
+}
+
+bool CANFilterListModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || index.row() >= entries.count() || role != Qt::CheckStateRole) return false;
+
+    Entry &entry = entries[index.row()];
+    bool checked = (static_cast<Qt::CheckState>(value.toInt()) == Qt::Checked);
+    if (entry.checked == checked) return true;
+    entry.checked = checked;
+    emit dataChanged(index, index, {Qt::CheckStateRole});
+    emit filterToggled(entry.id, checked);
+    return true;
+}
+
+Qt::ItemFlags CANFilterListModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable;
+}
+
+CANFilterListModel::Entry CANFilterListModel::makeEntry(uint32_t id, bool checked, bool useLabeling) const
+{
+    Entry entry;
+    entry.id = id;
+    entry.checked = checked;
+    if (listType == FILTER_IDS) entry.label = FilterUtility::getFilterLabel(id, useLabeling, &entry.tooltip);
+    else entry.label = FilterUtility::getBusFilterLabel(id, useLabeling);
+    entry.count = 0;
+    entry.lastCount = 0;
+    entry.rate = 0.0;
+    return entry;
+}
+
+void CANFilterListModel::rebuild(const QMap<int, bool> &filters, bool useLabeling)
+{
+    beginResetModel();
+    entries.clear();
+    entries.reserve(filters.count());
+    for (QMap<int, bool>::const_iterator it = filters.constBegin(); it != filters.constEnd(); ++it)
+    {
+        entries.append(makeEntry(it.key(), it.value(), useLabeling));
+    }
+    endResetModel();
+}
+
+/*
+ * Brings the list in line with the filter map. Both are in ID order so one walk over each finds the new IDs.
+ * Usually that's a few IDs tacked onto the end or dropped in between existing ones and the view only hears about
+ * those rows. IDs going away only happens when the filters get cleared or loaded from a file so that just resets.
+*/
+void CANFilterListModel::sync(const QMap<int, bool> &filters)
+{
+    QSettings settings;
+    bool useLabeling = settings.value("Main/FilterLabeling", false).toBool();
+
+    //first pass only looks to see how much changed
+    QMap<int, bool>::const_iterator it;
+    bool removed = false;
+    bool inRun = false;
+    int runs = 0;
+    int pos = 0;
+    for (it = filters.constBegin(); it != filters.constEnd() && !removed; ++it)
+    {
+        uint32_t id = static_cast<uint32_t>(it.key());
+        if (pos < entries.count() && entries[pos].id < id) removed = true;
+        else if (pos < entries.count() && entries[pos].id == id)
+        {
+            pos++;
+            inRun = false;
+        }
+        else
+        {
+            if (!inRun) runs++;
+            inRun = true;
+        }
+    }
+    if (pos < entries.count()) removed = true;
+
+    if (removed || runs > MAX_INSERT_RUNS)
+    {
+        rebuild(filters, useLabeling);
+        return;
+    }
+
+    bool checkChanged = false;
+    pos = 0;
+    it = filters.constBegin();
+    while (it != filters.constEnd())
+    {
+        if (pos < entries.count() && entries[pos].id == static_cast<uint32_t>(it.key()))
+        {
+            if (entries[pos].checked != it.value())
+            {
+                entries[pos].checked = it.value();
+                checkChanged = true;
+            }
+            pos++;
+            ++it;
+            continue;
+        }
+
+        //a run of new IDs that all go in front of entries[pos] (or on the end)
+        QVector<Entry> run;
+        while (it != filters.constEnd() && (pos >= entries.count() || static_cast<uint32_t>(it.key()) < entries[pos].id))
+        {
+            run.append(makeEntry(it.key(), it.value(), useLabeling));
+            ++it;
+        }
+
+        beginInsertRows(QModelIndex(), pos, pos + run.count() - 1);
+        entries.insert(pos, run.count(), Entry());
+        for (int i = 0; i < run.count(); i++) entries[pos + i] = run[i];
+        endInsertRows();
+        pos += run.count();
+    }
+
+    if (checkChanged && !entries.isEmpty()) emit dataChanged(index(0), index(entries.count() - 1), {Qt::CheckStateRole});
+}
+
+//counts are the running totals per ID. The rate is how much each went up since the last call
+void CANFilterListModel::updateCounts(const QHash<uint32_t, uint64_t> &counts, qint64 elapsedMS)
+{
+    if (elapsedMS <= 0) return;
+    for (int i = 0; i < entries.count(); i++)
+    {
+        Entry &entry = entries[i];
+        entry.count = counts.value(entry.id, 0);
+        //counts went backwards so they must have been cleared. Start the rate over
+        if (entry.count < entry.lastCount) entry.rate = 0.0;
+        else entry.rate = (entry.count - entry.lastCount) * 1000.0 / elapsedMS;
+        entry.lastCount = entry.count;
+    }
+
+    if (showCounts && !entries.isEmpty()) emit dataChanged(index(0), index(entries.count() - 1), {Qt::DisplayRole});
+}
+
+void CANFilterListModel::setShowCounts(bool show)
+{
+    if (showCounts == show) return;
+    showCounts = show;
+    if (!entries.isEmpty()) emit dataChanged(index(0), index(entries.count() - 1), {Qt::DisplayRole});
+}
+
+bool CANFilterListModel::getShowCounts() const
+{
+    return showCounts;
+}
+
+//labeling setting or the DBC files changed so every label could be different now
+void CANFilterListModel::relabel()
+{
+    QSettings settings;
+    bool useLabeling = settings.value("Main/FilterLabeling", false).toBool();
+
+    for (int i = 0; i < entries.count(); i++)
+    {
+        Entry &entry = entries[i];
+        entry.tooltip.clear();
+        if (listType == FILTER_IDS) entry.label = FilterUtility::getFilterLabel(entry.id, useLabeling, &entry.tooltip);
+        else entry.label = FilterUtility::getBusFilterLabel(entry.id, useLabeling);
+    }
+
+    if (!entries.isEmpty()) emit dataChanged(index(0), index(entries.count() - 1), {Qt::DisplayRole, Qt::ToolTipRole});
+}
+
+void CANFilterListModel::setAllChecked(bool checked)
+{
+    for (int i = 0; i < entries.count(); i++) entries[i].checked = checked;
+    if (!entries.isEmpty()) emit dataChanged(index(0), index(entries.count() - 1), {Qt::CheckStateRole});
+}
+
+uint32_t CANFilterListModel::idForRow(int row) const
+{
+    if (row < 0 || row >= entries.count()) return 0;
+    return entries[row].id;
+}
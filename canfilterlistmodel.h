@@ -0,0 +1,64 @@
+#ifndef CANFILTERLISTMODEL_H
+#define CANFILTERLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+
+/*
+ * Backs the ID and bus filter lists on the main screen. sync() is handed the filter map from CANFrameModel and only
+ * tells the view about IDs that weren't there last time so a bus that keeps turning up new IDs doesn't cause the
+ * whole list to be torn down and rebuilt every GUI tick. Rows are kept in ID order, same as the filter map.
+*/
+class CANFilterListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum ListType
+    {
+        FILTER_IDS,
+        FILTER_BUSES
+    };
+
+    explicit CANFilterListModel(ListType type, QObject *parent = 0);
+
+    // from abstractmodel:
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    void sync(const QMap<int, bool> &filters);
+    void updateCounts(const QHash<uint32_t, uint64_t> &counts, qint64 elapsedMS);
+    void setShowCounts(bool show);
+    bool getShowCounts() const;
+    void relabel();
+    void setAllChecked(bool checked);
+    uint32_t idForRow(int row) const;
+
+signals:
+    void filterToggled(uint32_t id, bool state); //only for changes made through the view, not ones sync() brings in
+
+private:
+    struct Entry
+    {
+        uint32_t id;
+        bool checked;
+        QString label;
+        QString tooltip;
+        uint64_t count;
+        uint64_t lastCount;
+        double rate;
+    };
+
+    Entry makeEntry(uint32_t id, bool checked, bool useLabeling) const;
+    void rebuild(const QMap<int, bool> &filters, bool useLabeling);
+
+    ListType listType;
+    QVector<Entry> entries;
+    bool showCounts;
+};
+
+#endif // CANFILTERLISTMODEL_H
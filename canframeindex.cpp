@@ -0,0 +1,222 @@
+#include "canframeindex.h"
+
+#include <algorithm>
+
+CANFrameIndex::CANFrameIndex()
+{
+    count = 0;
+    timeOrdered = true;
+    lastStamp = 0;
+}
+
+void CANFrameIndex::reset()
+{
+    postings.clear();
+    busesByID.clear();
+    blockMin.clear();
+    blockMax.clear();
+    count = 0;
+    timeOrdered = true;
+    lastStamp = 0;
+}
+
+void CANFrameIndex::update(const QVector<CANFrame> &frames)
+{
+    int total = frames.count();
+    if (total < count) reset(); //list shrank out from under us. Should have gotten a reset call but start over anyway
+
+    for (int i = count; i < total; i++)
+    {
+        const CANFrame &frame = frames[i];
+        int64_t stamp = frame.timeStamp().microSeconds();
+
+        uint64_t key = makeKey(frame.frameId(), frame.bus);
+        QHash<uint64_t, Posting>::iterator post = postings.find(key);
+        if (post == postings.end())
+        {
+            Posting posting;
+            posting.longestRow = i;
+            posting.longestLen = -1;
+            posting.maxErrorFlags = 0;
+            post = postings.insert(key, posting);
+            busesByID[frame.frameId()].append(frame.bus);
+        }
+        post->rows.append(i);
+        int len = frame.payload().length();
+        if (len > post->longestLen)
+        {
+            post->longestLen = len;
+            post->longestRow = i;
+        }
+        if (frame.frameType() == QCanBusFrame::ErrorFrame)
+        {
+            //counted the way the grid puts them on lines, one per flag
+            int flags = 0;
+            QCanBusFrame::FrameErrors errors = frame.error();
+            for (uint32_t bit = 1; bit <= QCanBusFrame::UnknownError; bit <<= 1)
+                if (errors.testFlag(static_cast<QCanBusFrame::FrameError>(bit))) flags++;
+            if (flags > post->maxErrorFlags) post->maxErrorFlags = flags;
+        }
+
+        if (i > 0 && stamp < lastStamp) timeOrdered = false;
+        lastStamp = stamp;
+
+        int block = i / BLOCK_SIZE;
+        if (block >= blockMin.count())
+        {
+            blockMin.append(stamp);
+            blockMax.append(stamp);
+        }
+        else
+        {
+            if (stamp < blockMin[block]) blockMin[block] = stamp;
+            if (stamp > blockMax[block]) blockMax[block] = stamp;
+        }
+    }
+    count = total;
+}
+
+int CANFrameIndex::indexedCount() const
+{
+    return count;
+}
+
+//bus goes in the upper half, ID in the lower half
+uint64_t CANFrameIndex::makeKey(uint32_t id, int bus)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(bus)) << 32) | id;
+}
+
+QList<uint64_t> CANFrameIndex::keys() const
+{
+    return postings.keys();
+}
+
+//every ID seen so far on any bus, in no particular order
+QList<uint32_t> CANFrameIndex::ids() const
+{
+    return busesByID.keys();
+}
+
+QVector<int> CANFrameIndex::rowsFor(uint32_t id, int bus) const
+{
+    QHash<uint64_t, Posting>::const_iterator it = postings.constFind(makeKey(id, bus));
+    if (it == postings.constEnd()) return QVector<int>();
+    return it->rows;
+}
+
+int CANFrameIndex::longestRowFor(uint64_t key) const
+{
+    QHash<uint64_t, Posting>::const_iterator it = postings.constFind(key);
+    return (it == postings.constEnd()) ? -1 : it->longestRow;
+}
+
+int CANFrameIndex::maxErrorFlagsFor(uint64_t key) const
+{
+    QHash<uint64_t, Posting>::const_iterator it = postings.constFind(key);
+    return (it == postings.constEnd()) ? 0 : it->maxErrorFlags;
+}
+
+/*
+ * All rows with an ID in [idLow, idHigh] on the given bus (-1 for any bus), in ascending order. If onlyIDs
+ * is passed the ID also has to be in that set. A single posting list comes straight back without any copying.
+*/
+QVector<int> CANFrameIndex::rowsMatching(uint32_t idLow, uint32_t idHigh, int bus, const QSet<uint32_t> *onlyIDs) const
+{
+    QList<const QVector<int>*> lists;
+    int total = 0;
+
+    for (QHash<uint64_t, Posting>::const_iterator it = postings.constBegin(); it != postings.constEnd(); ++it)
+    {
+        uint32_t id = static_cast<uint32_t>(it.key() & 0xFFFFFFFFull);
+        int keyBus = static_cast<int>(it.key() >> 32);
+        if (id < idLow || id > idHigh) continue;
+        if (bus != -1 && keyBus != bus) continue;
+        if (onlyIDs && !onlyIDs->contains(id)) continue;
+        lists.append(&it->rows);
+        total += it->rows.count();
+    }
+
+    if (lists.count() == 0) return QVector<int>();
+    if (lists.count() == 1) return *lists[0];
+
+    QVector<int> rows;
+    rows.reserve(total);
+    for (int i = 0; i < lists.count(); i++) rows.append(*lists[i]);
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+int CANFrameIndex::blockCount() const
+{
+    return blockMin.count();
+}
+
+int64_t CANFrameIndex::blockMinTime(int block) const
+{
+    return blockMin[block];
+}
+
+int64_t CANFrameIndex::blockMaxTime(int block) const
+{
+    return blockMax[block];
+}
+
+bool CANFrameIndex::isTimeOrdered() const
+{
+    return timeOrdered;
+}
+
+/*
+ * Row of the last frame with this ID (on any bus) at or before the given time. That's the frame that was current
+ * at that moment. -1 if the ID hadn't shown up yet. frames has to be the list this index was built over.
+*/
+int CANFrameIndex::rowForIDAtTime(const QVector<CANFrame> &frames, uint32_t id, int64_t time) const
+{
+    int bestRow = -1;
+    const QVector<int> buses = busesByID.value(id);
+
+    for (int b = 0; b < buses.count(); b++)
+    {
+        const QVector<int> &rows = postings.constFind(makeKey(id, buses[b]))->rows;
+        int found = -1;
+        if (timeOrdered)
+        {
+            QVector<int>::const_iterator it = std::upper_bound(rows.constBegin(), rows.constEnd(), time,
+                                                     [&frames](int64_t t, int row) { return t < frames[row].timeStamp().microSeconds(); });
+            if (it != rows.constBegin()) found = *(it - 1);
+        }
+        else
+        {
+            //no order to rely on. Same as always, go until the first frame past the time
+            for (int r = 0; r < rows.count(); r++)
+            {
+                if (frames[rows[r]].timeStamp().microSeconds() <= time) found = rows[r];
+                else break;
+            }
+        }
+        if (found > bestRow) bestRow = found;
+    }
+    return bestRow;
+}
+
+/*
+ * First and last row with a timestamp in [startTime, endTime]. Only works if the list is in time order, otherwise
+ * the rows in that span aren't all next to each other and this returns false. Also false if nothing is in the span.
+*/
+bool CANFrameIndex::rowsInTimeRange(const QVector<CANFrame> &frames, int64_t startTime, int64_t endTime, int &firstRow, int &lastRow) const
+{
+    if (!timeOrdered || count == 0) return false;
+
+    const CANFrame *begin = frames.constData();
+    const CANFrame *end = begin + count;
+    const CANFrame *first = std::lower_bound(begin, end, startTime,
+                                             [](const CANFrame &frame, int64_t t) { return frame.timeStamp().microSeconds() < t; });
+    const CANFrame *last = std::upper_bound(first, end, endTime,
+                                            [](int64_t t, const CANFrame &frame) { return t < frame.timeStamp().microSeconds(); });
+    if (first == last) return false;
+
+    firstRow = static_cast<int>(first - begin);
+    lastRow = static_cast<int>(last - begin) - 1;
+    return true;
+}
@@ -0,0 +1,122 @@
+#ifndef CANFRAMEINDEX_H
+#define CANFRAMEINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <algorithm>
+#include "can_structs.h"
+
+/*
+ * Index over a list of frames so that questions like "which rows hold ID 0x7E8 on bus 1" don't need a pass over
+ * the whole list. Every (ID, bus) pair gets a posting list of the rows it shows up in, always in ascending order.
+ * On top of that the rows are split into fixed size blocks and the smallest and largest timestamp in each block
+ * is kept. That's enough to skip whole blocks when only a slice of time is of interest even if the list isn't in time order.
+ * Each posting list also remembers its longest payload and the most error flags any of its error frames had, which is
+ * what decides how tall a row of the ID can get in the grid.
+ *
+ * The index only ever grows at the end. update() picks up whatever got appended to the list since the last call.
+ * If the list gets changed any other way (cleared, sorted, refiltered, trimmed) call reset() and the next
+ * update() builds it again from the top.
+ *
+ * It also notes whether the timestamps have only ever gone up. Captures nearly always do, and when they do
+ * the time lookups are binary searches instead of walks through the rows.
+ *
+ * Everything inside is implicitly shared so handing a copy to another thread is cheap. The copy doesn't change
+ * when the original keeps growing.
+*/
+class CANFrameIndex
+{
+public:
+    static const int BLOCK_SIZE = 1024;
+
+    CANFrameIndex();
+    void reset();
+    void update(const QVector<CANFrame> &frames);
+    int indexedCount() const;
+
+    static uint64_t makeKey(uint32_t id, int bus);
+    QList<uint64_t> keys() const;
+    QList<uint32_t> ids() const;
+    QVector<int> rowsFor(uint32_t id, int bus) const;
+    QVector<int> rowsMatching(uint32_t idLow, uint32_t idHigh, int bus, const QSet<uint32_t> *onlyIDs = nullptr) const;
+    int longestRowFor(uint64_t key) const;
+    int maxErrorFlagsFor(uint64_t key) const;
+
+    int blockCount() const;
+    int64_t blockMinTime(int block) const;
+    int64_t blockMaxTime(int block) const;
+
+    bool isTimeOrdered() const;
+    int rowForIDAtTime(const QVector<CANFrame> &frames, uint32_t id, int64_t time) const;
+    bool rowsInTimeRange(const QVector<CANFrame> &frames, int64_t startTime, int64_t endTime, int &firstRow, int &lastRow) const;
+
+    //last entry with a timestamp at or before time, -1 if there isn't one. The list has to be in time order
+    template<typename T> static int lastAtOrBefore(const T &list, int64_t time)
+    {
+        auto it = std::upper_bound(list.constBegin(), list.constEnd(), time,
+                                   [](int64_t t, const CANFrame &frame) { return t < frame.timeStamp().microSeconds(); });
+        return static_cast<int>(it - list.constBegin()) - 1;
+    }
+
+private:
+    struct Posting
+    {
+        QVector<int> rows;
+        int longestRow;     //first row with the longest payload
+        int longestLen;
+        int maxErrorFlags;
+    };
+
+    QHash<uint64_t, Posting> postings;
+    QHash<uint32_t, QVector<int>> busesByID; //which buses each ID has been seen on so ID only lookups can find their posting lists
+    QVector<int64_t> blockMin;
+    QVector<int64_t> blockMax;
+    int count;
+    bool timeOrdered;
+    int64_t lastStamp;
+};
+
+/*
+ * Some rows out of a frame list, usually an ID's posting list from CANFrameIndex, that can be read like a list of
+ * frames. Nothing is copied, at() goes straight to the frame in the list the rows came from. That means it's only
+ * good until that list is cleared, trimmed or rewritten. Trimming the oldest frames during a long capture doesn't
+ * come with a framesUpdated -1 or -2, so anything that holds on to rows has to check isCurrent() before using them
+ * and fetch them again if not. Rows from CANFrameModel::getFrameRows know which generation of the list they came
+ * from; ones made up by hand over a list nobody rewrites are always current.
+*/
+class CANFrameRows
+{
+public:
+    CANFrameRows() : frames(nullptr), liveGeneration(nullptr), generation(0) {}
+    CANFrameRows(const QVector<CANFrame> *frameList, const QVector<int> &rowList, const int *listGeneration = nullptr)
+        : frames(frameList), rows(rowList), liveGeneration(listGeneration), generation(listGeneration ? *listGeneration : 0) {}
+
+    bool isCurrent() const { return !liveGeneration || *liveGeneration == generation; }
+
+    int count() const { return rows.count(); }
+    bool isEmpty() const { return rows.isEmpty(); }
+    void clear() { rows.clear(); liveGeneration = nullptr; }
+    const CANFrame &at(int i) const { return frames->at(rows[i]); }
+    const CANFrame &operator[](int i) const { return frames->at(rows[i]); }
+    const CANFrame &first() const { return at(0); }
+    const CANFrame &last() const { return at(rows.count() - 1); }
+    int rowAt(int i) const { return rows[i]; }
+
+    //same as CANFrameIndex::lastAtOrBefore. The frames have to be in time order
+    int lastAtOrBefore(int64_t time) const
+    {
+        const QVector<CANFrame> *list = frames;
+        auto it = std::upper_bound(rows.constBegin(), rows.constEnd(), time,
+                                   [list](int64_t t, int row) { return t < list->at(row).timeStamp().microSeconds(); });
+        return static_cast<int>(it - rows.constBegin()) - 1;
+    }
+
+private:
+    const QVector<CANFrame> *frames;
+    QVector<int> rows;
+    const int *liveGeneration;  //the owner's counter, bumped whenever the list is rewritten
+    int generation;             //what it was when the rows were fetched
+};
+
+#endif // CANFRAMEINDEX_H
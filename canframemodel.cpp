@@ -5,10 +5,18 @@
 #include <QPalette>
 #include <QDateTime>
 #include <QSettings>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include "utility.h"
 
+#define RENDER_CACHE_ROWS   4096 //formatted rows kept around, a good number of screens worth of scrolling
+
 CANFrameModel::~CANFrameModel()
 {
+    delete captureObject; //stops the capture thread
     frames.clear();
     filteredFrames.clear();
     filters.clear();
@@ -83,11 +91,29 @@ CANFrameModel::CANFrameModel(QObject *parent)
     timeFormat =  "MMM-dd HH:mm:ss.zzz";
     sortDirAsc = false;
     bytesPerLine = 8;
+    ignoreDBCColors = false;
+    renderCache.setMaxCost(RENDER_CACHE_ROWS);
+    renderDBCGeneration = dbcHandler->getChangeCounter();
+    filteredGeneration = 0;
+    filterGeneration = 0;
+    captureGeneration = 0;
+    frameGeneration = 0;
+
+    //captured frames make a round trip through the capture thread before they land in the lists
+    captureObject = new FrameCaptureObject();
+    connect(this, &CANFrameModel::captureFrames, captureObject, &FrameCaptureObject::processFrames);
+    connect(this, &CANFrameModel::filtersChanged, captureObject, &FrameCaptureObject::setFilters);
+    connect(this, &CANFrameModel::timeOffsetChanged, captureObject, &FrameCaptureObject::setTimeOffset);
+    connect(this, &CANFrameModel::captureReset, captureObject, &FrameCaptureObject::resetCapture);
+    connect(captureObject, &FrameCaptureObject::framesProcessed, this, &CANFrameModel::applyBatch);
+    captureObject->initialize();
+    publishFilters();
 }
 
 void CANFrameModel::setBytesPerLine(int bpl)
 {
     bytesPerLine = bpl;
+    invalidateRenderCache();
 }
 
 void CANFrameModel::setHexMode(bool mode)
@@ -96,6 +122,7 @@ void CANFrameModel::setHexMode(bool mode)
     {
         this->beginResetModel();
         useHexMode = mode;
+        invalidateRenderCache();
         Utility::decimalMode = !useHexMode;
         this->endResetModel();
     }
@@ -108,6 +135,7 @@ void CANFrameModel::setTimeStyle(TimeStyle newStyle)
         this->beginResetModel();
         timeStyle = newStyle;
         Utility::timeStyle = newStyle;
+        invalidateRenderCache();
         this->endResetModel();
     }
 }
@@ -120,6 +148,7 @@ void CANFrameModel::setInterpretMode(bool mode)
     {
         this->beginResetModel();
         interpretFrames = mode;
+        invalidateRenderCache();
         this->endResetModel();
     }
 }
@@ -133,6 +162,7 @@ void CANFrameModel::setTimeFormat(QString format)
 {
     Utility::timeFormat = format;
     timeFormat = format;
+    invalidateRenderCache();
     beginResetModel(); //reset model to show new time format
     endResetModel();
 }
@@ -143,6 +173,7 @@ void CANFrameModel::setIgnoreDBCColors(bool mode)
     {
         beginResetModel(); //reset model to update the view
         ignoreDBCColors = mode;
+        invalidateRenderCache();
         endResetModel();
     }
 }
@@ -150,38 +181,70 @@ void CANFrameModel::setIgnoreDBCColors(bool mode)
 /*
  * Scan all frames for the smallest timestamp and offset all timestamps so that smallest one is at 0
 */
+#define NORMALIZE_MIN_CHUNK  262144 //each thread gets at least this many frames to shift
+
+//split [0, count) into one chunk per thread, or fewer if there isn't enough to go around
+static QVector<int> normalizeChunkBounds(int count)
+{
+    int numChunks = qBound(1, count / NORMALIZE_MIN_CHUNK, qMax(1, QThread::idealThreadCount()));
+    QVector<int> bounds;
+    for (int c = 0; c <= numChunks; c++) bounds.append(static_cast<int>((static_cast<qint64>(count) * c) / numChunks));
+    return bounds;
+}
+
+static void shiftTimestamps(QVector<CANFrame> &list, int64_t offset)
+{
+    if (list.isEmpty()) return;
+    CANFrame *data = list.data();
+    QVector<int> bounds = normalizeChunkBounds(list.count());
+    QVector<int> chunks;
+    for (int c = 0; c < bounds.count() - 1; c++) chunks.append(c);
+    QtConcurrent::blockingMap(chunks, [&](int &c)
+    {
+        for (int i = bounds[c]; i < bounds[c + 1]; i++)
+        {
+            data[i].setTimeStamp(QCanBusFrame::TimeStamp(0, data[i].timeStamp().microSeconds() - offset));
+        }
+    });
+}
+
 void CANFrameModel::normalizeTiming()
 {
     mutex.lock();
-    if (frames.count() == 0) 
+    int count = frames.count();
+    if (count == 0) 
     {
         mutex.unlock();
         return;
     }
-    timeOffset = frames[0].timeStamp().microSeconds();
-    qint64 prevStamp = 0;
 
     //find the absolute lowest timestamp in the whole time. Needed because maybe timestamp was reset in the middle.
-    for (int j = 0; j < frames.count(); j++)
+    //Each thread finds the lowest in its own chunk then the lowest of those wins
+    const CANFrame *frameData = frames.constData();
+    QVector<int> bounds = normalizeChunkBounds(count);
+    QVector<int64_t> chunkMins(bounds.count() - 1);
+    int64_t *mins = chunkMins.data();
+    QVector<int> chunks;
+    for (int c = 0; c < chunkMins.count(); c++) chunks.append(c);
+    QtConcurrent::blockingMap(chunks, [&](int &c)
     {
-        if (frames[j].timeStamp().microSeconds() < timeOffset) timeOffset = frames[j].timeStamp().microSeconds();
-    }
-
-    for (int i = 0; i < frames.count(); i++)
-    {
-        qint64 thisStamp = frames[i].timeStamp().microSeconds() - timeOffset;
-        if (thisStamp <= prevStamp)
+        int64_t lowest = frameData[bounds[c]].timeStamp().microSeconds();
+        for (int i = bounds[c] + 1; i < bounds[c + 1]; i++)
         {
-            timeOffset -= prevStamp;
+            if (frameData[i].timeStamp().microSeconds() < lowest) lowest = frameData[i].timeStamp().microSeconds();
         }
-        frames[i].setTimeStamp(QCanBusFrame::TimeStamp(0, thisStamp));
-    }
+        mins[c] = lowest;
+    });
+    timeOffset = *std::min_element(chunkMins.constBegin(), chunkMins.constEnd());
+
+    shiftTimestamps(frames, timeOffset);
+    framesChanged();
+    emit timeOffsetChanged(timeOffset);
 
     this->beginResetModel();
-    for (int i = 0; i < filteredFrames.count(); i++)
-    {
-        filteredFrames[i].setTimeStamp(QCanBusFrame::TimeStamp(0, filteredFrames[i].timeStamp().microSeconds() - timeOffset));
-    }
+    shiftTimestamps(filteredFrames, timeOffset);
+    filteredFramesChanged();
+    invalidateRenderCache();
     this->endResetModel();
 
     mutex.unlock();
@@ -191,6 +254,7 @@ void CANFrameModel::setOverwriteMode(bool mode)
 {
     beginResetModel();
     overwriteDups = mode;
+    invalidateRenderCache();
     recalcOverwrite();
     endResetModel();
 }
@@ -224,16 +288,53 @@ void CANFrameModel::setAllFilters(bool state)
     sendRefresh();
 }
 
+//returns false and leaves the old expression in place if the new one doesn't compile. getFilterExpressionError says why
+bool CANFrameModel::setFilterExpression(QString text)
+{
+    CANFilterExpression newExpression;
+    if (!newExpression.compile(text))
+    {
+        filterExpressionError = newExpression.getLastError();
+        return false;
+    }
+    filterExpressionError.clear();
+
+    mutex.lock();
+    filterExpression = newExpression;
+    mutex.unlock();
+    sendRefresh();
+    return true;
+}
+
+QString CANFrameModel::getFilterExpression() const
+{
+    return filterExpression.getText();
+}
+
+QString CANFrameModel::getFilterExpressionError() const
+{
+    return filterExpressionError;
+}
+
 /*
- * There is probably a more correct way to have done this but below are several functions that collectively implement
- * quicksort on the columns and interpret the columns numerically. But, correct or not, this implementation is quite fast
- * and sorts the columns properly.
+ * Sorting works on a compact array of (key, row) pairs rather than on the frames themselves. The key for each row is
+ * pulled out exactly once, the pairs get sorted, and then each frame is moved to its final spot exactly once.
+ * Large lists are split into chunks that are keyed and sorted on separate threads and then merged back together
+ * in parallel rounds. Both stable_sort and merge keep equal keys in their original order so the whole sort is
+ * stable. Sorting by ID keeps frames with the same ID in time order, for instance.
 */
-uint64_t CANFrameModel::getCANFrameVal(QVector<CANFrame> *frames, int row, Column col)
+struct CANFrameSortKey
+{
+    uint64_t key;
+    int row;
+};
+
+#define SORT_MIN_CHUNK  65536 //not worth farming out anything smaller than this to another thread
+#define COPY_CHUNK      8192  //rows copied per lock when another thread copies frames out, so applyBatch never waits long
+
+uint64_t CANFrameModel::getCANFrameVal(const CANFrame &frame, Column col) const
 {
     uint64_t temp = 0;
-    if (row >= frames->count()) return 0;
-    CANFrame frame = frames->at(row);
     switch (col)
     {
     case Column::TimeStamp:
@@ -257,84 +358,87 @@ uint64_t CANFrameModel::getCANFrameVal(QVector<CANFrame> *frames, int row, Colum
         return static_cast<uint64_t>(frame.payload().length());
     case Column::ASCII: //sort both the same for now
     case Column::Data:
-        for (int i = 0; i < std::min(frame.payload().length(), 8); i++) temp += (static_cast<uint64_t>(frame.payload()[i]) << (56 - (8 * i)));
-        //qDebug() << temp;
+    {
+        const QByteArray &payload = frame.payload();
+        for (int i = 0; i < std::min(payload.length(), 8); i++) temp += (static_cast<uint64_t>(payload[i]) << (56 - (8 * i)));
         return temp;
+    }
     case Column::NUM_COLUMN:
         return 0;
     }
     return 0;
 }
 
-void CANFrameModel::qSortCANFrameAsc(QVector<CANFrame> *frames, Column column, int lowerBound, int upperBound)
+void CANFrameModel::sortByColumn(int column)
 {
-    int p, i, j;
-    qDebug() << "Lower " << lowerBound << " Upper" << upperBound;
-    if (lowerBound < upperBound)
+    sortDirAsc = !sortDirAsc;
+    bool ascending = sortDirAsc;
+    Column col = Column(column);
+    auto compare = [ascending](const CANFrameSortKey &a, const CANFrameSortKey &b)
     {
-        uint64_t piv = getCANFrameVal(frames, lowerBound + (upperBound - lowerBound) / 2, column);
-        i = lowerBound - 1;
-        j = upperBound + 1;
-        for (;;){
-            do {
-                i++;
-            } while ((i < upperBound) && getCANFrameVal(frames, i, column) < piv);
+        return ascending ? (a.key < b.key) : (a.key > b.key);
+    };
 
-            do
-            {
-                j--;
-            } while ((j > lowerBound) && getCANFrameVal(frames, j, column) > piv);
-            if (i < j) {
-                CANFrame temp = frames->at(i);
-                frames->replace(i, frames->at(j));
-                frames->replace(j, temp);
-            }
-            else {p = j; break;}
-        }
-
-        qSortCANFrameAsc(frames, column, lowerBound, p);
-        qSortCANFrameAsc(frames, column, p+1, upperBound);
-    }
-}
+    mutex.lock();
 
-void CANFrameModel::qSortCANFrameDesc(QVector<CANFrame> *frames, Column column, int lowerBound, int upperBound)
-{
-    int p, i, j;
-    qDebug() << "Lower " << lowerBound << " Upper" << upperBound;
-    if (lowerBound < upperBound)
+    int count = filteredFrames.count();
+    if (count > 1)
     {
-        uint64_t piv = getCANFrameVal(frames, lowerBound + (upperBound - lowerBound) / 2, column);
-        i = lowerBound - 1;
-        j = upperBound + 1;
-        for (;;){
-            do {
-                i++;
-            } while ((i < upperBound) && getCANFrameVal(frames, i, column) > piv);
+        QVector<CANFrameSortKey> keys(count);
+        QVector<CANFrameSortKey> scratch(count);
+        CANFrameSortKey *src = keys.data();
+        CANFrameSortKey *dst = scratch.data();
+        CANFrame *frameData = filteredFrames.data();
+
+        int numChunks = qBound(1, count / SORT_MIN_CHUNK, qMax(1, QThread::idealThreadCount()));
+        QVector<int> bounds;
+        for (int c = 0; c <= numChunks; c++) bounds.append(static_cast<int>((static_cast<qint64>(count) * c) / numChunks));
+
+        QVector<int> chunks;
+        for (int c = 0; c < numChunks; c++) chunks.append(c);
+        QtConcurrent::blockingMap(chunks, [&](int &c)
+        {
+            for (int i = bounds[c]; i < bounds[c + 1]; i++)
+            {
+                src[i].key = getCANFrameVal(frameData[i], col);
+                src[i].row = i;
+            }
+            std::stable_sort(src + bounds[c], src + bounds[c + 1], compare);
+        });
 
-            do
+        //merge neighboring chunks pairwise until only one is left. An odd chunk out just gets copied across.
+        while (bounds.count() > 2)
+        {
+            int n = bounds.count() - 1;
+            QVector<int> pairs;
+            QVector<int> newBounds;
+            for (int c = 0; c < n; c += 2)
             {
-                j--;
-            } while ((j > lowerBound) && getCANFrameVal(frames, j, column) < piv);
-            if (i < j) {
-                CANFrame temp = frames->at(i);
-                frames->replace(i, frames->at(j));
-                frames->replace(j, temp);
+                pairs.append(c);
+                newBounds.append(bounds[c]);
             }
-            else {p = j; break;}
+            newBounds.append(bounds[n]);
+
+            QtConcurrent::blockingMap(pairs, [&](int &c)
+            {
+                int lo = bounds[c];
+                int mid = bounds[c + 1];
+                int hi = (c + 1 < n) ? bounds[c + 2] : mid;
+                std::merge(src + lo, src + mid, src + mid, src + hi, dst + lo, compare);
+            });
+
+            bounds = newBounds;
+            std::swap(src, dst);
         }
 
-        qSortCANFrameDesc(frames, column, lowerBound, p);
-        qSortCANFrameDesc(frames, column, p+1, upperBound);
+        //every frame moves straight to where it belongs, once
+        QVector<CANFrame> sorted;
+        sorted.reserve(count);
+        for (int i = 0; i < count; i++) sorted.append(std::move(frameData[src[i].row]));
+        filteredFrames.swap(sorted);
+        filteredFramesChanged();
     }
-}
 
-void CANFrameModel::sortByColumn(int column)
-{
-    sortDirAsc = !sortDirAsc;
-    if (sortDirAsc) qSortCANFrameAsc(&filteredFrames, Column(column), 0, filteredFrames.count()-1);
-    else qSortCANFrameDesc(&filteredFrames, Column(column), 0, filteredFrames.count()-1);
-
-    mutex.lock();
     beginResetModel();
     endResetModel();
     mutex.unlock();
@@ -360,7 +464,7 @@ void CANFrameModel::recalcOverwrite()
 
         idAugmented = frame.frameId();
         idAugmented = idAugmented + (frame.bus << 29ull);
-        if (filters[frame.frameId()] && busFilters[frame.bus])
+        if (passesFilters(frame))
         {
             if (!overWriteFrames.contains(idAugmented))
             {
@@ -384,6 +488,7 @@ void CANFrameModel::recalcOverwrite()
     filteredFrames.clear();
     filteredFrames.append(overWriteFrames.values().toVector());
     filteredFrames.reserve(preallocSize);
+    filteredFramesChanged();
 
     /*for (int i = 0; i < frames.count(); i++)
     {
@@ -399,34 +504,23 @@ void CANFrameModel::recalcOverwrite()
 
 QVariant CANFrameModel::data(const QModelIndex &index, int role) const
 {
-    QString tempString;
-    CANFrame thisFrame;
-    static bool rowFlip = false;
-    QVariant ts;
-
     if (!index.isValid())
         return QVariant();
 
     if (index.row() >= (filteredFrames.count()))
         return QVariant();
 
-    thisFrame = filteredFrames.at(index.row());
-
-    const unsigned char *data = reinterpret_cast<const unsigned char *>(thisFrame.payload().constData());
-    int dataLen = thisFrame.payload().count();
-
     if (role == Qt::BackgroundRole)
     {
         if (dbcHandler != nullptr && interpretFrames && !ignoreDBCColors)
         {
-            DBC_MESSAGE *msg = dbcHandler->findMessage(thisFrame);
+            DBC_MESSAGE *msg = getRenderedRow(index.row())->msg;
             if (msg != nullptr)
             {
                 return msg->bgColor;
             }
         }
-        rowFlip = (index.row() % 2);
-        if (rowFlip) return QApplication::palette().color(QPalette::Base);
+        if (index.row() % 2) return QApplication::palette().color(QPalette::Base);
         else return QApplication::palette().color(QPalette::AlternateBase);
     }
 
@@ -452,7 +546,7 @@ QVariant CANFrameModel::data(const QModelIndex &index, int role) const
     {
         if (dbcHandler != nullptr && interpretFrames && !ignoreDBCColors)
         {
-            DBC_MESSAGE *msg = dbcHandler->findMessage(thisFrame);
+            DBC_MESSAGE *msg = getRenderedRow(index.row())->msg;
             if (msg != nullptr)
             {
                 return msg->fgColor;
@@ -461,128 +555,317 @@ QVariant CANFrameModel::data(const QModelIndex &index, int role) const
         return QApplication::palette().color(QPalette::WindowText);
     }
 
-    if (role == Qt::DisplayRole) {
-        switch (Column(index.column()))
+    if (role == Qt::DisplayRole)
+    {
+        if (index.column() < 0 || index.column() >= (int)Column::NUM_COLUMN) return QString();
+        return getRenderedRow(index.row())->text[index.column()];
+    }
+
+    return QVariant();
+}
+
+/*
+ * The view asks for every role of every visible cell on each repaint and scroll. Formatting a row (especially
+ * interpreted, which decodes every signal) is far more expensive than anything else it asks for so whole rows get
+ * formatted at once and kept in a bounded LRU cache keyed by row number. Display settings and DBC changes
+ * drop the cache outright. Anything else that shuffles rows is caught by checking the frame at the row against
+ * what the cached text was made from.
+*/
+const CANFrameRenderedRow *CANFrameModel::getRenderedRow(int row) const
+{
+    const CANFrame &frame = filteredFrames.at(row);
+
+    checkDBCGeneration();
+
+    CANFrameRenderedRow *rendered = renderCache.object(row);
+    if (rendered != nullptr && rendered->timeStamp == frame.timeStamp().microSeconds() && rendered->frameId == frame.frameId()
+        && rendered->bus == frame.bus && rendered->frameCount == frame.frameCount && rendered->timedelta == frame.timedelta
+        && rendered->isReceived == frame.isReceived && rendered->payload == frame.payload())
+    {
+        return rendered;
+    }
+
+    rendered = new CANFrameRenderedRow;
+    renderRow(frame, *rendered);
+    renderCache.insert(row, rendered);
+    return rendered;
+}
+
+/*
+ * Everything cached for drawing rows can point into the loaded DBC files, which can have messages (or whole files)
+ * deleted out from under it. Anything that reads those caches calls this first so they get thrown out as soon as
+ * the handler reports a change, whether or not anybody remembered to call invalidateRenderCache.
+*/
+void CANFrameModel::checkDBCGeneration() const
+{
+    if (dbcHandler == nullptr) return;
+    int generation = dbcHandler->getChangeCounter();
+    if (generation == renderDBCGeneration) return;
+    invalidateRenderCache();
+    renderDBCGeneration = generation;
+}
+
+//same answer as dbcHandler->findMessage but remembered per ID and bus without going through the handler's lock each time
+DBC_MESSAGE *CANFrameModel::lookupMessage(const CANFrame &frame) const
+{
+    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(frame.bus)) << 32) | frame.frameId();
+    QHash<uint64_t, DBC_MESSAGE*>::const_iterator it = messageCache.constFind(key);
+    if (it != messageCache.constEnd()) return it.value();
+
+    DBC_MESSAGE *msg = dbcHandler->findMessage(frame);
+    messageCache.insert(key, msg);
+    return msg;
+}
+
+void CANFrameModel::invalidateRenderCache() const
+{
+    renderCache.clear();
+    messageCache.clear();
+    lineCountCache.clear();
+}
+
+//rounds like QVariant::toLongLong used to but pins values that don't fit (and NaN) instead of leaving it undefined
+static int64_t cachedValueAsInteger(double value)
+{
+    if (std::isnan(value)) return 0;
+    if (value >= 9223372036854775807.0) return std::numeric_limits<int64_t>::max();
+    if (value <= -9223372036854775808.0) return std::numeric_limits<int64_t>::min();
+    return qRound64(value);
+}
+
+//renderRow puts each error flag on a line of its own
+int CANFrameModel::errorLineCount(const CANFrame &frame)
+{
+    if (frame.frameType() != QCanBusFrame::ErrorFrame) return 0;
+    int lines = 0;
+    QCanBusFrame::FrameErrors errors = frame.error();
+    for (uint32_t bit = 1; bit <= QCanBusFrame::UnknownError; bit <<= 1)
+        if (errors.testFlag(static_cast<QCanBusFrame::FrameError>(bit))) lines++;
+    return lines;
+}
+
+/*
+ * How many lines of text renderRow will produce for a frame, worked out from the payload length and the DBC message
+ * without building any text. Everything but the multiplexed signals only depends on the bus, ID and length so that
+ * part is cached. worstCase counts every multiplexed signal instead of just the ones this payload selects.
+*/
+int CANFrameModel::lineCountFor(const CANFrame &frame, bool worstCase) const
+{
+    if (frame.frameType() == QCanBusFrame::RemoteRequestFrame) return 1;
+
+    checkDBCGeneration();
+
+    int dataLen = frame.payload().count();
+    int lines = errorLineCount(frame);
+
+    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(frame.bus)) << 40) | (static_cast<uint64_t>(frame.frameId()) << 8)
+                   | static_cast<uint64_t>(dataLen & 0xFF);
+    QHash<uint64_t, RowLineInfo>::const_iterator it = lineCountCache.constFind(key);
+    if (it == lineCountCache.constEnd())
+    {
+        RowLineInfo info;
+        info.fixedLines = qMax(1, (dataLen + bytesPerLine - 1) / bytesPerLine);
+        info.hasMux = false;
+
+        DBC_MESSAGE *msg = nullptr;
+        if (dbcHandler != nullptr && interpretFrames && frame.frameType() == QCanBusFrame::DataFrame) msg = lookupMessage(frame);
+        if (msg != nullptr)
         {
-        case Column::TimeStamp:            
-            //Reformatting the output a bit with custom code
-            if (overwriteDups)
-            {
-                if (timeStyle == TS_SECONDS) return QString::number(thisFrame.timedelta / 1000000.0, 'f', 5);
-                return QString::number(thisFrame.timedelta);
-            }
-            else ts = Utility::formatTimestamp(thisFrame.timeStamp().microSeconds());
-            if (ts.type() == QVariant::Double) return QString::number(ts.toDouble(), 'f', 5); //never scientific notation, 5 decimal places
-            if (ts.type() == QVariant::LongLong) return QString::number(ts.toLongLong()); //never scientific notion, all digits shown
-            if (ts.type() == QVariant::DateTime) return ts.toDateTime().toString(timeFormat); //custom set format for dates and times
-            return Utility::formatTimestamp(thisFrame.timeStamp().microSeconds());
-        case Column::FrameId:
-            return Utility::formatCANID(thisFrame.frameId(), thisFrame.hasExtendedFrameFormat());
-        case Column::Extended:
-            return QString::number(thisFrame.hasExtendedFrameFormat());
-        case Column::Remote:
-            if (!overwriteDups) return QString::number(thisFrame.frameType() == QCanBusFrame::RemoteRequestFrame);
-            return QString::number(thisFrame.frameCount);
-        case Column::Direction:
-            if (thisFrame.isReceived) return QString(tr("Rx"));
-            return QString(tr("Tx"));
-        case Column::Bus:
-            return QString::number(thisFrame.bus);
-        case Column::Length:
-            return QString::number(dataLen);
-        case Column::ASCII:
-            if (thisFrame.frameId() >= 0x7FFFFFF0ull)
+            info.fixedLines++; //the message name ends the payload lines so the signals start on a fresh one
+            if (msg->comment.length() > 1) info.fixedLines += msg->comment.count('\n') + 1;
+            for (int j = 0; j < msg->sigHandler->getCount(); j++)
             {
-                tempString.append("MARK ");
-                tempString.append(QString::number(thisFrame.frameId() & 0x7));
-                return tempString;
-            }
-            if (thisFrame.frameType() == QCanBusFrame::DataFrame) {
-                if (dataLen < 0) dataLen = 0;
-                //if (dLen > 8) dLen = 8;
-                for (int i = 0; i < dataLen; i++)
+                DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(j);
+                if (sig->multiplexParent == nullptr)
                 {
-                    char byt = thisFrame.payload()[i];
-                    //0x20 through 0x7E are printable characters. Outside of that range they aren't. So use dots instead
-                    if (byt < 0x20) byt = 0x2E; //dot character
-                    if (byt > 0x7E) byt = 0x2E;
-                    tempString.append(QString::fromUtf8(&byt, 1));
-                    if (!((i+1) % bytesPerLine) && (i != (dataLen - 1))) tempString.append("\n");
+                    if (dataLen * 8 >= sig->startBit + sig->signalSize) info.fixedLines++;
                 }
+                else if (overwriteDups) info.fixedLines++; //overwrite mode shows the last value of every multiplexed signal
+                else info.hasMux = true;
             }
-            if (thisFrame.frameType() == QCanBusFrame::ErrorFrame)
-            {
-                 tempString = "ERROR";
-            }
-            return tempString;
-        case Column::Data:
-            if (dataLen < 0) dataLen = 0;
-            //if (useHexMode) tempString.append("0x ");
-            if (thisFrame.frameType() == QCanBusFrame::RemoteRequestFrame) {
-                return tempString;
-            }
+        }
+        it = lineCountCache.insert(key, info);
+    }
+
+    lines += it.value().fixedLines;
+
+    //the message itself isn't kept in lineCountCache, messageCache has it and is checked against the DBC generation
+    DBC_MESSAGE *muxMsg = it.value().hasMux ? lookupMessage(frame) : nullptr;
+    if (muxMsg != nullptr)
+    {
+        for (int j = 0; j < muxMsg->sigHandler->getCount(); j++)
+        {
+            DBC_SIGNAL *sig = muxMsg->sigHandler->findSignalByIdx(j);
+            if (sig->multiplexParent != nullptr && (worstCase || sig->isPresentIn(frame))) lines++;
+        }
+    }
+
+    return lines;
+}
+
+//for the grid to size a row without having to lay out its text
+int CANFrameModel::getRowLineCount(int row) const
+{
+    if (row < 0 || row >= filteredFrames.count()) return 1;
+    return lineCountFor(filteredFrames[row], false);
+}
+
+/*
+ * Most lines any row in the grid could need. The index keeps track of the longest payload and the most error flags
+ * for each ID and bus as it goes, so this only measures one frame per ID and bus instead of every row. That's what
+ * lets a single height be used for every row of a huge capture. Error lines of the longest frame get swapped for
+ * the most any frame of the ID had so the answer never comes up short.
+*/
+int CANFrameModel::getMaxLineCount()
+{
+    int maxLines = 1;
+    mutex.lock();
+    filteredIndex.update(filteredFrames);
+    QList<uint64_t> keys = filteredIndex.keys();
+    for (int i = 0; i < keys.count(); i++)
+    {
+        int row = filteredIndex.longestRowFor(keys[i]);
+        if (row < 0 || row >= filteredFrames.count()) continue;
+        const CANFrame &frame = filteredFrames[row];
+        int lines = lineCountFor(frame, true) - errorLineCount(frame) + filteredIndex.maxErrorFlagsFor(keys[i]);
+        maxLines = qMax(maxLines, lines);
+    }
+    mutex.unlock();
+    return maxLines;
+}
+
+void CANFrameModel::renderRow(const CANFrame &thisFrame, CANFrameRenderedRow &rendered) const
+{
+    QString tempString;
+    QVariant ts;
+
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(thisFrame.payload().constData());
+    int dataLen = thisFrame.payload().count();
+    if (dataLen < 0) dataLen = 0;
+
+    rendered.timeStamp = thisFrame.timeStamp().microSeconds();
+    rendered.timedelta = thisFrame.timedelta;
+    rendered.frameId = thisFrame.frameId();
+    rendered.bus = thisFrame.bus;
+    rendered.frameCount = thisFrame.frameCount;
+    rendered.isReceived = thisFrame.isReceived;
+    rendered.payload = thisFrame.payload();
+    rendered.msg = nullptr;
+    if (dbcHandler != nullptr && interpretFrames) rendered.msg = lookupMessage(thisFrame);
+
+    //Reformatting the output a bit with custom code
+    if (overwriteDups)
+    {
+        if (timeStyle == TS_SECONDS) tempString = QString::number(thisFrame.timedelta / 1000000.0, 'f', 5);
+        else tempString = QString::number(thisFrame.timedelta);
+    }
+    else
+    {
+        ts = Utility::formatTimestamp(thisFrame.timeStamp().microSeconds());
+        if (ts.type() == QVariant::Double) tempString = QString::number(ts.toDouble(), 'f', 5); //never scientific notation, 5 decimal places
+        else if (ts.type() == QVariant::LongLong) tempString = QString::number(ts.toLongLong()); //never scientific notion, all digits shown
+        else if (ts.type() == QVariant::DateTime) tempString = ts.toDateTime().toString(timeFormat); //custom set format for dates and times
+        else tempString = ts.toString();
+    }
+    rendered.text[(int)Column::TimeStamp] = tempString;
+
+    rendered.text[(int)Column::FrameId] = Utility::formatCANID(thisFrame.frameId(), thisFrame.hasExtendedFrameFormat());
+    rendered.text[(int)Column::Extended] = QString::number(thisFrame.hasExtendedFrameFormat());
+    if (!overwriteDups) rendered.text[(int)Column::Remote] = QString::number(thisFrame.frameType() == QCanBusFrame::RemoteRequestFrame);
+    else rendered.text[(int)Column::Remote] = QString::number(thisFrame.frameCount);
+    if (thisFrame.isReceived) rendered.text[(int)Column::Direction] = QString(tr("Rx"));
+    else rendered.text[(int)Column::Direction] = QString(tr("Tx"));
+    rendered.text[(int)Column::Bus] = QString::number(thisFrame.bus);
+    rendered.text[(int)Column::Length] = QString::number(dataLen);
+
+    tempString.clear();
+    if (thisFrame.frameId() >= 0x7FFFFFF0ull)
+    {
+        tempString.append("MARK ");
+        tempString.append(QString::number(thisFrame.frameId() & 0x7));
+    }
+    else
+    {
+        if (thisFrame.frameType() == QCanBusFrame::DataFrame) {
             for (int i = 0; i < dataLen; i++)
             {
-                if (useHexMode) tempString.append( QString::number(data[i], 16).toUpper().rightJustified(2, '0'));
-                else tempString.append(QString::number(data[i], 10));
+                char byt = static_cast<char>(data[i]);
+                //0x20 through 0x7E are printable characters. Outside of that range they aren't. So use dots instead
+                if (byt < 0x20) byt = 0x2E; //dot character
+                if (byt > 0x7E) byt = 0x2E;
+                tempString.append(QLatin1Char(byt));
                 if (!((i+1) % bytesPerLine) && (i != (dataLen - 1))) tempString.append("\n");
-                else tempString.append(" ");
             }
-            if (thisFrame.frameType() == thisFrame.ErrorFrame)
-            {
-                if (thisFrame.error() & thisFrame.TransmissionTimeoutError) tempString.append("\nTX Timeout");
-                if (thisFrame.error() & thisFrame.LostArbitrationError) tempString.append("\nLost Arbitration");
-                if (thisFrame.error() & thisFrame.ControllerError) tempString.append("\nController Error");
-                if (thisFrame.error() & thisFrame.ProtocolViolationError) tempString.append("\nProtocol Violation");
-                if (thisFrame.error() & thisFrame.TransceiverError) tempString.append("\nTransceiver Error");
-                if (thisFrame.error() & thisFrame.MissingAcknowledgmentError) tempString.append("\nMissing ACK");
-                if (thisFrame.error() & thisFrame.BusOffError) tempString.append("\nBus OFF");
-                if (thisFrame.error() & thisFrame.BusError) tempString.append("\nBus ERR");
-                if (thisFrame.error() & thisFrame.ControllerRestartError) tempString.append("\nController restart err");
-                if (thisFrame.error() & thisFrame.UnknownError) tempString.append("\nUnknown error type");
-            }
-            //TODO: technically the actual returned bytes for an error frame encode some more info. Not interpreting it yet.
+        }
+        if (thisFrame.frameType() == QCanBusFrame::ErrorFrame)
+        {
+             tempString = "ERROR";
+        }
+    }
+    rendered.text[(int)Column::ASCII] = tempString;
 
-            //now, if we're supposed to interpret the data and the DBC handler is loaded then use it
-            if ( (dbcHandler != nullptr) && interpretFrames && (thisFrame.frameType() == thisFrame.DataFrame) )
-            {
-                DBC_MESSAGE *msg = dbcHandler->findMessage(thisFrame);
-                if (msg != nullptr)
+    tempString.clear();
+    //if (useHexMode) tempString.append("0x ");
+    if (thisFrame.frameType() == QCanBusFrame::RemoteRequestFrame) {
+        rendered.text[(int)Column::Data] = tempString;
+        return;
+    }
+    tempString.reserve(dataLen * 3 + 16);
+    for (int i = 0; i < dataLen; i++)
+    {
+        if (useHexMode) tempString.append( QString::number(data[i], 16).toUpper().rightJustified(2, '0'));
+        else tempString.append(QString::number(data[i], 10));
+        if (!((i+1) % bytesPerLine) && (i != (dataLen - 1))) tempString.append("\n");
+        else tempString.append(" ");
+    }
+    if (thisFrame.frameType() == thisFrame.ErrorFrame)
+    {
+        if (thisFrame.error() & thisFrame.TransmissionTimeoutError) tempString.append("\nTX Timeout");
+        if (thisFrame.error() & thisFrame.LostArbitrationError) tempString.append("\nLost Arbitration");
+        if (thisFrame.error() & thisFrame.ControllerError) tempString.append("\nController Error");
+        if (thisFrame.error() & thisFrame.ProtocolViolationError) tempString.append("\nProtocol Violation");
+        if (thisFrame.error() & thisFrame.TransceiverError) tempString.append("\nTransceiver Error");
+        if (thisFrame.error() & thisFrame.MissingAcknowledgmentError) tempString.append("\nMissing ACK");
+        if (thisFrame.error() & thisFrame.BusOffError) tempString.append("\nBus OFF");
+        if (thisFrame.error() & thisFrame.BusError) tempString.append("\nBus ERR");
+        if (thisFrame.error() & thisFrame.ControllerRestartError) tempString.append("\nController restart err");
+        if (thisFrame.error() & thisFrame.UnknownError) tempString.append("\nUnknown error type");
+    }
+    //TODO: technically the actual returned bytes for an error frame encode some more info. Not interpreting it yet.
+
+    //now, if we're supposed to interpret the data and the DBC handler is loaded then use it
+    if ( (dbcHandler != nullptr) && interpretFrames && (thisFrame.frameType() == thisFrame.DataFrame) )
+    {
+        DBC_MESSAGE *msg = rendered.msg;
+        if (msg != nullptr)
+        {
+            tempString.append("   <" + msg->name + ">\n");
+            if (msg->comment.length() > 1) tempString.append(msg->comment + "\n");
+            for (int j = 0; j < msg->sigHandler->getCount(); j++)
+            {                        
+                QString sigString;
+                DBC_SIGNAL* sig = msg->sigHandler->findSignalByIdx(j);
+
+                if ( (sig->multiplexParent == nullptr) && sig->processAsText(thisFrame, sigString))
                 {
-                    tempString.append("   <" + msg->name + ">\n");
-                    if (msg->comment.length() > 1) tempString.append(msg->comment + "\n");
-                    for (int j = 0; j < msg->sigHandler->getCount(); j++)
-                    {                        
-                        QString sigString;
-                        DBC_SIGNAL* sig = msg->sigHandler->findSignalByIdx(j);
-
-                        if ( (sig->multiplexParent == nullptr) && sig->processAsText(thisFrame, sigString))
-                        {
-                            tempString.append(sigString);
-                            tempString.append("\n");
-                            if (sig->isMultiplexor)
-                            {
-                                qDebug() << "Multiplexor. Diving into the tree";
-                                tempString.append(sig->processSignalTree(thisFrame));
-                            }
-                        }
-                        else if (sig->isMultiplexed && overwriteDups) //wasn't in this exact frame but is in the message. Use cached value
-                        {
-                            bool isInteger = false;
-                            if (sig->valType == UNSIGNED_INT || sig->valType == SIGNED_INT) isInteger = true;
-                            tempString.append(sig->makePrettyOutput(sig->cachedValue.toDouble(), sig->cachedValue.toLongLong(), true, isInteger));
-                            tempString.append("\n");
-                        }
+                    tempString.append(sigString);
+                    tempString.append("\n");
+                    if (sig->isMultiplexor)
+                    {
+                        tempString.append(sig->processSignalTree(thisFrame));
                     }
                 }
+                else if (sig->isMultiplexed && overwriteDups) //wasn't in this exact frame but is in the message. Use cached value
+                {
+                    bool isInteger = false;
+                    if (sig->valType == UNSIGNED_INT || sig->valType == SIGNED_INT) isInteger = true;
+                    tempString.append(sig->makePrettyOutput(sig->cachedValue, cachedValueAsInteger(sig->cachedValue), true, isInteger));
+                    tempString.append("\n");
+                }
             }
-            return tempString;
-        default:
-            return tempString;
         }
     }
-
-    return QVariant();
+    rendered.text[(int)Column::Data] = tempString;
 }
 
 QVariant CANFrameModel::headerData(int section, Qt::Orientation orientation,
@@ -650,10 +933,19 @@ bool CANFrameModel::any_busfilters_are_configured(void)
     return false;
 }
 
+bool CANFrameModel::passesFilters(const CANFrame &frame)
+{
+    if (!filters[frame.frameId()] || !busFilters[frame.bus]) return false;
+    return filterExpression.isEmpty() || filterExpression.matches(frame);
+}
+
 
+/*
+ * A single frame added straight from the GUI thread, like the sample row MainWindow measures at start up. Captured
+ * traffic doesn't come through here, it goes through addFrames and the capture thread.
+*/
 void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
 {
-    /*TODO: remove mutex */
     mutex.lock();
     CANFrame tempFrame;
     tempFrame = frame;
@@ -661,7 +953,9 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
     tempFrame.setTimeStamp(QCanBusFrame::TimeStamp(0, tempFrame.timeStamp().microSeconds() - timeOffset));
 
     lastUpdateNumFrames++;
+    captureObject->addStats(QVector<CANFrame>(1, tempFrame));
 
+    bool newFilters = false;
     //if this ID isn't found in the filters list then add it and show it by default
     if (!filters.contains(tempFrame.frameId()))
     {
@@ -671,6 +965,7 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
         else
             filters.insert(tempFrame.frameId(), true);
         needFilterRefresh = true;
+        newFilters = true;
     }
 
     //if this BusID isn't found in the busFilters list then add it and show it by default
@@ -682,15 +977,26 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
         else
             busFilters.insert(tempFrame.bus, true);
         needFilterRefresh = true;
+        newFilters = true;
     }
 
+    appendFrame(tempFrame, passesFilters(tempFrame), autoRefresh);
+    mutex.unlock();
+
+    //the capture thread needs to hear about these IDs or it'll decide for itself whether they start out enabled
+    if (newFilters) publishFilters();
+}
+
+//puts one frame on the end of the lists. Called with the mutex held
+void CANFrameModel::appendFrame(CANFrame &tempFrame, bool passes, bool autoRefresh)
+{
     if (!overwriteDups)
     {
         try
         {
             frames.append(tempFrame);
 
-            if (filters[tempFrame.frameId()] && busFilters[tempFrame.bus])
+            if (passes)
             {
                 if (autoRefresh) beginInsertRows(QModelIndex(), filteredFrames.count(), filteredFrames.count());
                 tempFrame.frameCount = 1;
@@ -724,6 +1030,7 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
                 tempFrame.frameCount = filteredFrames[i].frameCount + 1;
                 tempFrame.timedelta = tempFrame.timeStamp().microSeconds() - filteredFrames[i].timeStamp().microSeconds();
                 filteredFrames.replace(i, tempFrame);
+                filteredFramesChanged();
                 found = true;
                 break;
             }
@@ -732,7 +1039,7 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
         if (!found)
         {
             //frames.append(tempFrame);
-            if (filters[tempFrame.frameId()] && busFilters[tempFrame.bus])
+            if (passes)
             {
                 if (autoRefresh) beginInsertRows(QModelIndex(), filteredFrames.count(), filteredFrames.count());
                 tempFrame.frameCount = 1;
@@ -749,40 +1056,97 @@ void CANFrameModel::addFrame(const CANFrame& frame, bool autoRefresh = false)
                 {
                     if (autoRefresh) beginResetModel();
                     filteredFrames.replace(j, tempFrame);
+                    filteredFramesChanged();
                     if (autoRefresh) endResetModel();
                 }
             }
         }
     }
 
-    mutex.unlock();
 }
 
-
-void CANFrameModel::addFrames(const CANConnection*, const QVector<CANFrame>& pFrames)
+//drops the oldest 5% of frames from a list that's about to outgrow its preallocation. Called with the mutex held
+void CANFrameModel::trimFrames()
 {
     if(frames.length() > frames.capacity() * 0.99)
     {
-        mutex.lock();
         qDebug() << "Frames count: " << frames.length() << " of " << frames.capacity() << " capacity, removing first " << (int)(frames.capacity() * 0.05) << " frames";
         frames.remove(0, (int)(frames.capacity() * 0.05));
+        framesChanged();
         qDebug() << "Frames removed, new count: " << frames.length();
-        mutex.unlock();
     }
 
     if(filteredFrames.length() > filteredFrames.capacity() * 0.99)
     {
-        mutex.lock();
         qDebug() << "filteredFrames count: " << filteredFrames.length() << " of " << filteredFrames.capacity() << " capacity, removing first " << (int)(filteredFrames.capacity() * 0.05) << " frames";
         filteredFrames.remove(0, (int)(filteredFrames.capacity() * 0.05));
+        filteredFramesChanged();
         qDebug() << "filteredFrames removed, new count: " << filteredFrames.length();
-        mutex.unlock();
     }
+}
+
+//captured traffic from the connections. The per frame work all happens on the capture thread, see applyBatch
+void CANFrameModel::addFrames(const CANConnection*, const QVector<CANFrame>& pFrames)
+{
+    emit captureFrames(pFrames);
+}
+
+/*
+ * A batch back from the capture thread. Usually that's just tacking its frames onto both lists with one lock for the
+ * whole lot. If the filters changed while the batch was on its way, or the filter expression uses DBC signals, the
+ * frames get checked against the filters again here.
+*/
+void CANFrameModel::applyBatch(const CANFrameBatch &batch)
+{
+    if (batch.captureGeneration != captureGeneration) return; //captured before the last clear
+
+    mutex.lock();
+    trimFrames();
+
+    for (int i = 0; i < batch.newIDs.count(); i++)
+    {
+        if (filters.contains(batch.newIDs[i].first)) continue;
+        filters.insert(batch.newIDs[i].first, batch.newIDs[i].second);
+        needFilterRefresh = true;
+    }
+    for (int i = 0; i < batch.newBuses.count(); i++)
+    {
+        if (busFilters.contains(batch.newBuses[i].first)) continue;
+        busFilters.insert(batch.newBuses[i].first, batch.newBuses[i].second);
+        needFilterRefresh = true;
+    }
+
+    bool recheck = (batch.filterGeneration != filterGeneration) || !batch.filtersApplied;
+    if (recheck && filterExpression.needsResolve()) filterExpression.resolveSignals();
+    //timing was normalized after the capture thread stamped these
+    int64_t offsetFix = batch.timeOffset - timeOffset;
+    int count = batch.frames.count();
 
-    foreach(const CANFrame& frame, pFrames)
+    if (!overwriteDups)
     {
-        addFrame(frame);
+        int start = frames.count();
+        frames.append(batch.frames);
+        CANFrame *added = frames.data() + start;
+        for (int i = 0; i < count; i++)
+        {
+            if (offsetFix != 0) added[i].setTimeStamp(QCanBusFrame::TimeStamp(0, added[i].timeStamp().microSeconds() + offsetFix));
+            if (recheck ? !passesFilters(added[i]) : !batch.passed[i]) continue;
+            filteredFrames.append(added[i]);
+            filteredFrames.last().frameCount = 1;
+        }
     }
+    else //overwrite mode has to find each frame's ID in the filtered list so it goes one at a time
+    {
+        for (int i = 0; i < count; i++)
+        {
+            CANFrame frame = batch.frames[i];
+            if (offsetFix != 0) frame.setTimeStamp(QCanBusFrame::TimeStamp(0, frame.timeStamp().microSeconds() + offsetFix));
+            appendFrame(frame, recheck ? passesFilters(frame) : batch.passed[i], false);
+        }
+    }
+    lastUpdateNumFrames += count;
+    mutex.unlock();
+
     if (overwriteDups) //if in overwrite mode we'll update every time frames come in
     {
         beginResetModel();
@@ -790,10 +1154,23 @@ void CANFrameModel::addFrames(const CANConnection*, const QVector<CANFrame>& pFr
     }
 }
 
+//hands the capture thread a copy of the current filters. Anything it already sent back with an older generation gets checked again
+void CANFrameModel::publishFilters()
+{
+    filterGeneration++;
+    emit filtersChanged(filters, busFilters, filterExpression, filterGeneration);
+}
+
 void CANFrameModel::sendRefresh()
 {
     qDebug() << "Sending mass refresh";    
 
+    //every filter change ends up here so this is where the capture thread gets told about them
+    publishFilters();
+
+    //signals in the filter expression could have moved or gone away
+    if (filterExpression.needsResolve()) filterExpression.resolveSignals();
+
     if(overwriteDups)
     {
         recalcOverwrite();
@@ -804,7 +1181,7 @@ void CANFrameModel::sendRefresh()
         int count = frames.count();
         for (int i = 0; i < count; i++)
         {
-            if (filters[frames[i].frameId()] && busFilters[frames[i].bus])
+            if (passesFilters(frames[i]))
             {
                 tempContainer.append(frames[i]);
             }
@@ -815,6 +1192,7 @@ void CANFrameModel::sendRefresh()
         filteredFrames.clear();
         filteredFrames.append(tempContainer);
         filteredFrames.reserve(preallocSize);
+        filteredFramesChanged();
         lastUpdateNumFrames = 0;
         endResetModel();
         mutex.unlock();
@@ -843,6 +1221,12 @@ int CANFrameModel::sendBulkRefresh()
     beginResetModel();
     endResetModel();
 
+    //catch the indexes up with whatever came in since last time so they never have to do it all at once
+    mutex.lock();
+    frameIndex.update(frames);
+    filteredIndex.update(filteredFrames);
+    mutex.unlock();
+
     int num = lastUpdateNumFrames;
     lastUpdateNumFrames = 0;
 
@@ -855,6 +1239,8 @@ void CANFrameModel::clearFrames()
     this->beginResetModel();
     frames.clear();
     filteredFrames.clear();
+    filteredFramesChanged();
+    invalidateRenderCache();
     if(filtersPersistDuringClear == false)
     {
         filters.clear();
@@ -864,8 +1250,15 @@ void CANFrameModel::clearFrames()
     filteredFrames.reserve(preallocSize);
     this->endResetModel();
     lastUpdateNumFrames = 0;
+    framesChanged();
     mutex.unlock();
 
+    //cleared here so nobody sees old numbers, and again on the capture thread after anything it had in flight
+    captureObject->clearStats();
+    captureGeneration++;
+    emit captureReset(captureGeneration);
+    publishFilters();
+
     emit updatedFiltersList();
 }
 
@@ -880,8 +1273,11 @@ void CANFrameModel::insertFrames(const QVector<CANFrame> &newFrames)
     //and that refresh will cause the view to update. If you do both it usually ends up thinking you have
     //double the number of frames.
     //beginResetModel();
+    captureObject->addStats(newFrames);
     mutex.lock();
+    if (filterExpression.needsResolve()) filterExpression.resolveSignals();
     int insertedFiltered = 0;
+    bool newFilters = false;
     for (int i = 0; i < newFrames.count(); i++)
     {
         frames.append(newFrames[i]);
@@ -889,13 +1285,15 @@ void CANFrameModel::insertFrames(const QVector<CANFrame> &newFrames)
         {
             filters.insert(newFrames[i].frameId(), true);
             needFilterRefresh = true;
+            newFilters = true;
         }
-        if (filters[newFrames[i].frameId()])
+        if (!busFilters.contains(newFrames[i].bus))
         {
             busFilters.insert(newFrames[i].bus, true);
             needFilterRefresh = true;
+            newFilters = true;
         }
-        if (filters[newFrames[i].frameId()] && busFilters[newFrames[i].bus])
+        if (passesFilters(newFrames[i]))
         {
             insertedFiltered++;
             filteredFrames.append(newFrames[i]);
@@ -906,21 +1304,47 @@ void CANFrameModel::insertFrames(const QVector<CANFrame> &newFrames)
     //endResetModel();
     //beginInsertRows(QModelIndex(), filteredFrames.count() + 1, filteredFrames.count() + insertedFiltered);
     //endInsertRows();
+    if (newFilters) publishFilters();
     if (needFilterRefresh) emit updatedFiltersList();
 }
 
-int CANFrameModel::getIndexFromTimeID(unsigned int ID, double timestamp)
+/*
+ * Cuts the frame list down to a selection in place, the bisector's replace. The selection has to have been worked
+ * out over the list as it was at snapshot, otherwise nothing happens and this returns false. Frames that came in
+ * after the snapshot are dropped along with the unselected ones. The stats are rebuilt from what's left.
+*/
+bool CANFrameModel::keepFrames(const FrameSelection &selection, const CANFrameSnapshot &snapshot)
 {
-    int bestIndex = -1;
-    int64_t intTimeStamp = static_cast<int64_t> (timestamp * 1000000l);
-    for (int i = 0; i < frames.count(); i++)
+    mutex.lock();
+    if (snapshot.generation != frameGeneration || selection.total() != snapshot.count || frames.count() < snapshot.count)
     {
-        if ((frames[i].frameId() == ID))
-        {
-            if (frames[i].timeStamp().microSeconds() <= intTimeStamp) bestIndex = i;
-            else break; //drop out of loop as soon as we pass the proper timestamp
-        }
+        mutex.unlock();
+        return false;
     }
+    selection.keepIn(frames);
+    framesChanged();
+    lastUpdateNumFrames = 0;
+    mutex.unlock();
+
+    captureObject->clearStats();
+    captureObject->addStats(frames);
+    //rebuilds the filtered list from the frames that are left
+    sendRefresh();
+    return true;
+}
+
+/*
+ * Row in the filtered list (what the grid shows) of the newest frame with this ID at or before the timestamp.
+ * Used to line the grid up with wherever another window was clicked. Goes through the filtered list index so it's
+ * a binary search per bus the ID was seen on rather than a pass over every frame.
+*/
+int CANFrameModel::getIndexFromTimeID(unsigned int ID, double timestamp)
+{
+    int64_t intTimeStamp = static_cast<int64_t> (timestamp * 1000000l);
+    mutex.lock();
+    filteredIndex.update(filteredFrames);
+    int bestIndex = filteredIndex.rowForIDAtTime(filteredFrames, ID, intTimeStamp);
+    mutex.unlock();
     return bestIndex;
 }
 
@@ -972,6 +1396,81 @@ void CANFrameModel::saveFilterFile(QString filename)
     outFile->close();
 }
 
+//how many frames of each ID have come in since the last clear, all buses together
+QHash<uint32_t, uint64_t> CANFrameModel::getIDCounts()
+{
+    QHash<uint32_t, uint64_t> counts;
+    captureObject->readStats([&counts](const CANFrameStats &frameStats) { counts = frameStats.countsByID(); });
+    return counts;
+}
+
+QHash<uint32_t, double> CANFrameModel::getIDRates()
+{
+    QHash<uint32_t, double> rates;
+    captureObject->readStats([&rates](const CANFrameStats &frameStats) { rates = frameStats.ratesByID(); });
+    return rates;
+}
+
+/*
+ * Statistics for an ID (bus -1 for all buses) kept up as frames came in, so this is the same cost for ten frames
+ * or thirty million. They cover every frame since the last clear. With filteredOnly the answer is for the filtered
+ * list instead, which works by leaving out the buses that are filtered away. A filter expression can drop frames
+ * by their contents though and that can't be answered from here so it returns false and the caller has to count
+ * for itself.
+*/
+bool CANFrameModel::getIDStats(uint32_t id, int bus, CANIDStats &stats, bool filteredOnly, bool withDetail)
+{
+    if (withDetail) keepStatsDetail(id);
+
+    bool found = false;
+    captureObject->readStats([&](const CANFrameStats &frameStats)
+    {
+        if (!filteredOnly) found = frameStats.statsFor(id, bus, stats);
+        else if (filterExpression.isEmpty())
+        {
+            stats = CANIDStats();
+            if (filters.value(id, false))
+            {
+                QList<int> buses = frameStats.busesFor(id);
+                for (int i = 0; i < buses.count(); i++)
+                {
+                    if ((bus >= 0 && buses[i] != bus) || !busFilters.value(buses[i], false)) continue;
+                    CANIDStats busStats;
+                    if (frameStats.statsFor(id, buses[i], busStats)) stats.merge(busStats);
+                }
+            }
+            found = true;
+        }
+    });
+    return found;
+}
+
+/*
+ * The capture thread's statistics only keep histograms and interval percentiles for the few IDs somebody is looking
+ * at. Any bus this ID is on that doesn't have them yet gets counted once from the full list and handed over, after
+ * that they're kept up as frames come in. If frames arrive in between the counts won't match and the stats are left
+ * as they were, the caller can tell from hasDetail.
+*/
+void CANFrameModel::keepStatsDetail(uint32_t id)
+{
+    QList<int> missing;
+    captureObject->writeStats([&](CANFrameStats &frameStats)
+    {
+        QList<int> buses = frameStats.busesFor(id);
+        for (int i = 0; i < buses.count(); i++)
+        {
+            if (!frameStats.touchDetail(id, buses[i])) missing.append(buses[i]);
+        }
+    });
+
+    for (int i = 0; i < missing.count(); i++)
+    {
+        CANIDStats counted;
+        counted.addFrames(getFrameRows(&frames, id, missing[i]));
+        captureObject->writeStats([&](CANFrameStats &frameStats) { frameStats.setDetail(counted); });
+    }
+}
+
 bool CANFrameModel::needsFilterRefresh()
 {
     bool temp = needFilterRefresh;
@@ -1005,3 +1504,182 @@ const QMap<int, bool>* CANFrameModel::getBusFiltersReference() const
 {
     return &busFilters;
 }
+
+//called with the mutex held any time filteredFrames changes in some way other than new frames on the end
+void CANFrameModel::filteredFramesChanged()
+{
+    filteredGeneration++;
+    filteredIndex.reset();
+    renderCache.clear(); //cached rows are by row number and the rows just moved
+}
+
+//same thing for the full list
+void CANFrameModel::framesChanged()
+{
+    frameGeneration++;
+    frameIndex.reset();
+}
+
+/*
+ * The index over whichever of the two lists is passed in (getListReference or getFilteredListReference), brought
+ * up to date. This is the one copy of the rows per ID that all the windows share, so nothing needs its own cache of
+ * frames for an ID. GUI thread only since the index keeps growing as frames come in. nullptr for any other list.
+*/
+const CANFrameIndex *CANFrameModel::getFrameIndex(const QVector<CANFrame> *list)
+{
+    CANFrameIndex *index = nullptr;
+    mutex.lock();
+    if (list == &frames)
+    {
+        frameIndex.update(frames);
+        index = &frameIndex;
+    }
+    else if (list == &filteredFrames)
+    {
+        filteredIndex.update(filteredFrames);
+        index = &filteredIndex;
+    }
+    mutex.unlock();
+    return index;
+}
+
+//rows of an ID (bus -1 for every bus) in the given list, ready to be read like a list of frames. GUI thread only
+CANFrameRows CANFrameModel::getFrameRows(const QVector<CANFrame> *list, uint32_t id, int bus)
+{
+    const CANFrameIndex *index = getFrameIndex(list);
+    if (!index) return CANFrameRows();
+    const int *generation = (list == &frames) ? &frameGeneration : &filteredGeneration;
+    if (bus == -1) return CANFrameRows(list, index->rowsMatching(id, id, -1), generation);
+    return CANFrameRows(list, index->rowsFor(id, bus), generation);
+}
+
+/*
+ * Brings the index of filteredFrames up to date and gives the caller its own copy of it. The copy is good
+ * for as long as the returned generation matches. Meant for things like searching that want to
+ * work out which rows to look at on another thread.
+*/
+int CANFrameModel::snapshotFilteredIndex(CANFrameIndex &copy)
+{
+    mutex.lock();
+    filteredIndex.update(filteredFrames);
+    copy = filteredIndex;
+    int generation = filteredGeneration;
+    mutex.unlock();
+    return generation;
+}
+
+//same as snapshotFilteredIndex but for the full list. Rows out of the copy go to copyFrames along with the snapshot
+CANFrameSnapshot CANFrameModel::snapshotFrameIndex(CANFrameIndex &copy)
+{
+    CANFrameSnapshot snapshot;
+    mutex.lock();
+    frameIndex.update(frames);
+    copy = frameIndex;
+    snapshot.count = frames.count();
+    snapshot.generation = frameGeneration;
+    mutex.unlock();
+    return snapshot;
+}
+
+/*
+ * Copies rows [start, end) of filteredFrames for another thread to go through. The model is only locked for
+ * COPY_CHUNK rows at a time so new frames from the capture thread never wait behind a big copy. Anything that
+ * rewrites the list bumps the generation, so checking it again after each relock is enough to know the rows
+ * still point at the same frames. Returns false and leaves copy empty if the list changed along the way.
+*/
+bool CANFrameModel::copyFilteredFrames(int generation, int start, int end, QVector<CANFrame> &copy)
+{
+    copy.clear();
+    if (start < 0 || start > end) return false;
+    copy.reserve(end - start);
+    //always goes around at least once so a stale generation is caught even with nothing to copy
+    for (int pos = start; pos < end || pos == start; pos += COPY_CHUNK)
+    {
+        mutex.lock();
+        if (generation != filteredGeneration || end > filteredFrames.count())
+        {
+            mutex.unlock();
+            copy.clear();
+            return false;
+        }
+        int stop = qMin(end, pos + COPY_CHUNK);
+        for (int i = pos; i < stop; i++) copy.append(filteredFrames[i]);
+        mutex.unlock();
+    }
+    return true;
+}
+
+//same but only the given rows, in the order they're given
+bool CANFrameModel::copyFilteredFrames(int generation, const QVector<int> &rows, QVector<CANFrame> &copy)
+{
+    copy.clear();
+    copy.reserve(rows.count());
+    for (int pos = 0; pos < rows.count() || pos == 0; pos += COPY_CHUNK)
+    {
+        mutex.lock();
+        if (generation != filteredGeneration)
+        {
+            mutex.unlock();
+            copy.clear();
+            return false;
+        }
+        int stop = qMin(rows.count(), pos + COPY_CHUNK);
+        for (int i = pos; i < stop; i++)
+        {
+            if (rows[i] < 0 || rows[i] >= filteredFrames.count())
+            {
+                mutex.unlock();
+                copy.clear();
+                return false;
+            }
+            copy.append(filteredFrames[rows[i]]);
+        }
+        mutex.unlock();
+    }
+    return true;
+}
+
+//how far the full frame list goes right now. Hand it back to copyFrames to read up to there from another thread
+CANFrameSnapshot CANFrameModel::getFrameSnapshot()
+{
+    CANFrameSnapshot snapshot;
+    mutex.lock();
+    snapshot.count = frames.count();
+    snapshot.generation = frameGeneration;
+    mutex.unlock();
+    return snapshot;
+}
+
+/*
+ * Same idea as copyFilteredFrames but for the full list, also COPY_CHUNK rows per lock. The rows have to be inside
+ * the snapshot. Returns false and leaves copy empty if the list has been cleared, trimmed or rewritten since the
+ * snapshot was taken.
+*/
+bool CANFrameModel::copyFrames(const CANFrameSnapshot &snapshot, const QVector<int> &rows, QVector<CANFrame> &copy)
+{
+    copy.clear();
+    copy.reserve(rows.count());
+    for (int pos = 0; pos < rows.count() || pos == 0; pos += COPY_CHUNK)
+    {
+        mutex.lock();
+        if (snapshot.generation != frameGeneration || snapshot.count > frames.count())
+        {
+            mutex.unlock();
+            copy.clear();
+            return false;
+        }
+        int stop = qMin(rows.count(), pos + COPY_CHUNK);
+        for (int i = pos; i < stop; i++)
+        {
+            if (rows[i] < 0 || rows[i] >= snapshot.count)
+            {
+                mutex.unlock();
+                copy.clear();
+                return false;
+            }
+            copy.append(frames[rows[i]]);
+        }
+        mutex.unlock();
+    }
+    return true;
+}
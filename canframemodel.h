@@ -6,7 +6,14 @@
 #include <QVector>
 #include <QDebug>
 #include <QMutex>
+#include <QCache>
+#include <QHash>
 #include "can_structs.h"
+#include "canframeindex.h"
+#include "canframestats.h"
+#include "framecaptureobject.h"
+#include "canfilterexpression.h"
+#include "frameselection.h"
 #include "dbc/dbchandler.h"
 #include "connections/canconnection.h"
 #include "utility.h"
@@ -24,6 +31,38 @@ enum class Column {
     NUM_COLUMN
 };
 
+/*
+ * Everything the grid shows for one row, formatted once and then handed back on every repaint until the row changes.
+ * The frame fields at the top identify which frame the text was made from. Rows move around when sorting, filtering
+ * or trimming old frames so a cached row is only used if the frame now sitting at that row still matches.
+*/
+class CANFrameRenderedRow
+{
+public:
+    int64_t timeStamp;
+    uint64_t timedelta;
+    uint32_t frameId;
+    int bus;
+    uint32_t frameCount;
+    bool isReceived;
+    QByteArray payload; //shares the frame's bytes, only there to be compared
+    DBC_MESSAGE *msg; //message this frame decoded as at the time, used for colors
+    QString text[(int)Column::NUM_COLUMN];
+};
+
+/*
+ * How much of the full frame list someone has seen. generation goes up whenever the list is rewritten in any way other
+ * than new frames on the end (cleared, trimmed, timing normalized) so a snapshot with the current generation means the
+ * first count frames are exactly the ones that were there when it was taken.
+*/
+class CANFrameSnapshot
+{
+public:
+    CANFrameSnapshot() : count(0), generation(-1) {}
+    int count;
+    int generation;
+};
+
 class CANFrameModel: public QAbstractTableModel
 {
     Q_OBJECT
@@ -53,6 +92,9 @@ public:
     void setFilterState(unsigned int ID, bool state);
     void setBusFilterState(unsigned int BusID, bool state);
     void setAllFilters(bool state);
+    bool setFilterExpression(QString text);
+    QString getFilterExpression() const;
+    QString getFilterExpressionError() const;
     void setTimeFormat(QString);
     void setBytesPerLine(int bpl);
     void loadFilterFile(QString filename);
@@ -60,13 +102,27 @@ public:
     void normalizeTiming();
     void recalcOverwrite();
     bool needsFilterRefresh();
+    QHash<uint32_t, uint64_t> getIDCounts();
+    QHash<uint32_t, double> getIDRates();
+    bool getIDStats(uint32_t id, int bus, CANIDStats &stats, bool filteredOnly, bool withDetail = false);
     void insertFrames(const QVector<CANFrame> &newFrames);
+    bool keepFrames(const FrameSelection &selection, const CANFrameSnapshot &snapshot);
     void sortByColumn(int column);
     int getIndexFromTimeID(unsigned int ID, double timestamp);
+    int getRowLineCount(int row) const;
+    int getMaxLineCount();
     const QVector<CANFrame> *getListReference() const; //thou shalt not modify these frames externally!
     const QVector<CANFrame> *getFilteredListReference() const; //Thus saith the Lord, NO.
     const QMap<int, bool> *getFiltersReference() const; //this neither
     const QMap<int, bool> *getBusFiltersReference() const; //this neither
+    const CANFrameIndex *getFrameIndex(const QVector<CANFrame> *list);
+    CANFrameRows getFrameRows(const QVector<CANFrame> *list, uint32_t id, int bus = -1);
+    int snapshotFilteredIndex(CANFrameIndex &copy);
+    bool copyFilteredFrames(int generation, int start, int end, QVector<CANFrame> &copy);
+    bool copyFilteredFrames(int generation, const QVector<int> &rows, QVector<CANFrame> &copy);
+    CANFrameSnapshot getFrameSnapshot();
+    CANFrameSnapshot snapshotFrameIndex(CANFrameIndex &copy);
+    bool copyFrames(const CANFrameSnapshot &snapshot, const QVector<int> &rows, QVector<CANFrame> &copy);
 
 public slots:
     void addFrame(const CANFrame&, bool);
@@ -74,18 +130,46 @@ public slots:
 
 signals:
     void updatedFiltersList();
+    //to the capture thread
+    void captureFrames(const QVector<CANFrame> &frames);
+    void filtersChanged(const QMap<int, bool> &filters, const QMap<int, bool> &busFilters, const CANFilterExpression &expression, int generation);
+    void timeOffsetChanged(qint64 offset);
+    void captureReset(int generation);
+
+private slots:
+    void applyBatch(const CANFrameBatch &batch);
 
 private:
-    void qSortCANFrameAsc(QVector<CANFrame>* frames, Column column, int lowerBound, int upperBound);
-    void qSortCANFrameDesc(QVector<CANFrame>* frames, Column column, int lowerBound, int upperBound);
-    uint64_t getCANFrameVal(QVector<CANFrame> *frames, int row, Column col);
+    uint64_t getCANFrameVal(const CANFrame &frame, Column col) const;
+    const CANFrameRenderedRow *getRenderedRow(int row) const;
+    void renderRow(const CANFrame &frame, CANFrameRenderedRow &rendered) const;
+    DBC_MESSAGE *lookupMessage(const CANFrame &frame) const;
+    int lineCountFor(const CANFrame &frame, bool worstCase) const;
+    static int errorLineCount(const CANFrame &frame);
+    void keepStatsDetail(uint32_t id);
+    void invalidateRenderCache() const;
+    void checkDBCGeneration() const;
+    void filteredFramesChanged();
+    void framesChanged();
     bool any_filters_are_configured(void);
     bool any_busfilters_are_configured(void);
+    bool passesFilters(const CANFrame &frame);
+    void appendFrame(CANFrame &frame, bool passes, bool autoRefresh);
+    void trimFrames();
+    void publishFilters();
 
     QVector<CANFrame> frames;
     QVector<CANFrame> filteredFrames;
     QMap<int, bool> filters;
     QMap<int, bool> busFilters;
+    //does the per frame work for captured traffic on its own thread. Also keeps the per ID and bus statistics,
+    //every frame since the last clear whether it's filtered out or not
+    FrameCaptureObject *captureObject;
+    int filterGeneration;   //bumped every time the filters sent to captureObject change
+    int captureGeneration;  //bumped on every clear
+    int frameGeneration;    //bumped whenever frames is rewritten rather than appended to
+    CANFilterExpression filterExpression; //on top of the ID and bus checkboxes. Empty lets everything through
+    QString filterExpressionError;
     DBCHandler *dbcHandler;
     QMutex mutex;
     bool interpretFrames; //should we use the dbcHandler?
@@ -101,6 +185,22 @@ private:
     uint32_t preallocSize;
     bool sortDirAsc;
     int bytesPerLine;
+    //formatted rows and per ID message lookups. Both get tossed whenever a display setting or the DBC generation changes
+    mutable QCache<int, CANFrameRenderedRow> renderCache;
+    mutable QHash<uint64_t, DBC_MESSAGE*> messageCache;
+    //lines of text per bus, ID and length for everything that doesn't depend on the payload. Tossed along with the others
+    struct RowLineInfo
+    {
+        int fixedLines;
+        bool hasMux; //set when multiplexed signals have to be counted frame by frame
+    };
+    mutable QHash<uint64_t, RowLineInfo> lineCountCache;
+    mutable int renderDBCGeneration;
+    //index over frames, reset along with every frameGeneration bump
+    CANFrameIndex frameIndex;
+    //index over filteredFrames. The generation goes up whenever filteredFrames changes other than by appending
+    CANFrameIndex filteredIndex;
+    int filteredGeneration;
 };
 
 
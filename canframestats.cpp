@@ -0,0 +1,401 @@
+#include "canframestats.h"
+#include "canframeindex.h"
+#include "bitactivity.h"
+
+#include <cmath>
+
+CANIDStats::CANIDStats(bool keepDetail) : intervals(50.0)
+{
+    detailed = keepDetail;
+    id = 0;
+    bus = 0;
+    count = 0;
+    firstTime = 0;
+    lastTime = 0;
+    intervalCount = 0;
+    minInterval = 0;
+    maxInterval = 0;
+    minLen = 0;
+    maxLen = 0;
+    meanInterval = 0.0;
+    intervalM2 = 0.0;
+    prevTime = 0;
+    seenLen = 0;
+}
+
+void CANIDStats::growTo(int len)
+{
+    int old = minData.count();
+    if (len <= old) return;
+
+    minData.resize(len);
+    maxData.resize(len);
+    changedBits.resize(len);
+    firstData.resize(len);
+    lastData.resize(len);
+    for (int c = old; c < len; c++)
+    {
+        minData[c] = 0xFF;
+        maxData[c] = 0;
+        changedBits[c] = 0;
+    }
+    bitFlipCounts.resize(len * 8);
+    if (detailed)
+    {
+        bitSetCounts.resize(len * 8);
+        byteHistogram.resize(qMin(len, STATS_HISTOGRAM_BYTES) * 256);
+    }
+}
+
+//everything but the payload bytes. Doesn't bump count, that's left for after the bytes are done
+void CANIDStats::addTiming(const CANFrame &frame, int len)
+{
+    int64_t stamp = frame.timeStamp().microSeconds();
+
+    if (count == 0)
+    {
+        id = frame.frameId();
+        bus = frame.bus;
+        firstTime = stamp;
+        lastTime = stamp;
+        minLen = len;
+        maxLen = len;
+    }
+    else
+    {
+        //frames aren't always in time order so go whichever way doesn't come out negative
+        int64_t interval = (stamp > prevTime) ? (stamp - prevTime) : (prevTime - stamp);
+        if (intervalCount == 0 || interval < minInterval) minInterval = interval;
+        if (intervalCount == 0 || interval > maxInterval) maxInterval = interval;
+        intervalCount++;
+        double delta = interval - meanInterval;
+        meanInterval += delta / intervalCount;
+        intervalM2 += delta * (interval - meanInterval);
+        if (detailed) intervals.add(static_cast<double>(interval));
+
+        if (stamp < firstTime) firstTime = stamp;
+        if (stamp > lastTime) lastTime = stamp;
+        if (len < minLen) minLen = len;
+        if (len > maxLen) maxLen = len;
+    }
+    prevTime = stamp;
+
+    if (len >= lengthCounts.count()) lengthCounts.resize(len + 1);
+    lengthCounts[len]++;
+}
+
+void CANIDStats::addFrame(const CANFrame &frame)
+{
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
+    int len = frame.payload().length();
+
+    addTiming(frame, len);
+    growTo(len);
+    uint8_t *minPtr = minData.data();
+    uint8_t *maxPtr = maxData.data();
+    uint8_t *changedPtr = changedBits.data();
+    uint8_t *firstPtr = firstData.data();
+    uint8_t *lastPtr = lastData.data();
+    uint64_t *setPtr = detailed ? bitSetCounts.data() : nullptr;
+    uint64_t *flipPtr = bitFlipCounts.data();
+    uint64_t *histPtr = detailed ? byteHistogram.data() : nullptr;
+
+    for (int c = 0; c < len; c++)
+    {
+        uint8_t dat = data[c];
+        if (dat < minPtr[c]) minPtr[c] = dat;
+        if (dat > maxPtr[c]) maxPtr[c] = dat;
+        if (setPtr)
+        {
+            if (c < STATS_HISTOGRAM_BYTES) histPtr[c * 256 + dat]++;
+            for (int l = 0; l < 8; l++)
+            {
+                if (dat & (1 << l)) setPtr[c * 8 + l]++;
+            }
+        }
+
+        if (c < seenLen)
+        {
+            changedPtr[c] |= firstPtr[c] ^ dat;
+            //most bytes hold still from one frame to the next so this usually gets skipped
+            uint8_t flipped = lastPtr[c] ^ dat;
+            if (flipped)
+            {
+                for (int l = 0; l < 8; l++)
+                {
+                    if (flipped & (1 << l)) flipPtr[c * 8 + l]++;
+                }
+            }
+        }
+        else firstPtr[c] = dat; //first time this byte has shown up, everything after gets compared to it
+        lastPtr[c] = dat;
+    }
+    if (len > seenLen) seenLen = len;
+    count++;
+}
+
+/*
+ * Same numbers as calling addFrame for every row but the payload side goes through BitActivity a word at a time
+ * instead of a bit at a time. Made for building stats up from nothing. If there's already something here the rows
+ * get added up on their own and merged in so the flips between the old last frame and the new first one are lost.
+*/
+void CANIDStats::addFrames(const CANFrameRows &rows)
+{
+    if (rows.isEmpty()) return;
+    if (count > 0)
+    {
+        CANIDStats batch(detailed);
+        batch.addFrames(rows);
+        merge(batch);
+        return;
+    }
+
+    for (int i = 0; i < rows.count(); i++)
+    {
+        addTiming(rows[i], rows[i].payload().length());
+        count++;
+    }
+
+    BitActivity activity;
+    activity.addFrames(rows);
+    minData = activity.minData;
+    maxData = activity.maxData;
+    changedBits = activity.changedBits;
+    firstData = activity.firstData;
+    lastData = activity.lastData;
+    bitFlipCounts = activity.bitFlipCounts;
+    if (detailed)
+    {
+        bitSetCounts = activity.bitSetCounts;
+        byteHistogram = activity.byteHistogram;
+    }
+    seenLen = activity.byteCount();
+}
+
+bool CANIDStats::hasDetail() const
+{
+    return detailed;
+}
+
+void CANIDStats::dropDetail()
+{
+    detailed = false;
+    bitSetCounts.clear();
+    byteHistogram.clear();
+    intervals.clear();
+}
+
+/*
+ * Folds another set of stats for the same ID into this one, used to combine buses. Intervals aren't recomputed
+ * across the two so they stay the gaps within each bus.
+*/
+void CANIDStats::merge(const CANIDStats &other)
+{
+    if (other.count == 0) return;
+    if (count == 0)
+    {
+        *this = other;
+        return;
+    }
+
+    if (other.firstTime < firstTime) firstTime = other.firstTime;
+    if (other.lastTime > lastTime) lastTime = other.lastTime;
+    if (other.minLen < minLen) minLen = other.minLen;
+    if (other.maxLen > maxLen) maxLen = other.maxLen;
+
+    if (other.intervalCount > 0)
+    {
+        if (intervalCount == 0 || other.minInterval < minInterval) minInterval = other.minInterval;
+        if (intervalCount == 0 || other.maxInterval > maxInterval) maxInterval = other.maxInterval;
+        //Chan's way of combining two running means and sums of squares
+        double total = static_cast<double>(intervalCount + other.intervalCount);
+        double delta = other.meanInterval - meanInterval;
+        intervalM2 += other.intervalM2 + delta * delta * intervalCount * other.intervalCount / total;
+        meanInterval += delta * other.intervalCount / total;
+        intervalCount += other.intervalCount;
+        if (detailed && other.detailed) intervals.merge(other.intervals);
+    }
+    count += other.count;
+
+    if (other.lengthCounts.count() > lengthCounts.count()) lengthCounts.resize(other.lengthCounts.count());
+    for (int i = 0; i < other.lengthCounts.count(); i++) lengthCounts[i] += other.lengthCounts[i];
+
+    int otherSeen = other.seenLen;
+    growTo(other.minData.count());
+    for (int c = 0; c < other.minData.count(); c++)
+    {
+        if (other.minData[c] < minData[c]) minData[c] = other.minData[c];
+        if (other.maxData[c] > maxData[c]) maxData[c] = other.maxData[c];
+        changedBits[c] |= other.changedBits[c];
+        if (c < otherSeen)
+        {
+            if (c < seenLen) changedBits[c] |= firstData[c] ^ other.firstData[c];
+            else
+            {
+                firstData[c] = other.firstData[c];
+                lastData[c] = other.lastData[c];
+            }
+        }
+    }
+    if (otherSeen > seenLen) seenLen = otherSeen;
+    for (int i = 0; i < other.bitFlipCounts.count(); i++) bitFlipCounts[i] += other.bitFlipCounts[i];
+    if (detailed && other.detailed)
+    {
+        for (int i = 0; i < other.bitSetCounts.count(); i++) bitSetCounts[i] += other.bitSetCounts[i];
+        for (int i = 0; i < other.byteHistogram.count(); i++) byteHistogram[i] += other.byteHistogram[i];
+    }
+    else if (detailed) dropDetail(); //half the detail is missing so none of it would be right
+}
+
+double CANIDStats::intervalMean() const
+{
+    return meanInterval;
+}
+
+double CANIDStats::intervalStdDev() const
+{
+    if (intervalCount == 0) return 0.0;
+    return sqrt(intervalM2 / intervalCount);
+}
+
+double CANIDStats::intervalPercentile(double q) const
+{
+    return intervals.quantile(q);
+}
+
+uint64_t CANIDStats::intervalsAtOrBelow(int64_t interval) const
+{
+    if (intervalCount == 0) return 0;
+    return static_cast<uint64_t>(qRound64(intervals.cdf(static_cast<double>(interval)) * intervalCount));
+}
+
+double CANIDStats::rate() const
+{
+    if (count < 2 || lastTime <= firstTime) return 0.0;
+    return (count - 1) * 1000000.0 / (lastTime - firstTime);
+}
+
+int CANIDStats::byteCount() const
+{
+    return minData.count();
+}
+
+void CANFrameStats::clear()
+{
+    stats.clear();
+    busesByID.clear();
+    detailedKeys.clear();
+}
+
+void CANFrameStats::addFrame(const CANFrame &frame)
+{
+    uint64_t key = CANFrameIndex::makeKey(frame.frameId(), frame.bus);
+    QHash<uint64_t, CANIDStats>::iterator it = stats.find(key);
+    if (it == stats.end())
+    {
+        it = stats.insert(key, CANIDStats(false));
+        busesByID[frame.frameId()].append(frame.bus);
+    }
+    it->addFrame(frame);
+}
+
+//number of distinct ID and bus pairs
+int CANFrameStats::count() const
+{
+    return stats.count();
+}
+
+QList<int> CANFrameStats::busesFor(uint32_t id) const
+{
+    return busesByID.value(id);
+}
+
+//bus of -1 combines every bus the ID was seen on. False if the ID (or ID and bus) never showed up
+bool CANFrameStats::statsFor(uint32_t id, int bus, CANIDStats &out) const
+{
+    out = CANIDStats();
+    if (bus >= 0)
+    {
+        QHash<uint64_t, CANIDStats>::const_iterator it = stats.constFind(CANFrameIndex::makeKey(id, bus));
+        if (it == stats.constEnd()) return false;
+        out = it.value();
+        return true;
+    }
+
+    QList<int> buses = busesByID.value(id);
+    for (int i = 0; i < buses.count(); i++) out.merge(stats.value(CANFrameIndex::makeKey(id, buses[i])));
+    return !buses.isEmpty();
+}
+
+//frame count per ID with all buses added together
+QHash<uint32_t, uint64_t> CANFrameStats::countsByID() const
+{
+    QHash<uint32_t, uint64_t> counts;
+    counts.reserve(busesByID.count());
+    for (QHash<uint64_t, CANIDStats>::const_iterator it = stats.constBegin(); it != stats.constEnd(); ++it)
+    {
+        counts[it.value().id] += it.value().count;
+    }
+    return counts;
+}
+
+//frames per second per ID with all buses added together, over the time between the ID's first and last frame
+QHash<uint32_t, double> CANFrameStats::ratesByID() const
+{
+    QHash<uint32_t, double> rates;
+    rates.reserve(busesByID.count());
+    for (QHash<uint32_t, QList<int>>::const_iterator it = busesByID.constBegin(); it != busesByID.constEnd(); ++it)
+    {
+        uint64_t total = 0;
+        int64_t first = 0, last = 0;
+        for (int i = 0; i < it.value().count(); i++)
+        {
+            const CANIDStats &busStats = *stats.constFind(CANFrameIndex::makeKey(it.key(), it.value()[i]));
+            if (i == 0 || busStats.firstTime < first) first = busStats.firstTime;
+            if (i == 0 || busStats.lastTime > last) last = busStats.lastTime;
+            total += busStats.count;
+        }
+        rates.insert(it.key(), (total < 2 || last <= first) ? 0.0 : (total - 1) * 1000000.0 / (last - first));
+    }
+    return rates;
+}
+
+bool CANFrameStats::hasDetail(uint32_t id, int bus) const
+{
+    QHash<uint64_t, CANIDStats>::const_iterator it = stats.constFind(CANFrameIndex::makeKey(id, bus));
+    return it != stats.constEnd() && it.value().hasDetail();
+}
+
+/*
+ * Swaps in stats with detail for an ID and bus, counted from the frames the table entry was made from. If more frames
+ * have come in since they were counted the counts won't line up so nothing happens and false comes back. From here
+ * on addFrame keeps the detail going. Once more than STATS_DETAILED_KEYS pairs have detail the one that got it
+ * longest ago goes back to without.
+*/
+bool CANFrameStats::setDetail(const CANIDStats &counted)
+{
+    if (!counted.hasDetail()) return false;
+    uint64_t key = CANFrameIndex::makeKey(counted.id, counted.bus);
+    QHash<uint64_t, CANIDStats>::iterator it = stats.find(key);
+    if (it == stats.end() || it->count != counted.count) return false;
+
+    if (!it->hasDetail()) *it = counted;
+    detailedKeys.removeOne(key);
+    detailedKeys.append(key);
+
+    while (detailedKeys.count() > STATS_DETAILED_KEYS)
+    {
+        QHash<uint64_t, CANIDStats>::iterator oldest = stats.find(detailedKeys.takeFirst());
+        if (oldest != stats.end()) oldest->dropDetail();
+    }
+    return true;
+}
+
+//moves a pair that already has detail to the back of the line so it's the last to lose it
+bool CANFrameStats::touchDetail(uint32_t id, int bus)
+{
+    uint64_t key = CANFrameIndex::makeKey(id, bus);
+    if (!detailedKeys.removeOne(key)) return false;
+    detailedKeys.append(key);
+    return true;
+}
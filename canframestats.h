@@ -0,0 +1,102 @@
+#ifndef CANFRAMESTATS_H
+#define CANFRAMESTATS_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include "can_structs.h"
+#include "utils/tdigest.h"
+
+class CANFrameRows;
+
+#define STATS_HISTOGRAM_BYTES   8   //value histograms are 256 counters a byte so only the first few bytes get one
+#define STATS_DETAILED_KEYS     16  //ID and bus pairs CANFrameStats keeps detail for at once
+
+/*
+ * Running statistics for one ID on one bus. Every frame gets folded in as it arrives so asking for the numbers later
+ * costs nothing no matter how many frames there were. Intervals are the gap to the previous frame of this ID and bus
+ * in the order the frames came in. The per byte and per bit arrays grow to the longest payload seen.
+ *
+ * Stats made without detail leave out the value histogram, the per bit set counts and the interval percentiles. Those
+ * are most of the memory and only matter for an ID somebody is looking at.
+ *
+ * All the arrays are implicitly shared so handing out a copy is cheap.
+*/
+class CANIDStats
+{
+public:
+    explicit CANIDStats(bool keepDetail = true);
+    void addFrame(const CANFrame &frame);
+    void addFrames(const CANFrameRows &rows);
+    void merge(const CANIDStats &other);
+    bool hasDetail() const;
+    void dropDetail();
+
+    double intervalMean() const;    //all intervals are in microseconds
+    double intervalStdDev() const;  //jitter
+    double intervalPercentile(double q) const;  //needs detail
+    uint64_t intervalsAtOrBelow(int64_t interval) const;   //needs detail, approximate
+    double rate() const;            //frames per second between the first and last frame
+    int byteCount() const;          //longest payload seen
+
+    uint32_t id;
+    int bus;
+    uint64_t count;
+    int64_t firstTime;
+    int64_t lastTime;
+
+    uint64_t intervalCount;
+    int64_t minInterval;
+    int64_t maxInterval;
+
+    int minLen;
+    int maxLen;
+    QVector<uint64_t> lengthCounts;     //index is payload length
+
+    QVector<uint8_t> minData;
+    QVector<uint8_t> maxData;
+    QVector<uint8_t> changedBits;       //bits that have ever differed from the first value seen for that byte
+    QVector<uint64_t> bitSetCounts;     //byte * 8 + bit. Needs detail
+    QVector<uint64_t> bitFlipCounts;    //how many times each bit changed from one frame to the next
+    QVector<uint64_t> byteHistogram;    //byte * 256 + value for the first STATS_HISTOGRAM_BYTES bytes. Needs detail
+
+private:
+    void growTo(int len);
+    void addTiming(const CANFrame &frame, int len);
+
+    bool detailed;
+    double meanInterval;    //Welford running mean and sum of squares so the deviation never needs a second pass
+    double intervalM2;
+    TDigest intervals;
+    int64_t prevTime;
+    QVector<uint8_t> firstData;
+    QVector<uint8_t> lastData;
+    int seenLen;    //how many bytes firstData and lastData hold real values for
+};
+
+/*
+ * One CANIDStats per ID and bus. CANFrameModel feeds every captured or loaded frame through here. There can be
+ * thousands of IDs so these are kept without detail, except for the last STATS_DETAILED_KEYS pairs somebody handed
+ * to setDetail. Those keep their detail up to date as frames come in so showing them again costs nothing.
+*/
+class CANFrameStats
+{
+public:
+    void clear();
+    void addFrame(const CANFrame &frame);
+    int count() const;
+    QList<int> busesFor(uint32_t id) const;
+    bool statsFor(uint32_t id, int bus, CANIDStats &out) const;
+    QHash<uint32_t, uint64_t> countsByID() const;
+    QHash<uint32_t, double> ratesByID() const;
+    bool hasDetail(uint32_t id, int bus) const;
+    bool setDetail(const CANIDStats &counted);
+    bool touchDetail(uint32_t id, int bus);
+
+private:
+    QHash<uint64_t, CANIDStats> stats;
+    QHash<uint32_t, QList<int>> busesByID;
+    QList<uint64_t> detailedKeys;  //oldest first
+};
+
+#endif // CANFRAMESTATS_H
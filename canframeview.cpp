@@ -0,0 +1,37 @@
+#include "canframeview.h"
+#include "canframemodel.h"
+
+#include <QAbstractProxyModel>
+
+CANFrameView::CANFrameView(QWidget *parent) : QTableView(parent)
+{
+    frameModel = nullptr;
+    baseRowHeight = 0;
+}
+
+void CANFrameView::setFrameModel(CANFrameModel *frameModel)
+{
+    this->frameModel = frameModel;
+}
+
+void CANFrameView::setBaseRowHeight(int height)
+{
+    baseRowHeight = height;
+}
+
+int CANFrameView::heightForLines(int lines) const
+{
+    return baseRowHeight + (qMax(1, lines) - 1) * fontMetrics().lineSpacing();
+}
+
+int CANFrameView::sizeHintForRow(int row) const
+{
+    //the single line height gets measured the normal way first, everything after that is counted
+    if (frameModel == nullptr || baseRowHeight == 0) return QTableView::sizeHintForRow(row);
+
+    int sourceRow = row;
+    QAbstractProxyModel *proxy = qobject_cast<QAbstractProxyModel *>(model());
+    if (proxy) sourceRow = proxy->mapToSource(proxy->index(row, 0)).row();
+
+    return heightForLines(frameModel->getRowLineCount(sourceRow));
+}
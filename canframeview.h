@@ -0,0 +1,33 @@
+#ifndef CANFRAMEVIEW_H
+#define CANFRAMEVIEW_H
+
+#include <QTableView>
+
+class CANFrameModel;
+
+/*
+ * The main frame grid. The only thing it does differently from a plain QTableView is how tall it thinks a row
+ * should be. QTableView asks the delegate for every cell which means formatting the interpreted text of every row
+ * just to measure it. Here the height comes from how many lines the model says the row will have so expanding
+ * rows costs about the same as counting them.
+*/
+class CANFrameView : public QTableView
+{
+    Q_OBJECT
+
+public:
+    explicit CANFrameView(QWidget *parent = 0);
+
+    void setFrameModel(CANFrameModel *frameModel);
+    void setBaseRowHeight(int height);
+    int heightForLines(int lines) const;
+
+protected:
+    int sizeHintForRow(int row) const override;
+
+private:
+    CANFrameModel *frameModel;
+    int baseRowHeight; //height of a row with a single line of text. 0 until it's been measured
+};
+
+#endif // CANFRAMEVIEW_H
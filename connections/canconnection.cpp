@@ -338,7 +338,12 @@ bool CANConnection::removeTargettedFrame(int pBusId, uint32_t ID, uint32_t mask,
     target.id = ID;
     target.mask = mask;
     target.observer = receiver;
-    mBusData[pBusId].mTargettedFrames.removeAll(target);
+    if (pBusId > -1)
+        mBusData[pBusId].mTargettedFrames.removeAll(target);
+    else
+    {
+        for (int i = 0; i < mBusData.count(); i++) mBusData[i].mTargettedFrames.removeAll(target);
+    }
 
     return true;
 }
@@ -2,6 +2,81 @@
 #include "dbchandler.h"
 #include "utility.h"
 #include <QtMath>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QAtomicInt>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+//The pool is global rather than per file because the same attribute names and units show up in every DBC.
+//DBC files are normally loaded from the GUI thread but the lock keeps things sane if something else touches the pool.
+static QMutex poolMutex;
+static QHash<QString, int> attrNameIds; //keyed by lower case name since attribute names are case insensitive
+static QVector<QString> attrNames;
+static QSet<QString> stringPool;
+//every stamp handed out is new so a deleted message can't be mistaken for a new one that took over its ID
+static QAtomicInt messageStamps(0);
+
+int DBCStringPool::internAttrName(const QString &name)
+{
+    QString key = name.toLower();
+    poolMutex.lock();
+    int id = attrNameIds.value(key, -1);
+    if (id == -1)
+    {
+        id = attrNames.count();
+        attrNames.append(name);
+        attrNameIds.insert(key, id);
+    }
+    poolMutex.unlock();
+    return id;
+}
+
+int DBCStringPool::findAttrName(const QString &name)
+{
+    poolMutex.lock();
+    int id = attrNameIds.value(name.toLower(), -1);
+    poolMutex.unlock();
+    return id;
+}
+
+QString DBCStringPool::attrName(int id)
+{
+    QString name;
+    poolMutex.lock();
+    if (id >= 0 && id < attrNames.count()) name = attrNames.at(id);
+    poolMutex.unlock();
+    return name;
+}
+
+//Returns a copy of the string that shares its data with every other identical string that went through here
+QString DBCStringPool::shared(const QString &str)
+{
+    if (str.isEmpty()) return QString();
+    poolMutex.lock();
+    QSet<QString>::const_iterator it = stringPool.constFind(str);
+    if (it == stringPool.constEnd()) it = stringPool.insert(str);
+    QString out = *it;
+    poolMutex.unlock();
+    return out;
+}
+
+DBC_ATTRIBUTE_VALUE::DBC_ATTRIBUTE_VALUE()
+{
+    attrId = -1;
+}
+
+QString DBC_ATTRIBUTE_VALUE::attrName() const
+{
+    return DBCStringPool::attrName(attrId);
+}
+
+void DBC_ATTRIBUTE_VALUE::setAttrName(const QString &name)
+{
+    attrId = DBCStringPool::internAttrName(name);
+}
 
 DBC_MESSAGE::DBC_MESSAGE()
 {
@@ -10,6 +85,12 @@ DBC_MESSAGE::DBC_MESSAGE()
     len = 0;
     multiplexorSignal = nullptr;
     sender = nullptr;
+    touch();
+}
+
+void DBC_MESSAGE::touch()
+{
+    changeStamp = messageStamps.fetchAndAddRelaxed(1) + 1;
 }
 
 DBC_SIGNAL::DBC_SIGNAL()
@@ -29,6 +110,7 @@ DBC_SIGNAL::DBC_SIGNAL()
     signalSize = 1;
     startBit = 1;
     valType = DBC_SIG_VAL_TYPE::UNSIGNED_INT;
+    cachedValue = 0.0;
 }
 
 bool DBC_SIGNAL::isSignalInMessage(const CANFrame &frame)
@@ -138,7 +220,6 @@ bool DBC_SIGNAL::processAsText(const CANFrame &frame, QString &outString, bool o
         int bytes = signalSize / 8;
         for (int x = 0; x < bytes; x++) buildString.append(frame.payload().data()[startByte + x]);
         outString = buildString;
-        cachedValue = outString;
         return true;
     }
 
@@ -181,20 +262,38 @@ bool DBC_SIGNAL::processAsText(const CANFrame &frame, QString &outString, bool o
 
 bool DBC_SIGNAL::getValueString(int64_t intVal, QString &outString)
 {
-    if (valList.count() > 0) //if this is a value list type then look it up and display the proper string
+    if (valList.count() == 0) return false;
+    if (intVal < INT_MIN || intVal > INT_MAX) return false; //can't possibly be in the list
+
+    //valList is kept sorted so this is a binary search instead of a walk through every entry
+    DBC_VAL_ENUM_ENTRY key;
+    key.value = static_cast<int>(intVal);
+    QVector<DBC_VAL_ENUM_ENTRY>::const_iterator it = std::lower_bound(valList.constBegin(), valList.constEnd(), key);
+    if (it != valList.constEnd() && it->value == key.value)
     {
-        for (int x = 0; x < valList.count(); x++)
-        {
-            if (valList.at(x).value == intVal)
-            {
-                outString = valList.at(x).descript;
-                return true;
-            }
-        }
+        outString = it->descript;
+        return true;
     }
     return false;
 }
 
+//Inserts the entry in sorted position. Entries with the same value stay in the order they were added
+void DBC_SIGNAL::addValueEntry(const DBC_VAL_ENUM_ENTRY &entry)
+{
+    DBC_VAL_ENUM_ENTRY val = entry;
+    val.descript = DBCStringPool::shared(entry.descript);
+    QVector<DBC_VAL_ENUM_ENTRY>::iterator it = std::upper_bound(valList.begin(), valList.end(), val);
+    valList.insert(it, val);
+}
+
+//Anything that edits valList in place needs to call this afterward. Returns true if the order changed.
+bool DBC_SIGNAL::sortValueList()
+{
+    if (std::is_sorted(valList.constBegin(), valList.constEnd())) return false;
+    std::stable_sort(valList.begin(), valList.end());
+    return true;
+}
+
 QString DBC_SIGNAL::makePrettyOutput(double floatVal, int64_t intVal, bool outputName, bool isInteger, bool outputUnit)
 {
     QString outputString;
@@ -203,17 +302,9 @@ QString DBC_SIGNAL::makePrettyOutput(double floatVal, int64_t intVal, bool outpu
 
     if (valList.count() > 0) //if this is a value list type then look it up and display the proper string
     {
-        bool foundVal = false;
-        for (int x = 0; x < valList.count(); x++)
-        {
-            if (valList.at(x).value == intVal)
-            {
-                outputString += valList.at(x).descript;
-                foundVal = true;
-                break;
-            }
-        }
-        if (!foundVal) outputString += QString::number(intVal);
+        QString valString;
+        if (getValueString(intVal, valString)) outputString += valString;
+        else outputString += QString::number(intVal);
         if (outputUnit) outputString += unitName;
     }
     else //otherwise display the actual number and unit (if it exists)
@@ -320,12 +411,67 @@ bool DBC_SIGNAL::processAsDouble(const CANFrame &frame, double &outValue)
     return true;
 }
 
+bool DBC_SIGNAL::isPresentIn(const CANFrame &frame) const
+{
+    if (!isMultiplexed || multiplexParent == nullptr) return true;
+
+    const DBC_SIGNAL *parent = multiplexParent;
+    if (!parent->isPresentIn(frame)) return false;
+    if (frame.payload().length() * 8 < (parent->startBit + parent->signalSize)) return false;
+
+    int64_t val = Utility::processIntegerSignal(frame.payload(), parent->startBit, parent->signalSize, parent->intelByteOrder, parent->valType == SIGNED_INT);
+    return (val >= multiplexLowValue) && (val <= multiplexHighValue);
+}
+
+bool DBC_SIGNAL::decodeValue(const CANFrame &frame, double &outValue) const
+{
+    int64_t result;
+    const QByteArray &payload = frame.payload();
+
+    switch (valType)
+    {
+    case SIGNED_INT:
+    case UNSIGNED_INT:
+        if (payload.length() * 8 < (startBit + signalSize)) return false;
+        result = Utility::processIntegerSignal(payload, startBit, signalSize, intelByteOrder, valType == SIGNED_INT);
+        outValue = ((double)result * factor) + bias;
+        return true;
+    case SP_FLOAT:
+    {
+        if (payload.length() * 8 < (startBit + 32)) return false;
+        result = Utility::processIntegerSignal(payload, startBit, 32, intelByteOrder, false);
+        uint32_t bits = static_cast<uint32_t>(result);
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        outValue = (f * factor) + bias;
+        return true;
+    }
+    case DP_FLOAT:
+    {
+        if (payload.length() < 8) return false;
+        result = Utility::processIntegerSignal(payload, startBit, 64, intelByteOrder, false);
+        double d;
+        memcpy(&d, &result, sizeof(d));
+        outValue = (d * factor) + bias;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
 DBC_ATTRIBUTE_VALUE *DBC_SIGNAL::findAttrValByName(QString name)
 {
     if (attributes.length() == 0) return nullptr;
+    return findAttrValById(DBCStringPool::findAttrName(name));
+}
+
+DBC_ATTRIBUTE_VALUE *DBC_SIGNAL::findAttrValById(int id)
+{
+    if (id < 0) return nullptr;
     for (int i = 0; i < attributes.length(); i++)
     {
-        if (attributes[i].attrName.compare(name, Qt::CaseInsensitive) == 0)
+        if (attributes[i].attrId == id)
         {
             return &attributes[i];
         }
@@ -343,9 +489,15 @@ DBC_ATTRIBUTE_VALUE *DBC_SIGNAL::findAttrValByIdx(int idx)
 DBC_ATTRIBUTE_VALUE *DBC_MESSAGE::findAttrValByName(QString name)
 {
     if (attributes.length() == 0) return nullptr;
+    return findAttrValById(DBCStringPool::findAttrName(name));
+}
+
+DBC_ATTRIBUTE_VALUE *DBC_MESSAGE::findAttrValById(int id)
+{
+    if (id < 0) return nullptr;
     for (int i = 0; i < attributes.length(); i++)
     {
-        if (attributes[i].attrName.compare(name, Qt::CaseInsensitive) == 0)
+        if (attributes[i].attrId == id)
         {
             return &attributes[i];
         }
@@ -363,9 +515,15 @@ DBC_ATTRIBUTE_VALUE *DBC_MESSAGE::findAttrValByIdx(int idx)
 DBC_ATTRIBUTE_VALUE *DBC_NODE::findAttrValByName(QString name)
 {
     if (attributes.length() == 0) return nullptr;
+    return findAttrValById(DBCStringPool::findAttrName(name));
+}
+
+DBC_ATTRIBUTE_VALUE *DBC_NODE::findAttrValById(int id)
+{
+    if (id < 0) return nullptr;
     for (int i = 0; i < attributes.length(); i++)
     {
-        if (attributes[i].attrName.compare(name, Qt::CaseInsensitive) == 0)
+        if (attributes[i].attrId == id)
         {
             return &attributes[i];
         }
@@ -5,6 +5,7 @@
 #include <QString>
 #include <QStringList>
 #include <QVariant>
+#include <QVector>
 #include "can_structs.h"
 
 /*classes to encapsulate data from a DBC file. Really, the stuff of interest
@@ -52,11 +53,30 @@ public:
     QVariant defaultValue;
 };
 
+/*
+ * Shared storage for the strings that repeat over and over in a DBC file. Attribute names are interned to
+ * small integer IDs so attribute values only carry an int and lookups are an integer compare instead of
+ * a case insensitive string compare. Units, comments, and value descriptions are deduplicated so every
+ * "km/h" or "Not Available" in a big file shares one copy of the string data.
+*/
+class DBCStringPool
+{
+public:
+    static int internAttrName(const QString &name); //returns the ID for this name, creating it if necessary
+    static int findAttrName(const QString &name); //returns -1 if the name has never been interned
+    static QString attrName(int id);
+    static QString shared(const QString &str);
+};
+
 class DBC_ATTRIBUTE_VALUE
 {
 public:
-    QString attrName;
+    int attrId; //interned name of the attribute, see DBCStringPool
     QVariant value;
+
+    DBC_ATTRIBUTE_VALUE();
+    QString attrName() const;
+    void setAttrName(const QString &name);
 };
 
 class DBC_VAL_ENUM_ENTRY
@@ -64,6 +84,11 @@ class DBC_VAL_ENUM_ENTRY
 public:
     int value;
     QString descript;
+
+    friend bool operator<(const DBC_VAL_ENUM_ENTRY& l, const DBC_VAL_ENUM_ENTRY& r)
+    {
+        return (l.value < r.value);
+    }
 };
 
 class DBC_NODE
@@ -72,9 +97,10 @@ public:
     QString name;
     QString comment;
     QString sourceFileName;
-    QList<DBC_ATTRIBUTE_VALUE> attributes;
+    QVector<DBC_ATTRIBUTE_VALUE> attributes;
 
     DBC_ATTRIBUTE_VALUE *findAttrValByName(QString name);
+    DBC_ATTRIBUTE_VALUE *findAttrValById(int id);
     DBC_ATTRIBUTE_VALUE *findAttrValByIdx(int idx);
 
     friend bool operator<(const DBC_NODE& l, const DBC_NODE& r)
@@ -106,9 +132,9 @@ public: //TODO: this is sloppy. It shouldn't all be public!
     DBC_MESSAGE *parentMessage;
     QString unitName;
     QString comment;
-    QVariant cachedValue;
-    QList<DBC_ATTRIBUTE_VALUE> attributes;
-    QList<DBC_VAL_ENUM_ENTRY> valList;
+    double cachedValue; //last value decoded for this signal
+    QVector<DBC_ATTRIBUTE_VALUE> attributes;
+    QVector<DBC_VAL_ENUM_ENTRY> valList; //always kept sorted by value so lookups can binary search
     QList<DBC_SIGNAL *> multiplexedChildren;
     DBC_SIGNAL *multiplexParent;
     DBC_SIGNAL *self;
@@ -118,11 +144,17 @@ public: //TODO: this is sloppy. It shouldn't all be public!
     bool processAsInt(const CANFrame &frame, int32_t &outValue);
     bool processAsDouble(const CANFrame &frame, double &outValue);
     bool getValueString(int64_t intVal, QString &outString);
+    void addValueEntry(const DBC_VAL_ENUM_ENTRY &entry);
+    bool sortValueList();
     QString makePrettyOutput(double floatVal, int64_t intVal, bool outputName = true, bool isInteger = false, bool outputUnit = true);
     QString processSignalTree(const CANFrame &frame);
     DBC_ATTRIBUTE_VALUE *findAttrValByName(QString name);
+    DBC_ATTRIBUTE_VALUE *findAttrValById(int id);
     DBC_ATTRIBUTE_VALUE *findAttrValByIdx(int idx);
     bool isSignalInMessage(const CANFrame &frame);
+    //same answers as isSignalInMessage and processAsDouble but these leave cachedValue alone so any number of threads can use them at once
+    bool isPresentIn(const CANFrame &frame) const;
+    bool decodeValue(const CANFrame &frame, double &outValue) const;
 
     friend bool operator<(const DBC_SIGNAL& l, const DBC_SIGNAL& r)
     {
@@ -145,11 +177,14 @@ public:
     DBC_NODE *sender;
     QColor bgColor;
     QColor fgColor;
-    QList<DBC_ATTRIBUTE_VALUE> attributes;
+    QVector<DBC_ATTRIBUTE_VALUE> attributes;
     DBCSignalHandler *sigHandler;
     DBC_SIGNAL* multiplexorSignal;
+    int changeStamp; //new value from touch() whenever the message or its signals get edited, see DBCWriter
 
+    void touch();
     DBC_ATTRIBUTE_VALUE *findAttrValByName(QString name);
+    DBC_ATTRIBUTE_VALUE *findAttrValById(int id);
     DBC_ATTRIBUTE_VALUE *findAttrValByIdx(int idx);
 
     friend bool operator<(const DBC_MESSAGE& l, const DBC_MESSAGE& r)
@@ -0,0 +1,391 @@
+#include "dbccache.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QApplication>
+#include <QPalette>
+#include <QDateTime>
+#include <QDebug>
+
+//bump this any time the layout written below changes. Old caches are then just ignored and rewritten.
+#define DBC_CACHE_MAGIC     0x53444243ul   //"SDBC"
+#define DBC_CACHE_VERSION   1
+
+//attribute IDs are only valid for this run of the program so the names are what get stored
+static void writeAttrVals(QDataStream &stream, const QVector<DBC_ATTRIBUTE_VALUE> &attrs)
+{
+    stream << static_cast<qint32>(attrs.count());
+    for (int i = 0; i < attrs.count(); i++)
+    {
+        stream << attrs[i].attrName() << attrs[i].value;
+    }
+}
+
+static void readAttrVals(QDataStream &stream, QVector<DBC_ATTRIBUTE_VALUE> &attrs)
+{
+    qint32 count;
+    stream >> count;
+    attrs.clear();
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        DBC_ATTRIBUTE_VALUE val;
+        QString name;
+        stream >> name >> val.value;
+        val.setAttrName(name);
+        attrs.append(val);
+    }
+}
+
+static qint32 nodeIndex(DBCFile *file, const DBC_NODE *node)
+{
+    if (!node) return -1;
+    for (int i = 0; i < file->dbc_nodes.count(); i++)
+    {
+        if (&file->dbc_nodes.at(i) == node) return i;
+    }
+    return -1;
+}
+
+static qint32 signalIndex(DBC_MESSAGE *msg, const DBC_SIGNAL *sig)
+{
+    if (!sig) return -1;
+    for (int i = 0; i < msg->sigHandler->getCount(); i++)
+    {
+        if (msg->sigHandler->findSignalByIdx(i) == sig) return i;
+    }
+    return -1;
+}
+
+QString DBCCache::getCacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/dbc";
+}
+
+//one cache file per source file. The name is just a hash of the absolute path so it's stable and filesystem safe.
+QString DBCCache::getCacheFilename(QString dbcFilename)
+{
+    QString absPath = QFileInfo(dbcFilename).absoluteFilePath();
+    QByteArray pathHash = QCryptographicHash::hash(absPath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return getCacheDirectory() + "/" + QString::fromLatin1(pathHash) + ".dbcc";
+}
+
+/*
+ * The key is everything that has to match for the cached data to be trusted. Path, size and mtime are cheap
+ * and catch nearly every change but the content hash is there too so that touching or copying a file around doesn't
+ * hand us stale data. The palette colors are included because loadFile bakes them into the color attributes
+ * when a DBC doesn't specify its own, so a theme change has to force a reparse.
+*/
+bool DBCCache::buildKey(QString dbcFilename, QByteArray &key)
+{
+    QFileInfo info(dbcFilename);
+    if (!info.exists()) return false;
+
+    QFile inFile(dbcFilename);
+    if (!inFile.open(QIODevice::ReadOnly)) return false;
+
+    QCryptographicHash hasher(QCryptographicHash::Sha1);
+    if (!hasher.addData(&inFile)) return false;
+    inFile.close();
+
+    key.clear();
+    QDataStream stream(&key, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << static_cast<quint32>(DBC_CACHE_VERSION);
+    stream << info.absoluteFilePath();
+    stream << static_cast<qint64>(info.size());
+    stream << static_cast<qint64>(info.lastModified().toMSecsSinceEpoch());
+    stream << hasher.result();
+    stream << QApplication::palette().color(QPalette::Base).name();
+    stream << QApplication::palette().color(QPalette::WindowText).name();
+    return true;
+}
+
+bool DBCCache::saveFile(QString dbcFilename, DBCFile *file)
+{
+    QByteArray key;
+    if (!file) return false;
+    if (!buildKey(dbcFilename, key)) return false;
+
+    QDir dir;
+    if (!dir.mkpath(getCacheDirectory()))
+    {
+        qDebug() << "Could not create DBC cache directory " << getCacheDirectory();
+        return false;
+    }
+
+    //write to a temporary name first so a crash or full disk never leaves a half written cache with a valid header
+    QString cacheName = getCacheFilename(dbcFilename);
+    QFile outFile(cacheName + ".tmp");
+    if (!outFile.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Could not open DBC cache file for writing: " << cacheName;
+        return false;
+    }
+
+    QDataStream stream(&outFile);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    stream << static_cast<quint32>(DBC_CACHE_MAGIC);
+    stream << key;
+
+    stream << static_cast<qint32>(file->messageHandler->getMatchingCriteria());
+    stream << file->messageHandler->filterLabeling();
+
+    stream << static_cast<qint32>(file->dbc_nodes.count());
+    for (int i = 0; i < file->dbc_nodes.count(); i++)
+    {
+        const DBC_NODE &node = file->dbc_nodes.at(i);
+        stream << node.name << node.comment << node.sourceFileName;
+        writeAttrVals(stream, node.attributes);
+    }
+
+    stream << static_cast<qint32>(file->dbc_attributes.count());
+    for (int i = 0; i < file->dbc_attributes.count(); i++)
+    {
+        const DBC_ATTRIBUTE &attr = file->dbc_attributes.at(i);
+        stream << attr.name << static_cast<qint32>(attr.valType) << static_cast<qint32>(attr.attrType);
+        stream << attr.upper << attr.lower << attr.enumVals << attr.defaultValue;
+    }
+
+    stream << static_cast<qint32>(file->messageHandler->getCount());
+    for (int m = 0; m < file->messageHandler->getCount(); m++)
+    {
+        DBC_MESSAGE *msg = file->messageHandler->findMsgByIdx(m);
+        stream << msg->ID << msg->extendedID << msg->name << msg->comment << msg->len;
+        stream << nodeIndex(file, msg->sender) << msg->bgColor << msg->fgColor;
+        writeAttrVals(stream, msg->attributes);
+        stream << signalIndex(msg, msg->multiplexorSignal);
+
+        stream << static_cast<qint32>(msg->sigHandler->getCount());
+        for (int s = 0; s < msg->sigHandler->getCount(); s++)
+        {
+            DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
+            stream << sig->name << static_cast<qint32>(sig->startBit) << static_cast<qint32>(sig->signalSize);
+            stream << sig->intelByteOrder << sig->isMultiplexor << sig->isMultiplexed;
+            stream << static_cast<qint32>(sig->multiplexHighValue) << static_cast<qint32>(sig->multiplexLowValue);
+            stream << static_cast<qint32>(sig->valType) << sig->factor << sig->bias << sig->min << sig->max;
+            stream << nodeIndex(file, sig->receiver) << sig->unitName << sig->comment;
+            writeAttrVals(stream, sig->attributes);
+
+            stream << static_cast<qint32>(sig->valList.count());
+            for (int v = 0; v < sig->valList.count(); v++)
+            {
+                stream << static_cast<qint32>(sig->valList[v].value) << sig->valList[v].descript;
+            }
+
+            stream << signalIndex(msg, sig->multiplexParent);
+            stream << static_cast<qint32>(sig->multiplexedChildren.count());
+            foreach (DBC_SIGNAL *child, sig->multiplexedChildren)
+            {
+                stream << signalIndex(msg, child);
+            }
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        outFile.remove();
+        return false;
+    }
+    outFile.close();
+
+    QFile::remove(cacheName);
+    if (!QFile::rename(cacheName + ".tmp", cacheName))
+    {
+        QFile::remove(cacheName + ".tmp");
+        return false;
+    }
+    qDebug() << "Wrote DBC cache " << cacheName << " for " << dbcFilename;
+    return true;
+}
+
+//Fills out the nodes, attributes and messages of the passed file from the cache. Returns false if there is no
+//usable cache for this DBC in which case the file has not been touched and the caller should parse as normal.
+bool DBCCache::loadFile(QString dbcFilename, DBCFile *file)
+{
+    QByteArray key, storedKey;
+    quint32 magic;
+    qint32 count;
+
+    if (!file) return false;
+
+    QFile inFile(getCacheFilename(dbcFilename));
+    if (!inFile.exists()) return false;
+    if (!buildKey(dbcFilename, key)) return false;
+    if (!inFile.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream stream(&inFile);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    stream >> magic;
+    if (magic != DBC_CACHE_MAGIC) return false;
+    stream >> storedKey;
+    if (stream.status() != QDataStream::Ok || storedKey != key)
+    {
+        qDebug() << "DBC cache is stale for " << dbcFilename;
+        return false;
+    }
+
+    qint32 matchingCriteria;
+    bool filterLabeling;
+    stream >> matchingCriteria >> filterLabeling;
+
+    QList<DBC_NODE> nodes;
+    stream >> count;
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        DBC_NODE node;
+        stream >> node.name >> node.comment >> node.sourceFileName;
+        node.comment = DBCStringPool::shared(node.comment);
+        readAttrVals(stream, node.attributes);
+        nodes.append(node);
+    }
+
+    QList<DBC_ATTRIBUTE> attributes;
+    stream >> count;
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        DBC_ATTRIBUTE attr;
+        qint32 valType, attrType;
+        stream >> attr.name >> valType >> attrType;
+        stream >> attr.upper >> attr.lower >> attr.enumVals >> attr.defaultValue;
+        attr.valType = static_cast<DBC_ATTRIBUTE_VAL_TYPE>(valType);
+        attr.attrType = static_cast<DBC_ATTRIBUTE_TYPE>(attrType);
+        attributes.append(attr);
+    }
+
+    //the pointers inside the tree can only be set once every list has stopped growing, otherwise
+    //appending could move things out from under us. So remember the indexes and fix everything up afterward.
+    struct SigLinks
+    {
+        qint32 receiver;
+        qint32 multiplexParent;
+        QList<qint32> children;
+    };
+    struct MsgLinks
+    {
+        qint32 sender;
+        qint32 multiplexor;
+        QList<SigLinks> sigLinks;
+    };
+    QList<MsgLinks> msgLinks;
+    QList<DBC_MESSAGE> messages;
+
+    stream >> count;
+    for (int m = 0; m < count && stream.status() == QDataStream::Ok; m++)
+    {
+        DBC_MESSAGE msg;
+        MsgLinks links;
+        qint32 numSigs;
+
+        stream >> msg.ID >> msg.extendedID >> msg.name >> msg.comment >> msg.len;
+        msg.comment = DBCStringPool::shared(msg.comment);
+        stream >> links.sender >> msg.bgColor >> msg.fgColor;
+        readAttrVals(stream, msg.attributes);
+        stream >> links.multiplexor;
+
+        stream >> numSigs;
+        for (int s = 0; s < numSigs && stream.status() == QDataStream::Ok; s++)
+        {
+            DBC_SIGNAL sig;
+            SigLinks sLinks;
+            qint32 startBit, signalSize, muxHigh, muxLow, valType, numVals, numChildren;
+
+            stream >> sig.name >> startBit >> signalSize;
+            stream >> sig.intelByteOrder >> sig.isMultiplexor >> sig.isMultiplexed;
+            stream >> muxHigh >> muxLow;
+            stream >> valType >> sig.factor >> sig.bias >> sig.min >> sig.max;
+            stream >> sLinks.receiver >> sig.unitName >> sig.comment;
+            readAttrVals(stream, sig.attributes);
+            sig.startBit = startBit;
+            sig.signalSize = signalSize;
+            sig.multiplexHighValue = muxHigh;
+            sig.multiplexLowValue = muxLow;
+            sig.valType = static_cast<DBC_SIG_VAL_TYPE>(valType);
+            sig.unitName = DBCStringPool::shared(sig.unitName);
+            sig.comment = DBCStringPool::shared(sig.comment);
+
+            stream >> numVals;
+            for (int v = 0; v < numVals && stream.status() == QDataStream::Ok; v++)
+            {
+                DBC_VAL_ENUM_ENTRY val;
+                qint32 value;
+                stream >> value >> val.descript;
+                val.value = value;
+                sig.addValueEntry(val);
+            }
+
+            stream >> sLinks.multiplexParent;
+            stream >> numChildren;
+            for (int c = 0; c < numChildren && stream.status() == QDataStream::Ok; c++)
+            {
+                qint32 childIdx;
+                stream >> childIdx;
+                sLinks.children.append(childIdx);
+            }
+
+            msg.sigHandler->addSignal(sig);
+            links.sigLinks.append(sLinks);
+        }
+        messages.append(msg);
+        msgLinks.append(links);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        qDebug() << "DBC cache for " << dbcFilename << " is truncated or corrupt. Ignoring it.";
+        return false;
+    }
+    inFile.close();
+
+    //Everything read cleanly so now it's safe to replace what was in the file object
+    file->dbc_nodes = nodes;
+    file->dbc_attributes = attributes;
+    file->messageHandler->removeAllMessages();
+    file->messageHandler->setMatchingCriteria(static_cast<MatchingCriteria_t>(matchingCriteria));
+    file->messageHandler->setFilterLabeling(filterLabeling);
+    foreach (DBC_MESSAGE msg, messages) file->messageHandler->addMessage(msg);
+
+    for (int m = 0; m < file->messageHandler->getCount(); m++)
+    {
+        DBC_MESSAGE *msg = file->messageHandler->findMsgByIdx(m);
+        const MsgLinks &links = msgLinks.at(m);
+        msg->sender = file->findNodeByIdx(links.sender);
+        if (!msg->sender) msg->sender = file->findNodeByIdx(0);
+        msg->multiplexorSignal = msg->sigHandler->findSignalByIdx(links.multiplexor);
+
+        for (int s = 0; s < msg->sigHandler->getCount(); s++)
+        {
+            DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
+            const SigLinks &sLinks = links.sigLinks.at(s);
+            sig->parentMessage = msg;
+            sig->receiver = file->findNodeByIdx(sLinks.receiver);
+            if (!sig->receiver) sig->receiver = file->findNodeByIdx(0);
+            sig->multiplexParent = msg->sigHandler->findSignalByIdx(sLinks.multiplexParent);
+            sig->multiplexedChildren.clear();
+            foreach (qint32 childIdx, sLinks.children)
+            {
+                DBC_SIGNAL *child = msg->sigHandler->findSignalByIdx(childIdx);
+                if (child) sig->multiplexedChildren.append(child);
+            }
+        }
+    }
+
+    qDebug() << "Loaded " << dbcFilename << " from DBC cache";
+    return true;
+}
+
+void DBCCache::removeFile(QString dbcFilename)
+{
+    QFile::remove(getCacheFilename(dbcFilename));
+}
+
+void DBCCache::clearAll()
+{
+    QDir dir(getCacheDirectory());
+    if (dir.exists()) dir.removeRecursively();
+}
@@ -0,0 +1,32 @@
+#ifndef DBCCACHE_H
+#define DBCCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include "dbchandler.h"
+
+/*
+ * Binary cache of fully parsed DBC files. Parsing a big DBC with all the regular expressions in DBCFile::loadFile
+ * is slow so after a successful parse the whole tree (nodes, attributes, messages, signals, value tables and
+ * multiplexing relationships) gets dumped to a versioned binary file in the user cache directory.
+ * On the next load of the same file the cache is used directly as long as the path, size, modification time and
+ * content hash of the source file all still match. Any mismatch (or a different cache version) and we just parse normally.
+ *
+ * Pointers within the tree can't be stored directly so they're flattened to indexes (node index for senders and receivers,
+ * signal index within the message for multiplexing) and rebuilt on load.
+*/
+class DBCCache
+{
+public:
+    static bool loadFile(QString dbcFilename, DBCFile *file);
+    static bool saveFile(QString dbcFilename, DBCFile *file);
+    static void removeFile(QString dbcFilename);
+    static void clearAll();
+
+private:
+    static QString getCacheDirectory();
+    static QString getCacheFilename(QString dbcFilename);
+    static bool buildKey(QString dbcFilename, QByteArray &key);
+};
+
+#endif // DBCCACHE_H
@@ -11,11 +11,20 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QAtomicInt>
+#include <QMutexLocker>
 #include "utility.h"
+#include "dbccache.h"
+#include "dbcwriter.h"
 #include "connections/canconmanager.h"
 
 DBCHandler* DBCHandler::instance = nullptr;
 
+//Bumped by anything that could change which message a frame resolves to or how it decodes (or move messages
+//and signals around in memory). DBCHandler compares against this to know when its routing table is stale and
+//DBCSignalCache does the same for its decoded values.
+static QAtomicInt dbcChangeCounter(0);
+
 DBC_SIGNAL* DBCSignalHandler::findSignalByIdx(int idx)
 {
     if (sigs.count() == 0) return nullptr;
@@ -41,6 +50,7 @@ DBC_SIGNAL* DBCSignalHandler::findSignalByName(QString name)
 bool DBCSignalHandler::addSignal(DBC_SIGNAL &sig)
 {
     sigs.append(sig);
+    dbcChangeCounter.ref();
     return true;
 }
 
@@ -52,6 +62,7 @@ bool DBCSignalHandler::removeSignal(DBC_SIGNAL *sig)
         if (sigs[i].name == sig->name)
         {
             sigs.removeAt(i);
+            dbcChangeCounter.ref();
             qDebug() << "Removed signal at idx " << i;
         }
     }
@@ -64,6 +75,7 @@ bool DBCSignalHandler::removeSignal(int idx)
     if (idx < 0) return false;
     if (idx >= sigs.count()) return false;
     sigs.removeAt(idx);
+    dbcChangeCounter.ref();
     return true;
 }
 
@@ -76,6 +88,7 @@ bool DBCSignalHandler::removeSignal(QString name)
         if (sigs[i].name.compare(name, Qt::CaseInsensitive) == 0)
         {
             sigs.removeAt(i);
+            dbcChangeCounter.ref();
             foundSome = true;
         }
     }
@@ -85,6 +98,7 @@ bool DBCSignalHandler::removeSignal(QString name)
 void DBCSignalHandler::removeAllSignals()
 {
     sigs.clear();
+    dbcChangeCounter.ref();
 }
 
 int DBCSignalHandler::getCount()
@@ -95,6 +109,7 @@ int DBCSignalHandler::getCount()
 void DBCSignalHandler::sort()
 {
     std::sort(sigs.begin(), sigs.end());
+    dbcChangeCounter.ref();
 }
 
 DBC_MESSAGE* DBCMessageHandler::findMsgByID(uint32_t id)
@@ -198,6 +213,7 @@ QList<DBC_MESSAGE*> DBCMessageHandler::findMsgsByNode(DBC_NODE* node)
 bool DBCMessageHandler::addMessage(DBC_MESSAGE &msg)
 {
     messages.append(msg);
+    dbcChangeCounter.ref();
     return true;
 }
 
@@ -209,6 +225,7 @@ bool DBCMessageHandler::removeMessage(DBC_MESSAGE *msg)
         if (messages[i].name == msg->name)
         {
             messages.removeAt(i);
+            dbcChangeCounter.ref();
             qDebug() << "Removed message at idx " << i;
             break;
         }
@@ -222,6 +239,7 @@ bool DBCMessageHandler::removeMessageByIndex(int idx)
     if (idx < 0) return false;
     if (idx >= messages.count()) return false;
     messages.removeAt(idx);
+    dbcChangeCounter.ref();
     return true;
 }
 
@@ -234,6 +252,7 @@ bool DBCMessageHandler::removeMessage(uint32_t ID)
         if (messages[i].ID == ID)
         {
             messages.removeAt(i);
+            dbcChangeCounter.ref();
             foundSome = true;
         }
     }
@@ -249,6 +268,7 @@ bool DBCMessageHandler::removeMessage(QString name)
         if (messages[i].name.compare(name, Qt::CaseInsensitive) == 0)
         {
             messages.removeAt(i);
+            dbcChangeCounter.ref();
             foundSome = true;
         }
     }
@@ -258,6 +278,7 @@ bool DBCMessageHandler::removeMessage(QString name)
 void DBCMessageHandler::removeAllMessages()
 {
     messages.clear();
+    dbcChangeCounter.ref();
 }
 
 int DBCMessageHandler::getCount()
@@ -268,6 +289,7 @@ int DBCMessageHandler::getCount()
 void DBCMessageHandler::sort()
 {
     std::sort(messages.begin(), messages.end());
+    dbcChangeCounter.ref();
     for (int i = 0; i < messages.count(); i++)
     {
         messages[i].sigHandler->sort();
@@ -292,6 +314,7 @@ MatchingCriteria_t DBCMessageHandler::getMatchingCriteria()
 void DBCMessageHandler::setMatchingCriteria(MatchingCriteria_t _matchingCriteria)
 {
     matchingCriteria = _matchingCriteria;
+    dbcChangeCounter.ref();
 }
 
 DBCFile::DBCFile()
@@ -318,6 +341,7 @@ DBCFile::DBCFile(const DBCFile& cpy) : QObject()
     dbc_nodes.append(cpy.dbc_nodes);
     dbc_attributes.clear();
     dbc_attributes.append(cpy.dbc_attributes);
+    savedSections = cpy.savedSections;
     isDirty = cpy.isDirty;
 }
 
@@ -333,6 +357,7 @@ DBCFile& DBCFile::operator=(const DBCFile& cpy)
         dbc_nodes.append(cpy.dbc_nodes);
         dbc_attributes.clear();
         dbc_attributes.append(cpy.dbc_attributes);
+        savedSections = cpy.savedSections;
     }
     return *this;
 }
@@ -414,6 +439,7 @@ void DBCFile::setAssocBus(int bus)
     //int numBuses = CANConManager::getInstance()->getNumBuses();
     //if (bus >= numBuses) return;
     assocBuses = bus;
+    dbcChangeCounter.ref();
 }
 
 DBC_ATTRIBUTE *DBCFile::findAttributeByName(QString name, DBC_ATTRIBUTE_TYPE type)
@@ -446,9 +472,24 @@ void DBCFile::findAttributesByType(DBC_ATTRIBUTE_TYPE typ, QList<DBC_ATTRIBUTE>
     }
 }
 
+/*
+ * Editors set this after changing things in place (like a message ID) so it also invalidates message routing.
+ * Without a message it could have been anything (a node rename shows up in every message the node sends) so none of
+ * the saved sections can be trusted anymore. Editors that only changed one message pass it in instead so only that
+ * message gets written out fresh next save. Pass nullptr when messages were only added or removed.
+*/
 void DBCFile::setDirtyFlag()
 {
     isDirty = true;
+    dbcChangeCounter.ref();
+    savedSections.clear();
+}
+
+void DBCFile::setDirtyFlag(DBC_MESSAGE *changed)
+{
+    isDirty = true;
+    dbcChangeCounter.ref();
+    if (changed) changed->touch();
 }
 
 //BE CAREFUL HERE. Do not clear the dirty flag unless you're absolutely sure nothing has changed.
@@ -613,7 +654,7 @@ DBC_SIGNAL* DBCFile::parseSignalLine(QString line, DBC_MESSAGE *msg)
         sig.bias = match.captured(7 + offset).toDouble();
         sig.min = match.captured(8 + offset).toDouble();
         sig.max = match.captured(9 + offset).toDouble();
-        sig.unitName = match.captured(10 + offset);
+        sig.unitName = DBCStringPool::shared(match.captured(10 + offset));
         if (match.captured(11 + offset).contains(','))
         {
             QString tmp = match.captured(11 + offset).split(',')[0];
@@ -743,7 +784,7 @@ bool DBCFile::parseValueLine(QString line)
                         val.value = match.captured(1).toULong() & 0x1FFFFFFFul;
                         val.descript = match.captured(2);
                         //qDebug() << "sig val " << val.value << " desc " <<val.descript;
-                        sig->valList.append(val);
+                        sig->addValueEntry(val);
                         int rightSize = tokenString.length() - match.captured(1).length() - match.captured(2).length() - 4;
                         if (rightSize > 0) tokenString = tokenString.right(rightSize);
                         else tokenString = "";
@@ -786,7 +827,7 @@ bool DBCFile::parseAttributeLine(QString line)
                 else
                 {
                     DBC_ATTRIBUTE_VALUE val;
-                    val.attrName = match.captured(1);
+                    val.setAttrName(match.captured(1));
                     val.value = processAttributeVal(match.captured(3), foundAttr->valType);
                     foundMsg->attributes.append(val);
                 }
@@ -819,7 +860,7 @@ bool DBCFile::parseAttributeLine(QString line)
                     else
                     {
                         DBC_ATTRIBUTE_VALUE val;
-                        val.attrName = match.captured(1);
+                        val.setAttrName(match.captured(1));
                         val.value = processAttributeVal(match.captured(3), foundAttr->valType);
                         foundSig->attributes.append(val);
                     }
@@ -849,7 +890,7 @@ bool DBCFile::parseAttributeLine(QString line)
                 else
                 {
                     DBC_ATTRIBUTE_VALUE val;
-                    val.attrName = match.captured(1);
+                    val.setAttrName(match.captured(1));
                     val.value = processAttributeVal(match.captured(3), foundAttr->valType);
                     foundNode->attributes.append(val);
                 }
@@ -922,6 +963,18 @@ bool DBCFile::loadFile(QString fileName)
 
     qDebug() << "DBC File: " << fileName;
 
+    //if this exact file has been parsed before then the binary cache already has the whole tree
+    if (DBCCache::loadFile(fileName, this))
+    {
+        delete inFile;
+        QStringList fileList = fileName.split('/');
+        this->fileName = fileList[fileList.length() - 1];
+        filePath = fileName.left(fileName.length() - this->fileName.length());
+        assocBuses = -1;
+        isDirty = false;
+        return true;
+    }
+
     if (!inFile->open(QIODevice::ReadOnly | QIODevice::Text))
     {
         delete inFile;
@@ -1025,7 +1078,7 @@ bool DBCFile::loadFile(QString fileName)
                         DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(match.captured(2));
                         if (sig != nullptr)
                         {
-                            sig->comment = match.captured(3);
+                            sig->comment = DBCStringPool::shared(match.captured(3));
                         }
                     }
                 }
@@ -1043,7 +1096,7 @@ bool DBCFile::loadFile(QString fileName)
                     DBC_MESSAGE *msg = messageHandler->findMsgByID(match.captured(1).toUInt());
                     if (msg != nullptr)
                     {
-                        msg->comment = match.captured(2);
+                        msg->comment = DBCStringPool::shared(match.captured(2));
                     }
                 }
             }
@@ -1060,7 +1113,7 @@ bool DBCFile::loadFile(QString fileName)
                     DBC_NODE *node = findNodeByName(match.captured(1));
                     if (node != nullptr)
                     {
-                        node->comment = match.captured(2);
+                        node->comment = DBCStringPool::shared(match.captured(2));
                     }
                 }
             }
@@ -1225,6 +1278,10 @@ bool DBCFile::loadFile(QString fileName)
     }
     inFile->close();
     delete inFile;
+
+    //only cache clean parses so the user keeps getting told about faulty entries until they're fixed
+    if (numSigFaults == 0 && numMsgFaults == 0) DBCCache::saveFile(fileName, this);
+
     QStringList fileList = fileName.split('/');
     this->fileName = fileList[fileList.length() - 1]; //whoops... same name as parameter in this function.
     filePath = fileName.left(fileName.length() - this->fileName.length());
@@ -1348,348 +1405,14 @@ bool DBCFile::parseAttribute(QString inpString, DBC_ATTRIBUTE &attr)
     return goodAttr;
 }
 
-bool DBCFile::saveFile(QString fileName)
+bool DBCFile::saveFile(QString fileName, bool inBackground)
 {
-    int nodeNumber = 1;
-    int msgNumber = 1;
-    int sigNumber = 1;
-    QFile *outFile = new QFile(fileName);
-    QString nodesOutput, msgOutput, commentsOutput, valuesOutput, extMultiplexOutput;
-    QString defaultsOutput, attrValOutput;
-    bool hasExtendedMultiplexing = false;
-
-    if (!outFile->open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        delete outFile;
-        return false;
-    }
-
-    //right now it outputs a standard hard coded boilerplate
-    outFile->write("VERSION \"\"\n");
-    outFile->write("\n");
-    outFile->write("\n");
-    outFile->write("NS_ :\n");
-    outFile->write("    NS_DESC_\n");
-    outFile->write("    CM_\n");
-    outFile->write("    BA_DEF_\n");
-    outFile->write("    BA_\n");
-    outFile->write("    VAL_\n");
-    outFile->write("    CAT_DEF_\n");
-    outFile->write("    CAT_\n");
-    outFile->write("    FILTER\n");
-    outFile->write("    BA_DEF_DEF_\n");
-    outFile->write("    EV_DATA_\n");
-    outFile->write("    ENVVAR_DATA_\n");
-    outFile->write("    SGTYPE_\n");
-    outFile->write("    SGTYPE_VAL_\n");
-    outFile->write("    BA_DEF_SGTYPE_\n");
-    outFile->write("    BA_SGTYPE_\n");
-    outFile->write("    SIG_TYPE_REF_\n");
-    outFile->write("    VAL_TABLE_\n");
-    outFile->write("    SIG_GROUP_\n");
-    outFile->write("    SIG_VALTYPE_\n");
-    outFile->write("    SIGTYPE_VALTYPE_\n");
-    outFile->write("    BO_TX_BU_\n");
-    outFile->write("    BA_DEF_REL_\n");
-    outFile->write("    BA_REL_\n");
-    outFile->write("    BA_DEF_DEF_REL_\n");
-    outFile->write("    BU_SG_REL_\n");
-    outFile->write("    BU_EV_REL_\n");
-    outFile->write("    BU_BO_REL_\n");
-    outFile->write("    SG_MUL_VAL_\n");
-    outFile->write("\n");
-    outFile->write("BS_: \n");
-
-    //Build list of nodes line
-    nodesOutput.append("BU_: ");
-    for (int x = 0; x < dbc_nodes.count(); x++)
-    {
-        DBC_NODE node = dbc_nodes[x];
-        if (node.name.compare("Vector__XXX", Qt::CaseInsensitive) != 0)
-        {
-            if (node.name.length() < 1) //detect an empty string and fill it out with something
-            {
-                node.name = "NODE" + QString::number(nodeNumber);
-                nodeNumber++;
-            }
-            nodesOutput.append(node.name + " ");
-            if (node.comment.length() > 0)
-            {
-                commentsOutput.append("CM_ BU_ " + node.name + " \"" + node.comment + "\";\n");
-            }
-            if (node.attributes.count() > 0)
-            {
-                foreach (DBC_ATTRIBUTE_VALUE val, node.attributes) {
-                    attrValOutput.append("BA_ \"" + val.attrName + "\" BU_ ");
-                    switch (val.value.type())
-                    {
-                    case QVariant::Type::String:
-                        attrValOutput.append("\"" + val.value.toString() + "\";\n");
-                        break;
-                    default:
-                        attrValOutput.append(val.value.toString() + ";\n");
-                        break;
-                    }
-                }
-            }
-        }
-    }
-    nodesOutput.append("\n");
-    outFile->write(nodesOutput.toUtf8());
-
-    //Go through all messages one at at time issuing the message line then all signals in there too.
-    for (int x = 0; x < messageHandler->getCount(); x++)
-    {
-        DBC_MESSAGE *msg = messageHandler->findMsgByIdx(x);
-
-        if (msg->name.length() < 1) //detect an empty string and fill it out with something
-        {
-            msg->name = "MSG" + QString::number(msgNumber);
-            msgNumber++;
-        }
-
-        uint32_t ID = msg->ID;
-        if (msg->ID > 0x7FF || msg->extendedID)
-        {
-            ID += 0x80000000ul; //set bit 31 if this ID is extended.
-        }
-
-        msgOutput.append("BO_ " + QString::number(ID) + " " + msg->name + ": " + QString::number(msg->len) +
-                         " " + msg->sender->name + "\n");
-        if (msg->comment.length() > 0)
-        {
-            commentsOutput.append("CM_ BO_ " + QString::number(ID) + " \"" + msg->comment + "\";\n");
-        }
-
-        //If this message has attributes then compile them into attributes list to output later on.
-        if (msg->attributes.count() > 0)
-        {
-            foreach (DBC_ATTRIBUTE_VALUE val, msg->attributes) {
-                attrValOutput.append("BA_ \"" + val.attrName + "\" BO_ " + QString::number(ID) + " ");
-                switch (val.value.type())
-                {
-                case QVariant::Type::String:
-                    attrValOutput.append("\"" + val.value.toString() + "\";\n");
-                    break;
-                default:
-                    attrValOutput.append(val.value.toString() + ";\n");
-                    break;
-                }
-            }
-        }
-
-        for (int s = 0; s < msg->sigHandler->getCount(); s++)
-        {
-            DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
-
-            if (sig->name.length() < 1) //detect an empty string and fill it out with something
-            {
-                sig->name = "SIG" + QString::number(sigNumber);
-                sigNumber++;
-            }
-
-            msgOutput.append("   SG_ " + sig->name);
-
-            if (sig->isMultiplexed)
-            {
-                msgOutput.append(" m" + QString::number(sig->multiplexLowValue));
-            }
-            if (sig->isMultiplexor)
-            {
-                if (!sig->isMultiplexed) msgOutput.append(" ");
-                msgOutput.append("M");
-            }
-            //check for the two telltale signs that we've got extended multiplexing going on.
-            if (sig->isMultiplexed && sig->isMultiplexor) hasExtendedMultiplexing = true;
-            if (sig->multiplexLowValue != sig->multiplexHighValue) hasExtendedMultiplexing = true;
-
-            msgOutput.append(" : " + QString::number(sig->startBit) + "|" + QString::number(sig->signalSize) + "@");
-
-            switch (sig->valType)
-            {
-            case UNSIGNED_INT:
-                if (sig->intelByteOrder) msgOutput.append("1+");
-                else msgOutput.append("0+");
-                break;
-            case SIGNED_INT:
-                if (sig->intelByteOrder) msgOutput.append("1-");
-                else msgOutput.append("0-");
-                break;
-            case SP_FLOAT:
-                if (sig->intelByteOrder) msgOutput.append("5-");
-                else msgOutput.append("2-");
-                break;
-            case DP_FLOAT:
-                if (sig->intelByteOrder) msgOutput.append("6-");
-                else msgOutput.append("3-");
-                break;
-            case STRING:
-                msgOutput.append("4-");
-                break;
-            default:
-                msgOutput.append("0-");
-                break;
-            }
-            msgOutput.append(" (" + QString::number(sig->factor) + "," + QString::number(sig->bias) + ") [" +
-                             QString::number(sig->min) + "|" + QString::number(sig->max) + "] \"" + sig->unitName
-                             + "\" " + sig->receiver->name + "\n");
-            if (sig->comment.length() > 0)
-            {
-                commentsOutput.append("CM_ SG_ " + QString::number(ID) + " " + sig->name + " \"" + sig->comment + "\";\n");
-            }
-
-            //if this signal has attributes then compile them in a special list of attributes
-            if (sig->attributes.count() > 0)
-            {
-                foreach (DBC_ATTRIBUTE_VALUE val, sig->attributes) {
-                    attrValOutput.append("BA_ \"" + val.attrName + "\" SG_ " + QString::number(ID) + " " + sig->name + " ");
-                    switch (val.value.type())
-                    {
-                    case QVariant::Type::String:
-                        attrValOutput.append("\"" + val.value.toString() + "\";\n");
-                        break;
-                    default:
-                        attrValOutput.append(val.value.toString() + ";\n");
-                        break;
-                    }
-                }
-            }
+    bool result;
 
-            if (sig->valList.count() > 0)
-            {
-                valuesOutput.append("VAL_ " + QString::number(ID) + " " + sig->name);
-                for (int v = 0; v < sig->valList.count(); v++)
-                {
-                    DBC_VAL_ENUM_ENTRY val = sig->valList[v];
-                    valuesOutput.append(" " + QString::number(val.value) + " \"" + val.descript +"\"");
-                }
-                valuesOutput.append(";\n");
-            }
-        }
-        msgOutput.append("\n");
-        //write it out every message so the string doesn't end up too huge
-        outFile->write(msgOutput.toUtf8());
-        msgOutput.clear(); //got to reset it after writing
-    }
-
-    outFile->write(commentsOutput.toUtf8());
-    commentsOutput.clear();
-
-    //Now dump out all of the stored attributes
-    for (int x = 0; x < dbc_attributes.count(); x++)
-    {
-        msgOutput.append("BA_DEF_ ");
-        switch (dbc_attributes[x].attrType)
-        {
-        case ATTR_TYPE_GENERAL:
-            break;
-        case ATTR_TYPE_NODE:
-            msgOutput.append("BU_ ");
-            break;
-        case ATTR_TYPE_MESSAGE:
-            msgOutput.append("BO_ ");
-            break;
-        case ATTR_TYPE_SIG:
-            msgOutput.append("SG_ ");
-            break;
-        case ATTR_TYPE_ANY:
-            break;
-        }
-
-        msgOutput.append("\"" + dbc_attributes[x].name + "\" ");
-
-        switch (dbc_attributes[x].valType)
-        {
-        case ATTR_INT:
-            msgOutput.append("INT " + QString::number(dbc_attributes[x].lower) + " " + QString::number(dbc_attributes[x].upper));
-            break;
-        case ATTR_FLOAT:
-            msgOutput.append("FLOAT " + QString::number(dbc_attributes[x].lower) + " " + QString::number(dbc_attributes[x].upper));
-            break;
-        case ATTR_STRING:
-            msgOutput.append("STRING ");
-            break;
-        case ATTR_ENUM:
-            msgOutput.append("ENUM ");
-            foreach (QString str, dbc_attributes[x].enumVals)
-            {
-                msgOutput.append("\"" + str + "\",");
-            }
-            msgOutput.truncate(msgOutput.length() - 1); //remove trailing ,
-            break;
-        }
-
-        msgOutput.append(";\n");
+    if (inBackground) result = DBCWriter::writeFileInBackground(this, fileName);
+    else result = DBCWriter::writeFile(this, fileName);
 
-        outFile->write(msgOutput.toUtf8());
-        msgOutput.clear(); //got to reset it after writing
-
-        if (dbc_attributes[x].defaultValue.isValid())
-        {
-            defaultsOutput.append("BA_DEF_DEF_ \"" + dbc_attributes[x].name + "\" ");
-            switch (dbc_attributes[x].valType)
-            {
-            case ATTR_STRING:
-                defaultsOutput.append("\"" + dbc_attributes[x].defaultValue.toString() + "\";\n");
-                break;
-            case ATTR_ENUM:
-                defaultsOutput.append("\"" + dbc_attributes[x].enumVals[dbc_attributes[x].defaultValue.toInt()] + "\";\n");
-                break;
-            case ATTR_INT:
-                defaultsOutput.append(QString::number(dbc_attributes[x].defaultValue.toLongLong()) + ";\n");
-                break;
-            case ATTR_FLOAT:
-                defaultsOutput.append(dbc_attributes[x].defaultValue.toString() + ";\n");
-                break;
-            }
-        }
-    }
-
-    //extended multiplexing uses SG_MUL_VAL_ to specify the relationships. If a signal is marked
-    //as multiplexed then output a record for it. That's the most complete option. We've already
-    //given the single value multiplex above for backward compatibility with things that don't support extended mode
-    if (hasExtendedMultiplexing)
-    {
-        for (int x = 0; x < messageHandler->getCount(); x++)
-        {
-            DBC_MESSAGE *msg = messageHandler->findMsgByIdx(x);
-
-            uint32_t ID = msg->ID;
-            if (msg->ID > 0x7FF || msg->extendedID)
-            {
-                ID += 0x80000000ul; //set bit 31 if this ID is extended.
-            }
-
-            for (int s = 0; s < msg->sigHandler->getCount(); s++)
-            {
-                DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
-
-                if (sig->isMultiplexed)
-                {
-                    msgOutput.append("SG_MUL_VAL_ " + QString::number(ID) + " ");
-                    msgOutput.append(sig->name + " " + sig->multiplexParent->name + " ");
-                    msgOutput.append(QString::number(sig->multiplexLowValue) + "-" + QString::number(sig->multiplexHighValue) + ";");
-                    msgOutput.append("\n");
-                    extMultiplexOutput.append(msgOutput);
-                    msgOutput.clear(); //got to reset it after writing
-                }
-            }
-        }
-    }
-
-    //now write out all of the accumulated comments and value tables from above
-    outFile->write(defaultsOutput.toUtf8());
-    outFile->write(attrValOutput.toUtf8());    
-    outFile->write(valuesOutput.toUtf8());
-    outFile->write(extMultiplexOutput.toUtf8());
-
-    attrValOutput.clear();
-    defaultsOutput.clear();
-    valuesOutput.clear();
-    extMultiplexOutput.clear();
-
-    outFile->close();
-    delete outFile;
+    if (!result) return false;
 
     isDirty = false;
 
@@ -1724,7 +1447,7 @@ void DBCHandler::saveDBCFile(int idx)
     {
         filename = dialog.selectedFiles()[0];
         if (!filename.contains('.')) filename += ".dbc";
-        loadedFiles[idx].saveFile(filename);
+        loadedFiles[idx].saveFile(filename, true);
         settings.setValue("DBC/LoadSaveDirectory", dialog.directory().path());
     }
 }
@@ -1780,6 +1503,7 @@ int DBCHandler::createBlankFile()
     newFile.setAssocBus(-1);
 
     loadedFiles.append(newFile);
+    dbcChangeCounter.ref();
     return loadedFiles.count();
 }
 
@@ -1789,6 +1513,7 @@ DBCFile* DBCHandler::loadDBCFile(QString filename)
     if (newFile.loadFile(filename))
     {
         loadedFiles.append(newFile);
+        dbcChangeCounter.ref();
     }
     else
     {
@@ -1925,7 +1650,7 @@ DBCFile* DBCHandler::loadSecretCSVFile(QString filename)
                     DBC_VAL_ENUM_ENTRY entry;
                     entry.value = valToks[0].toInt();
                     entry.descript = valToks[1];
-                    sig.valList.append(entry);
+                    sig.addValueEntry(entry);
                 }
                 pMsg->sigHandler->addSignal(sig);
                 pSig = pMsg->sigHandler->findSignalByIdx(pMsg->sigHandler->getCount()-1);
@@ -1979,7 +1704,7 @@ DBCFile* DBCHandler::loadSecretCSVFile(QString filename)
                     DBC_VAL_ENUM_ENTRY entry;
                     entry.value = valToks[0].toInt();
                     entry.descript = valToks[1];
-                    sig.valList.append(entry);
+                    sig.addValueEntry(entry);
                 }
                 pMsg->sigHandler->addSignal(sig);
                 pSig = pMsg->sigHandler->findSignalByIdx(pMsg->sigHandler->getCount()-1);
@@ -1991,7 +1716,7 @@ DBCFile* DBCHandler::loadSecretCSVFile(QString filename)
                 DBC_VAL_ENUM_ENTRY entry;
                 entry.value = valToks[0].toInt();
                 entry.descript = valToks[1];
-                pSig->valList.append(entry);
+                pSig->addValueEntry(entry);
             }
         }
     }
@@ -2077,7 +1802,7 @@ DBCFile* DBCHandler::loadJSONFile(QString filename)
                 sig.max = sigObj.find("max").value().toDouble();
                 sig.min = sigObj.find("min").value().toDouble();
                 sig.startBit = sigObj.find("start_position").value().toInt();
-                sig.unitName = sigObj.find("units").value().toString();
+                sig.unitName = DBCStringPool::shared(sigObj.find("units").value().toString());
                 sig.signalSize = sigObj.find("width").value().toInt();
                 sig.isMultiplexed = false;
                 sig.isMultiplexor = false;
@@ -2112,7 +1837,7 @@ DBCFile* DBCHandler::loadJSONFile(QString filename)
                         DBC_VAL_ENUM_ENTRY valEnum;
                         valEnum.value = valIter.value().toInt();
                         valEnum.descript = valIter.key().toUtf8();
-                        sig.valList.append(valEnum);
+                        sig.addValueEntry(valEnum);
                     }
                 }
 
@@ -2178,12 +1903,16 @@ void DBCHandler::removeDBCFile(int idx)
     if (loadedFiles.count() == 0) return;
     if (idx < 0) return;
     if (idx >= loadedFiles.count()) return;
+    //no point keeping the parsed cache around for a file the user got rid of
+    DBCCache::removeFile(loadedFiles[idx].getFullFilename());
     loadedFiles.removeAt(idx);
+    dbcChangeCounter.ref();
 }
 
 void DBCHandler::removeAllFiles()
 {
     loadedFiles.clear();
+    dbcChangeCounter.ref();
 }
 
 void DBCHandler::swapFiles(int pos1, int pos2)
@@ -2195,6 +1924,7 @@ void DBCHandler::swapFiles(int pos1, int pos2)
     if (pos2 >= loadedFiles.count()) return;
 
     loadedFiles.swapItemsAt(pos1, pos2);
+    dbcChangeCounter.ref();
 }
 
 /*
@@ -2205,15 +1935,60 @@ void DBCHandler::swapFiles(int pos1, int pos2)
 */
 DBC_MESSAGE* DBCHandler::findMessage(const CANFrame &frame)
 {
-    for(int i = 0; i < loadedFiles.count(); i++)
+    QMutexLocker locker(&routeMutex);
+
+    if (routeGeneration != dbcChangeCounter.loadAcquire()) rebuildRoutes();
+
+    //buses without their own files all share the wildcard route so they can share cache entries too
+    int routeBus = busRoutes.contains(frame.bus) ? frame.bus : -1;
+    quint64 key = (static_cast<quint64>(static_cast<uint32_t>(routeBus)) << 32) | frame.frameId();
+
+    QHash<quint64, DBC_MESSAGE*>::const_iterator it = routeCache.constFind(key);
+    if (it != routeCache.constEnd()) return it.value();
+
+    const QVector<DBCFile*> &files = (routeBus == -1) ? wildcardRoute : busRoutes[routeBus];
+    DBC_MESSAGE* msg = nullptr;
+    for (int i = 0; i < files.count(); i++)
     {
-        if (loadedFiles[i].getAssocBus() == -1 || frame.bus == loadedFiles[i].getAssocBus())
+        msg = files[i]->messageHandler->findMsgByID(frame.frameId());
+        if (msg != nullptr) break;
+    }
+
+    //a flood of random IDs (fuzzing for instance) shouldn't be able to grow this forever
+    if (routeCache.count() > 65536) routeCache.clear();
+    routeCache.insert(key, msg); //misses are cached too, they're just as common
+    return msg;
+}
+
+//called with routeMutex held
+void DBCHandler::rebuildRoutes()
+{
+    busRoutes.clear();
+    wildcardRoute.clear();
+    routeCache.clear();
+    routeGeneration = dbcChangeCounter.loadAcquire();
+
+    for (int i = 0; i < loadedFiles.count(); i++)
+    {
+        int bus = loadedFiles[i].getAssocBus();
+        if (bus != -1 && !busRoutes.contains(bus)) busRoutes.insert(bus, QVector<DBCFile*>());
+    }
+
+    //file order is priority order so each route has to keep it
+    for (int i = 0; i < loadedFiles.count(); i++)
+    {
+        DBCFile *file = &loadedFiles[i];
+        int bus = file->getAssocBus();
+        if (bus == -1)
         {
-            DBC_MESSAGE* msg = loadedFiles[i].messageHandler->findMsgByID(frame.frameId());
-            if (msg != nullptr) return msg;
+            wildcardRoute.append(file);
+            for (QHash<int, QVector<DBCFile*>>::iterator it = busRoutes.begin(); it != busRoutes.end(); ++it)
+            {
+                it.value().append(file);
+            }
         }
+        else busRoutes[bus].append(file);
     }
-    return nullptr;
 }
 
 DBC_MESSAGE* DBCHandler::findMessage(uint32_t id)
@@ -2305,6 +2080,12 @@ DBC_MESSAGE* DBCHandler::findMessage(const QString msgName, const QString fullyQ
     return msg;
 }
 
+//goes up every time anything in any loaded file changes. Compare against a saved value to see if something is stale.
+int DBCHandler::getChangeCounter()
+{
+    return dbcChangeCounter.loadAcquire();
+}
+
 int DBCHandler::getFileCount()
 {
     return loadedFiles.count();
@@ -2333,6 +2114,8 @@ DBCFile* DBCHandler::getFileByName(QString name)
 
 DBCHandler::DBCHandler()
 {
+    routeGeneration = -1;
+
     // Load previously saved DBC file settings
     QSettings settings;
     qDebug() <<"Settings file: " << settings.fileName();
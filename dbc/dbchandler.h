@@ -2,6 +2,9 @@
 #define DBCHANDLER_H
 
 #include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
 #include "dbc_classes.h"
 #include "can_structs.h"
 
@@ -63,6 +66,21 @@ private:
     bool filterLabelingEnabled;
 };
 
+//Already formatted DBC output for everything a single message contributes to a file. DBCWriter keeps these
+//around so that saving again only has to regenerate the messages that changed since the last save.
+class DBCMessageSection
+{
+public:
+    DBCMessageSection() : stamp(0), hasExtendedMultiplexing(false) {}
+    int stamp;             //DBC_MESSAGE::changeStamp of the message it was formatted from
+    bool hasExtendedMultiplexing;
+    QByteArray definition; //BO_ line and all of the SG_ lines
+    QByteArray comments;
+    QByteArray attrValues;
+    QByteArray valueTables;
+    QByteArray extMultiplex;
+};
+
 //technically there should be a node handler too but I'm sort of treating nodes as second class
 //citizens since they aren't really all that important (to me anyway)
 class DBCFile: public QObject
@@ -78,7 +96,7 @@ public:
     DBC_ATTRIBUTE *findAttributeByName(QString name, DBC_ATTRIBUTE_TYPE type = ATTR_TYPE_ANY);
     DBC_ATTRIBUTE *findAttributeByIdx(int idx);
     void findAttributesByType(DBC_ATTRIBUTE_TYPE typ, QList<DBC_ATTRIBUTE> *list);
-    bool saveFile(QString);
+    bool saveFile(QString fileName, bool inBackground = false);
     bool loadFile(QString);
     QString getFullFilename();
     QString getFilename();
@@ -87,6 +105,7 @@ public:
     int getAssocBus();
     void setAssocBus(int bus);
     void setDirtyFlag();
+    void setDirtyFlag(DBC_MESSAGE *changed);
     bool getDirtyFlag();
     void clearDirtyFlag();
     void sort();
@@ -94,6 +113,7 @@ public:
     DBCMessageHandler *messageHandler;
     QList<DBC_NODE> dbc_nodes;
     QList<DBC_ATTRIBUTE> dbc_attributes;
+    QHash<uint32_t, DBCMessageSection> savedSections; //keyed by message ID as written to the file
 private:
     QString fileName;
     QString filePath;
@@ -133,11 +153,26 @@ public:
     int createBlankFile();
     DBCFile* loadJSONFile(QString);
     DBCFile* loadSecretCSVFile(QString);
+    int getChangeCounter();
     static DBCHandler *getReference();
 
 private:
     QList<DBCFile> loadedFiles;
 
+    /*
+     * Routing table for findMessage(frame). Each bus that has a file explicitly assigned to it gets the list of files
+     * that apply to it (its own plus the "all buses" ones) in load order. Any other bus just uses the wildcard list.
+     * Resolved lookups are remembered per bus and ID so repeat frames are a single hash lookup. Everything here is
+     * thrown away and rebuilt whenever a file, message, or bus association changes.
+    */
+    QHash<int, QVector<DBCFile*>> busRoutes;
+    QVector<DBCFile*> wildcardRoute;
+    QHash<quint64, DBC_MESSAGE*> routeCache;
+    int routeGeneration;
+    QMutex routeMutex;
+
+    void rebuildRoutes();
+
     DBCHandler();
     static DBCHandler *instance;
 };
@@ -5,6 +5,7 @@
 #include <QMessageBox>
 #include <qevent.h>
 #include "helpwindow.h"
+#include "dbccache.h"
 #include "connections/canconmanager.h"
 
 DBCLoadSaveWindow::DBCLoadSaveWindow(const QVector<CANFrame> *frames, QWidget *parent) :
@@ -66,6 +67,7 @@ DBCLoadSaveWindow::DBCLoadSaveWindow(const QVector<CANFrame> *frames, QWidget *p
     connect(ui->btnRemove, &QAbstractButton::clicked, this, &DBCLoadSaveWindow::removeFile);
     connect(ui->btnSave, &QAbstractButton::clicked, this, &DBCLoadSaveWindow::saveFile);
     connect(ui->btnNewDBC, &QAbstractButton::clicked, this, &DBCLoadSaveWindow::newFile);
+    connect(ui->btnClearCache, &QAbstractButton::clicked, this, &DBCLoadSaveWindow::clearCache);
     connect(ui->tableFiles, &QTableWidget::cellChanged, this, &DBCLoadSaveWindow::cellChanged);
     connect(ui->tableFiles, &QTableWidget::cellDoubleClicked, this, &DBCLoadSaveWindow::cellDoubleClicked);
 
@@ -260,6 +262,16 @@ void DBCLoadSaveWindow::removeFile()
     updateSettings();
 }
 
+//Only throws away the parsed copies. Loaded files are untouched and get cached again on their next load or save
+void DBCLoadSaveWindow::clearCache()
+{
+    QMessageBox::StandardButton confirmDialog;
+    confirmDialog = QMessageBox::question(this, "Clear DBC Cache", "This removes the cached copy of every DBC file.\nLarge files will be slower the next time they are loaded.\nAre you sure?",
+                                      QMessageBox::Yes|QMessageBox::No);
+    if (confirmDialog != QMessageBox::Yes) return;
+    DBCCache::clearAll();
+}
+
 void DBCLoadSaveWindow::moveUp()
 {
     int idx = ui->tableFiles->currentRow();
@@ -31,6 +31,7 @@ private slots:
     void cellDoubleClicked(int row, int col);
     void matchingCriteriaChanged(int index);
     void newFile();
+    void clearCache();
 
 signals:
     void updatedDBCSettings();
@@ -654,7 +654,7 @@ void DBCMainEditor::copyMessageToNode(DBC_NODE *parentNode, DBC_MESSAGE *source,
     itemToMessage.insert(newMsgItem, msgPtr);
     nodeItem->addChild(newMsgItem);
     //ui->treeDBC->setCurrentItem(newMsgItem);
-    dbcFile->setDirtyFlag();
+    dbcFile->setDirtyFlag(msgPtr);
 }
 
 //create a new message with it's parent being the node we're currently within
@@ -734,7 +734,7 @@ void DBCMainEditor::newMessage()
     itemToMessage.insert(newMsgItem, msgPtr);
     nodeItem->addChild(newMsgItem);
     ui->treeDBC->setCurrentItem(newMsgItem);
-    dbcFile->setDirtyFlag();
+    dbcFile->setDirtyFlag(msgPtr);
 }
 
 void DBCMainEditor::newSignal()
@@ -799,7 +799,7 @@ void DBCMainEditor::newSignal()
     itemToSignal.insert(newSigItem, sigPtr);
     parentItem->addChild(newSigItem);
     ui->treeDBC->setCurrentItem(newSigItem);
-    dbcFile->setDirtyFlag();
+    dbcFile->setDirtyFlag(msg);
 }
 
 //gets confirmation before calling the real routines that delete things
@@ -949,7 +949,7 @@ void DBCMainEditor::deleteMessage(DBC_MESSAGE *msg)
     messageToItem.remove(msg);
     ui->treeDBC->removeItemWidget(currItem, 0);
     delete currItem;
-    dbcFile->setDirtyFlag();
+    dbcFile->setDirtyFlag(nullptr); //the message is gone so nothing saved for it gets used again
 }
 
 void DBCMainEditor::deleteSignal(DBC_SIGNAL *sig)
@@ -957,11 +957,12 @@ void DBCMainEditor::deleteSignal(DBC_SIGNAL *sig)
     qDebug() << "Signal about to vanish.";
     if (!signalToItem.contains(sig)) return;
     QTreeWidgetItem *currItem = signalToItem[sig];
-    sig->parentMessage->sigHandler->removeSignal(sig);
+    DBC_MESSAGE *msg = sig->parentMessage;
+    msg->sigHandler->removeSignal(sig);
 
     itemToSignal.remove(currItem);
     signalToItem.remove(sig);
     ui->treeDBC->removeItemWidget(currItem, 0);
     //delete currItem; //already removed by above remove call
-    dbcFile->setDirtyFlag();
+    dbcFile->setDirtyFlag(msg);
 }
@@ -24,7 +24,7 @@ DBCMessageEditor::DBCMessageEditor(QWidget *parent) :
         {
             if (dbcMessage == nullptr) return;
             if (suppressEditCallbacks) return;
-            if (dbcMessage->comment != ui->lineComment->text()) dbcFile->setDirtyFlag();
+            if (dbcMessage->comment != ui->lineComment->text()) dbcFile->setDirtyFlag(dbcMessage);
             dbcMessage->comment = ui->lineComment->text();
             emit updatedTreeInfo(dbcMessage);
         });
@@ -34,7 +34,7 @@ DBCMessageEditor::DBCMessageEditor(QWidget *parent) :
         {
             if (dbcMessage == nullptr) return;
             if (suppressEditCallbacks) return;
-            if ((dbcMessage->ID & 0x1FFFFFFFul) != Utility::ParseStringToNum(ui->lineFrameID->text())) dbcFile->setDirtyFlag();
+            if ((dbcMessage->ID & 0x1FFFFFFFul) != Utility::ParseStringToNum(ui->lineFrameID->text())) dbcFile->setDirtyFlag(dbcMessage);
             dbcMessage->ID = Utility::ParseStringToNum(ui->lineFrameID->text());
             emit updatedTreeInfo(dbcMessage);
         });
@@ -44,7 +44,7 @@ DBCMessageEditor::DBCMessageEditor(QWidget *parent) :
         {
             if (dbcMessage == nullptr) return;
             if (suppressEditCallbacks) return;
-            if (dbcMessage->name != ui->lineMsgName->text().simplified().replace(' ', '_')) dbcFile->setDirtyFlag();
+            if (dbcMessage->name != ui->lineMsgName->text().simplified().replace(' ', '_')) dbcFile->setDirtyFlag(dbcMessage);
             dbcMessage->name = ui->lineMsgName->text().simplified().replace(' ', '_');
             emit updatedTreeInfo(dbcMessage);
         });
@@ -54,7 +54,7 @@ DBCMessageEditor::DBCMessageEditor(QWidget *parent) :
         {
             if (dbcMessage == nullptr) return;
             if (suppressEditCallbacks) return;
-            if (dbcMessage->len != Utility::ParseStringToNum(ui->lineFrameLen->text())) dbcFile->setDirtyFlag();
+            if (dbcMessage->len != Utility::ParseStringToNum(ui->lineFrameLen->text())) dbcFile->setDirtyFlag(dbcMessage);
             dbcMessage->len = Utility::ParseStringToNum(ui->lineFrameLen->text());
         });
 
@@ -65,7 +65,7 @@ DBCMessageEditor::DBCMessageEditor(QWidget *parent) :
                 if (suppressEditCallbacks) return;
                 DBC_NODE *node = dbcFile->findNodeByName(newText);
                 if (!node) return;
-                if (node != dbcMessage->sender) dbcFile->setDirtyFlag();
+                if (node != dbcMessage->sender) dbcFile->setDirtyFlag(dbcMessage);
                 dbcMessage->sender = node;
                 emit updatedTreeInfo(dbcMessage);
             });
@@ -85,7 +85,7 @@ DBCMessageEditor::DBCMessageEditor(QWidget *parent) :
                     node = dbcFile->findNodeByName(newText);
                     ui->comboSender->addItem(newText);
                 }
-                if (node != dbcMessage->sender) dbcFile->setDirtyFlag();
+                if (node != dbcMessage->sender) dbcFile->setDirtyFlag(dbcMessage);
                 dbcMessage->sender = node;
                 emit updatedTreeInfo(dbcMessage);
             });
@@ -95,7 +95,7 @@ DBCMessageEditor::DBCMessageEditor(QWidget *parent) :
         {
             if (suppressEditCallbacks) return;
             QColor newColor = QColorDialog::getColor(dbcMessage->fgColor);
-            if (dbcMessage->fgColor != newColor) dbcFile->setDirtyFlag();
+            if (dbcMessage->fgColor != newColor) dbcFile->setDirtyFlag(dbcMessage);
             dbcMessage->fgColor = newColor;
             DBC_ATTRIBUTE_VALUE *val = dbcMessage->findAttrValByName("GenMsgForegroundColor");
             if (val)
@@ -105,7 +105,7 @@ DBCMessageEditor::DBCMessageEditor(QWidget *parent) :
             else
             {
                 DBC_ATTRIBUTE_VALUE newVal;
-                newVal.attrName = "GenMsgForegroundColor";
+                newVal.setAttrName("GenMsgForegroundColor");
                 newVal.value = newColor.name();
                 dbcMessage->attributes.append(newVal);
             }
@@ -117,7 +117,7 @@ DBCMessageEditor::DBCMessageEditor(QWidget *parent) :
         {
             if (suppressEditCallbacks) return;
             QColor newColor = QColorDialog::getColor(dbcMessage->bgColor);
-            if (dbcMessage->bgColor != newColor) dbcFile->setDirtyFlag();
+            if (dbcMessage->bgColor != newColor) dbcFile->setDirtyFlag(dbcMessage);
             dbcMessage->bgColor = newColor;
             DBC_ATTRIBUTE_VALUE *val = dbcMessage->findAttrValByName("GenMsgBackgroundColor");
             if (val)
@@ -127,7 +127,7 @@ DBCMessageEditor::DBCMessageEditor(QWidget *parent) :
             else
             {
                 DBC_ATTRIBUTE_VALUE newVal;
-                newVal.attrName = "GenMsgBackgroundColor";
+                newVal.setAttrName("GenMsgBackgroundColor");
                 newVal.value = newColor.name();
                 dbcMessage->attributes.append(newVal);
             }
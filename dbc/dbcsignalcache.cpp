@@ -0,0 +1,144 @@
+#include "dbcsignalcache.h"
+#include "dbchandler.h"
+#include "utility.h"
+#include <QSettings>
+#include <QDebug>
+
+DBCSignalCache* DBCSignalCache::instance = nullptr;
+
+qint64 DBCSignalSeries::memoryUsed() const
+{
+    return static_cast<qint64>(times.capacity()) * sizeof(int64_t)
+         + static_cast<qint64>(values.capacity()) * sizeof(double)
+         + static_cast<qint64>(rawValues.capacity()) * sizeof(int64_t)
+         + static_cast<qint64>(frameIndexes.capacity()) * sizeof(int);
+}
+
+DBCSignalCache::DBCSignalCache()
+{
+    QSettings settings;
+    memoryBudget = settings.value("Main/SignalCacheMB", 256).toLongLong() * 1024ll * 1024ll;
+    dbcGeneration = DBCHandler::getReference()->getChangeCounter();
+    useCounter = 0;
+}
+
+DBCSignalCache* DBCSignalCache::getReference()
+{
+    if (!instance) instance = new DBCSignalCache();
+    return instance;
+}
+
+void DBCSignalCache::clear()
+{
+    entries.clear();
+}
+
+//hooked up to MainWindow::framesUpdated. Anything other than new frames arriving means the frame list was cleared
+//or rewritten so none of the stored indexes or values can be trusted any longer.
+void DBCSignalCache::framesUpdated(int numFrames)
+{
+    if (numFrames < 0) clear();
+}
+
+/*
+ * Returns the decoded history of sig as seen on the given bus (-1 = any bus). The returned arrays are implicitly
+ * shared with the cache so this is cheap to call and the caller can hang on to the result as long as it wants.
+*/
+DBCSignalSeries DBCSignalCache::getSeries(DBC_SIGNAL *sig, int bus, const QVector<CANFrame> *frames)
+{
+    if (!sig || !sig->parentMessage || !frames) return DBCSignalSeries();
+
+    int currentGeneration = DBCHandler::getReference()->getChangeCounter();
+    if (currentGeneration != dbcGeneration)
+    {
+        //signals may have been edited, moved, or deleted. Nothing here is trustworthy any longer
+        clear();
+        dbcGeneration = currentGeneration;
+    }
+
+    QPair<DBC_SIGNAL*, int> key(sig, bus);
+    CacheEntry &entry = entries[key];
+
+    //a shorter list than we've already gone through or a different list entirely means start over. So does a list
+    //that had old frames trimmed off the front, which shifts every row; the last frame scanned won't be where it was
+    bool rewritten = (entry.framesScanned > frames->count());
+    if (!rewritten && entry.framesScanned > 0)
+    {
+        const CANFrame &last = frames->at(entry.framesScanned - 1);
+        rewritten = (last.timeStamp().microSeconds() != entry.lastScannedTime || last.frameId() != entry.lastScannedID);
+    }
+    if (entry.frames != frames || rewritten)
+    {
+        entry.series = DBCSignalSeries();
+        entry.frames = frames;
+        entry.framesScanned = 0;
+    }
+
+    if (entry.framesScanned < frames->count()) appendFrames(sig, bus, entry);
+    entry.lastUsed = ++useCounter;
+
+    DBCSignalSeries result = entry.series;
+    enforceBudget(key);
+    return result;
+}
+
+void DBCSignalCache::appendFrames(DBC_SIGNAL *sig, int bus, CacheEntry &entry)
+{
+    const QVector<CANFrame> &frames = *entry.frames;
+    uint32_t msgID = sig->parentMessage->ID;
+    bool isSigned = (sig->valType == SIGNED_INT);
+    double value;
+
+    for (int i = entry.framesScanned; i < frames.count(); i++)
+    {
+        const CANFrame &frame = frames[i];
+        if (frame.frameId() != msgID) continue;
+        if (frame.frameType() != QCanBusFrame::DataFrame) continue;
+        if (bus != -1 && frame.bus != bus) continue;
+        if (!sig->isSignalInMessage(frame)) continue;
+
+        int64_t raw = Utility::processIntegerSignal(frame.payload(), sig->startBit, sig->signalSize, sig->intelByteOrder, isSigned);
+        if (!sig->processAsDouble(frame, value)) value = (raw * sig->factor) + sig->bias;
+
+        entry.series.times.append(frame.timeStamp().microSeconds());
+        entry.series.values.append(value);
+        entry.series.rawValues.append(raw);
+        entry.series.frameIndexes.append(i);
+    }
+    entry.framesScanned = frames.count();
+    if (!frames.isEmpty())
+    {
+        entry.lastScannedTime = frames.last().timeStamp().microSeconds();
+        entry.lastScannedID = frames.last().frameId();
+    }
+}
+
+//Throw out the least recently used series until we fit in the budget again. The series that was just asked for
+//is never evicted to make room for others but if it alone is over budget it doesn't get to stay either.
+void DBCSignalCache::enforceBudget(const QPair<DBC_SIGNAL*, int> &keep)
+{
+    qint64 total = 0;
+    for (QHash<QPair<DBC_SIGNAL*, int>, CacheEntry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it)
+    {
+        total += it.value().series.memoryUsed();
+    }
+
+    while (total > memoryBudget && entries.count() > 1)
+    {
+        QHash<QPair<DBC_SIGNAL*, int>, CacheEntry>::iterator oldest = entries.end();
+        for (QHash<QPair<DBC_SIGNAL*, int>, CacheEntry>::iterator it = entries.begin(); it != entries.end(); ++it)
+        {
+            if (it.key() == keep) continue;
+            if (oldest == entries.end() || it.value().lastUsed < oldest.value().lastUsed) oldest = it;
+        }
+        if (oldest == entries.end()) break;
+        total -= oldest.value().series.memoryUsed();
+        entries.erase(oldest);
+    }
+
+    if (total > memoryBudget)
+    {
+        qDebug() << "Signal series is larger than the whole signal cache budget. Not keeping it.";
+        entries.remove(keep);
+    }
+}
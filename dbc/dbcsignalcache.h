@@ -0,0 +1,79 @@
+#ifndef DBCSIGNALCACHE_H
+#define DBCSIGNALCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPair>
+#include <QVector>
+#include "dbc_classes.h"
+#include "can_structs.h"
+
+/*
+ * Decoded time series for a single signal. Everything is columnar and indexed the same way so
+ * times[i], values[i], rawValues[i] and frameIndexes[i] all describe the same sample.
+ * times are the raw frame timestamps in microseconds, values are scaled like processAsDouble does it,
+ * rawValues are the unscaled integer bits (what value tables are keyed on) and frameIndexes point back
+ * into the frame list the series was built from.
+*/
+class DBCSignalSeries
+{
+public:
+    QVector<int64_t> times;
+    QVector<double> values;
+    QVector<int64_t> rawValues;
+    QVector<int> frameIndexes;
+
+    int count() const { return times.count(); }
+    qint64 memoryUsed() const;
+};
+
+/*
+ * Shared cache of decoded signal values. Every window that wants the history of a signal (graphs, the signal viewer, etc)
+ * used to decode it from scratch out of the whole frame list. Now the first one to ask pays for that and everyone after
+ * gets the same arrays back. Each series remembers how far into the frame list it has gotten so asking again after more
+ * traffic comes in only decodes the new frames.
+ *
+ * Series are keyed by signal and bus (-1 for any bus). The whole cache is dropped whenever anything in the loaded DBC files
+ * changes and whenever the frame list is cleared or replaced. Total size is kept under a memory budget
+ * (Main/SignalCacheMB in the settings) by throwing out the least recently used series first.
+ *
+ * Only meant to be used from the GUI thread, same as the frame list it reads from.
+*/
+class DBCSignalCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    DBCSignalSeries getSeries(DBC_SIGNAL *sig, int bus, const QVector<CANFrame> *frames);
+    void clear();
+    static DBCSignalCache *getReference();
+
+public slots:
+    void framesUpdated(int numFrames);
+
+private:
+    class CacheEntry
+    {
+    public:
+        CacheEntry() : frames(nullptr), framesScanned(0), lastScannedTime(0), lastScannedID(0), lastUsed(0) {}
+        DBCSignalSeries series;
+        const QVector<CANFrame> *frames;
+        int framesScanned;
+        int64_t lastScannedTime;    //the frame at framesScanned - 1. If it's a different frame now the list was rewritten
+        uint32_t lastScannedID;
+        quint64 lastUsed;
+    };
+
+    QHash<QPair<DBC_SIGNAL*, int>, CacheEntry> entries;
+    int dbcGeneration;
+    qint64 memoryBudget;
+    quint64 useCounter;
+
+    void appendFrames(DBC_SIGNAL *sig, int bus, CacheEntry &entry);
+    void enforceBudget(const QPair<DBC_SIGNAL*, int> &keep);
+
+    DBCSignalCache();
+    static DBCSignalCache *instance;
+};
+
+#endif // DBCSIGNALCACHE_H
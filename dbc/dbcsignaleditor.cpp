@@ -4,6 +4,7 @@
 #include <QDebug>
 #include <QMenu>
 #include <QSettings>
+#include <QTimer>
 #include <QRandomGenerator>
 #include <qevent.h>
 #include "helpwindow.h"
@@ -51,7 +52,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (currentSignal == nullptr) return;
                 if (currentSignal->intelByteOrder != ui->cbIntelFormat->isChecked())
                 {
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     pushToUndoBuffer();
                     currentSignal->intelByteOrder = ui->cbIntelFormat->isChecked();
                     //fillSignalForm(currentSignal);
@@ -68,7 +69,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 DBC_NODE *node = dbcFile->findNodeByName(ui->comboReceiver->currentText());
                 if (currentSignal->receiver != node)
                 {
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     pushToUndoBuffer();
                     currentSignal->receiver = node;
                 }
@@ -84,7 +85,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                     {
                         pushToUndoBuffer();
                         currentSignal->valType = UNSIGNED_INT;
-                        dbcFile->setDirtyFlag();
+                        dbcFile->setDirtyFlag(dbcMessage);
                         fillSignalForm(currentSignal);
                     }
                     break;
@@ -93,7 +94,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                     {
                         pushToUndoBuffer();
                         currentSignal->valType = SIGNED_INT;
-                        dbcFile->setDirtyFlag();
+                        dbcFile->setDirtyFlag(dbcMessage);
                         fillSignalForm(currentSignal);
                     }
                     break;
@@ -102,7 +103,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                     {
                         pushToUndoBuffer();
                         currentSignal->valType = SP_FLOAT;
-                        dbcFile->setDirtyFlag();
+                        dbcFile->setDirtyFlag(dbcMessage);
                         if (dbcMessage) //if we have a good msg reference we can use it to get the # of bytes expected.
                         {
                             int maxBit = ((dbcMessage->len * 8) - 32 + 7);
@@ -119,7 +120,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                     {
                         pushToUndoBuffer();
                         currentSignal->valType = DP_FLOAT;
-                        dbcFile->setDirtyFlag();
+                        dbcFile->setDirtyFlag(dbcMessage);
                         if (dbcMessage)
                         {
                             int maxBit = ((dbcMessage->len * 8) - 64 + 7);
@@ -135,7 +136,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                     {
                         pushToUndoBuffer();
                         currentSignal->valType = STRING;
-                        dbcFile->setDirtyFlag();
+                        dbcFile->setDirtyFlag(dbcMessage);
                         fillSignalForm(currentSignal);
                     }
                     break;
@@ -153,7 +154,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                     if (currentSignal->bias != temp)
                     {
                         pushToUndoBuffer();
-                        dbcFile->setDirtyFlag();
+                        dbcFile->setDirtyFlag(dbcMessage);
                         currentSignal->bias = temp;
                     }
                 }
@@ -171,7 +172,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                     if (currentSignal->max != temp)
                     {
                         pushToUndoBuffer();
-                        dbcFile->setDirtyFlag();
+                        dbcFile->setDirtyFlag(dbcMessage);
                         currentSignal->max = temp;
                     }
                 }
@@ -189,7 +190,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                     if (currentSignal->min != temp)
                     {
                         pushToUndoBuffer();
-                        dbcFile->setDirtyFlag();
+                        dbcFile->setDirtyFlag(dbcMessage);
                         currentSignal->min = temp;
                     }
                 }
@@ -207,7 +208,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                     if (currentSignal->factor != temp)
                     {
                         pushToUndoBuffer();
-                        dbcFile->setDirtyFlag();
+                        dbcFile->setDirtyFlag(dbcMessage);
                         currentSignal->factor = temp;
                     }
                 }
@@ -220,7 +221,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (currentSignal->comment != ui->txtComment->text().simplified().replace(' ','_'))
                 {
                     pushToUndoBuffer();
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     currentSignal->comment = ui->txtComment->text().simplified().replace(' ', '_');
                     emit updatedTreeInfo(currentSignal);
                 }
@@ -233,7 +234,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (currentSignal->unitName != ui->txtUnitName->text().simplified().replace(' ','_'))
                 {
                     pushToUndoBuffer();
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     currentSignal->unitName = ui->txtUnitName->text().simplified().replace(' ', '_');
                 }
             });
@@ -257,7 +258,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (currentSignal->signalSize != temp)
                 {
                     pushToUndoBuffer();
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     currentSignal->signalSize = temp;
                     //fillSignalForm(currentSignal);
                     refreshBitGrid();
@@ -273,7 +274,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (currentSignal->name != tempNameStr)
                 {
                     pushToUndoBuffer();
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     currentSignal->name = tempNameStr;
                     refreshBitGrid();
                     //need to update the tree too.
@@ -290,7 +291,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (currentSignal->multiplexLowValue != temp)
                 {
                     pushToUndoBuffer();
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     //TODO: could look up the multiplexor and ensure that the value is within a range that the multiplexor could return
                     currentSignal->multiplexLowValue = temp;
                 }
@@ -305,7 +306,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (currentSignal->multiplexHighValue != temp)
                 {
                     pushToUndoBuffer();
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     //TODO: could look up the multiplexor and ensure that the value is within a range that the multiplexor could return
                     currentSignal->multiplexHighValue = temp;
                 }
@@ -321,7 +322,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (!currentSignal->isMultiplexed || !currentSignal->isMultiplexor)
                 {
                     pushToUndoBuffer();
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     currentSignal->isMultiplexed = true;
                     currentSignal->isMultiplexor = true;
                     //an extended multi signal cannot be the root multiplexor for a message so make sure to remove it if it was.
@@ -343,7 +344,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (!currentSignal->isMultiplexed || currentSignal->isMultiplexor)
                 {
                     pushToUndoBuffer();
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     currentSignal->isMultiplexed = true;
                     currentSignal->isMultiplexor = false;
                     //if the set multiplexor for the message was this signal then clear it
@@ -364,7 +365,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (currentSignal->isMultiplexed || !currentSignal->isMultiplexor)
                 {
                     pushToUndoBuffer();
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     currentSignal->isMultiplexed = false;
                     currentSignal->isMultiplexor = true;
                     //we just set that this is the multiplexor so update the message to show that as well.
@@ -385,7 +386,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (currentSignal->isMultiplexed || currentSignal->isMultiplexor)
                 {
                     pushToUndoBuffer();
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     currentSignal->isMultiplexed = false;
                     currentSignal->isMultiplexor = false;
                     if (dbcMessage->multiplexorSignal == currentSignal) dbcMessage->multiplexorSignal = nullptr;
@@ -410,7 +411,7 @@ DBCSignalEditor::DBCSignalEditor(QWidget *parent) :
                 if (newSig && oldParent && (newSig != oldParent))
                 {
                     pushToUndoBuffer();
-                    dbcFile->setDirtyFlag();
+                    dbcFile->setDirtyFlag(dbcMessage);
                     oldParent->multiplexedChildren.removeOne(currentSignal);
                     currentSignal->multiplexParent = newSig;
                     newSig->multiplexedChildren.append(currentSignal);
@@ -545,6 +546,14 @@ void DBCSignalEditor::onValuesCellChanged(int row,int col)
     {
         currentSignal->valList[row].descript = ui->valuesTable->item(row, col)->text().simplified().replace(' ', '_');
     }
+    dbcFile->setDirtyFlag(dbcMessage);
+
+    //the value list has to stay sorted for lookups so if this edit moved things around the table rows no longer
+    //line up with the list. Redraw once the table is done processing this edit.
+    if (currentSignal->sortValueList())
+    {
+        QTimer::singleShot(0, this, [this]() { fillValueTable(currentSignal); });
+    }
 }
 
 void DBCSignalEditor::onCustomMenuValues(QPoint point)
@@ -564,6 +573,7 @@ void DBCSignalEditor::deleteCurrentValue()
     {
         ui->valuesTable->removeRow(currIdx);
         currentSignal->valList.removeAt(currIdx);
+        dbcFile->setDirtyFlag(dbcMessage);
     }
 }
 
@@ -909,6 +919,7 @@ void DBCSignalEditor::popFromUndoBuffer()
     undoBuffer.pop_back();
     currentSignal = sig.self; //restore the pointer
     *currentSignal = sig; //write the contents into the memory pointed to
+    if (dbcMessage) dbcMessage->touch(); //not the dirty flag, emptying the buffer might have just cleared it
 
     fillSignalForm(currentSignal);
     fillValueTable(currentSignal);
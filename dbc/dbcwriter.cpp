@@ -0,0 +1,501 @@
+#include "dbcwriter.h"
+
+#include <QFile>
+#include <QApplication>
+#include <QProgressDialog>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
+
+static const char dbcBoilerplate[] =
+    "VERSION \"\"\n"
+    "\n"
+    "\n"
+    "NS_ :\n"
+    "    NS_DESC_\n"
+    "    CM_\n"
+    "    BA_DEF_\n"
+    "    BA_\n"
+    "    VAL_\n"
+    "    CAT_DEF_\n"
+    "    CAT_\n"
+    "    FILTER\n"
+    "    BA_DEF_DEF_\n"
+    "    EV_DATA_\n"
+    "    ENVVAR_DATA_\n"
+    "    SGTYPE_\n"
+    "    SGTYPE_VAL_\n"
+    "    BA_DEF_SGTYPE_\n"
+    "    BA_SGTYPE_\n"
+    "    SIG_TYPE_REF_\n"
+    "    VAL_TABLE_\n"
+    "    SIG_GROUP_\n"
+    "    SIG_VALTYPE_\n"
+    "    SIGTYPE_VALTYPE_\n"
+    "    BO_TX_BU_\n"
+    "    BA_DEF_REL_\n"
+    "    BA_REL_\n"
+    "    BA_DEF_DEF_REL_\n"
+    "    BU_SG_REL_\n"
+    "    BU_EV_REL_\n"
+    "    BU_BO_REL_\n"
+    "    SG_MUL_VAL_\n"
+    "\n"
+    "BS_: \n";
+
+//QString::number and friends allocate a new string for every call. Integers are most of what gets written so
+//format them directly into the output instead.
+static inline void appendNumber(QByteArray &out, qint64 val)
+{
+    char buf[24];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    quint64 mag = (val < 0) ? (0 - static_cast<quint64>(val)) : static_cast<quint64>(val);
+    do
+    {
+        *--p = static_cast<char>('0' + (mag % 10));
+        mag /= 10;
+    } while (mag);
+    if (val < 0) *--p = '-';
+    out.append(p, static_cast<int>(end - p));
+}
+
+//same formatting QString::number(double) uses so files come out exactly as they always have
+static inline void appendNumber(QByteArray &out, double val)
+{
+    out.append(QByteArray::number(val));
+}
+
+static inline void appendString(QByteArray &out, const QString &str)
+{
+    out.append(str.toUtf8());
+}
+
+static void appendAttrValue(QByteArray &out, const DBC_ATTRIBUTE_VALUE &val)
+{
+    switch (val.value.type())
+    {
+    case QVariant::Type::String:
+        out.append('"');
+        appendString(out, val.value.toString());
+        out.append("\";\n");
+        break;
+    default:
+        appendString(out, val.value.toString());
+        out.append(";\n");
+        break;
+    }
+}
+
+//the ID as it appears in the file. Bit 31 flags an extended ID.
+static uint32_t outputID(const DBC_MESSAGE *msg)
+{
+    uint32_t ID = msg->ID;
+    if (msg->ID > 0x7FF || msg->extendedID)
+    {
+        ID += 0x80000000ul; //set bit 31 if this ID is extended.
+    }
+    return ID;
+}
+
+void DBCWriter::buildMessageSection(DBC_MESSAGE *msg, DBCMessageSection &section)
+{
+    uint32_t ID = outputID(msg);
+
+    section.definition.clear();
+    section.comments.clear();
+    section.attrValues.clear();
+    section.valueTables.clear();
+    section.extMultiplex.clear();
+    section.hasExtendedMultiplexing = false;
+
+    QByteArray &def = section.definition;
+    def.reserve(64 + msg->sigHandler->getCount() * 96);
+
+    def.append("BO_ ");
+    appendNumber(def, static_cast<qint64>(ID));
+    def.append(' ');
+    appendString(def, msg->name);
+    def.append(": ");
+    appendNumber(def, static_cast<qint64>(msg->len));
+    def.append(' ');
+    appendString(def, msg->sender->name);
+    def.append('\n');
+
+    if (msg->comment.length() > 0)
+    {
+        section.comments.append("CM_ BO_ ");
+        appendNumber(section.comments, static_cast<qint64>(ID));
+        section.comments.append(" \"");
+        appendString(section.comments, msg->comment);
+        section.comments.append("\";\n");
+    }
+
+    //If this message has attributes then compile them into attributes list to output later on.
+    for (int i = 0; i < msg->attributes.count(); i++)
+    {
+        section.attrValues.append("BA_ \"");
+        appendString(section.attrValues, msg->attributes[i].attrName());
+        section.attrValues.append("\" BO_ ");
+        appendNumber(section.attrValues, static_cast<qint64>(ID));
+        section.attrValues.append(' ');
+        appendAttrValue(section.attrValues, msg->attributes[i]);
+    }
+
+    for (int s = 0; s < msg->sigHandler->getCount(); s++)
+    {
+        DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
+
+        def.append("   SG_ ");
+        appendString(def, sig->name);
+
+        if (sig->isMultiplexed)
+        {
+            def.append(" m");
+            appendNumber(def, static_cast<qint64>(sig->multiplexLowValue));
+        }
+        if (sig->isMultiplexor)
+        {
+            if (!sig->isMultiplexed) def.append(' ');
+            def.append('M');
+        }
+        //check for the two telltale signs that we've got extended multiplexing going on.
+        if (sig->isMultiplexed && sig->isMultiplexor) section.hasExtendedMultiplexing = true;
+        if (sig->multiplexLowValue != sig->multiplexHighValue) section.hasExtendedMultiplexing = true;
+
+        def.append(" : ");
+        appendNumber(def, static_cast<qint64>(sig->startBit));
+        def.append('|');
+        appendNumber(def, static_cast<qint64>(sig->signalSize));
+        def.append('@');
+
+        switch (sig->valType)
+        {
+        case UNSIGNED_INT:
+            def.append(sig->intelByteOrder ? "1+" : "0+");
+            break;
+        case SIGNED_INT:
+            def.append(sig->intelByteOrder ? "1-" : "0-");
+            break;
+        case SP_FLOAT:
+            def.append(sig->intelByteOrder ? "5-" : "2-");
+            break;
+        case DP_FLOAT:
+            def.append(sig->intelByteOrder ? "6-" : "3-");
+            break;
+        case STRING:
+            def.append("4-");
+            break;
+        default:
+            def.append("0-");
+            break;
+        }
+
+        def.append(" (");
+        appendNumber(def, sig->factor);
+        def.append(',');
+        appendNumber(def, sig->bias);
+        def.append(") [");
+        appendNumber(def, sig->min);
+        def.append('|');
+        appendNumber(def, sig->max);
+        def.append("] \"");
+        appendString(def, sig->unitName);
+        def.append("\" ");
+        appendString(def, sig->receiver->name);
+        def.append('\n');
+
+        if (sig->comment.length() > 0)
+        {
+            section.comments.append("CM_ SG_ ");
+            appendNumber(section.comments, static_cast<qint64>(ID));
+            section.comments.append(' ');
+            appendString(section.comments, sig->name);
+            section.comments.append(" \"");
+            appendString(section.comments, sig->comment);
+            section.comments.append("\";\n");
+        }
+
+        //if this signal has attributes then compile them in a special list of attributes
+        for (int i = 0; i < sig->attributes.count(); i++)
+        {
+            section.attrValues.append("BA_ \"");
+            appendString(section.attrValues, sig->attributes[i].attrName());
+            section.attrValues.append("\" SG_ ");
+            appendNumber(section.attrValues, static_cast<qint64>(ID));
+            section.attrValues.append(' ');
+            appendString(section.attrValues, sig->name);
+            section.attrValues.append(' ');
+            appendAttrValue(section.attrValues, sig->attributes[i]);
+        }
+
+        if (sig->valList.count() > 0)
+        {
+            section.valueTables.append("VAL_ ");
+            appendNumber(section.valueTables, static_cast<qint64>(ID));
+            section.valueTables.append(' ');
+            appendString(section.valueTables, sig->name);
+            for (int v = 0; v < sig->valList.count(); v++)
+            {
+                section.valueTables.append(' ');
+                appendNumber(section.valueTables, static_cast<qint64>(sig->valList[v].value));
+                section.valueTables.append(" \"");
+                appendString(section.valueTables, sig->valList[v].descript);
+                section.valueTables.append('"');
+            }
+            section.valueTables.append(";\n");
+        }
+
+        //extended multiplexing records are only written if something in the file needs them but
+        //it's easiest to build them now and let serialize decide
+        if (sig->isMultiplexed)
+        {
+            section.extMultiplex.append("SG_MUL_VAL_ ");
+            appendNumber(section.extMultiplex, static_cast<qint64>(ID));
+            section.extMultiplex.append(' ');
+            appendString(section.extMultiplex, sig->name);
+            section.extMultiplex.append(' ');
+            appendString(section.extMultiplex, sig->multiplexParent->name);
+            section.extMultiplex.append(' ');
+            appendNumber(section.extMultiplex, static_cast<qint64>(sig->multiplexLowValue));
+            section.extMultiplex.append('-');
+            appendNumber(section.extMultiplex, static_cast<qint64>(sig->multiplexHighValue));
+            section.extMultiplex.append(";\n");
+        }
+    }
+    def.append('\n');
+}
+
+QByteArray DBCWriter::serialize(DBCFile *file)
+{
+    int nodeNumber = 1;
+    int msgNumber = 1;
+    int sigNumber = 1;
+    bool hasExtendedMultiplexing = false;
+    QByteArray output, commentsOutput, attrValOutput, valuesOutput, extMultiplexOutput, defaultsOutput;
+    QHash<uint32_t, DBCMessageSection> sections;
+
+    //size the buffer off of the last save if there was one so it doesn't have to keep growing
+    qint64 estimate = 4096 + file->messageHandler->getCount() * 512;
+    for (QHash<uint32_t, DBCMessageSection>::const_iterator it = file->savedSections.constBegin(); it != file->savedSections.constEnd(); ++it)
+    {
+        estimate += it.value().definition.size();
+    }
+    output.reserve(static_cast<int>(qMin(estimate, static_cast<qint64>(0x3FFFFFFF))));
+
+    //right now it outputs a standard hard coded boilerplate
+    output.append(dbcBoilerplate);
+
+    //Build list of nodes line
+    output.append("BU_: ");
+    for (int x = 0; x < file->dbc_nodes.count(); x++)
+    {
+        const DBC_NODE &node = file->dbc_nodes[x];
+        if (node.name.compare("Vector__XXX", Qt::CaseInsensitive) != 0)
+        {
+            QString nodeName = node.name;
+            if (nodeName.length() < 1) //detect an empty string and fill it out with something
+            {
+                nodeName = "NODE" + QString::number(nodeNumber);
+                nodeNumber++;
+            }
+            appendString(output, nodeName);
+            output.append(' ');
+            if (node.comment.length() > 0)
+            {
+                commentsOutput.append("CM_ BU_ ");
+                appendString(commentsOutput, nodeName);
+                commentsOutput.append(" \"");
+                appendString(commentsOutput, node.comment);
+                commentsOutput.append("\";\n");
+            }
+            for (int i = 0; i < node.attributes.count(); i++)
+            {
+                attrValOutput.append("BA_ \"");
+                appendString(attrValOutput, node.attributes[i].attrName());
+                attrValOutput.append("\" BU_ ");
+                appendAttrValue(attrValOutput, node.attributes[i]);
+            }
+        }
+    }
+    output.append('\n');
+
+    //Go through all messages one at at time issuing the message line then all signals in there too.
+    for (int x = 0; x < file->messageHandler->getCount(); x++)
+    {
+        DBC_MESSAGE *msg = file->messageHandler->findMsgByIdx(x);
+
+        if (msg->name.length() < 1) //detect an empty string and fill it out with something
+        {
+            msg->name = "MSG" + QString::number(msgNumber);
+            msgNumber++;
+        }
+        for (int s = 0; s < msg->sigHandler->getCount(); s++)
+        {
+            DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(s);
+            if (sig->name.length() < 1)
+            {
+                sig->name = "SIG" + QString::number(sigNumber);
+                sigNumber++;
+            }
+        }
+
+        uint32_t ID = outputID(msg);
+        DBCMessageSection section = file->savedSections.value(ID);
+        if (section.stamp != msg->changeStamp)
+        {
+            buildMessageSection(msg, section);
+            section.stamp = msg->changeStamp;
+        }
+        sections.insert(ID, section);
+
+        output.append(section.definition);
+        commentsOutput.append(section.comments);
+        attrValOutput.append(section.attrValues);
+        valuesOutput.append(section.valueTables);
+        extMultiplexOutput.append(section.extMultiplex);
+        if (section.hasExtendedMultiplexing) hasExtendedMultiplexing = true;
+    }
+    //only keep sections for messages that still exist
+    file->savedSections = sections;
+
+    output.append(commentsOutput);
+    commentsOutput.clear();
+
+    //Now dump out all of the stored attributes
+    for (int x = 0; x < file->dbc_attributes.count(); x++)
+    {
+        const DBC_ATTRIBUTE &attr = file->dbc_attributes[x];
+        output.append("BA_DEF_ ");
+        switch (attr.attrType)
+        {
+        case ATTR_TYPE_GENERAL:
+            break;
+        case ATTR_TYPE_NODE:
+            output.append("BU_ ");
+            break;
+        case ATTR_TYPE_MESSAGE:
+            output.append("BO_ ");
+            break;
+        case ATTR_TYPE_SIG:
+            output.append("SG_ ");
+            break;
+        case ATTR_TYPE_ANY:
+            break;
+        }
+
+        output.append('"');
+        appendString(output, attr.name);
+        output.append("\" ");
+
+        switch (attr.valType)
+        {
+        case ATTR_INT:
+            output.append("INT ");
+            appendNumber(output, attr.lower);
+            output.append(' ');
+            appendNumber(output, attr.upper);
+            break;
+        case ATTR_FLOAT:
+            output.append("FLOAT ");
+            appendNumber(output, attr.lower);
+            output.append(' ');
+            appendNumber(output, attr.upper);
+            break;
+        case ATTR_STRING:
+            output.append("STRING ");
+            break;
+        case ATTR_ENUM:
+            output.append("ENUM ");
+            foreach (QString str, attr.enumVals)
+            {
+                output.append('"');
+                appendString(output, str);
+                output.append("\",");
+            }
+            output.chop(1); //remove trailing ,
+            break;
+        }
+
+        output.append(";\n");
+
+        if (attr.defaultValue.isValid())
+        {
+            defaultsOutput.append("BA_DEF_DEF_ \"");
+            appendString(defaultsOutput, attr.name);
+            defaultsOutput.append("\" ");
+            switch (attr.valType)
+            {
+            case ATTR_STRING:
+                defaultsOutput.append('"');
+                appendString(defaultsOutput, attr.defaultValue.toString());
+                defaultsOutput.append("\";\n");
+                break;
+            case ATTR_ENUM:
+                defaultsOutput.append('"');
+                appendString(defaultsOutput, attr.enumVals[attr.defaultValue.toInt()]);
+                defaultsOutput.append("\";\n");
+                break;
+            case ATTR_INT:
+                appendNumber(defaultsOutput, static_cast<qint64>(attr.defaultValue.toLongLong()));
+                defaultsOutput.append(";\n");
+                break;
+            case ATTR_FLOAT:
+                appendString(defaultsOutput, attr.defaultValue.toString());
+                defaultsOutput.append(";\n");
+                break;
+            }
+        }
+    }
+
+    //now write out all of the accumulated comments and value tables from above
+    output.append(defaultsOutput);
+    output.append(attrValOutput);
+    output.append(valuesOutput);
+    //extended multiplexing uses SG_MUL_VAL_ to specify the relationships. We've already given the single value
+    //multiplex above for backward compatibility with things that don't support extended mode
+    if (hasExtendedMultiplexing) output.append(extMultiplexOutput);
+
+    return output;
+}
+
+bool DBCWriter::writeFile(DBCFile *file, QString fileName)
+{
+    QFile outFile(fileName);
+
+    if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        return false;
+    }
+
+    QByteArray output = serialize(file);
+    bool result = (outFile.write(output) == output.size());
+    outFile.close();
+    return result;
+}
+
+bool DBCWriter::writeFileInBackground(DBCFile *file, QString fileName)
+{
+    QFuture<bool> future = QtConcurrent::run(&DBCWriter::writeFile, file, fileName);
+
+    QProgressDialog progress(QApplication::activeWindow());
+    progress.setWindowModality(Qt::ApplicationModal);
+    progress.setLabelText(QObject::tr("Saving DBC file..."));
+    progress.setCancelButton(nullptr);
+    progress.setRange(0, 0);
+    progress.setMinimumDuration(0);
+
+    QFutureWatcher<bool> watcher;
+    QEventLoop loop;
+    QObject::connect(&watcher, &QFutureWatcher<bool>::finished, &loop, &QEventLoop::quit);
+    watcher.setFuture(future);
+
+    if (!future.isFinished())
+    {
+        progress.show();
+        loop.exec();
+    }
+    progress.cancel();
+
+    return future.result();
+}
@@ -0,0 +1,31 @@
+#ifndef DBCWRITER_H
+#define DBCWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include "dbchandler.h"
+
+/*
+ * Turns a DBCFile back into DBC text. The output goes straight into one preallocated byte buffer with hand rolled
+ * integer formatting instead of being built up from piles of temporary QStrings.
+ *
+ * Everything a message contributes to the file (its BO_/SG_ block plus its comments, attribute values, value tables
+ * and extended multiplexing records) is formatted as a unit and remembered in DBCFile::savedSections along with the
+ * message's change stamp. The editors give a message a new stamp whenever they change it so the next save reuses the
+ * stored text for every message with the same stamp and after a small edit only the touched messages get formatted again.
+ *
+ * writeFileInBackground does the work on a worker thread and keeps an application modal progress dialog up in the
+ * meantime. The GUI keeps painting but nobody can edit the file out from under the writer.
+*/
+class DBCWriter
+{
+public:
+    static QByteArray serialize(DBCFile *file);
+    static bool writeFile(DBCFile *file, QString fileName);
+    static bool writeFileInBackground(DBCFile *file, QString fileName);
+
+private:
+    static void buildMessageSection(DBC_MESSAGE *msg, DBCMessageSection &section);
+};
+
+#endif // DBCWRITER_H
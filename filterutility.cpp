@@ -63,18 +63,27 @@ QListWidgetItem * FilterUtility::createCheckableBusFilterItem(uint32_t id, bool
 QListWidgetItem * FilterUtility::createFilterItem(uint32_t id, QListWidget* parent)
 {
     QSettings settings;
-    DBCHandler * dbcHandler = DBCHandler::getReference();
     QListWidgetItem *thisItem = new QListWidgetItem(parent);
-    QString filterItemName = Utility::formatCANID(id);
+    QString tooltip;
 
     //Note, there are multiple filter labeling preferences. There is one in main settings to globally
     //enable or disable them all. Then each loaded DBC file also can be selected on/off
     //Both must be enabled for you to see labeling.
-    if (settings.value("Main/FilterLabeling", false).toBool())
+    thisItem->setText(getFilterLabel(id, settings.value("Main/FilterLabeling", false).toBool(), &tooltip));
+    if (!tooltip.isEmpty()) thisItem->setToolTip(tooltip);
+    return thisItem;
+}
+
+//ID formatted like everywhere else, followed by the message name from the DBC files if labeling is turned on
+QString FilterUtility::getFilterLabel(uint32_t id, bool useLabeling, QString *tooltip)
+{
+    QString filterItemName = Utility::formatCANID(id);
+
+    if (useLabeling)
     {
         // Filter labeling (show interpreted frame names next to the CAN addr ID)
         MatchingCriteria_t matchingCriteria;
-        DBC_MESSAGE *msg = dbcHandler->findMessageForFilter(id,&matchingCriteria);
+        DBC_MESSAGE *msg = DBCHandler::getReference()->findMessageForFilter(id,&matchingCriteria);
         if (msg != nullptr)
         {
             filterItemName.append(" ");
@@ -82,30 +91,36 @@ QListWidgetItem * FilterUtility::createFilterItem(uint32_t id, QListWidget* pare
 
             // Create tooltip to show the whole name just in case it's too long to fit in the filter window.
             // Also if the matching criteria is set to GMLAN, show the Arbitration ID as well
-            QString tooltip;
-            if (matchingCriteria == GMLAN)
-                tooltip.append("0x" + QString::number(FilterUtility::getGMLanArbitrationId(id), 16).toUpper().rightJustified(4,'0') + ": ");
-            tooltip.append(msg->name);
-            thisItem->setToolTip(tooltip);
+            if (tooltip)
+            {
+                tooltip->clear();
+                if (matchingCriteria == GMLAN)
+                    tooltip->append("0x" + QString::number(FilterUtility::getGMLanArbitrationId(id), 16).toUpper().rightJustified(4,'0') + ": ");
+                tooltip->append(msg->name);
+            }
         }
     }
 
-    thisItem->setText(filterItemName);
-    return thisItem;
+    return filterItemName;
 }
 
 QListWidgetItem * FilterUtility::createBusFilterItem(uint32_t id, QListWidget* parent)
 {
     QSettings settings;
-    DBCHandler * dbcHandler = DBCHandler::getReference();
     QListWidgetItem *thisItem = new QListWidgetItem(parent);
+    thisItem->setText(getBusFilterLabel(id, settings.value("Main/FilterLabeling", false).toBool()));
+    return thisItem;
+}
+
+QString FilterUtility::getBusFilterLabel(uint32_t id, bool useLabeling)
+{
     QString filterItemName = QStringLiteral("%1").arg(id);
 
-    if (settings.value("Main/FilterLabeling", false).toBool())
+    if (useLabeling)
     {
         // Filter labeling (show interpreted frame names next to the CAN addr ID)
         MatchingCriteria_t matchingCriteria;
-        DBC_MESSAGE *msg = dbcHandler->findMessageForFilter(id,&matchingCriteria);
+        DBC_MESSAGE *msg = DBCHandler::getReference()->findMessageForFilter(id,&matchingCriteria);
         if (msg != NULL)
         {
             filterItemName.append(" ");
@@ -113,6 +128,5 @@ QListWidgetItem * FilterUtility::createBusFilterItem(uint32_t id, QListWidget* p
         }
     }
 
-    thisItem->setText(filterItemName);
-    return thisItem;
+    return filterItemName;
 }
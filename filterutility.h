@@ -12,6 +12,8 @@ public:
     static QListWidgetItem * createCheckableFilterItem(uint32_t id, bool checked, QListWidget* parent=NULL);
     static QListWidgetItem * createBusFilterItem(uint32_t id, QListWidget* parent=NULL);   // if parent is given, add item automatically to listwidget
     static QListWidgetItem * createCheckableBusFilterItem(uint32_t id, bool checked, QListWidget* parent=NULL);
+    static QString getFilterLabel(uint32_t id, bool useLabeling, QString *tooltip=NULL);
+    static QString getBusFilterLabel(uint32_t id, bool useLabeling);
 
     static uint32_t getIdAsInt( QListWidgetItem * item );
     static QString getId( QListWidgetItem * item );
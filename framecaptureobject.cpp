@@ -0,0 +1,140 @@
+#include "framecaptureobject.h"
+
+FrameCaptureObject::FrameCaptureObject()
+{
+    mThread_p = new QThread();
+
+    qRegisterMetaType<QVector<CANFrame>>("QVector<CANFrame>");
+    qRegisterMetaType<CANFrameBatch>("CANFrameBatch");
+    qRegisterMetaType<CANFilterExpression>("CANFilterExpression");
+    qRegisterMetaType<QMap<int, bool>>("QMap<int,bool>");
+
+    idFiltersConfigured = false;
+    busFiltersConfigured = false;
+    filterGeneration = 0;
+    captureGeneration = 0;
+    timeOffset = 0;
+}
+
+FrameCaptureObject::~FrameCaptureObject()
+{
+    mThread_p->quit();
+    mThread_p->wait();
+    delete mThread_p;
+}
+
+//moves over to the capture thread. Until this is called everything runs right where it's called from
+void FrameCaptureObject::initialize()
+{
+    if (mThread_p->isRunning()) return;
+    moveToThread(mThread_p);
+    mThread_p->start(QThread::HighPriority);
+}
+
+//runs the reader with the statistics locked so they can't change part way through
+void FrameCaptureObject::readStats(const std::function<void(const CANFrameStats &)> &reader)
+{
+    statsMutex.lock();
+    reader(frameStats);
+    statsMutex.unlock();
+}
+
+//same but for the odd change from the GUI side, like handing over stats with detail
+void FrameCaptureObject::writeStats(const std::function<void(CANFrameStats &)> &writer)
+{
+    statsMutex.lock();
+    writer(frameStats);
+    statsMutex.unlock();
+}
+
+//for frames that get to the model some other way (loaded files, things added directly from the GUI)
+void FrameCaptureObject::addStats(const QVector<CANFrame> &frames)
+{
+    statsMutex.lock();
+    for (int i = 0; i < frames.count(); i++) frameStats.addFrame(frames[i]);
+    statsMutex.unlock();
+}
+
+void FrameCaptureObject::clearStats()
+{
+    statsMutex.lock();
+    frameStats.clear();
+    statsMutex.unlock();
+}
+
+bool FrameCaptureObject::anyDisabled(const QMap<int, bool> &map)
+{
+    for (auto const &val : map)
+    {
+        if (!val) return true;
+    }
+    return false;
+}
+
+void FrameCaptureObject::processFrames(const QVector<CANFrame> &frames)
+{
+    if (frames.isEmpty()) return;
+
+    CANFrameBatch batch;
+    batch.frames = frames;
+    batch.passed.resize(frames.count());
+    batch.filterGeneration = filterGeneration;
+    batch.captureGeneration = captureGeneration;
+    batch.timeOffset = timeOffset;
+    batch.filtersApplied = !filterExpression.usesSignals();
+
+    CANFrame *frameData = batch.frames.data();
+    bool *passed = batch.passed.data();
+
+    for (int i = 0; i < batch.frames.count(); i++)
+    {
+        CANFrame &frame = frameData[i];
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, frame.timeStamp().microSeconds() - timeOffset));
+
+        QMap<int, bool>::const_iterator idIt = filters.constFind(frame.frameId());
+        if (idIt == filters.constEnd())
+        {
+            //same rule the model has always used. Once anything is switched off new IDs come in switched off too
+            idIt = filters.insert(frame.frameId(), !idFiltersConfigured);
+            batch.newIDs.append(qMakePair(frame.frameId(), !idFiltersConfigured));
+        }
+        QMap<int, bool>::const_iterator busIt = busFilters.constFind(frame.bus);
+        if (busIt == busFilters.constEnd())
+        {
+            busIt = busFilters.insert(frame.bus, !busFiltersConfigured);
+            batch.newBuses.append(qMakePair(frame.bus, !busFiltersConfigured));
+        }
+
+        passed[i] = idIt.value() && busIt.value();
+        if (passed[i] && batch.filtersApplied && !filterExpression.isEmpty()) passed[i] = filterExpression.matches(frame);
+    }
+
+    statsMutex.lock();
+    for (int i = 0; i < batch.frames.count(); i++) frameStats.addFrame(frameData[i]);
+    statsMutex.unlock();
+
+    emit framesProcessed(batch);
+}
+
+//a fresh copy of the model's filters. Frames after this are checked against them and tagged with the generation
+void FrameCaptureObject::setFilters(const QMap<int, bool> &newFilters, const QMap<int, bool> &newBusFilters, const CANFilterExpression &expression, int generation)
+{
+    filters = newFilters;
+    busFilters = newBusFilters;
+    idFiltersConfigured = anyDisabled(filters);
+    busFiltersConfigured = anyDisabled(busFilters);
+    filterExpression = expression;
+    filterGeneration = generation;
+}
+
+void FrameCaptureObject::setTimeOffset(qint64 offset)
+{
+    timeOffset = offset;
+}
+
+//the model cleared its frames. Anything already on its way back will be thrown out when it gets there
+void FrameCaptureObject::resetCapture(int generation)
+{
+    captureGeneration = generation;
+    clearStats();
+}
@@ -0,0 +1,83 @@
+#ifndef FRAMECAPTUREOBJECT_H
+#define FRAMECAPTUREOBJECT_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QMap>
+#include <QPair>
+#include <QVector>
+#include <functional>
+#include "can_structs.h"
+#include "canframestats.h"
+#include "canfilterexpression.h"
+
+/*
+ * One lot of captured frames on its way from the capture thread back to CANFrameModel. Every frame already has the
+ * time offset taken off and passed[i] says whether frames[i] gets through the filters as they stood at
+ * filterGeneration. newIDs and newBuses are ones this lot turned up for the first time along with whether
+ * they start out enabled. captureGeneration goes up with every clear so frames from before one can be thrown out.
+*/
+class CANFrameBatch
+{
+public:
+    CANFrameBatch() : filterGeneration(0), captureGeneration(0), timeOffset(0), filtersApplied(false) {}
+    QVector<CANFrame> frames;
+    QVector<bool> passed;
+    QVector<QPair<uint32_t, bool>> newIDs;
+    QVector<QPair<int, bool>> newBuses;
+    int filterGeneration;
+    int captureGeneration;
+    int64_t timeOffset;
+    bool filtersApplied; //false when the filter expression uses DBC signals. Those can only be checked on the GUI thread
+};
+
+/*
+ * The per frame work of capturing traffic, done on its own thread instead of the GUI's. Frames from the connections come
+ * in here first to have their timestamps adjusted, go into the per ID statistics and get checked against a copy of
+ * the filters. What comes out is a CANFrameBatch that CANFrameModel can tack onto its lists in one go.
+ *
+ * Anything that changes what happens to new frames (filters, clearing, the time offset) is sent over as a queued call
+ * so it lands in order with the frames around it. The statistics belong to this object and are only touched with
+ * statsMutex held so the GUI can read them whenever it likes.
+*/
+class FrameCaptureObject : public QObject
+{
+    Q_OBJECT
+
+public:
+    FrameCaptureObject();
+    ~FrameCaptureObject();
+
+    void initialize();
+    void readStats(const std::function<void(const CANFrameStats &)> &reader);
+    void writeStats(const std::function<void(CANFrameStats &)> &writer);
+    void addStats(const QVector<CANFrame> &frames);
+    void clearStats();
+
+public slots:
+    void processFrames(const QVector<CANFrame> &frames);
+    void setFilters(const QMap<int, bool> &newFilters, const QMap<int, bool> &newBusFilters, const CANFilterExpression &expression, int generation);
+    void setTimeOffset(qint64 offset);
+    void resetCapture(int generation);
+
+signals:
+    void framesProcessed(const CANFrameBatch &batch);
+
+private:
+    static bool anyDisabled(const QMap<int, bool> &map);
+
+    QThread *mThread_p;
+    QMutex statsMutex;
+    CANFrameStats frameStats;
+    QMap<int, bool> filters;
+    QMap<int, bool> busFilters;
+    bool idFiltersConfigured;  //some ID is switched off so new ones start off too
+    bool busFiltersConfigured;
+    CANFilterExpression filterExpression;
+    int filterGeneration;
+    int captureGeneration;
+    int64_t timeOffset;
+};
+
+#endif // FRAMECAPTUREOBJECT_H
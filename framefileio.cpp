@@ -6,6 +6,7 @@
 #include <QRegularExpression>
 #include <QtEndian>
 #include <QSettings>
+#include <QThread>
 #include <iostream>
 #include <memory>
 #include "pcaplite.h"
@@ -32,7 +33,7 @@ FrameFileIO::FrameFileIO()
 {
 }
 
-bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* frameCache)
+bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* frameCache, const FrameSelection *selection)
 {
     QString filename;
     QFileDialog dialog(qApp->activeWindow());
@@ -74,10 +75,18 @@ bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* fram
 
         qApp->processEvents();
 
+        //the other writers go over the list more than once or look at its first frame so they get the frames on their own
+        QVector<CANFrame> selectedFrames;
+        if (selection && dialog.selectedNameFilter() != filters[0])
+        {
+            selection->copyTo(*frameCache, selectedFrames);
+            frameCache = &selectedFrames;
+        }
+
         if (dialog.selectedNameFilter() == filters[0])
         {
             if (!filename.contains('.')) filename += ".csv";
-            result = saveNativeCSVFile(filename, frameCache);
+            result = saveNativeCSVFile(filename, frameCache, selection);
         }
         if (dialog.selectedNameFilter() == filters[1])
         {
@@ -158,13 +167,9 @@ bool FrameFileIO::saveFrameFile(QString &fileName, const QVector<CANFrame>* fram
     return false;
 }
 
-bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache)
+//the load dialog's filters. The index of the one picked is the fileType the loaders below go by, 0 is autodetect
+QStringList FrameFileIO::loadFilters()
 {
-    QString filename;
-    QFileDialog dialog;
-    QSettings settings;
-    bool result = false;
-
     QStringList filters;
     filters.append(QString(tr("Autodetect File Type (*.*)")));
     filters.append(QString(tr("GVRET Logs (*.csv *.CSV)")));
@@ -191,17 +196,16 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
     filters.append(QString(tr("CLX000 (*.txt *.TXT)")));
     filters.append(QString(tr("CANServer Binary Log (*.log *.LOG)")));
     filters.append(QString(tr("Wireshark (*.pcap *.PCAP *.pcapng *.PCAPNG)")));
+    return filters;
+}
 
-    dialog.setDirectory(settings.value("FileIO/LoadSaveDirectory", dialog.directory().path()).toString());
-    dialog.setFileMode(QFileDialog::ExistingFile);
-    dialog.setNameFilters(filters);
-    dialog.setViewMode(QFileDialog::Detail);
+bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache)
+{
+    QString filename;
+    int fileType;
 
-    if (dialog.exec() == QDialog::Accepted)
+    if (pickLoadFile(filename, fileType))
     {
-        filename = dialog.selectedFiles()[0];
-        QString selectedNameFilter = dialog.selectedNameFilter();
-
         QProgressDialog progress(qApp->activeWindow());
         progress.setWindowModality(Qt::WindowModal);
         progress.setLabelText("Loading file...");
@@ -212,32 +216,7 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
 
         qApp->processEvents();
 
-        if (selectedNameFilter == filters[0]) result = autoDetectLoadFile(filename, frameCache);
-        if (selectedNameFilter == filters[1]) result = loadNativeCSVFile(filename, frameCache);
-        if (selectedNameFilter == filters[2]) result = loadCRTDFile(filename, frameCache);
-        if (selectedNameFilter == filters[3]) result = loadLogFile(filename, frameCache);
-        if (selectedNameFilter == filters[4]) result = loadMicrochipFile(filename, frameCache);
-        if (selectedNameFilter == filters[5]) result = loadTraceFile(filename, frameCache);
-        if (selectedNameFilter == filters[6]) result = loadIXXATFile(filename, frameCache);
-        if (selectedNameFilter == filters[7]) result = loadCANDOFile(filename, frameCache);
-        if (selectedNameFilter == filters[8]) result = loadVehicleSpyFile(filename, frameCache);
-        if (selectedNameFilter == filters[9]) result = loadCanDumpFile(filename, frameCache);
-        if (selectedNameFilter == filters[10]) result = loadLawicelFile(filename, frameCache);
-        if (selectedNameFilter == filters[11]) result = loadPCANFile(filename, frameCache);
-        if (selectedNameFilter == filters[12]) result = loadKvaserFile(filename, frameCache, false);
-        if (selectedNameFilter == filters[13]) result = loadKvaserFile(filename, frameCache, true);
-        if (selectedNameFilter == filters[14]) result = loadCanalyzerASC(filename, frameCache);
-        if (selectedNameFilter == filters[15]) result = loadCanalyzerBLF(filename, frameCache);
-        if (selectedNameFilter == filters[16]) result = loadCARBUSAnalyzerFile(filename, frameCache);
-        if (selectedNameFilter == filters[17]) result = loadCANHackerFile(filename, frameCache);
-        if (selectedNameFilter == filters[18]) result = loadGenericCSVFile(filename, frameCache);
-        if (selectedNameFilter == filters[19]) result = loadCabanaFile(filename, frameCache);
-        if (selectedNameFilter == filters[20]) result = loadCANOpenFile(filename, frameCache);
-        if (selectedNameFilter == filters[21]) result = loadTeslaAPFile(filename, frameCache);
-        if (selectedNameFilter == filters[22]) result = loadCLX000File(filename, frameCache);
-        if (selectedNameFilter == filters[23]) result = loadCANServerFile(filename, frameCache);
-        if (selectedNameFilter == filters[24]) result = loadWiresharkFile(filename, frameCache);
-
+        bool result = loadFileOfType(filename, fileType, frameCache);
 
         progress.cancel();
 
@@ -245,12 +224,11 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
         {
             QStringList fileList = filename.split('/');
             fileName = fileList[fileList.length() - 1];
-            settings.setValue("FileIO/LoadSaveDirectory", dialog.directory().path());
             return true;
         }
         else
         {
-            if (dialog.selectedNameFilter() != filters[0])
+            if (fileType != 0)
             {
                 QMessageBox msgBox;
                 msgBox.setText("File load completed with errors.\r\nPerhaps you selected the wrong file type?");
@@ -262,6 +240,117 @@ bool FrameFileIO::loadFrameFile(QString &fileName, QVector<CANFrame>* frameCache
     return false;
 }
 
+//just the file dialog. Gives back the full path and which of the load filters was picked
+bool FrameFileIO::pickLoadFile(QString &filename, int &fileType)
+{
+    QFileDialog dialog;
+    QSettings settings;
+
+    QStringList filters = loadFilters();
+
+    dialog.setDirectory(settings.value("FileIO/LoadSaveDirectory", dialog.directory().path()).toString());
+    dialog.setFileMode(QFileDialog::ExistingFile);
+    dialog.setNameFilters(filters);
+    dialog.setViewMode(QFileDialog::Detail);
+
+    if (dialog.exec() == QDialog::Accepted)
+    {
+        filename = dialog.selectedFiles()[0];
+        fileType = qMax(0, filters.indexOf(dialog.selectedNameFilter()));
+        settings.setValue("FileIO/LoadSaveDirectory", dialog.directory().path());
+        return true;
+    }
+    return false;
+}
+
+bool FrameFileIO::loadFileOfType(QString filename, int fileType, QVector<CANFrame>* frameCache)
+{
+    switch (fileType)
+    {
+    case 1: return loadNativeCSVFile(filename, frameCache);
+    case 2: return loadCRTDFile(filename, frameCache);
+    case 3: return loadLogFile(filename, frameCache);
+    case 4: return loadMicrochipFile(filename, frameCache);
+    case 5: return loadTraceFile(filename, frameCache);
+    case 6: return loadIXXATFile(filename, frameCache);
+    case 7: return loadCANDOFile(filename, frameCache);
+    case 8: return loadVehicleSpyFile(filename, frameCache);
+    case 9: return loadCanDumpFile(filename, frameCache);
+    case 10: return loadLawicelFile(filename, frameCache);
+    case 11: return loadPCANFile(filename, frameCache);
+    case 12: return loadKvaserFile(filename, frameCache, false);
+    case 13: return loadKvaserFile(filename, frameCache, true);
+    case 14: return loadCanalyzerASC(filename, frameCache);
+    case 15: return loadCanalyzerBLF(filename, frameCache);
+    case 16: return loadCARBUSAnalyzerFile(filename, frameCache);
+    case 17: return loadCANHackerFile(filename, frameCache);
+    case 18: return loadGenericCSVFile(filename, frameCache);
+    case 19: return loadCabanaFile(filename, frameCache);
+    case 20: return loadCANOpenFile(filename, frameCache);
+    case 21: return loadTeslaAPFile(filename, frameCache);
+    case 22: return loadCLX000File(filename, frameCache);
+    case 23: return loadCANServerFile(filename, frameCache);
+    case 24: return loadWiresharkFile(filename, frameCache);
+    default: return autoDetectLoadFile(filename, frameCache);
+    }
+}
+
+//where the frames of a streaming load on this thread go. Only set while streamFileOfType is running
+struct FrameFileStream
+{
+    const std::function<bool(QVector<CANFrame> &)> *sink;
+    QVector<CANFrame> *chunk;
+    int chunkSize;
+    bool stopped;
+};
+static thread_local FrameFileStream *activeStream = nullptr;
+
+/*
+ * Loads a file without ever holding more than chunkSize frames of it. Every loader adds its frames through
+ * appendLoadedFrame which hands each full chunk to the sink and starts a new one. The sink can return false to stop
+ * the load, the loaders check loadStopped() as they go and quit early. Safe to run off the GUI thread.
+*/
+bool FrameFileIO::streamFileOfType(QString filename, int fileType, const std::function<bool(QVector<CANFrame> &)> &sink, int chunkSize)
+{
+    QVector<CANFrame> chunk;
+    FrameFileStream stream;
+    stream.sink = &sink;
+    stream.chunk = &chunk;
+    stream.chunkSize = qMax(1, chunkSize);
+    stream.stopped = false;
+    chunk.reserve(stream.chunkSize);
+
+    FrameFileStream *previous = activeStream;
+    activeStream = &stream;
+    bool result = loadFileOfType(filename, fileType, &chunk);
+    if (!stream.stopped && !chunk.isEmpty() && !sink(chunk)) stream.stopped = true;
+    activeStream = previous;
+
+    return result && !stream.stopped;
+}
+
+void FrameFileIO::appendLoadedFrame(QVector<CANFrame> *frames, const CANFrame &frame)
+{
+    if (!activeStream || frames != activeStream->chunk)
+    {
+        frames->append(frame);
+        return;
+    }
+    if (activeStream->stopped) return;
+
+    frames->append(frame);
+    if (frames->count() >= activeStream->chunkSize)
+    {
+        if (!(*activeStream->sink)(*frames)) activeStream->stopped = true;
+        frames->resize(0);
+    }
+}
+
+bool FrameFileIO::loadStopped()
+{
+    return activeStream && activeStream->stopped;
+}
+
 
 //Try every format by first using the "is" functions which try to detect whether a given file is a good match to that
 //file format or not. Those functions are much less tolerant than the load functions and so should help to discriminate
@@ -504,9 +593,13 @@ bool FrameFileIO::autoDetectLoadFile(QString filename, QVector<CANFrame>* frames
         }
     }
 
-    QMessageBox msgBox;
-    msgBox.setText("Could not autodetect the file type.\rPlease try to manually select the file format.");
-    msgBox.exec();
+    //streaming loads run on worker threads where there's no popping up dialogs
+    if (QThread::currentThread() == qApp->thread())
+    {
+        QMessageBox msgBox;
+        msgBox.setText("Could not autodetect the file type.\rPlease try to manually select the file format.");
+        msgBox.exec();
+    }
     qDebug() << "Nothing worked... sorry...";
     return false;
 }
@@ -588,7 +681,7 @@ bool FrameFileIO::loadVehicleSpyFile(QString filename, QVector<CANFrame> *frames
 
     if (inFile->atEnd()) foundErrors = true;
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -620,7 +713,7 @@ bool FrameFileIO::loadVehicleSpyFile(QString filename, QVector<CANFrame> *frames
                 else break;
             }
             thisFrame.setPayload(bytes);
-            frames->append(thisFrame);
+            appendLoadedFrame(frames, thisFrame);
         }
         else foundErrors = true;
     }
@@ -730,7 +823,7 @@ bool FrameFileIO::loadCRTDFile(QString filename, QVector<CANFrame>* frames)
 
     line = inFile->readLine().toUpper(); //read out the header first and discard it.
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -783,7 +876,7 @@ bool FrameFileIO::loadCRTDFile(QString filename, QVector<CANFrame>* frames)
                         else bytes[d] = 0;
                     }
                     thisFrame.setPayload(bytes);
-                    frames->append(thisFrame);
+                    appendLoadedFrame(frames, thisFrame);
                 }
             }
             else foundErrors = true;
@@ -857,7 +950,7 @@ bool FrameFileIO::loadCARBUSAnalyzerFile(QString filename, QVector<CANFrame>* fr
         version = match.captured("version").toInt();
     }
 
-    while (!txt.atEnd()) {
+    while (!txt.atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -893,7 +986,7 @@ bool FrameFileIO::loadCARBUSAnalyzerFile(QString filename, QVector<CANFrame>* fr
                     else bytes[d] = 0;
                 }
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendLoadedFrame(frames, thisFrame);
             }
             else
             {
@@ -1021,7 +1114,7 @@ bool FrameFileIO::isCANHackerFile(QString filename)
         line = inFile->readLine().toUpper(); //read out the header first and discard it.
         if (line.contains("CANHACKER")) return true;
 
-        while (!inFile->atEnd()) {
+        while (!inFile->atEnd() && !loadStopped()) {
             lineCounter++;
             line = inFile->readLine().simplified();
             if (line.length() > 2)
@@ -1074,7 +1167,7 @@ bool FrameFileIO::loadCANHackerFile(QString filename, QVector<CANFrame>* frames)
 
     line = inFile->readLine().toUpper(); //read out the header first and discard it.
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -1126,7 +1219,7 @@ bool FrameFileIO::loadCANHackerFile(QString filename, QVector<CANFrame>* frames)
                     else bytes[d] = 0;
                 }
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendLoadedFrame(frames, thisFrame);
             }
             else foundErrors = true;
         }
@@ -1158,7 +1251,7 @@ bool FrameFileIO::isCANOpenFile(QString filename)
         line = inFile->readLine();
         line = inFile->readLine();
 
-        while (!inFile->atEnd()) {
+        while (!inFile->atEnd() && !loadStopped()) {
             lineCounter++;
             if (lineCounter > 10)
             {
@@ -1213,7 +1306,7 @@ bool FrameFileIO::loadCANOpenFile(QString filename, QVector<CANFrame>* frames)
     line = inFile->readLine();
     line = inFile->readLine();
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -1244,7 +1337,7 @@ bool FrameFileIO::loadCANOpenFile(QString filename, QVector<CANFrame>* frames)
                     else bytes[d] = 0;
                 }
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendLoadedFrame(frames, thisFrame);
             }
             else foundErrors = true;
         }
@@ -1332,7 +1425,7 @@ bool FrameFileIO::isPCANFile(QString filename)
 
     try
     {
-        while (!inFile->atEnd()) {
+        while (!inFile->atEnd() && !loadStopped()) {
             lineCounter++;
             if (lineCounter > 25)
             {
@@ -1408,7 +1501,7 @@ bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
         return false;
     }
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -1466,7 +1559,7 @@ bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
                             }
                         }
                         thisFrame.setPayload(bytes);
-                        frames->append(thisFrame);
+                        appendLoadedFrame(frames, thisFrame);
                     }
                 }
             }
@@ -1517,7 +1610,7 @@ bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
                             }
                         }
                         thisFrame.setPayload(bytes);
-                        frames->append(thisFrame);
+                        appendLoadedFrame(frames, thisFrame);
                     }
                 }
             }
@@ -1559,7 +1652,7 @@ bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
                             }
                         }
                         thisFrame.setPayload(bytes);
-                        frames->append(thisFrame);
+                        appendLoadedFrame(frames, thisFrame);
                     }
                 }
             }
@@ -1611,7 +1704,7 @@ bool FrameFileIO::loadPCANFile(QString filename, QVector<CANFrame>* frames)
                             }
                         }
                         thisFrame.setPayload(bytes);
-                        frames->append(thisFrame);
+                        appendLoadedFrame(frames, thisFrame);
                     }
                 }
             }
@@ -1711,7 +1804,7 @@ bool FrameFileIO::loadCanalyzerASC(QString filename, QVector<CANFrame>* frames)
         return false;
     }
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -1867,7 +1960,7 @@ bool FrameFileIO::loadCanalyzerASC(QString filename, QVector<CANFrame>* frames)
                         }
                         thisFrame.setPayload(bytes);
                     }
-                    frames->append(thisFrame);
+                    appendLoadedFrame(frames, thisFrame);
                 }
             }
         }
@@ -2077,7 +2170,7 @@ bool FrameFileIO::loadNativeCSVFile(QString filename, QVector<CANFrame>* frames)
     line = inFile->readLine().toUpper(); //read out the header first and discard it.
     if (line.at(23) == 'D') fileVersion = 2; //Dir is found starting at position 23 if this is a V2 file
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -2140,7 +2233,7 @@ bool FrameFileIO::loadNativeCSVFile(QString filename, QVector<CANFrame>* frames)
                     thisFrame.setPayload(bytes);
                 }
 
-                frames->append(thisFrame);
+                appendLoadedFrame(frames, thisFrame);
             }
             else foundErrors = true;
         }
@@ -2150,7 +2243,8 @@ bool FrameFileIO::loadNativeCSVFile(QString filename, QVector<CANFrame>* frames)
     return !foundErrors;
 }
 
-bool FrameFileIO::saveNativeCSVFile(QString filename, const QVector<CANFrame>* frames)
+//with a selection only the selected rows are written, picked straight out of frames as it goes
+bool FrameFileIO::saveNativeCSVFile(QString filename, const QVector<CANFrame>* frames, const FrameSelection *selection)
 {
     QFile *outFile = new QFile(filename);
     int lineCounter = 0;
@@ -2168,7 +2262,9 @@ bool FrameFileIO::saveNativeCSVFile(QString filename, const QVector<CANFrame>* f
     outFile->write("Time Stamp,ID,Extended,Dir,Bus,LEN,D1,D2,D3,D4,D5,D6,D7,D8");
     outFile->write("\n");
 
-    for (int c = 0; c < frames->count(); c++)
+    int end = frames->count();
+    if (selection) end = qMin(end, selection->total());
+    for (int c = selection ? selection->next(0) : 0; c < end; c = selection ? selection->next(c + 1) : c + 1)
     {
         lineCounter++;
         if (lineCounter > 100)
@@ -2382,7 +2478,7 @@ bool FrameFileIO::loadGenericCSVFile(QString filename, QVector<CANFrame>* frames
 
     line = inFile->readLine(); //read out the header first and discard it.
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -2410,7 +2506,7 @@ bool FrameFileIO::loadGenericCSVFile(QString filename, QVector<CANFrame>* frames
                 QByteArray bytes(dLen, 0);
                 for (int d = 0; d < dLen; d++) bytes[d] = static_cast<char>(dataTok[d].toInt(nullptr, 16));
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendLoadedFrame(frames, thisFrame);
             }
         }
         else foundErrors = true;
@@ -2570,7 +2666,7 @@ bool FrameFileIO::loadLogFile(QString filename, QVector<CANFrame>* frames)
 
     line = inFile->readLine(); //read out the header first and discard it.
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -2616,7 +2712,7 @@ bool FrameFileIO::loadLogFile(QString filename, QVector<CANFrame>* frames)
                         bytes[d] = static_cast<char>(tokens[d + 6].toInt(nullptr, 16));
                 }
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendLoadedFrame(frames, thisFrame);
             }
             else foundErrors = true;
         }
@@ -2761,7 +2857,7 @@ bool FrameFileIO::loadIXXATFile(QString filename, QVector<CANFrame>* frames)
 
     for (int i = 0; i < 7; i++) line = inFile->readLine(); //read out the header first and discard it.
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -2813,7 +2909,7 @@ bool FrameFileIO::loadIXXATFile(QString filename, QVector<CANFrame>* frames)
                 if (numBytes > 8) return false;
                 for (int d = 0; d < numBytes; d++) bytes[d] = static_cast<char>(dataToks[d].toInt(nullptr, 16));
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendLoadedFrame(frames, thisFrame);
             }
             else return false;
         }
@@ -2955,7 +3051,7 @@ bool FrameFileIO::loadCANDOFile(QString filename, QVector<CANFrame>* frames)
     //Bytes 2 - 3 are the data length (top 4 bits) then ID (bottom 11 bits)
     //Bytes 4 - 11 are the data bytes (padded with FF for bytes not used)
 
-    while (!inFile->atEnd())
+    while (!inFile->atEnd() && !loadStopped())
     {
         lineCounter++;
         if (lineCounter > 100)
@@ -2989,7 +3085,7 @@ bool FrameFileIO::loadCANDOFile(QString filename, QVector<CANFrame>* frames)
         {
             for (int d = 0; d < numBytes; d++) bytes[d] = data[4 + d];
             thisFrame.setPayload(bytes);
-            frames->append(thisFrame);
+            appendLoadedFrame(frames, thisFrame);
         }
         else foundErrors = true;
     }
@@ -3143,7 +3239,7 @@ bool FrameFileIO::loadMicrochipFile(QString filename, QVector<CANFrame>* frames)
 
     //line = inFile->readLine(); //read out the header first and discard it.
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -3180,7 +3276,7 @@ bool FrameFileIO::loadMicrochipFile(QString filename, QVector<CANFrame>* frames)
                         if (thisFrame.payload().length() + 4 > tokens.length()) thisFrame.payload().resize( tokens.length() - 4 );
                         for (int d = 0; d < numBytes; d++) bytes[d] = static_cast<char>( Utility::ParseStringToNum(tokens[4 + d]) );
                         thisFrame.setPayload(bytes);
-                        frames->append(thisFrame);
+                        appendLoadedFrame(frames, thisFrame);
                     }
                     else foundErrors = true;
                 }
@@ -3364,7 +3460,7 @@ bool FrameFileIO::loadTraceFile(QString filename, QVector<CANFrame>* frames)
         return false;
     }
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -3406,7 +3502,7 @@ bool FrameFileIO::loadTraceFile(QString filename, QVector<CANFrame>* frames)
                     //if (numBytes > dataToks.length()) thisFrame.payload().resize(dataToks.length());
                     for (int d = 0; d < numBytes; d++) bytes[d] = static_cast<char>(dataToks[d].toInt(nullptr, 16));
                     thisFrame.setPayload(bytes);
-                    frames->append(thisFrame);
+                    appendLoadedFrame(frames, thisFrame);
                 }
                 else foundErrors = true;
             }
@@ -3725,7 +3821,7 @@ bool FrameFileIO::loadCanDumpFile(QString filename, QVector<CANFrame>* frames)
         return false;
     }
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -3829,7 +3925,7 @@ bool FrameFileIO::loadCanDumpFile(QString filename, QVector<CANFrame>* frames)
             /*NB: should we make sure len <= 8? */
             thisFrame.isReceived = true;
        }
-       frames->append(thisFrame);
+       appendLoadedFrame(frames, thisFrame);
     }
     inFile->close();
     delete inFile;
@@ -3896,7 +3992,7 @@ bool FrameFileIO::loadLawicelFile(QString filename, QVector<CANFrame>* frames)
         return false;
     }
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -3920,7 +4016,7 @@ bool FrameFileIO::loadLawicelFile(QString filename, QVector<CANFrame>* frames)
                 bytes[d] = static_cast<char>(line.mid(d * 2, 2).toInt(nullptr, 16));
             }
             thisFrame.setPayload(bytes);
-            frames->append(thisFrame);
+            appendLoadedFrame(frames, thisFrame);
         }
     }
     inFile->close();
@@ -3997,7 +4093,7 @@ bool FrameFileIO::loadKvaserFile(QString filename, QVector<CANFrame> *frames, bo
 
     if (inFile->atEnd()) foundErrors = true;
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -4025,7 +4121,7 @@ bool FrameFileIO::loadKvaserFile(QString filename, QVector<CANFrame> *frames, bo
             if (line.mid(72, 1).toUpper() == "R") thisFrame.isReceived = true;
                 else thisFrame.isReceived = false;
             thisFrame.setPayload(bytes);
-            frames->append(thisFrame);
+            appendLoadedFrame(frames, thisFrame);
         }
         //else foundErrors = true;
     }
@@ -4105,7 +4201,7 @@ bool FrameFileIO::loadCabanaFile(QString filename, QVector<CANFrame>* frames)
 
     line = inFile->readLine().toUpper(); //read out the header first and discard it.
 
-    while (!inFile->atEnd()) {
+    while (!inFile->atEnd() && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -4176,7 +4272,7 @@ bool FrameFileIO::loadCabanaFile(QString filename, QVector<CANFrame>* frames)
                 }
                 
                 thisFrame.setPayload(finalbytes);
-                frames->append(thisFrame);
+                appendLoadedFrame(frames, thisFrame);
             }
             else foundErrors = true;
         }
@@ -4260,7 +4356,7 @@ bool FrameFileIO::isTeslaAPFile(QString filename)
         return false;
     }
 
-    while (!inFile->atEnd())
+    while (!inFile->atEnd() && !loadStopped())
     {
         inFile->read((char *)&record, sizeof(TeslaAPCANRecord));
         if (record.id > 0x7FF) isValidFile = false;
@@ -4291,7 +4387,7 @@ bool FrameFileIO::loadTeslaAPFile(QString filename, QVector<CANFrame>* frames)
         return false;
     }
 
-    while (!inFile->atEnd())
+    while (!inFile->atEnd() && !loadStopped())
     {
         lineCounter++;
         if (lineCounter > 100)
@@ -4317,7 +4413,7 @@ bool FrameFileIO::loadTeslaAPFile(QString filename, QVector<CANFrame>* frames)
         {
             for (int d = 0; d < numBytes; d++) bytes[d] = record.data[d];
             thisFrame.setPayload(bytes);
-            frames->append(thisFrame);
+            appendLoadedFrame(frames, thisFrame);
         }
         else foundErrors = true;
     }
@@ -4759,7 +4855,7 @@ bool FrameFileIO::loadCLX000File(QString filename, QVector<CANFrame>* frames) {
                 currentFrame.setPayload(QByteArray());
             }
 
-            frames->append(currentFrame);
+            appendLoadedFrame(frames, currentFrame);
         } else {
             qDebug() << "Could not parse:" << recordLine;
         }
@@ -4860,7 +4956,7 @@ bool FrameFileIO::loadCANServerFile(QString filename, QVector<CANFrame>* frames)
         //uint64_t lastFrameTime = 0;
         
         uint8_t data[1];
-        while (!inFile->atEnd())
+        while (!inFile->atEnd() && !loadStopped())
         {
             inFile->read((char*)&data, 1);
 
@@ -4993,7 +5089,7 @@ bool FrameFileIO::loadCANServerFile(QString filename, QVector<CANFrame>* frames)
                 }
                 
                 thisFrame.setPayload(bytes);
-                frames->append(thisFrame);
+                appendLoadedFrame(frames, thisFrame);
             }
         }
     }
@@ -5030,7 +5126,7 @@ bool FrameFileIO::loadWiresharkFile(QString filename, QVector<CANFrame>* frames)
 
     packetData = (const char*)pcap_next(pcap_data_file, &packetHeader);
 
-    while (packetData) {
+    while (packetData && !loadStopped()) {
         lineCounter++;
         if (lineCounter > 100)
         {
@@ -5062,7 +5158,7 @@ bool FrameFileIO::loadWiresharkFile(QString filename, QVector<CANFrame>* frames)
             bytes[d] = *(packetData + 24 + d);
         }
         thisFrame.setPayload(bytes);
-        frames->append(thisFrame);
+        appendLoadedFrame(frames, thisFrame);
 
         packetData = (const char*)pcap_next(pcap_data_file, &packetHeader);
     }
@@ -12,7 +12,9 @@
 #include <QString>
 #include <QStringList>
 #include <QFileDialog>
+#include <functional>
 #include "can_structs.h"
+#include "frameselection.h"
 #include "utility.h"
 
 class FrameFileIO: public QObject
@@ -27,7 +29,19 @@ public:
     //The QVector is used as either the target for loading or the source for saving.
     //These routines call the below loading/saving functions so no need to use them directly if you don't want.
     static bool loadFrameFile(QString &, QVector<CANFrame>*);
-    static bool saveFrameFile(QString &, const QVector<CANFrame>*);
+    //With a selection only the selected frames are saved. GVRET logs are written straight from the list, any
+    //other format gets a copy of the selected frames to work from
+    static bool saveFrameFile(QString &, const QVector<CANFrame>*, const FrameSelection *selection = nullptr);
+
+    //The same thing split up. pickLoadFile is just the dialog, fileType is the index of the filter that was picked
+    //(0 is autodetect). streamFileOfType hands the frames to the sink a chunk at a time instead of keeping them all
+    //so files bigger than memory can be gone through. The sink returns false to stop loading.
+    static bool pickLoadFile(QString &filename, int &fileType);
+    static bool loadFileOfType(QString filename, int fileType, QVector<CANFrame>*);
+    static bool streamFileOfType(QString filename, int fileType, const std::function<bool(QVector<CANFrame> &)> &sink, int chunkSize = 65536);
+    //every loader adds frames through these so streaming works for all of them
+    static void appendLoadedFrame(QVector<CANFrame> *frames, const CANFrame &frame);
+    static bool loadStopped();
 
     //These do the actual loading and saving and can be used directly if you'd prefer
     static bool autoDetectLoadFile(QString, QVector<CANFrame>*);
@@ -82,7 +96,7 @@ public:
     static bool isWiresharkFile(QString filename);
 
     static bool saveCRTDFile(QString, const QVector<CANFrame>*);
-    static bool saveNativeCSVFile(QString, const QVector<CANFrame>*);
+    static bool saveNativeCSVFile(QString, const QVector<CANFrame>*, const FrameSelection *selection = nullptr);
     static bool saveGenericCSVFile(QString, const QVector<CANFrame>*);
     static bool saveLogFile(QString, const QVector<CANFrame>*);
     static bool saveMicrochipFile(QString, const QVector<CANFrame>*);
@@ -102,6 +116,7 @@ public:
 
 private:
     static QFile continuousFile;
+    static QStringList loadFilters();
 };
 
 #endif // FRAMEFILEIO_H
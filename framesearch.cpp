@@ -0,0 +1,540 @@
+#include "framesearch.h"
+
+#include <QThread>
+#include <QRegularExpression>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include "canframemodel.h"
+#include "dbc/dbchandler.h"
+#include "utility.h"
+
+#define SEARCH_CHUNK    16384 //rows each search thread takes at a time
+
+//a slice of rows for one search thread along with whatever it found there
+struct FrameSearchChunk
+{
+    int start;
+    int end;
+    QVector<int> hits;
+};
+
+FrameSearchQuery::FrameSearchQuery()
+{
+    useIDRange = false;
+    idLow = 0;
+    idHigh = 0xFFFFFFFF;
+    bus = -1;
+    patternOffset = -1;
+    useTimeRange = false;
+    timeLow = 0;
+    timeHigh = 0;
+    signalOp = FSO_EQUAL;
+    signalValue = 0.0;
+}
+
+//"7E8" for a single ID or "700-7FF" for a range. Always hex, a leading 0x is fine too. Blank means any ID
+bool FrameSearchQuery::setIDRange(QString text)
+{
+    text = text.simplified().remove(' ');
+    if (text.isEmpty())
+    {
+        useIDRange = false;
+        return true;
+    }
+
+    QStringList parts = text.split('-');
+    if (parts.count() > 2)
+    {
+        lastError = "ID range should look like 700-7FF";
+        return false;
+    }
+
+    uint32_t values[2];
+    for (int i = 0; i < parts.count(); i++)
+    {
+        QString part = parts[i];
+        if (part.startsWith("0x", Qt::CaseInsensitive)) part = part.mid(2);
+        bool ok;
+        values[i] = part.toUInt(&ok, 16);
+        if (!ok)
+        {
+            lastError = "Could not read \"" + parts[i] + "\" as a hex ID";
+            return false;
+        }
+    }
+    idLow = values[0];
+    idHigh = (parts.count() > 1) ? values[1] : values[0];
+    if (idLow > idHigh) std::swap(idLow, idHigh);
+    useIDRange = true;
+    return true;
+}
+
+//hex bytes, spaces optional. A ? in place of a hex digit matches anything: "02 ?? 0C", "1?FF". Blank means no pattern
+bool FrameSearchQuery::setPattern(QString text)
+{
+    patternValues.clear();
+    patternMask.clear();
+
+    text = text.simplified().remove(' ').toUpper();
+    if (text.isEmpty()) return true;
+
+    if (text.length() % 2)
+    {
+        lastError = "Payload pattern needs two hex digits (or ?) per byte";
+        return false;
+    }
+
+    for (int i = 0; i < text.length(); i += 2)
+    {
+        unsigned char value = 0;
+        unsigned char mask = 0;
+        for (int n = 0; n < 2; n++)
+        {
+            QChar c = text[i + n];
+            int shift = (n == 0) ? 4 : 0;
+            if (c == '?') continue;
+            int digit = QString(c).toInt(nullptr, 16);
+            if (digit == 0 && c != '0')
+            {
+                lastError = QString("\"") + c + "\" isn't a hex digit";
+                patternValues.clear();
+                patternMask.clear();
+                return false;
+            }
+            value |= (digit << shift);
+            mask |= (0xF << shift);
+        }
+        patternValues.append(static_cast<char>(value));
+        patternMask.append(static_cast<char>(mask));
+    }
+    return true;
+}
+
+//"EngineSpeed > 3000". Understands < <= = == != >= >. Blank means no signal test
+bool FrameSearchQuery::setSignalPredicate(QString text)
+{
+    signalName.clear();
+    signalsByID.clear();
+
+    text = text.trimmed();
+    if (text.isEmpty()) return true;
+
+    QRegularExpression re("^([A-Za-z_][A-Za-z0-9_.]*)\\s*(<=|>=|==|!=|=|<|>)\\s*([-+]?[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?)$");
+    QRegularExpressionMatch match = re.match(text);
+    if (!match.hasMatch())
+    {
+        lastError = "Signal test should look like EngineSpeed > 3000";
+        return false;
+    }
+
+    QString op = match.captured(2);
+    if (op == "<") signalOp = FSO_LESS;
+    else if (op == "<=") signalOp = FSO_LESS_EQ;
+    else if (op == "!=") signalOp = FSO_NOT_EQUAL;
+    else if (op == ">=") signalOp = FSO_GREATER_EQ;
+    else if (op == ">") signalOp = FSO_GREATER;
+    else signalOp = FSO_EQUAL;
+    signalValue = match.captured(3).toDouble();
+    signalName = match.captured(1);
+
+    return resolveSignals();
+}
+
+//find every message in the loaded DBC files with a signal by this name. Needs doing again any time the DBC files change
+bool FrameSearchQuery::resolveSignals()
+{
+    signalsByID.clear();
+    if (signalName.isEmpty()) return true;
+
+    DBCHandler *dbcHandler = DBCHandler::getReference();
+    for (int f = 0; f < dbcHandler->getFileCount(); f++)
+    {
+        DBCFile *file = dbcHandler->getFileByIdx(f);
+        for (int m = 0; m < file->messageHandler->getCount(); m++)
+        {
+            DBC_MESSAGE *msg = file->messageHandler->findMsgByIdx(m);
+            DBC_SIGNAL *sig = msg->sigHandler->findSignalByName(signalName);
+            if (sig == nullptr || sig->valType == STRING) continue;
+            if (!signalsByID.contains(msg->ID)) signalsByID.insert(msg->ID, sig); //first file loaded wins like everywhere else
+        }
+    }
+
+    if (signalsByID.isEmpty())
+    {
+        lastError = "No numeric signal named " + signalName + " in the loaded DBC files";
+        return false;
+    }
+    return true;
+}
+
+bool FrameSearchQuery::isEmpty() const
+{
+    return !useIDRange && bus == -1 && patternValues.isEmpty() && !useTimeRange && signalName.isEmpty();
+}
+
+QSet<uint32_t> FrameSearchQuery::signalIDs() const
+{
+    QSet<uint32_t> ids;
+    for (QHash<uint32_t, DBC_SIGNAL*>::const_iterator it = signalsByID.constBegin(); it != signalsByID.constEnd(); ++it)
+    {
+        ids.insert(it.key());
+    }
+    return ids;
+}
+
+bool FrameSearchQuery::matches(const CANFrame &frame) const
+{
+    if (useIDRange && (frame.frameId() < idLow || frame.frameId() > idHigh)) return false;
+    if (bus != -1 && frame.bus != bus) return false;
+    if (useTimeRange)
+    {
+        int64_t stamp = frame.timeStamp().microSeconds();
+        if (stamp < timeLow || stamp > timeHigh) return false;
+    }
+    if (!patternValues.isEmpty() && !matchPattern(frame.payload())) return false;
+    if (!signalName.isEmpty() && !matchSignal(frame)) return false;
+    return true;
+}
+
+bool FrameSearchQuery::matchPattern(const QByteArray &payload) const
+{
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+    const unsigned char *values = reinterpret_cast<const unsigned char *>(patternValues.constData());
+    const unsigned char *masks = reinterpret_cast<const unsigned char *>(patternMask.constData());
+    int len = patternValues.length();
+    int dataLen = payload.length();
+
+    int first = (patternOffset >= 0) ? patternOffset : 0;
+    int last = (patternOffset >= 0) ? patternOffset : dataLen - len;
+    for (int offset = first; offset <= last; offset++)
+    {
+        if (offset + len > dataLen) return false;
+        int i;
+        for (i = 0; i < len; i++)
+        {
+            if ((data[offset + i] & masks[i]) != values[i]) break;
+        }
+        if (i == len) return true;
+    }
+    return false;
+}
+
+bool FrameSearchQuery::matchSignal(const CANFrame &frame) const
+{
+    if (frame.frameType() != QCanBusFrame::DataFrame) return false;
+    DBC_SIGNAL *sig = signalsByID.value(frame.frameId(), nullptr);
+    if (sig == nullptr) return false;
+    if (!sig->isPresentIn(frame)) return false;
+
+    double value;
+    if (!sig->decodeValue(frame, value)) return false;
+
+    switch (signalOp)
+    {
+    case FSO_LESS:
+        return value < signalValue;
+    case FSO_LESS_EQ:
+        return value <= signalValue;
+    case FSO_EQUAL:
+        return std::fabs(value - signalValue) <= 1e-9 * std::max(1.0, std::fabs(signalValue));
+    case FSO_NOT_EQUAL:
+        return std::fabs(value - signalValue) > 1e-9 * std::max(1.0, std::fabs(signalValue));
+    case FSO_GREATER_EQ:
+        return value >= signalValue;
+    case FSO_GREATER:
+        return value > signalValue;
+    }
+    return false;
+}
+
+FrameSearch::FrameSearch(CANFrameModel *model, QObject *parent) : QObject(parent)
+{
+    this->model = model;
+    useCandidates = false;
+    generation = -1;
+    dbcGeneration = -1;
+    serial = 0;
+    running = false;
+    complete = false;
+    findSerial = 0;
+
+    qRegisterMetaType<QVector<int>>("QVector<int>");
+    connect(this, &FrameSearch::partialResults, this, &FrameSearch::gotPartialResults, Qt::QueuedConnection);
+    connect(this, &FrameSearch::searchDone, this, &FrameSearch::gotSearchDone, Qt::QueuedConnection);
+    connect(this, &FrameSearch::findDone, this, &FrameSearch::gotFindDone, Qt::QueuedConnection);
+}
+
+FrameSearch::~FrameSearch()
+{
+    cancel();
+}
+
+void FrameSearch::start(const FrameSearchQuery &newQuery)
+{
+    cancel();
+
+    query = newQuery;
+    results.clear();
+    complete = false;
+    candidates.clear();
+    useCandidates = false;
+    emit resultsUpdated(0);
+
+    //signal pointers might have gone stale since the query was built
+    dbcGeneration = DBCHandler::getReference()->getChangeCounter();
+    if (!query.resolveSignals())
+    {
+        emit searchFinished(true);
+        return;
+    }
+
+    generation = model->snapshotFilteredIndex(index);
+
+    //if the query pins down which IDs can match then only their rows need looking at
+    if (query.useIDRange || !query.signalName.isEmpty())
+    {
+        useCandidates = true;
+        uint32_t low = query.useIDRange ? query.idLow : 0;
+        uint32_t high = query.useIDRange ? query.idHigh : 0xFFFFFFFF;
+        if (!query.signalName.isEmpty())
+        {
+            QSet<uint32_t> ids = query.signalIDs();
+            candidates = index.rowsMatching(low, high, query.bus, &ids);
+        }
+        else candidates = index.rowsMatching(low, high, query.bus);
+    }
+
+    serial++;
+    running = true;
+    cancelFlag.storeRelease(0);
+    int searchSerial = serial;
+    future = QtConcurrent::run([this, searchSerial]() { runSearch(searchSerial); });
+}
+
+void FrameSearch::cancel()
+{
+    cancelFind();
+    cancelFlag.storeRelease(1);
+    future.waitForFinished();
+    running = false;
+}
+
+//stops a find next/previous that's still looking. Whatever it sends back afterward gets ignored
+void FrameSearch::cancelFind()
+{
+    findCancelFlag.storeRelease(1);
+    findFuture.waitForFinished();
+    findSerial++;
+}
+
+bool FrameSearch::isRunning() const
+{
+    return running;
+}
+
+const QVector<int> &FrameSearch::getResults() const
+{
+    return results;
+}
+
+//runs on a worker thread. Goes through the list a round of chunks at a time, sending back what it found after each round
+void FrameSearch::runSearch(int searchSerial)
+{
+    int total = useCandidates ? candidates.count() : index.indexedCount();
+    int roundSize = SEARCH_CHUNK * qMax(1, QThread::idealThreadCount());
+
+    for (int pos = 0; pos < total; pos += roundSize)
+    {
+        if (cancelFlag.loadAcquire() || DBCHandler::getReference()->getChangeCounter() != dbcGeneration)
+        {
+            emit searchDone(searchSerial, false);
+            return;
+        }
+
+        QVector<int> hits;
+        if (!scanRows(pos, qMin(total, pos + roundSize), hits))
+        {
+            //frame list got sorted or refiltered or cleared. Rows from here on wouldn't mean the same thing
+            emit searchDone(searchSerial, false);
+            return;
+        }
+        if (!hits.isEmpty()) emit partialResults(searchSerial, hits);
+    }
+    emit searchDone(searchSerial, true);
+}
+
+/*
+ * Checks positions [start, end) in parallel and adds any matching rows to hits, in row order. Positions are indexes into
+ * candidates when the query narrowed things down by ID, otherwise they're rows. Returns false if the model's list
+ * changed since the index was taken.
+*/
+bool FrameSearch::scanRows(int start, int end, QVector<int> &hits)
+{
+    if (start >= end) return true;
+
+    QVector<FrameSearchChunk> chunks;
+    for (int pos = start; pos < end; pos += SEARCH_CHUNK)
+    {
+        FrameSearchChunk chunk;
+        chunk.start = pos;
+        chunk.end = qMin(end, pos + SEARCH_CHUNK);
+        chunks.append(chunk);
+    }
+
+    //copy of just this stretch so the model can go on taking frames while the threads look through it.
+    //frames[i - start] is position i
+    const int *cand = useCandidates ? candidates.constData() : nullptr;
+    QVector<CANFrame> copy;
+    bool ok;
+    if (cand) ok = model->copyFilteredFrames(generation, candidates.mid(start, end - start), copy);
+    else ok = model->copyFilteredFrames(generation, start, end, copy);
+    if (!ok) return false;
+    const CANFrame *frames = copy.constData();
+
+    QtConcurrent::blockingMap(chunks, [&](FrameSearchChunk &chunk)
+    {
+        if (cand)
+        {
+            for (int i = chunk.start; i < chunk.end; i++)
+            {
+                if (query.matches(frames[i - start])) chunk.hits.append(cand[i]);
+            }
+            return;
+        }
+
+        int row = chunk.start;
+        while (row < chunk.end)
+        {
+            int block = row / CANFrameIndex::BLOCK_SIZE;
+            int blockEnd = qMin(chunk.end, (block + 1) * CANFrameIndex::BLOCK_SIZE);
+            //whole block is outside the time range so don't bother looking at it
+            if (query.useTimeRange && block < index.blockCount()
+                && (index.blockMaxTime(block) < query.timeLow || index.blockMinTime(block) > query.timeHigh))
+            {
+                row = blockEnd;
+                continue;
+            }
+            for (; row < blockEnd; row++)
+            {
+                if (query.matches(frames[row - start])) chunk.hits.append(row);
+            }
+        }
+    });
+
+    for (int i = 0; i < chunks.count(); i++) hits.append(chunks[i].hits);
+    return true;
+}
+
+void FrameSearch::gotPartialResults(int searchSerial, QVector<int> rows)
+{
+    if (searchSerial != serial) return; //left over from a search that's been replaced
+    results.append(rows);
+    emit resultsUpdated(results.count());
+}
+
+void FrameSearch::gotSearchDone(int searchSerial, bool completed)
+{
+    if (searchSerial != serial) return;
+    running = false;
+    complete = completed;
+    emit searchFinished(completed);
+}
+
+void FrameSearch::gotFindDone(int searchSerial, int row, bool forward)
+{
+    if (searchSerial != findSerial) return; //a newer find or search replaced this one
+    emit matchFound(row, forward);
+}
+
+void FrameSearch::findNext(int fromRow)
+{
+    findFrom(fromRow, true);
+}
+
+void FrameSearch::findPrevious(int fromRow)
+{
+    findFrom(fromRow, false);
+}
+
+void FrameSearch::findFrom(int fromRow, bool forward)
+{
+    cancelFind();
+    if (query.isEmpty())
+    {
+        emit matchFound(-1, forward);
+        return;
+    }
+
+    //rows got rearranged or the DBC files changed since the search ran. Start it over against what's there now
+    CANFrameIndex current;
+    if (model->snapshotFilteredIndex(current) != generation || DBCHandler::getReference()->getChangeCounter() != dbcGeneration)
+    {
+        start(query);
+    }
+
+    //whatever has been found so far might already have the answer
+    if (!results.isEmpty())
+    {
+        if (forward)
+        {
+            QVector<int>::const_iterator it = std::upper_bound(results.constBegin(), results.constEnd(), fromRow);
+            if (it != results.constEnd())
+            {
+                emit matchFound(*it, forward);
+                return;
+            }
+        }
+        else
+        {
+            QVector<int>::const_iterator it = std::lower_bound(results.constBegin(), results.constEnd(), fromRow);
+            if (it != results.constBegin())
+            {
+                emit matchFound(*(it - 1), forward);
+                return;
+            }
+        }
+    }
+    if (complete)
+    {
+        emit matchFound(-1, forward);
+        return;
+    }
+
+    //search hasn't gotten that far yet. Look in the background same as the search itself does
+    findCancelFlag.storeRelease(0);
+    int searchSerial = findSerial;
+    findFuture = QtConcurrent::run([this, fromRow, forward, searchSerial]() { runFind(fromRow, forward, searchSerial); });
+}
+
+//runs on a worker thread. Looks outward from the row a round at a time until something turns up
+void FrameSearch::runFind(int fromRow, bool forward, int searchSerial)
+{
+    int total = useCandidates ? candidates.count() : index.indexedCount();
+    int roundSize = SEARCH_CHUNK * qMax(1, QThread::idealThreadCount());
+    int pos;
+    if (useCandidates)
+    {
+        if (forward) pos = std::upper_bound(candidates.constBegin(), candidates.constEnd(), fromRow) - candidates.constBegin();
+        else pos = std::lower_bound(candidates.constBegin(), candidates.constEnd(), fromRow) - candidates.constBegin();
+    }
+    else pos = forward ? qMax(0, fromRow + 1) : qMin(fromRow, total);
+
+    while (forward ? (pos < total) : (pos > 0))
+    {
+        if (findCancelFlag.loadAcquire()) return;
+        int start = forward ? pos : qMax(0, pos - roundSize);
+        int end = forward ? qMin(total, pos + roundSize) : pos;
+        QVector<int> hits;
+        if (!scanRows(start, end, hits)) break;
+        if (!hits.isEmpty())
+        {
+            emit findDone(searchSerial, forward ? hits.first() : hits.last(), forward);
+            return;
+        }
+        pos = forward ? end : start;
+    }
+    emit findDone(searchSerial, -1, forward);
+}
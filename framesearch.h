@@ -0,0 +1,134 @@
+#ifndef FRAMESEARCH_H
+#define FRAMESEARCH_H
+
+#include <QObject>
+#include <QFuture>
+#include <QAtomicInt>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include "can_structs.h"
+#include "canframeindex.h"
+#include "dbc/dbc_classes.h"
+
+class CANFrameModel;
+
+enum FrameSearchOp
+{
+    FSO_LESS,
+    FSO_LESS_EQ,
+    FSO_EQUAL,
+    FSO_NOT_EQUAL,
+    FSO_GREATER_EQ,
+    FSO_GREATER
+};
+
+/*
+ * What to look for. Every part that has been set has to match for a frame to count:
+ *  ID range        - "7E8" or "700-7FF", hex like everywhere else
+ *  bus             - -1 for any
+ *  payload pattern - hex bytes with ? as a wildcard nibble, "02 ?? 0C" or "1? FF". Matches at patternOffset or anywhere if that's -1
+ *  time range      - in microseconds, same as the frame timestamps
+ *  signal          - "EngineSpeed > 3000". Signal gets looked up by name in every loaded DBC file
+ *
+ * Built once on the GUI thread, then only read by the search threads.
+*/
+class FrameSearchQuery
+{
+public:
+    FrameSearchQuery();
+    bool setIDRange(QString text);
+    bool setPattern(QString text);
+    bool setSignalPredicate(QString text);
+    bool resolveSignals();
+    bool isEmpty() const;
+    bool matches(const CANFrame &frame) const;
+    QSet<uint32_t> signalIDs() const;
+
+    bool useIDRange;
+    uint32_t idLow;
+    uint32_t idHigh;
+    int bus;
+    QByteArray patternValues;
+    QByteArray patternMask;
+    int patternOffset;
+    bool useTimeRange;
+    int64_t timeLow;
+    int64_t timeHigh;
+    QString signalName;
+    FrameSearchOp signalOp;
+    double signalValue;
+    QString lastError;
+
+private:
+    QHash<uint32_t, DBC_SIGNAL*> signalsByID; //every message that has a signal by that name, keyed by message ID
+
+    bool matchPattern(const QByteArray &payload) const;
+    bool matchSignal(const CANFrame &frame) const;
+};
+
+/*
+ * Searches the rows of the main frame grid (the model's filtered list) in the background.
+ *
+ * Queries that pin down the ID (an ID range or a DBC signal) never look at the rest of the capture. The rows come straight out of the
+ * model's per ID index. Everything else gets split into chunks that are checked in parallel, skipping blocks of rows that can't
+ * fall in the time range. Hits come back in row order as each round of chunks finishes so results show up while the
+ * search is still going.
+ *
+ * findNext/findPrevious use the finished results when there are some. Otherwise they scan outward from the given row
+ * on a worker thread and stop at the first hit. Either way the answer comes back through matchFound, -1 if there isn't one.
+*/
+class FrameSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    FrameSearch(CANFrameModel *model, QObject *parent = nullptr);
+    ~FrameSearch();
+    void start(const FrameSearchQuery &query);
+    void cancel();
+    bool isRunning() const;
+    const QVector<int> &getResults() const;
+    void findNext(int fromRow);
+    void findPrevious(int fromRow);
+
+signals:
+    void resultsUpdated(int numFound);
+    void searchFinished(bool completed);
+    void matchFound(int row, bool forward);
+    //used internally to get results from the search threads back to the GUI thread
+    void partialResults(int serial, QVector<int> rows);
+    void searchDone(int serial, bool completed);
+    void findDone(int serial, int row, bool forward);
+
+private slots:
+    void gotPartialResults(int serial, QVector<int> rows);
+    void gotSearchDone(int serial, bool completed);
+    void gotFindDone(int serial, int row, bool forward);
+
+private:
+    CANFrameModel *model;
+    FrameSearchQuery query;
+    CANFrameIndex index;
+    QVector<int> candidates;
+    bool useCandidates;
+    int generation;
+    int dbcGeneration;
+    QFuture<void> future;
+    QAtomicInt cancelFlag;
+    int serial;
+    bool running;
+    bool complete;
+    QVector<int> results;
+    QFuture<void> findFuture;
+    QAtomicInt findCancelFlag;
+    int findSerial;
+
+    void runSearch(int searchSerial);
+    void findFrom(int fromRow, bool forward);
+    void runFind(int fromRow, bool forward, int searchSerial);
+    void cancelFind();
+    bool scanRows(int start, int end, QVector<int> &hits);
+};
+
+#endif // FRAMESEARCH_H
@@ -0,0 +1,214 @@
+#include "framesearchwindow.h"
+#include "ui_framesearchwindow.h"
+
+#include "mainwindow.h"
+#include "helpwindow.h"
+#include "utility.h"
+
+#include <QKeyEvent>
+#include <QListWidgetItem>
+
+#define MAX_LISTED_RESULTS  10000 //beyond this the count still goes up but the list stops growing
+
+FrameSearchWindow::FrameSearchWindow(CANFrameModel *model, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::FrameSearchWindow)
+{
+    ui->setupUi(this);
+    setWindowFlags(Qt::Window);
+
+    this->model = model;
+    search = new FrameSearch(model, this);
+    currentRow = -1;
+    listedResults = 0;
+    haveSearched = false;
+
+    connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    connect(ui->btnSearch, &QAbstractButton::clicked, this, &FrameSearchWindow::handleSearchButton);
+    connect(ui->btnStop, &QAbstractButton::clicked, this, &FrameSearchWindow::handleStopButton);
+    connect(ui->btnNext, &QAbstractButton::clicked, this, &FrameSearchWindow::findNext);
+    connect(ui->btnPrevious, &QAbstractButton::clicked, this, &FrameSearchWindow::findPrevious);
+    connect(ui->listResults, &QListWidget::itemClicked, this, &FrameSearchWindow::resultClicked);
+    connect(search, &FrameSearch::resultsUpdated, this, &FrameSearchWindow::resultsUpdated);
+    connect(search, &FrameSearch::searchFinished, this, &FrameSearchWindow::searchFinished);
+    connect(search, &FrameSearch::matchFound, this, &FrameSearchWindow::matchFound);
+
+    ui->btnStop->setEnabled(false);
+
+    installEventFilter(this);
+}
+
+FrameSearchWindow::~FrameSearchWindow()
+{
+    removeEventFilter(this);
+    delete ui;
+}
+
+bool FrameSearchWindow::eventFilter(QObject *obj, QEvent *event)
+{
+    if (event->type() == QEvent::KeyRelease) {
+        QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
+        switch (keyEvent->key())
+        {
+        case Qt::Key_F1:
+            HelpWindow::getRef()->showHelp("framesearch.md");
+            break;
+        }
+        return true;
+    } else {
+        // standard event processing
+        return QObject::eventFilter(obj, event);
+    }
+    return false;
+}
+
+//main window tells us where the user is in the grid so find next/previous go from there
+void FrameSearchWindow::setCurrentRow(int row)
+{
+    currentRow = row;
+}
+
+bool FrameSearchWindow::buildQuery(FrameSearchQuery &query)
+{
+    bool ok = query.setIDRange(ui->editID->text()) && query.setPattern(ui->editPattern->text())
+              && query.setSignalPredicate(ui->editSignal->text());
+
+    query.bus = ui->spinBus->value();
+    query.patternOffset = ui->spinOffset->value();
+
+    if (ok && (!ui->editTimeFrom->text().isEmpty() || !ui->editTimeTo->text().isEmpty()))
+    {
+        bool fromOk = true;
+        bool toOk = true;
+        double from = ui->editTimeFrom->text().isEmpty() ? -1e12 : ui->editTimeFrom->text().toDouble(&fromOk);
+        double to = ui->editTimeTo->text().isEmpty() ? 1e12 : ui->editTimeTo->text().toDouble(&toOk);
+        if (!fromOk || !toOk)
+        {
+            query.lastError = "Times are in seconds, like 12.5";
+            ok = false;
+        }
+        else
+        {
+            query.useTimeRange = true;
+            query.timeLow = static_cast<int64_t>(from * 1000000.0);
+            query.timeHigh = static_cast<int64_t>(to * 1000000.0);
+        }
+    }
+
+    if (ok && query.isEmpty())
+    {
+        query.lastError = "Nothing to search for";
+        ok = false;
+    }
+
+    if (!ok) ui->lblStatus->setText(query.lastError);
+    return ok;
+}
+
+void FrameSearchWindow::handleSearchButton()
+{
+    startSearch();
+}
+
+bool FrameSearchWindow::startSearch()
+{
+    FrameSearchQuery query;
+    if (!buildQuery(query)) return false;
+
+    ui->listResults->clear();
+    listedResults = 0;
+    ui->lblStatus->setText("Searching...");
+    ui->btnStop->setEnabled(true);
+    haveSearched = true;
+    search->start(query);
+    return true;
+}
+
+void FrameSearchWindow::handleStopButton()
+{
+    search->cancel();
+    ui->btnStop->setEnabled(false);
+    ui->lblStatus->setText("Stopped after " + QString::number(search->getResults().count()) + " matches");
+}
+
+void FrameSearchWindow::resultsUpdated(int numFound)
+{
+    const QVector<int> &results = search->getResults();
+    const QVector<CANFrame> *frames = model->getFilteredListReference();
+
+    //search started over so whatever is listed is from the old one
+    if (numFound < listedResults)
+    {
+        ui->listResults->clear();
+        listedResults = 0;
+    }
+
+    ui->listResults->setUpdatesEnabled(false);
+    for (; listedResults < numFound && listedResults < MAX_LISTED_RESULTS; listedResults++)
+    {
+        int row = results[listedResults];
+        if (row >= frames->count()) break;
+        const CANFrame &frame = frames->at(row);
+        QString text = QString::number(row + 1) + "  " + Utility::formatCANID(frame.frameId(), frame.hasExtendedFrameFormat())
+                       + "  " + QString::number(frame.timeStamp().microSeconds() / 1000000.0, 'f', 5);
+        QListWidgetItem *item = new QListWidgetItem(text, ui->listResults);
+        item->setData(Qt::UserRole, row);
+    }
+    ui->listResults->setUpdatesEnabled(true);
+
+    ui->lblStatus->setText("Searching... " + QString::number(numFound) + " matches so far");
+}
+
+void FrameSearchWindow::searchFinished(bool completed)
+{
+    ui->btnStop->setEnabled(false);
+    int found = search->getResults().count();
+    if (completed) ui->lblStatus->setText(QString::number(found) + " matches");
+    else ui->lblStatus->setText("Search stopped early with " + QString::number(found) + " matches");
+}
+
+void FrameSearchWindow::resultClicked(QListWidgetItem *item)
+{
+    jumpTo(item->data(Qt::UserRole).toInt());
+}
+
+void FrameSearchWindow::findNext()
+{
+    //nothing searched yet. Start one in the background, finding the next match doesn't wait for it to finish
+    if (!haveSearched && !startSearch()) return;
+    search->findNext(currentRow);
+}
+
+void FrameSearchWindow::findPrevious()
+{
+    if (!haveSearched && !startSearch()) return;
+    search->findPrevious((currentRow < 0) ? model->rowCount() : currentRow);
+}
+
+void FrameSearchWindow::matchFound(int row, bool forward)
+{
+    if (row >= 0) jumpTo(row);
+    else if (forward) ui->lblStatus->setText("No more matches after this row");
+    else ui->lblStatus->setText("No more matches before this row");
+}
+
+void FrameSearchWindow::jumpTo(int row)
+{
+    currentRow = row;
+    emit jumpToRow(row);
+}
+
+void FrameSearchWindow::updatedFrames(int numFrames)
+{
+    //rows don't mean the same thing any more so the old results are no good
+    if (numFrames < 0)
+    {
+        search->cancel();
+        ui->listResults->clear();
+        listedResults = 0;
+        currentRow = -1;
+        haveSearched = false;
+        ui->btnStop->setEnabled(false);
+        ui->lblStatus->setText("Frames changed. Search again to update the results");
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef FRAMESEARCHWINDOW_H
+#define FRAMESEARCHWINDOW_H
+
+#include <QDialog>
+#include "framesearch.h"
+
+class CANFrameModel;
+class QListWidgetItem;
+
+namespace Ui {
+class FrameSearchWindow;
+}
+
+class FrameSearchWindow : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit FrameSearchWindow(CANFrameModel *model, QWidget *parent = 0);
+    ~FrameSearchWindow();
+    void setCurrentRow(int row);
+
+signals:
+    void jumpToRow(int row);
+
+public slots:
+    void findNext();
+    void findPrevious();
+
+private slots:
+    void handleSearchButton();
+    void handleStopButton();
+    void resultsUpdated(int numFound);
+    void searchFinished(bool completed);
+    void matchFound(int row, bool forward);
+    void resultClicked(QListWidgetItem *item);
+    void updatedFrames(int numFrames);
+
+private:
+    Ui::FrameSearchWindow *ui;
+    CANFrameModel *model;
+    FrameSearch *search;
+    int currentRow;
+    int listedResults;
+    bool haveSearched;
+
+    bool startSearch();
+    bool buildQuery(FrameSearchQuery &query);
+    void jumpTo(int row);
+    bool eventFilter(QObject *obj, QEvent *event);
+};
+
+#endif // FRAMESEARCHWINDOW_H
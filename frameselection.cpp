@@ -0,0 +1,140 @@
+#include "frameselection.h"
+
+#include <QThread>
+#include <QtAlgorithms>
+#include <QtConcurrent/QtConcurrentMap>
+#include <utility>
+
+FrameSelection::FrameSelection()
+{
+    clear();
+}
+
+void FrameSelection::clear()
+{
+    rows = 0;
+    selected = 0;
+    rangeStart = rangeEnd = 0;
+    bits.clear();
+}
+
+//rows [start, end) out of a list of total
+void FrameSelection::selectRange(int total, int start, int end)
+{
+    clear();
+    rows = qMax(0, total);
+    rangeStart = qBound(0, start, rows);
+    rangeEnd = qBound(rangeStart, end, rows);
+    selected = rangeEnd - rangeStart;
+}
+
+/*
+ * Every one of the first total frames that test passes. test gets called from several threads at once so it must
+ * only read things.
+*/
+void FrameSelection::selectMatching(const QVector<CANFrame> &frames, int total, const std::function<bool(const CANFrame &)> &test)
+{
+    clear();
+    rows = qBound(0, total, static_cast<int>(frames.count()));
+    int words = (rows + 63) / 64;
+    if (words == 0) return;
+    bits.fill(0, words);
+
+    int threads = qMax(1, QThread::idealThreadCount());
+    int wordsPerChunk = qMax(FRAME_SELECTION_MIN_CHUNK / 64, (words + threads - 1) / threads);
+    QVector<int> chunks;
+    for (int c = 0; c * wordsPerChunk < words; c++) chunks.append(c);
+    QVector<int> chunkCounts(chunks.count());
+
+    const CANFrame *frameData = frames.constData();
+    quint64 *bitData = bits.data();
+    int *counts = chunkCounts.data();
+    int rowCount = rows;
+    QtConcurrent::blockingMap(chunks, [&](int &c)
+    {
+        int start = c * wordsPerChunk * 64;
+        int end = qMin(rowCount, start + wordsPerChunk * 64);
+        int found = 0;
+        for (int i = start; i < end; i++)
+        {
+            if (!test(frameData[i])) continue;
+            bitData[i >> 6] |= Q_UINT64_C(1) << (i & 63);
+            found++;
+        }
+        counts[c] = found;
+    });
+
+    for (int c = 0; c < chunkCounts.count(); c++) selected += chunkCounts[c];
+}
+
+int FrameSelection::total() const
+{
+    return rows;
+}
+
+int FrameSelection::count() const
+{
+    return selected;
+}
+
+bool FrameSelection::contains(int row) const
+{
+    if (row < 0 || row >= rows) return false;
+    if (bits.isEmpty()) return row >= rangeStart && row < rangeEnd;
+    return (bits[row >> 6] >> (row & 63)) & 1;
+}
+
+//first selected row at or after row, total() if there aren't any more
+int FrameSelection::next(int row) const
+{
+    if (row < 0) row = 0;
+    if (row >= rows) return rows;
+    if (bits.isEmpty())
+    {
+        if (rangeStart == rangeEnd || row >= rangeEnd) return rows;
+        return qMax(row, rangeStart);
+    }
+
+    int w = row >> 6;
+    quint64 word = bits[w] & (~Q_UINT64_C(0) << (row & 63));
+    while (word == 0)
+    {
+        if (++w >= bits.count()) return rows;
+        word = bits[w];
+    }
+    return (w << 6) + qCountTrailingZeroBits(word);
+}
+
+//the selected frames on their own, for anything that really does need a list of just them
+void FrameSelection::copyTo(const QVector<CANFrame> &frames, QVector<CANFrame> &out) const
+{
+    out.clear();
+    out.reserve(selected);
+    int end = qMin(rows, static_cast<int>(frames.count()));
+    for (int r = next(0); r < end; r = next(r + 1)) out.append(frames[r]);
+}
+
+/*
+ * Cuts frames down to the selected ones in place, keeping their order. Selected frames slide down over the ones that
+ * weren't so nothing is allocated and the list keeps its capacity. Frames past total() are dropped too.
+*/
+int FrameSelection::keepIn(QVector<CANFrame> &frames) const
+{
+    int end = qMin(rows, static_cast<int>(frames.count()));
+    if (bits.isEmpty())
+    {
+        frames.resize(qMin(rangeEnd, end));
+        if (rangeStart > 0) frames.remove(0, qMin(rangeStart, static_cast<int>(frames.count())));
+        return frames.count();
+    }
+
+    CANFrame *data = frames.data();
+    int kept = 0;
+    for (int r = next(0); r < end; r = next(r + 1))
+    {
+        if (r != kept) data[kept] = std::move(data[r]);
+        kept++;
+    }
+    frames.resize(kept);
+    return kept;
+}
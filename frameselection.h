@@ -0,0 +1,41 @@
+#ifndef FRAMESELECTION_H
+#define FRAMESELECTION_H
+
+#include <QVector>
+#include <functional>
+#include "can_structs.h"
+
+#define FRAME_SELECTION_MIN_CHUNK   65536   //frames per thread. Less than this isn't worth handing out
+
+/*
+ * Which rows of a frame list were picked, without copying any frames. A split by frame number is a single range of
+ * rows and costs nothing. A split on anything else is one bit per frame, worked out a chunk per thread straight over
+ * the list. Chunks are whole 64 bit words so no two threads ever write the same word. 40M frames is 5MB of bits.
+ *
+ * The selection only means something for the list it was worked out over and only until that list is cleared or
+ * rewritten, so hang on to the CANFrameSnapshot taken with it and check the generation before using it.
+*/
+class FrameSelection
+{
+public:
+    FrameSelection();
+    void clear();
+    void selectRange(int total, int start, int end);
+    void selectMatching(const QVector<CANFrame> &frames, int total, const std::function<bool(const CANFrame &)> &test);
+
+    int total() const;
+    int count() const;
+    bool contains(int row) const;
+    int next(int row) const;
+    void copyTo(const QVector<CANFrame> &frames, QVector<CANFrame> &out) const;
+    int keepIn(QVector<CANFrame> &frames) const;
+
+private:
+    int rows;           //rows of the list the selection covers
+    int selected;
+    int rangeStart;     //used when there are no bits
+    int rangeEnd;
+    QVector<quint64> bits;
+};
+
+#endif // FRAMESELECTION_H
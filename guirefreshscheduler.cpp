@@ -0,0 +1,295 @@
+#include "guirefreshscheduler.h"
+#include <QSettings>
+#include <climits>
+
+//how often pending updates get looked at. Windows can't ask to be updated faster than this
+#define SCHEDULER_TICK_MS       50
+//how often costs are totaled up and intervals adjusted
+#define REBALANCE_MS            1000
+//slowest a window will be throttled to no matter how expensive it is
+#define MAX_REFRESH_INTERVAL    4000
+
+GUIRefreshScheduler* GUIRefreshScheduler::instance = nullptr;
+
+GUIRefreshScheduler::GUIRefreshScheduler(QObject *parent) : QObject(parent)
+{
+    QSettings settings;
+    frameSource = nullptr;
+    budget = 50;
+    setBudget(settings.value("Main/RefreshBudget", 50).toInt());
+    mainPeriodCost = 0;
+    mainPeriodRuns = 0;
+    mainLoad = 0.0;
+    mainRate = 0.0;
+    lastTotalLoad = 0.0;
+
+    connect(&tickTimer, &QTimer::timeout, this, &GUIRefreshScheduler::runPending);
+    tickTimer.setInterval(SCHEDULER_TICK_MS);
+    tickTimer.start();
+    periodTimer.start();
+}
+
+GUIRefreshScheduler* GUIRefreshScheduler::getReference()
+{
+    if (!instance) instance = new GUIRefreshScheduler();
+    return instance;
+}
+
+/*
+ * Register a window to be told about new frames. callback gets the same values framesUpdated would have given it,
+ * only batched up. intervalMS is the fastest the window wants to be updated. Windows are dropped automatically
+ * when they're destroyed.
+*/
+void GUIRefreshScheduler::addWindow(QWidget *window, std::function<void(int)> callback, RefreshPriority priority, int intervalMS)
+{
+    if (!window || !callback) return;
+    removeWindow(window);
+
+    Client client;
+    client.window = window;
+    client.callback = callback;
+    client.priority = priority;
+    client.desiredInterval = qMax(intervalMS, SCHEDULER_TICK_MS);
+    client.interval = client.desiredInterval;
+    client.pendingFrames = 0;
+    client.pendingReset = 0;
+    client.periodCost = 0;
+    client.periodRuns = 0;
+    client.avgCost = 0.0;
+    client.lastLoad = 0.0;
+    client.lastRate = 0.0;
+    clients.append(client);
+
+    connect(window, &QObject::destroyed, this, [this](QObject *obj) { removeWindow(static_cast<QWidget *>(obj)); });
+}
+
+void GUIRefreshScheduler::removeWindow(QWidget *window)
+{
+    for (int i = clients.count() - 1; i >= 0; i--)
+    {
+        if (clients[i].window.isNull() || clients[i].window == window) clients.removeAt(i);
+    }
+}
+
+void GUIRefreshScheduler::purge()
+{
+    for (int i = clients.count() - 1; i >= 0; i--)
+    {
+        if (clients[i].window.isNull()) clients.removeAt(i);
+    }
+}
+
+//the frame list windows read from. Used to notice a hidden window has fallen so far behind it needs a full reload
+void GUIRefreshScheduler::setFrameSource(const QVector<CANFrame> *frames)
+{
+    frameSource = frames;
+}
+
+void GUIRefreshScheduler::setBudget(int percent)
+{
+    budget = qBound(5, percent, 100);
+}
+
+int GUIRefreshScheduler::getBudget() const
+{
+    return budget;
+}
+
+//time MainWindow spent on its own refresh. Counts against the budget but can't be throttled from here
+void GUIRefreshScheduler::addMainCost(qint64 nsecs)
+{
+    mainPeriodCost += nsecs;
+    mainPeriodRuns++;
+}
+
+int GUIRefreshScheduler::getInterval(QWidget *window) const
+{
+    for (const Client &client : clients)
+    {
+        if (client.window == window) return client.interval;
+    }
+    return -1;
+}
+
+bool GUIRefreshScheduler::isPaused(const Client &client)
+{
+    if (client.window.isNull()) return true;
+    return !client.window->isVisible() || client.window->isMinimized();
+}
+
+void GUIRefreshScheduler::framesUpdated(int numFrames)
+{
+    if (numFrames == 0) return;
+
+    for (int i = 0; i < clients.count(); i++)
+    {
+        Client &client = clients[i];
+        if (numFrames < 0)
+        {
+            //whatever was pending is about frames that don't exist any longer
+            client.pendingReset = numFrames;
+            client.pendingFrames = 0;
+        }
+        else client.pendingFrames = static_cast<int>(qMin<qint64>(static_cast<qint64>(client.pendingFrames) + numFrames, INT_MAX));
+    }
+
+    if (numFrames > 0) return;
+
+    //windows on screen shouldn't show frames that are gone for even a tick
+    for (int i = 0; i < clients.count(); i++)
+    {
+        if (clients[i].pendingReset == 0 || isPaused(clients[i])) continue;
+        clients[i].pendingReset = 0;
+        deliver(i, numFrames);
+    }
+}
+
+void GUIRefreshScheduler::deliver(int index, int numFrames)
+{
+    QWidget *window = clients[index].window;
+    std::function<void(int)> callback = clients[index].callback;
+
+    QElapsedTimer costTimer;
+    costTimer.start();
+    callback(numFrames);
+    qint64 cost = costTimer.nsecsElapsed();
+
+    //the callback is free to open or close other windows so the list might have shifted under us
+    if (index >= clients.count() || clients[index].window != window)
+    {
+        index = -1;
+        for (int i = 0; i < clients.count(); i++)
+        {
+            if (clients[i].window == window) index = i;
+        }
+        if (index < 0) return;
+    }
+
+    Client &client = clients[index];
+    client.lastRun.start();
+    client.periodCost += cost;
+    client.periodRuns++;
+    if (client.avgCost == 0.0) client.avgCost = cost;
+    else client.avgCost = client.avgCost * 0.8 + cost * 0.2;
+}
+
+void GUIRefreshScheduler::runPending()
+{
+    purge();
+
+    for (int i = 0; i < clients.count(); i++)
+    {
+        Client &client = clients[i];
+        if (client.pendingReset == 0 && client.pendingFrames == 0) continue;
+        if (isPaused(client)) continue;
+
+        if (client.pendingReset != 0)
+        {
+            int reset = client.pendingReset;
+            client.pendingReset = 0;
+            //a -2 means the window reloads everything so that covers anything that came in after it too
+            if (reset == -2) client.pendingFrames = 0;
+            deliver(i, reset);
+            continue;
+        }
+
+        if (client.lastRun.isValid() && client.lastRun.elapsed() < client.interval) continue;
+
+        int numFrames = client.pendingFrames;
+        client.pendingFrames = 0;
+        //been hidden long enough that the oldest frames it hasn't seen are gone. Only thing to do is start over
+        if (frameSource && numFrames > frameSource->count()) numFrames = -2;
+        deliver(i, numFrames);
+    }
+
+    if (periodTimer.elapsed() >= REBALANCE_MS) rebalance();
+}
+
+/*
+ * Totals up where the time went over the last period and nudges intervals toward keeping inside the budget.
+ * Only one priority level is changed per pass so each step gets measured before the next one is taken.
+*/
+void GUIRefreshScheduler::rebalance()
+{
+    qint64 elapsed = periodTimer.nsecsElapsed();
+    periodTimer.restart();
+    if (elapsed <= 0) return;
+
+    purge();
+
+    qint64 total = mainPeriodCost;
+    mainLoad = mainPeriodCost * 100.0 / elapsed;
+    mainRate = mainPeriodRuns * 1000000000.0 / elapsed;
+    mainPeriodCost = 0;
+    mainPeriodRuns = 0;
+
+    for (int i = 0; i < clients.count(); i++)
+    {
+        Client &client = clients[i];
+        total += client.periodCost;
+        client.lastLoad = client.periodCost * 100.0 / elapsed;
+        client.lastRate = client.periodRuns * 1000000000.0 / elapsed;
+        client.periodCost = 0;
+        client.periodRuns = 0;
+    }
+    lastTotalLoad = total * 100.0 / elapsed;
+
+    if (lastTotalLoad > budget)
+    {
+        //least important windows that actually cost something get slowed down first
+        for (int p = REFRESH_LOW; p <= REFRESH_HIGH; p++)
+        {
+            bool changed = false;
+            for (int i = 0; i < clients.count(); i++)
+            {
+                Client &client = clients[i];
+                if (client.priority != p || client.lastLoad <= 0.0 || client.interval >= MAX_REFRESH_INTERVAL) continue;
+                client.interval = qMin(client.interval * 3 / 2, MAX_REFRESH_INTERVAL);
+                changed = true;
+            }
+            if (changed) break;
+        }
+    }
+    else if (lastTotalLoad < budget * 0.6)
+    {
+        //plenty of room, give the most important windows their rate back first
+        for (int p = REFRESH_HIGH; p >= REFRESH_LOW; p--)
+        {
+            bool changed = false;
+            for (int i = 0; i < clients.count(); i++)
+            {
+                Client &client = clients[i];
+                if (client.priority != p || client.interval <= client.desiredInterval) continue;
+                client.interval = qMax(client.interval * 2 / 3, client.desiredInterval);
+                changed = true;
+            }
+            if (changed) break;
+        }
+    }
+
+    emit costsUpdated();
+}
+
+//one line per window, for the cost overlay on the main screen
+QString GUIRefreshScheduler::getCostSummary() const
+{
+    QString out = QString("GUI refresh %1% of %2% budget").arg(lastTotalLoad, 0, 'f', 1).arg(budget);
+    out += QString("\n%1 %2/s %3%").arg(QString("Main window"), -24).arg(mainRate, 5, 'f', 1).arg(mainLoad, 5, 'f', 1);
+
+    for (const Client &client : clients)
+    {
+        if (client.window.isNull()) continue;
+        QString name = client.window->windowTitle();
+        if (name.isEmpty()) name = client.window->metaObject()->className();
+        name = name.left(24);
+
+        if (isPaused(client))
+        {
+            out += QString("\n%1 paused").arg(name, -24);
+            continue;
+        }
+        out += QString("\n%1 %2/s %3% %4ms each, every %5ms").arg(name, -24).arg(client.lastRate, 5, 'f', 1)
+                .arg(client.lastLoad, 5, 'f', 1).arg(client.avgCost / 1000000.0, 0, 'f', 1).arg(client.interval);
+    }
+    return out;
+}
@@ -0,0 +1,98 @@
+#ifndef GUIREFRESHSCHEDULER_H
+#define GUIREFRESHSCHEDULER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QWidget>
+#include <functional>
+#include "can_structs.h"
+
+/*
+ * Hands out MainWindow::framesUpdated to the sub-windows instead of every window hearing about every GUI tick.
+ * Windows register with a priority and how often they'd like to be updated. New frame counts pile up per window
+ * and get delivered as one call once the window's interval has passed. Windows that are hidden or minimized
+ * are skipped entirely and catch up in one go when they're shown again.
+ *
+ * Each delivery is timed. Once a second the total time spent (sub-windows plus the main grid refresh) is compared
+ * against the CPU budget (Main/RefreshBudget, percent of the GUI thread). Over budget the least important windows
+ * get their intervals stretched first, under budget the most important ones get theirs back first.
+ *
+ * -1 and -2 (cleared / all new frames) are never throttled. Visible windows get them right away, hidden ones
+ * when they next show up. Only meant to be used from the GUI thread.
+*/
+
+enum RefreshPriority
+{
+    REFRESH_LOW = 0,
+    REFRESH_NORMAL = 1,
+    REFRESH_HIGH = 2
+};
+
+class GUIRefreshScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GUIRefreshScheduler(QObject *parent = nullptr);
+    static GUIRefreshScheduler *getReference();
+
+    void addWindow(QWidget *window, std::function<void(int)> callback, RefreshPriority priority = REFRESH_NORMAL, int intervalMS = 250);
+    template<typename T> void addWindow(T *window, void (T::*slot)(int), RefreshPriority priority = REFRESH_NORMAL, int intervalMS = 250)
+    {
+        addWindow(window, [window, slot](int numFrames) { (window->*slot)(numFrames); }, priority, intervalMS);
+    }
+    void removeWindow(QWidget *window);
+    void setFrameSource(const QVector<CANFrame> *frames);
+    void setBudget(int percent);
+    int getBudget() const;
+    void addMainCost(qint64 nsecs);
+    int getInterval(QWidget *window) const;
+    QString getCostSummary() const;
+
+public slots:
+    void framesUpdated(int numFrames);
+    void runPending();
+    void rebalance();
+
+signals:
+    void costsUpdated(); //once a second after the intervals have been adjusted
+
+private:
+    struct Client
+    {
+        QPointer<QWidget> window;
+        std::function<void(int)> callback;
+        RefreshPriority priority;
+        int desiredInterval;
+        int interval;           //what the budget currently allows, never less than desiredInterval
+        int pendingFrames;
+        int pendingReset;       //0, -1 or -2 waiting to go out
+        QElapsedTimer lastRun;
+        qint64 periodCost;      //nanoseconds spent in the callback since the last rebalance
+        int periodRuns;
+        double avgCost;         //running average of one delivery in nanoseconds
+        double lastLoad;        //percent of the last period spent in this window
+        double lastRate;        //deliveries per second over the last period
+    };
+
+    QVector<Client> clients;
+    QTimer tickTimer;
+    QElapsedTimer periodTimer;
+    const QVector<CANFrame> *frameSource;
+    int budget;
+    qint64 mainPeriodCost;
+    int mainPeriodRuns;
+    double mainLoad;
+    double mainRate;
+    double lastTotalLoad;
+
+    static bool isPaused(const Client &client);
+    void deliver(int index, int numFrames);
+    void purge();
+    static GUIRefreshScheduler *instance;
+};
+
+#endif // GUIREFRESHSCHEDULER_H
@@ -106,6 +106,8 @@ MainSettingsDialog::MainSettingsDialog(QWidget *parent) :
 
     ui->spinMaximumFrames->setValue(settings.value("Main/MaximumFrames", maxFramesDefault).toInt());
     ui->spinBytesPerLine->setValue(settings.value("Main/BytesPerLine", 8).toInt());
+    ui->spinRefreshBudget->setValue(settings.value("Main/RefreshBudget", 50).toInt());
+    ui->cbRefreshOverlay->setChecked(settings.value("Main/RefreshOverlay", false).toBool());
 
     //just for simplicity they all call the same function and that function updates all settings at once
     connect(ui->cbDisplayHex, SIGNAL(toggled(bool)), this, SLOT(updateSettings()));
@@ -138,6 +140,8 @@ MainSettingsDialog::MainSettingsDialog(QWidget *parent) :
     connect(ui->spinMaximumFrames, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
     connect(ui->cbFontFixedWidth, SIGNAL(toggled(bool)), this, SLOT(updateSettings()));
     connect(ui->spinBytesPerLine, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
+    connect(ui->spinRefreshBudget, SIGNAL(valueChanged(int)), this, SLOT(updateSettings()));
+    connect(ui->cbRefreshOverlay, SIGNAL(toggled(bool)), this, SLOT(updateSettings()));
 
     installEventFilter(this);
 }
@@ -207,6 +211,8 @@ void MainSettingsDialog::updateSettings()
     settings.setValue("Main/IgnoreDBCColors", ui->cbIgnoreDBCColors->isChecked());
     settings.setValue("Main/MaximumFrames", ui->spinMaximumFrames->value());
     settings.setValue("Main/BytesPerLine", ui->spinBytesPerLine->value());
+    settings.setValue("Main/RefreshBudget", ui->spinRefreshBudget->value());
+    settings.setValue("Main/RefreshOverlay", ui->cbRefreshOverlay->isChecked());
     settings.setValue("Main/FontFixedWidth", ui->cbFontFixedWidth->isChecked());
 
     settings.sync();
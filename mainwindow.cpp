@@ -3,12 +3,17 @@
 #include "can_structs.h"
 #include <QDateTime>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QtSerialPort/QSerialPortInfo>
 #include "connections/canconmanager.h"
 #include "connections/connectionwindow.h"
 #include "helpwindow.h"
 #include "utility.h"
 #include "filterutility.h"
+#include "dbc/dbcsignalcache.h"
+#include "guirefreshscheduler.h"
+
+#define PER_ROW_EXPANSION_LIMIT 20000 //more rows than this and expanded rows all get the height of the tallest one
 
 /*
 Some notes on things I'd like to put into the program but haven't put on github (yet)
@@ -47,6 +52,19 @@ MainWindow::MainWindow(QWidget *parent) :
     proxyModel->setSourceModel(model);
 
     ui->canFramesView->setModel(proxyModel);
+    ui->canFramesView->setFrameModel(model);
+
+    filterListModel = new CANFilterListModel(CANFilterListModel::FILTER_IDS, this);
+    busFilterListModel = new CANFilterListModel(CANFilterListModel::FILTER_BUSES, this);
+    ui->listFilters->setModel(filterListModel);
+    ui->listBusFilters->setModel(busFilterListModel);
+
+    //small see-through readout of where the GUI thread's time is going. Turned on in the preferences
+    refreshOverlay = new QLabel(ui->canFramesView);
+    refreshOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+    refreshOverlay->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    refreshOverlay->setStyleSheet("QLabel { background-color: rgba(0, 0, 0, 160); color: white; padding: 4px; }");
+    refreshOverlay->hide();
 
     settingsDialog = new MainSettingsDialog(); //instantiate the settings dialog so it can initialize settings if this is the first run or the config file was deleted.
     settingsDialog->updateSettings(); //write out all the settings. If this is the first run it'll write defaults out.
@@ -96,9 +114,15 @@ MainWindow::MainWindow(QWidget *parent) :
     temporalGraphWindow = nullptr;
     dbcComparatorWindow = nullptr;
     canBridgeWindow = nullptr;
+    frameSearchWindow = nullptr;
     dbcHandler = DBCHandler::getReference();
+    //connected first so the cache is already reset by the time any window reacts to a cleared or replaced frame list
+    connect(this, &MainWindow::framesUpdated, DBCSignalCache::getReference(), &DBCSignalCache::framesUpdated);
+    //sub-windows get their updates through the scheduler so hidden ones are skipped and busy ones get throttled
+    connect(this, &MainWindow::framesUpdated, GUIRefreshScheduler::getReference(), &GUIRefreshScheduler::framesUpdated);
+    connect(GUIRefreshScheduler::getReference(), &GUIRefreshScheduler::costsUpdated, this, &MainWindow::updateRefreshOverlay);
+    GUIRefreshScheduler::getReference()->setFrameSource(model->getListReference());
     bDirty = false;
-    inhibitFilterUpdate = false;
     rxFrames = 0;
     framesPerSec = 0;
     continuousLogging = false;
@@ -138,6 +162,7 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->actionSave_Continuous_Logfile, &QAction::triggered, this, &MainWindow::handleContinousLogging);
     connect(ui->actionTemporal_Graph, &QAction::triggered, this, &MainWindow::showTemporalGraphWindow);
     connect(ui->actionCAN_Bridge, &QAction::triggered, this, &MainWindow::showCANBridgeWindow);
+    connect(ui->actionSearch_Frames, &QAction::triggered, this, &MainWindow::showFrameSearchWindow);
 
     //handlers fror interactions with the main can frame view table
     connect(ui->canFramesView, &QAbstractItemView::clicked, this, &MainWindow::gridClicked);
@@ -153,14 +178,17 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->cbInterpret, &QAbstractButton::toggled, this, &MainWindow::interpretToggled);
     connect(ui->cbOverwrite, &QAbstractButton::toggled, this, &MainWindow::overwriteToggled);
     connect(ui->cbPersistentFilters, &QAbstractButton::toggled, this, &MainWindow::presistentFiltersToggled);
-    connect(ui->listFilters, &QListWidget::itemChanged, this, &MainWindow::filterListItemChanged);
-    connect(ui->listBusFilters, &QListWidget::itemChanged, this, &MainWindow::busFilterListItemChanged);
+    connect(filterListModel, &CANFilterListModel::filterToggled, this, &MainWindow::filterToggled);
+    connect(busFilterListModel, &CANFilterListModel::filterToggled, this, &MainWindow::busFilterToggled);
+    connect(ui->cbFilterCounts, &QAbstractButton::toggled, filterListModel, &CANFilterListModel::setShowCounts);
 
     connect(ui->btnCaptureToggle, &QAbstractButton::clicked, this, &MainWindow::toggleCapture);
     connect(ui->btnClearFrames, &QAbstractButton::clicked, this, &MainWindow::clearFrames);
     connect(ui->btnNormalize, &QAbstractButton::clicked, this, &MainWindow::normalizeTiming);
     connect(ui->btnFilterAll, &QAbstractButton::clicked, this, &MainWindow::filterSetAll);
     connect(ui->btnFilterNone, &QAbstractButton::clicked, this, &MainWindow::filterClearAll);
+    connect(ui->lineFilterExpression, &QLineEdit::returnPressed, this, &MainWindow::filterExpressionEntered);
+    connect(ui->lineFilterExpression, &QLineEdit::textChanged, this, &MainWindow::filterExpressionEdited);
     connect(ui->btnExpandAll, &QAbstractButton::clicked, this, &MainWindow::expandAllRows);
     connect(ui->btnCollapseAll, &QAbstractButton::clicked, this, &MainWindow::collapseAllRows);
 
@@ -193,6 +221,7 @@ MainWindow::MainWindow(QWidget *parent) :
 
     elapsedTime = new QElapsedTimer;
     elapsedTime->start();
+    filterCountTimer.start();
 
     isConnected = false;
     allowCapture = true;
@@ -212,6 +241,7 @@ MainWindow::MainWindow(QWidget *parent) :
     normalRowHeight = ui->canFramesView->rowHeight(0);
     if (normalRowHeight == 0) normalRowHeight = 30; //should not be necessary but provides a sane number if something stupid happened.
     qDebug() << "normal row height = " << normalRowHeight;
+    ui->canFramesView->setBaseRowHeight(normalRowHeight);
     model->clearFrames();
 
     ui->canFramesView->verticalHeader()->setDefaultSectionSize(normalRowHeight);    // Set the default height for all rows to the height that was calculated
@@ -293,6 +323,7 @@ void MainWindow::killEmAll()
     killWindow(signalViewerWindow);
     killWindow(temporalGraphWindow);
     killWindow(canBridgeWindow);
+    killWindow(frameSearchWindow);
 
     //trying to kill this window can cause a fault to happen. It's closed last just in case.
     killWindow(connectionWindow);
@@ -438,7 +469,13 @@ void MainWindow::readUpdateableSettings()
         ui->listFilters->setMaximumWidth(250);
     else
         ui->listFilters->setMaximumWidth(175);
-    updateFilterList();    
+    updateFilterList();
+    filterListModel->relabel();
+    busFilterListModel->relabel();
+
+    GUIRefreshScheduler::getReference()->setBudget(settings.value("Main/RefreshBudget", 50).toInt());
+    refreshOverlay->setVisible(settings.value("Main/RefreshOverlay", false).toBool());
+    updateRefreshOverlay();
 }    
 
 
@@ -654,38 +691,30 @@ void MainWindow::headerClicked(int logicalIndex)
 
 void MainWindow::expandAllRows()
 {
-    bool goAhead = false;
-    int numRows = ui->canFramesView->model()->rowCount();
-
-    if (numRows > 20000)
-    {
-        QMessageBox::StandardButton confirmDialog;
-        confirmDialog = QMessageBox::question(this, "Really?", "It's not recommended to use this\non more than 20000 frames.\nIt can take a long time.\n\nYou have been warned!\nStill do it?",
-                                  QMessageBox::Yes|QMessageBox::No);
-
-        if (confirmDialog == QMessageBox::Yes) goAhead = true;
-    }
-    else goAhead = true;
-
-    if (goAhead)
-    {
-        ui->canFramesView->resizeRowsToContents();
-
-        rowExpansionActive = true;
-    }
+    rowExpansionActive = true;
+    sizeExpandedRows();
 }
 
 void MainWindow::manageRowExpansion()
+{
+    if(rowExpansionActive && model->getInterpretMode()) sizeExpandedRows();
+}
+
+/*
+ * Row heights come from how many lines each row will have rather than from laying the text out so this is cheap
+ * per row. Past a point even that adds up every GUI tick though, so big lists give every row the height of the
+ * tallest one. Setting the default size is a single pass inside the header instead of a call per row.
+*/
+void MainWindow::sizeExpandedRows()
 {
     int numRows = ui->canFramesView->model()->rowCount();
-    if(numRows < 20000)
+    if (numRows <= PER_ROW_EXPANSION_LIMIT)
     {
-        if(rowExpansionActive && model->getInterpretMode())
-            ui->canFramesView->resizeRowsToContents();
+        ui->canFramesView->resizeRowsToContents();
     }
     else
     {
-        disableAutoRowExpansion();
+        ui->canFramesView->verticalHeader()->setDefaultSectionSize(ui->canFramesView->heightForLines(model->getMaxLineCount()));
     }
 }
 
@@ -696,29 +725,15 @@ void MainWindow::disableAutoRowExpansion()
 
 void MainWindow::collapseAllRows()
 {
-    bool goAhead = false;
-    int numRows = ui->canFramesView->model()->rowCount();
+    //resizes every row in one go, no need to do them one at a time
+    ui->canFramesView->verticalHeader()->setDefaultSectionSize(normalRowHeight);
 
-    if (numRows > 50000)
-    {
-        QMessageBox::StandardButton confirmDialog;
-        confirmDialog = QMessageBox::question(this, "Really?", "It's not recommended to use this\non more than 50000 frames.\nIt can take a long time.\n\nYou have been warned!\nStill do it?",
-                                  QMessageBox::Yes|QMessageBox::No);
-
-        if (confirmDialog == QMessageBox::Yes) goAhead = true;
-    }
-    else goAhead = true;
-
-    if (goAhead)
-    {
-        for (int i = 0; i < numRows; i++) ui->canFramesView->setRowHeight(i, normalRowHeight);
-
-        rowExpansionActive = false;
-    }
+    rowExpansionActive = false;
 }
 
 void MainWindow::gridClicked(QModelIndex idx)
 {
+    if (frameSearchWindow) frameSearchWindow->setCurrentRow(idx.row());
     //qDebug() << "Grid Clicked";
     if (ui->canFramesView->rowHeight(idx.row()) > normalRowHeight)
     {
@@ -877,68 +892,28 @@ void MainWindow::updateFilterList()
     const QMap<int, bool> *busFilters = model->getBusFiltersReference();
     if (filters == nullptr || busFilters == nullptr) return;
 
-    qDebug() << "updateFilterList called on MainWindow";
-
-    inhibitFilterUpdate = true;
-
-    ui->listFilters->clear();
-    ui->listBusFilters->clear();
-
-    if (filters->isEmpty()) return;
-
-    QMap<int, bool>::const_iterator filterIter;
-    for (filterIter = filters->begin(); filterIter != filters->end(); ++filterIter)
-    {
-        /*QListWidgetItem *thisItem = */FilterUtility::createCheckableFilterItem(filterIter.key(), filterIter.value(), ui->listFilters);
-    }
-
-    if (busFilters->isEmpty()) return;
-
-    for (filterIter = busFilters->begin(); filterIter != busFilters->end(); ++filterIter)
-    {
-        /*QListWidgetItem *thisItem = */ FilterUtility::createCheckableBusFilterItem(filterIter.key(), filterIter.value(), ui->listBusFilters);
-    }
-    inhibitFilterUpdate = false;
+    //only IDs the lists haven't seen yet get added, everything else stays put
+    filterListModel->sync(*filters);
+    busFilterListModel->sync(*busFilters);
 }
 
-void MainWindow::filterListItemChanged(QListWidgetItem *item)
+void MainWindow::filterToggled(uint32_t id, bool state)
 {
-    if (inhibitFilterUpdate) return;
-    //qDebug() << item->text();
-
-    // strip away possible filter label
-    int ID = FilterUtility::getIdAsInt(item);
-    bool isSet = false;
-    if (item->checkState() == Qt::Checked) isSet = true;
-
-    model->setFilterState(ID, isSet);
+    model->setFilterState(id, state);
 
     manageRowExpansion();
 }
 
-void MainWindow::busFilterListItemChanged(QListWidgetItem *item)
+void MainWindow::busFilterToggled(uint32_t id, bool state)
 {
-    if (inhibitFilterUpdate) return;
-    //qDebug() << item->text();
-
-    // strip away possible filter label
-    int ID = FilterUtility::getIdAsInt(item);
-    bool isSet = false;
-    if (item->checkState() == Qt::Checked) isSet = true;
-
-    model->setBusFilterState(ID, isSet);
+    model->setBusFilterState(id, state);
 
     manageRowExpansion();
 }
 
 void MainWindow::filterSetAll()
 {
-    inhibitFilterUpdate = true;
-    for (int i = 0; i < ui->listFilters->count(); i++)
-    {
-        ui->listFilters->item(i)->setCheckState(Qt::Checked);
-    }
-    inhibitFilterUpdate = false;
+    filterListModel->setAllChecked(true);
     model->setAllFilters(true);
 
     manageRowExpansion();
@@ -946,13 +921,28 @@ void MainWindow::filterSetAll()
 
 void MainWindow::filterClearAll()
 {
-    inhibitFilterUpdate = true;
-    for (int i = 0; i < ui->listFilters->count(); i++)
+    filterListModel->setAllChecked(false);
+    model->setAllFilters(false);
+}
+
+void MainWindow::filterExpressionEntered()
+{
+    if (model->setFilterExpression(ui->lineFilterExpression->text()))
     {
-        ui->listFilters->item(i)->setCheckState(Qt::Unchecked);
+        ui->lineFilterExpression->setToolTip(tr("Only show frames matching this expression. Press enter to apply, clear it to show everything"));
+        ui->statusBar->clearMessage();
     }
-    inhibitFilterUpdate = false;
-    model->setAllFilters(false);
+    else
+    {
+        ui->lineFilterExpression->setToolTip(model->getFilterExpressionError());
+        ui->statusBar->showMessage(tr("Filter expression: ") + model->getFilterExpressionError(), 5000);
+    }
+}
+
+//clearing the box (or hitting its clear button) takes the filter off right away instead of waiting for enter
+void MainWindow::filterExpressionEdited(const QString &text)
+{
+    if (text.trimmed().isEmpty() && !model->getFilterExpression().isEmpty()) filterExpressionEntered();
 }
 
 void MainWindow::logReceivedFrame(CANConnection* conn, QVector<CANFrame> frames)
@@ -960,12 +950,28 @@ void MainWindow::logReceivedFrame(CANConnection* conn, QVector<CANFrame> frames)
     Q_UNUSED(conn);
     if (continuousLogging)
     {
-        FrameFileIO::writeContinuousNative(&frames, 0);
+        if (logFilter.isEmpty())
+        {
+            FrameFileIO::writeContinuousNative(&frames, 0);
+            return;
+        }
+
+        if (logFilter.needsResolve()) logFilter.resolveSignals();
+        QVector<CANFrame> matched;
+        matched.reserve(frames.count());
+        for (const CANFrame &frame : frames)
+        {
+            if (logFilter.matches(frame)) matched.append(frame);
+        }
+        if (!matched.isEmpty()) FrameFileIO::writeContinuousNative(&matched, 0);
     }
 }
 
 void MainWindow::tickGUIUpdate()
 {
+    QElapsedTimer costTimer;
+    costTimer.start();
+
     rxFrames = model->sendBulkRefresh();
     //if(rxFrames>0)
     //{
@@ -990,6 +996,9 @@ void MainWindow::tickGUIUpdate()
 
         if (model->needsFilterRefresh()) updateFilterList();
 
+        //counts and rates in the filter list. Kept up to date even when hidden so the rate is right the moment they're shown
+        if (filterCountTimer.elapsed() >= 1000) filterListModel->updateCounts(model->getIDCounts(), filterCountTimer.restart());
+
         if (continuousLogging)
         {
 //            const QVector<CANFrame> *modelFrames = model->getListReference();
@@ -1028,6 +1037,20 @@ void MainWindow::tickGUIUpdate()
 
         rxFrames = 0;
     //}
+
+    GUIRefreshScheduler::getReference()->addMainCost(costTimer.nsecsElapsed());
+}
+
+//pinned to the top right corner of the frame grid
+void MainWindow::updateRefreshOverlay()
+{
+    if (refreshOverlay->isHidden()) return;
+    refreshOverlay->setText(GUIRefreshScheduler::getReference()->getCostSummary());
+    refreshOverlay->adjustSize();
+    int x = ui->canFramesView->width() - refreshOverlay->width() - 4;
+    if (ui->canFramesView->verticalScrollBar()->isVisible()) x -= ui->canFramesView->verticalScrollBar()->width();
+    refreshOverlay->move(qMax(0, x), ui->canFramesView->horizontalHeader()->height() + 4);
+    refreshOverlay->raise();
 }
 
 void MainWindow::gotFrames(int framesSinceLastUpdate)
@@ -1051,10 +1074,18 @@ void MainWindow::addFrameToDisplay(CANFrame &frame, bool autoRefresh = false)
 void MainWindow::gotCenterTimeID(uint32_t ID, double timestamp)
 {
     int idx = model->getIndexFromTimeID(ID, timestamp);
-    if (idx > -1)
-    {
-        ui->canFramesView->selectRow(idx);
-    }
+    if (idx > -1) gotJumpToRow(idx);
+}
+
+//select and show a row of the frame grid. Row is in terms of the model's filtered list
+void MainWindow::gotJumpToRow(int row)
+{
+    QSortFilterProxyModel *proxyModel = qobject_cast<QSortFilterProxyModel *>(ui->canFramesView->model());
+    QModelIndex idx = model->index(row, 0);
+    if (proxyModel) idx = proxyModel->mapFromSource(idx);
+    if (!idx.isValid()) return;
+    ui->canFramesView->selectRow(idx.row());
+    ui->canFramesView->scrollTo(idx, QAbstractItemView::PositionAtCenter);
 }
 
 void MainWindow::clearFrames()
@@ -1157,6 +1188,18 @@ void MainWindow::handleDroppedFile(const QString &filename)
 }
 
 
+//the bisector replacing the frame list with part of itself. Done in place in the model so nothing gets copied
+bool MainWindow::keepFrames(const FrameSelection &selection, const CANFrameSnapshot &snapshot)
+{
+    ui->canFramesView->scrollToTop();
+    if (!model->keepFrames(selection, snapshot)) return false;
+    ui->lbNumFrames->setText(QString::number(model->rowCount()));
+    bDirty = true;
+    updateFileStatus();
+    emit framesUpdated(-2); //every row is a different frame now
+    return true;
+}
+
 void MainWindow::handleSaveFile()
 {
     QString filename;
@@ -1170,6 +1213,21 @@ void MainWindow::handleSaveFile()
 
 void MainWindow::handleContinousLogging()
 {
+    if (!continuousLogging)
+    {
+        //optionally only log some of the traffic. Keep asking until the expression compiles or they give up
+        QString text = logFilter.getText();
+        while (true)
+        {
+            bool ok;
+            text = QInputDialog::getText(this, tr("Continuous Logging"), tr("Only log frames matching this filter expression (leave blank to log everything):"),
+                                         QLineEdit::Normal, text, &ok);
+            if (!ok) return;
+            if (logFilter.compile(text)) break;
+            QMessageBox::warning(this, tr("Continuous Logging"), tr("That filter expression doesn't work: ") + logFilter.getLastError());
+        }
+    }
+
     continuousLogging = !continuousLogging;
 
     if (continuousLogging)
@@ -1608,6 +1666,7 @@ void MainWindow::showGraphingWindow()
 
     connect(lastGraphingWindow, SIGNAL(sendCenterTimeID(uint32_t,double)), this, SLOT(gotCenterTimeID(uint32_t,double)));
     connect(this, SIGNAL(sendCenterTimeID(uint32_t,double)), lastGraphingWindow, SLOT(gotCenterTimeID(uint32_t,double)));
+    if (frameInfoWindow) connect(lastGraphingWindow, SIGNAL(sendCenterTimeID(uint32_t,double)), frameInfoWindow, SLOT(gotCenterTimeID(uint32_t,double)));
 
     if (flowViewWindow) //connect the two external windows together
     {
@@ -1655,6 +1714,11 @@ void MainWindow::showFrameDataAnalysis()
             frameInfoWindow = new FrameInfoWindow(model->getListReference());
         else
             frameInfoWindow = new FrameInfoWindow(model->getFilteredListReference());
+        //frame info only follows along, it doesn't have a time axis of its own to send from
+        connect(this, SIGNAL(sendCenterTimeID(uint32_t,double)), frameInfoWindow, SLOT(gotCenterTimeID(uint32_t,double)));
+        for (GraphingWindow *graph : graphWindows)
+            connect(graph, SIGNAL(sendCenterTimeID(uint32_t,double)), frameInfoWindow, SLOT(gotCenterTimeID(uint32_t,double)));
+        if (flowViewWindow) connect(flowViewWindow, SIGNAL(sendCenterTimeID(uint32_t,double)), frameInfoWindow, SLOT(gotCenterTimeID(uint32_t,double)));
     }
     frameInfoWindow->show();
 }
@@ -1687,6 +1751,16 @@ void MainWindow::showBisectWindow()
     bisectWindow->show();
 }
 
+void MainWindow::showFrameSearchWindow()
+{
+    if (!frameSearchWindow)
+    {
+        frameSearchWindow = new FrameSearchWindow(model);
+        connect(frameSearchWindow, &FrameSearchWindow::jumpToRow, this, &MainWindow::gotJumpToRow);
+    }
+    frameSearchWindow->show();
+}
+
 void MainWindow::showCANBridgeWindow()
 {
     if (!canBridgeWindow)
@@ -1816,14 +1890,15 @@ void MainWindow::showFlowViewWindow()
             flowViewWindow = new FlowViewWindow(model->getListReference());
         else
             flowViewWindow = new FlowViewWindow(model->getFilteredListReference());
-        connect(flowViewWindow, SIGNAL(sendCenterTimeID(uint32_t,double)), this, SLOT(gotCenterTimeID(int32_t,double)));
-        connect(this, SIGNAL(sendCenterTimeID(uint32_t,double)), flowViewWindow, SLOT(gotCenterTimeID(int32_t,double)));
-    }
+        connect(flowViewWindow, SIGNAL(sendCenterTimeID(uint32_t,double)), this, SLOT(gotCenterTimeID(uint32_t,double)));
+        connect(this, SIGNAL(sendCenterTimeID(uint32_t,double)), flowViewWindow, SLOT(gotCenterTimeID(uint32_t,double)));
+        if (frameInfoWindow) connect(flowViewWindow, SIGNAL(sendCenterTimeID(uint32_t,double)), frameInfoWindow, SLOT(gotCenterTimeID(uint32_t,double)));
 
-    if (lastGraphingWindow)
-    {
-        connect(lastGraphingWindow, SIGNAL(sendCenterTimeID(uint32_t,double)), flowViewWindow, SLOT(gotCenterTimeID(int32_t,double)));
-        connect(flowViewWindow, SIGNAL(sendCenterTimeID(uint32_t,double)), lastGraphingWindow, SLOT(gotCenterTimeID(int32_t,double)));
+        if (lastGraphingWindow)
+        {
+            connect(lastGraphingWindow, SIGNAL(sendCenterTimeID(uint32_t,double)), flowViewWindow, SLOT(gotCenterTimeID(uint32_t,double)));
+            connect(flowViewWindow, SIGNAL(sendCenterTimeID(uint32_t,double)), lastGraphingWindow, SLOT(gotCenterTimeID(uint32_t,double)));
+        }
     }
 
     flowViewWindow->show();
@@ -1833,6 +1908,7 @@ void MainWindow::showFlowViewWindow()
 void MainWindow::DBCSettingsUpdated()
     {
     updateFilterList();
+    filterListModel->relabel();
     model->sendRefresh();
     }
 
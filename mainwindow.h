@@ -6,6 +6,7 @@
 #include <QSerialPort>
 #include <QSerialPortInfo>
 #include "canframemodel.h"
+#include "canfilterlistmodel.h"
 #include "can_structs.h"
 #include "framefileio.h"
 #include "dbc/dbchandler.h"
@@ -34,6 +35,7 @@
 #include "re/temporalgraphwindow.h"
 #include "re/dbccomparatorwindow.h"
 #include "canbridgewindow.h"
+#include "framesearchwindow.h"
 
 class CANConnection;
 class ConnectionWindow;
@@ -68,6 +70,7 @@ public:
     ~MainWindow();
 
     void handleDroppedFile(const QString &filename);
+    bool keepFrames(const FrameSelection &selection, const CANFrameSnapshot &snapshot);
 
 private slots:
     void handleLoadFile();
@@ -103,6 +106,7 @@ private slots:
     void showTemporalGraphWindow();
     void showDBCComparisonWindow();
     void showCANBridgeWindow();
+    void showFrameSearchWindow();
     void exitApp();
     void handleSaveDecoded();
     void handleSaveDecodedCsv();
@@ -120,19 +124,23 @@ private slots:
     void toggleCapture();
     void normalizeTiming();
     void updateFilterList();
-    void filterListItemChanged(QListWidgetItem *item);
-    void busFilterListItemChanged(QListWidgetItem *item);
+    void filterToggled(uint32_t id, bool state);
+    void busFilterToggled(uint32_t id, bool state);
     void filterSetAll();
     void filterClearAll();
+    void filterExpressionEntered();
+    void filterExpressionEdited(const QString &text);
     void headerClicked (int logicalIndex);
     void DBCSettingsUpdated();
     void onSenderCellChanged(int, int);
+    void updateRefreshOverlay();
 
 public slots:
     void gotFrames(int);
     void updateSettings();
     void readUpdateableSettings();
     void gotCenterTimeID(uint32_t ID, double timestamp);
+    void gotJumpToRow(int row);
     void updateConnectionSettings(QString connectionType, QString port, int speed0, int speed1);
 
 signals:
@@ -151,14 +159,17 @@ private:
 
     //canbus related data
     CANFrameModel *model;
+    CANFilterListModel *filterListModel;
+    CANFilterListModel *busFilterListModel;
     DBCHandler *dbcHandler;
     QByteArray inputBuffer;
     QTimer updateTimer;
     QElapsedTimer *elapsedTime;
+    QElapsedTimer filterCountTimer;
+    QLabel *refreshOverlay;
     FrameSenderObject *frameSender;
     int framesPerSec;
     int rxFrames;
-    bool inhibitFilterUpdate;
     bool useHex;
     bool allowCapture;
     bool ignoreDBCColors;
@@ -169,6 +180,7 @@ private:
 
     bool continuousLogging;
     int continuousLogFlushCounter;
+    CANFilterExpression logFilter; //which frames go into the continuous log. Empty logs them all
 
     //References to other windows we can display
 
@@ -199,6 +211,7 @@ private:
     TemporalGraphWindow *temporalGraphWindow;
     DBCComparatorWindow *dbcComparatorWindow;
     CANBridgeWindow *canBridgeWindow;
+    FrameSearchWindow *frameSearchWindow;
 
     //various private storage
     QLabel lbStatusConnected;
@@ -225,6 +238,7 @@ private:
     void writeSettings();
     bool eventFilter(QObject *obj, QEvent *event);
     void manageRowExpansion();
+    void sizeExpandedRows();
     void disableAutoRowExpansion();
     void createSenderRow();
     void processSenderCellChange(int line, int col);
@@ -0,0 +1,262 @@
+#include "discretestatecorrelator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+QString DiscreteStateCandidate::describe() const
+{
+    QString temp = "ID: " + QString::number(id, 16) + " startBit: " + QString::number(startBit) + "  len: " + QString::number(bitLength);
+    temp += bigEndian ? " BigEndian" : " LittleEndian";
+    temp += "  Score: " + QString::number(score, 'f', 3);
+    return temp;
+}
+
+bool DiscreteStateCandidate::ranksAbove(const DiscreteStateCandidate &other) const
+{
+    if (score != other.score) return score > other.score;
+    if (bitLength != other.bitLength) return bitLength < other.bitLength;
+    if (id != other.id) return id < other.id;
+    if (startBit != other.startBit) return startBit < other.startBit;
+    return !bigEndian && other.bigEndian;
+}
+
+//which period each frame time falls in or -1 for none. Periods have to be in time order and not overlap
+QVector<int> DiscreteStateCorrelator::labelFrames(const QVector<int64_t> &times, const QVector<DiscreteStatePeriod> &periods, int64_t guardTime)
+{
+    QVector<int> labels(times.count(), -1);
+    for (int i = 0; i < times.count(); i++)
+    {
+        int64_t t = times[i];
+        auto it = std::upper_bound(periods.constBegin(), periods.constEnd(), t,
+                                   [](int64_t time, const DiscreteStatePeriod &p) { return time < p.startTime; });
+        if (it == periods.constBegin()) continue;
+        --it;
+        if (t >= it->endTime || t < it->startTime + guardTime) continue;
+        labels[i] = static_cast<int>(it - periods.constBegin());
+    }
+    return labels;
+}
+
+void DiscreteStateCorrelator::sortCandidates(QVector<DiscreteStateCandidate> &candidates)
+{
+    std::sort(candidates.begin(), candidates.end(),
+              [](const DiscreteStateCandidate &a, const DiscreteStateCandidate &b) { return a.ranksAbove(b); });
+}
+
+/*
+ * Every field from minBits to maxBits long at every start bit. Big endian fields only get tried when they cross into
+ * the next byte, inside one byte they're the same bits as a little endian field.
+*/
+QVector<DiscreteStateCorrelator::Field> DiscreteStateCorrelator::fieldsToTry(const RangeSignalMatrix &matrix, const DiscreteStateSettings &settings)
+{
+    QVector<Field> fields;
+    int minBits = qBound(1, settings.minBits, DISCRETE_STATE_MAX_BITS);
+    int maxBits = qBound(minBits, settings.maxBits, DISCRETE_STATE_MAX_BITS);
+    int bits = matrix.searchBits();
+    auto moves = [&](int bit) { return !matrix.isConstant(bit, 1, false); };
+
+    for (int len = minBits; len <= maxBits; len++)
+    {
+        for (int sb = 0; sb < bits; sb++)
+        {
+            if (sb + len <= bits && moves(sb) && (len == 1 || moves(sb + len - 1)))
+            {
+                Field field;
+                field.startBit = sb;
+                field.bitLength = len;
+                field.bigEndian = false;
+                fields.append(field);
+            }
+
+            if ((sb % 8) + 1 >= len) continue;
+            int pos = (sb / 8) * 8 + (7 - (sb % 8)) + len - 1;
+            if (pos >= bits) continue;
+            int lowBit = (pos / 8) * 8 + (7 - (pos % 8));
+            if (moves(sb) && moves(lowBit))
+            {
+                Field field;
+                field.startBit = sb;
+                field.bitLength = len;
+                field.bigEndian = true;
+                fields.append(field);
+            }
+        }
+    }
+    return fields;
+}
+
+DiscreteStateCandidate DiscreteStateCorrelator::makeCandidate(const RangeSignalMatrix &matrix, const Field &field, double score)
+{
+    DiscreteStateCandidate candidate;
+    candidate.id = matrix.getID();
+    candidate.startBit = field.startBit;
+    candidate.bitLength = field.bitLength;
+    candidate.bigEndian = field.bigEndian;
+    candidate.score = score;
+    return candidate;
+}
+
+static double entropy(const int *counts, int num, int total)
+{
+    double h = 0.0;
+    for (int i = 0; i < num; i++)
+    {
+        if (counts[i] == 0) continue;
+        double p = static_cast<double>(counts[i]) / total;
+        h -= p * std::log2(p);
+    }
+    return h;
+}
+
+/*
+ * framePeriods is what labelFrames gave back for the frames in the matrix. Comes back ranked with only the
+ * fields that scored at least DISCRETE_STATE_MIN_SCORE.
+*/
+QVector<DiscreteStateCandidate> DiscreteStateCorrelator::correlate(const RangeSignalMatrix &matrix, const QVector<int> &framePeriods,
+                                                                   const QVector<DiscreteStatePeriod> &periods, const DiscreteStateSettings &settings)
+{
+    QVector<DiscreteStateCandidate> out;
+    int count = matrix.frameCount();
+    if (count < 2 || framePeriods.count() != count || periods.isEmpty()) return out;
+
+    int numStates = 0;
+    for (const DiscreteStatePeriod &p : periods) numStates = qMax(numStates, p.state + 1);
+    if (numStates < 2) return out;
+
+    const int numValues = 1 << DISCRETE_STATE_MAX_BITS;
+    std::vector<uint64_t> raw(static_cast<size_t>(count));
+    std::vector<int> joint(static_cast<size_t>(numValues * numStates));
+    std::vector<int> valueTotals(numValues);
+    std::vector<int> stateTotals(numStates);
+    std::vector<int> segmentHist(numValues, 0);
+    std::vector<int> touched;
+    std::vector<int> stateMajority(numStates);
+    QVector<QPair<int, int>> segments; //state and most common value of each separate time through a state
+
+    const QVector<Field> fields = fieldsToTry(matrix, settings);
+    for (const Field &field : fields)
+    {
+        matrix.extract(field.startBit, field.bitLength, field.bigEndian, raw.data());
+        int fieldValues = 1 << field.bitLength;
+        std::fill(joint.begin(), joint.begin() + fieldValues * numStates, 0);
+        std::fill(valueTotals.begin(), valueTotals.begin() + fieldValues, 0);
+        std::fill(stateTotals.begin(), stateTotals.end(), 0);
+        segments.clear();
+
+        int labelled = 0;
+        int currPeriod = -1;
+        auto closeSegment = [&]()
+        {
+            if (currPeriod < 0 || touched.empty()) return;
+            int best = touched[0];
+            for (int v : touched)
+            {
+                if (segmentHist[v] > segmentHist[best]) best = v;
+            }
+            for (int v : touched) segmentHist[v] = 0;
+            touched.clear();
+            segments.append(qMakePair(periods[currPeriod].state, best));
+        };
+
+        for (int i = 0; i < count; i++)
+        {
+            int p = framePeriods[i];
+            if (p != currPeriod)
+            {
+                closeSegment();
+                currPeriod = p;
+            }
+            if (p < 0) continue;
+            int v = static_cast<int>(raw[i]);
+            int s = periods[p].state;
+            joint[v * numStates + s]++;
+            valueTotals[v]++;
+            stateTotals[s]++;
+            labelled++;
+            if (segmentHist[v]++ == 0) touched.push_back(v);
+        }
+        closeSegment();
+        if (labelled < 2) continue;
+
+        double hValue = entropy(valueTotals.data(), fieldValues, labelled);
+        double hState = entropy(stateTotals.data(), numStates, labelled);
+        if (hValue <= 0.0 || hState <= 0.0) continue;
+        double hJoint = entropy(joint.data(), fieldValues * numStates, labelled);
+        double uncertainty = 2.0 * (hValue + hState - hJoint) / (hValue + hState);
+
+        //the value each state mostly had. At least two states have to look different for this to be a state signal
+        QVector<int> stateValues(numStates, -1);
+        QVector<int> distinct;
+        for (int s = 0; s < numStates; s++)
+        {
+            if (stateTotals[s] == 0) continue;
+            int best = 0;
+            for (int v = 1; v < fieldValues; v++)
+            {
+                if (joint[v * numStates + s] > joint[best * numStates + s]) best = v;
+            }
+            stateMajority[s] = best;
+            stateValues[s] = best;
+            if (!distinct.contains(best)) distinct.append(best);
+        }
+        if (distinct.count() < 2) continue;
+
+        int agree = 0;
+        for (const QPair<int, int> &seg : segments)
+        {
+            if (stateMajority[seg.first] == seg.second) agree++;
+        }
+        double score = uncertainty * agree / segments.count();
+        if (score < DISCRETE_STATE_MIN_SCORE) continue;
+
+        DiscreteStateCandidate candidate = makeCandidate(matrix, field, score);
+        candidate.stateValues = stateValues;
+        out.append(candidate);
+    }
+
+    sortCandidates(out);
+    return out;
+}
+
+/*
+ * No timeline to go on. Fields that only ever take numStates different values, ranked by how few times they changed.
+ * One that goes through each state just once scores 1.
+*/
+QVector<DiscreteStateCandidate> DiscreteStateCorrelator::findStateFields(const RangeSignalMatrix &matrix, const DiscreteStateSettings &settings)
+{
+    QVector<DiscreteStateCandidate> out;
+    int count = matrix.frameCount();
+    if (count < 2 || settings.numStates < 2) return out;
+
+    std::vector<uint64_t> raw(static_cast<size_t>(count));
+    std::vector<int> valueTotals(1 << DISCRETE_STATE_MAX_BITS);
+
+    const QVector<Field> fields = fieldsToTry(matrix, settings);
+    for (const Field &field : fields)
+    {
+        int fieldValues = 1 << field.bitLength;
+        if (fieldValues < settings.numStates) continue;
+
+        matrix.extract(field.startBit, field.bitLength, field.bigEndian, raw.data());
+        std::fill(valueTotals.begin(), valueTotals.begin() + fieldValues, 0);
+        int distinct = 0;
+        int transitions = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (valueTotals[raw[i]]++ == 0) distinct++;
+            if (i > 0 && raw[i] != raw[i - 1]) transitions++;
+        }
+        if (distinct != settings.numStates || transitions < settings.numStates - 1) continue;
+
+        DiscreteStateCandidate candidate = makeCandidate(matrix, field, static_cast<double>(settings.numStates - 1) / transitions);
+        for (int v = 0; v < fieldValues; v++)
+        {
+            if (valueTotals[v] > 0) candidate.stateValues.append(v);
+        }
+        out.append(candidate);
+    }
+
+    sortCandidates(out);
+    return out;
+}
@@ -0,0 +1,87 @@
+#ifndef DISCRETESTATECORRELATOR_H
+#define DISCRETESTATECORRELATOR_H
+
+#include <QString>
+#include <QVector>
+#include "rangesignalmatrix.h"
+
+//biggest field looked at. State signals are small and this keeps the value histograms tiny
+#define DISCRETE_STATE_MAX_BITS     8
+//anything that scores lower than this isn't worth showing
+#define DISCRETE_STATE_MIN_SCORE    0.5
+
+//one stretch of time the user was holding one state. Times are frame timestamps in microseconds, end not included
+class DiscreteStatePeriod
+{
+public:
+    DiscreteStatePeriod() : startTime(0), endTime(0), state(0) {}
+    DiscreteStatePeriod(int64_t start, int64_t end, int st) : startTime(start), endTime(end), state(st) {}
+
+    int64_t startTime;
+    int64_t endTime;
+    int state;
+};
+
+//a field that looks like it tracks the states
+class DiscreteStateCandidate
+{
+public:
+    DiscreteStateCandidate() : id(0), startBit(0), bitLength(0), bigEndian(false), score(0.0) {}
+    QString describe() const;
+    bool ranksAbove(const DiscreteStateCandidate &other) const;
+
+    uint32_t id;
+    int startBit;
+    int bitLength;
+    bool bigEndian;
+    double score;               //0 to 1, bigger is better
+    QVector<int> stateValues;   //most common value of the field in each state, -1 if that state was never seen
+};
+
+class DiscreteStateSettings
+{
+public:
+    DiscreteStateSettings() : minBits(1), maxBits(8), numStates(2), guardTime(0) {}
+
+    int minBits;
+    int maxBits;
+    int numStates;      //only used on logged data where there's no recorded timeline to say how many there were
+    int64_t guardTime;  //frames this soon after a state change get left out, the user is still getting there
+};
+
+/*
+ * Finds the fields in one ID's frames that line up with a set of states.
+ *
+ * With a recorded timeline (the realtime mode) every frame gets tagged with the period it fell in. Each field is then
+ * scored by how much knowing its value says about which state the user was in (symmetric uncertainty, the mutual
+ * information over the average of the two entropies) times how often each separate time through a state came out
+ * with that state's usual value. A field that follows the states exactly scores 1, one that has nothing to do with
+ * them (or is a counter that has a different value in every frame) ends up close to 0.
+ *
+ * Logged data has no timeline so there all that can be done is look for fields that take exactly numStates values
+ * and change as seldom as possible while doing it.
+ *
+ * Fields that have a bit at either end that never moves are skipped, the field one bit narrower says the same thing.
+*/
+class DiscreteStateCorrelator
+{
+public:
+    static QVector<int> labelFrames(const QVector<int64_t> &times, const QVector<DiscreteStatePeriod> &periods, int64_t guardTime);
+    static QVector<DiscreteStateCandidate> correlate(const RangeSignalMatrix &matrix, const QVector<int> &framePeriods,
+                                                     const QVector<DiscreteStatePeriod> &periods, const DiscreteStateSettings &settings);
+    static QVector<DiscreteStateCandidate> findStateFields(const RangeSignalMatrix &matrix, const DiscreteStateSettings &settings);
+    static void sortCandidates(QVector<DiscreteStateCandidate> &candidates);
+
+private:
+    class Field
+    {
+    public:
+        int startBit;
+        int bitLength;
+        bool bigEndian;
+    };
+    static QVector<Field> fieldsToTry(const RangeSignalMatrix &matrix, const DiscreteStateSettings &settings);
+    static DiscreteStateCandidate makeCandidate(const RangeSignalMatrix &matrix, const Field &field, double score);
+};
+
+#endif // DISCRETESTATECORRELATOR_H
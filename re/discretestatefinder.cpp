@@ -0,0 +1,122 @@
+#include "discretestatefinder.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+
+//one ID's share of the search
+struct DiscreteStateTask
+{
+    uint32_t id;
+    bool failed;
+    QVector<DiscreteStateCandidate> found;
+};
+
+DiscreteStateFinder::DiscreteStateFinder(CANFrameModel *model, QObject *parent) : QObject(parent)
+{
+    this->model = model;
+    serial = 0;
+    running = false;
+
+    qRegisterMetaType<QVector<DiscreteStateCandidate>>("QVector<DiscreteStateCandidate>");
+    connect(this, &DiscreteStateFinder::searchDone, this, &DiscreteStateFinder::gotSearchDone, Qt::QueuedConnection);
+}
+
+DiscreteStateFinder::~DiscreteStateFinder()
+{
+    cancel();
+}
+
+//an empty list of periods means there's no timeline and it's a search of logged data
+void DiscreteStateFinder::start(const QVector<uint32_t> &newIDs, const QVector<DiscreteStatePeriod> &newPeriods, const DiscreteStateSettings &newSettings)
+{
+    cancel();
+
+    ids = newIDs;
+    periods = newPeriods;
+    settings = newSettings;
+    snapshot = model->snapshotFrameIndex(index);
+
+    serial++;
+    running = true;
+    cancelFlag.storeRelease(0);
+    int searchSerial = serial;
+    future = QtConcurrent::run([this, searchSerial]() { runSearch(searchSerial); });
+}
+
+void DiscreteStateFinder::cancel()
+{
+    cancelFlag.storeRelease(1);
+    future.waitForFinished();
+    running = false;
+}
+
+bool DiscreteStateFinder::isRunning() const
+{
+    return running;
+}
+
+//runs on a worker thread
+void DiscreteStateFinder::runSearch(int searchSerial)
+{
+    QVector<DiscreteStateTask> tasks(ids.count());
+    for (int i = 0; i < ids.count(); i++)
+    {
+        tasks[i].id = ids[i];
+        tasks[i].failed = false;
+    }
+
+    QtConcurrent::blockingMap(tasks, [this](DiscreteStateTask &task)
+    {
+        if (cancelFlag.loadAcquire()) return;
+
+        QVector<int> rows = index.rowsMatching(task.id, task.id, -1);
+        if (rows.isEmpty()) return;
+
+        QVector<CANFrame> frames;
+        if (!model->copyFrames(snapshot, rows, frames))
+        {
+            //frames got cleared or rewritten out from under the search
+            task.failed = true;
+            return;
+        }
+
+        RangeSignalMatrix matrix;
+        QVector<int> framePeriods;
+        if (periods.isEmpty()) matrix.build(task.id, frames);
+        else
+        {
+            //only the frames that fell inside the timeline are any use
+            QVector<int64_t> times(frames.count());
+            for (int i = 0; i < frames.count(); i++) times[i] = frames[i].timeStamp().microSeconds();
+            QVector<int> labels = DiscreteStateCorrelator::labelFrames(times, periods, settings.guardTime);
+            QVector<int> keptRows;
+            for (int i = 0; i < frames.count(); i++)
+            {
+                if (labels[i] < 0) continue;
+                keptRows.append(i);
+                framePeriods.append(labels[i]);
+            }
+            matrix.build(task.id, frames.constData(), keptRows);
+        }
+
+        if (periods.isEmpty()) task.found = DiscreteStateCorrelator::findStateFields(matrix, settings);
+        else task.found = DiscreteStateCorrelator::correlate(matrix, framePeriods, periods, settings);
+    });
+
+    QVector<DiscreteStateCandidate> found;
+    bool completed = !cancelFlag.loadAcquire();
+    for (int i = 0; i < tasks.count(); i++)
+    {
+        if (tasks[i].failed) completed = false;
+        found.append(tasks[i].found);
+    }
+    DiscreteStateCorrelator::sortCandidates(found);
+    emit searchDone(searchSerial, found, completed);
+}
+
+void DiscreteStateFinder::gotSearchDone(int searchSerial, QVector<DiscreteStateCandidate> candidates, bool completed)
+{
+    if (searchSerial != serial) return; //left over from a search that's been replaced
+    running = false;
+    emit searchFinished(candidates, completed);
+}
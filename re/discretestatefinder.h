@@ -0,0 +1,51 @@
+#ifndef DISCRETESTATEFINDER_H
+#define DISCRETESTATEFINDER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QAtomicInt>
+#include <QVector>
+#include "canframeindex.h"
+#include "canframemodel.h"
+#include "discretestatecorrelator.h"
+
+/*
+ * Runs the discrete state search in the background over the model's full frame list. Every ID gets done on its own
+ * across the thread pool. With a timeline only the frames that fall inside it get looked at. All of the results
+ * come back at once, ranked, when every ID is done.
+*/
+class DiscreteStateFinder : public QObject
+{
+    Q_OBJECT
+
+public:
+    DiscreteStateFinder(CANFrameModel *model, QObject *parent = nullptr);
+    ~DiscreteStateFinder();
+    void start(const QVector<uint32_t> &ids, const QVector<DiscreteStatePeriod> &periods, const DiscreteStateSettings &settings);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void searchFinished(QVector<DiscreteStateCandidate> candidates, bool completed);
+    //used internally to get results from the search thread back to the GUI thread
+    void searchDone(int serial, QVector<DiscreteStateCandidate> candidates, bool completed);
+
+private slots:
+    void gotSearchDone(int serial, QVector<DiscreteStateCandidate> candidates, bool completed);
+
+private:
+    CANFrameModel *model;
+    CANFrameIndex index;
+    CANFrameSnapshot snapshot;
+    QVector<uint32_t> ids;
+    QVector<DiscreteStatePeriod> periods;
+    DiscreteStateSettings settings;
+    QFuture<void> future;
+    QAtomicInt cancelFlag;
+    int serial;
+    bool running;
+
+    void runSearch(int searchSerial);
+};
+
+#endif // DISCRETESTATEFINDER_H
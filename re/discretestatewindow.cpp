@@ -1,6 +1,7 @@
 #include "discretestatewindow.h"
 #include "ui_discretestatewindow.h"
 #include "mainwindow.h"
+#include "guirefreshscheduler.h"
 #include "helpwindow.h"
 
 DiscreteStateWindow::DiscreteStateWindow(const QVector<CANFrame> *frames, QWidget *parent) :
@@ -19,9 +20,13 @@ DiscreteStateWindow::DiscreteStateWindow(const QVector<CANFrame> *frames, QWidge
     isRealtime = ui->rbRealtime->isChecked();
     typeChanged();
 
+    ui->treeMatches->setHeaderLabel("Candidate");
+    finder = new DiscreteStateFinder(MainWindow::getReference()->getCANFrameModel(), this);
+    connect(finder, &DiscreteStateFinder::searchFinished, this, &DiscreteStateWindow::searchFinished);
+
     connect(ui->btnStart, SIGNAL(clicked(bool)), this, SLOT(handleStartButton()));
     connect(timer, SIGNAL(timeout()), this, SLOT(handleTick()));
-    connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    GUIRefreshScheduler::getReference()->addWindow(this, &DiscreteStateWindow::updatedFrames, REFRESH_LOW, 1000);
     connect(ui->rbLogged, SIGNAL(clicked(bool)), this, SLOT(typeChanged()));
     connect(ui->rbRealtime, SIGNAL(clicked(bool)), this, SLOT(typeChanged()));
 
@@ -64,12 +69,7 @@ DiscreteStateWindow::~DiscreteStateWindow()
 {
     removeEventFilter(this);
     timer->stop();
-
-    for (int i = 0; i < stateFrames.count(); i++)
-    {
-        stateFrames[i]->clear();
-        delete(stateFrames[i]);
-    }
+    finder->cancel();
 
     delete timer;
     delete ui;
@@ -100,11 +100,6 @@ void DiscreteStateWindow::typeChanged()
         ui->spinFreq->setEnabled(false);
         ui->spinIterations->setEnabled(false);
         ui->lblStatus->setEnabled(false);
-        ui->spinMaxBits->setEnabled(true);
-        ui->spinMinBits->setEnabled(true);
-        ui->listID->setEnabled(true);
-        ui->btnAll->setEnabled(true);
-        ui->btnNone->setEnabled(true);
         isRealtime = false;
     }
     else
@@ -112,11 +107,6 @@ void DiscreteStateWindow::typeChanged()
         ui->spinFreq->setEnabled(true);
         ui->spinIterations->setEnabled(true);
         ui->lblStatus->setEnabled(true);
-        ui->spinMaxBits->setEnabled(false);
-        ui->spinMinBits->setEnabled(false);
-        ui->listID->setEnabled(false);
-        ui->btnAll->setEnabled(false);
-        ui->btnNone->setEnabled(false);
         isRealtime = true;
     }
 }
@@ -126,11 +116,13 @@ void DiscreteStateWindow::updatedFrames(int numFrames)
     CANFrame thisFrame;
     if (numFrames == -1) //all frames deleted. Kill the display
     {
+        finder->cancel(); //whatever it was looking at is gone
         ui->listID->clear();
         idFilters.clear();
     }
     else if (numFrames == -2) //all new set of frames. Reset
     {
+        finder->cancel();
         refreshFilterList();
     }
     else //just got some new frames. See if they are relevant.
@@ -147,31 +139,29 @@ void DiscreteStateWindow::updatedFrames(int numFrames)
                 listItem->setFlags(listItem->flags() | Qt::ItemIsUserCheckable); // set checkable flag
                 listItem->setCheckState(Qt::Checked); //default all filters to be set active
             }
-
-            //if (operatingState == DWStates::IDLE) stateFrames[0]->append(thisFrame);
-            //else stateFrames[currToggleState + 1]->append(thisFrame);
         }
     }
 }
 
 void DiscreteStateWindow::refreshFilterList()
 {
-    int id;
-
     idFilters.clear();
     ui->listID->clear();
 
-    for (int i = 0; i < modelFrames->length(); i++)
+    //one frame per ID and bus out of the model's index is enough to know whether the ID is extended
+    const CANFrameIndex *index = MainWindow::getReference()->getCANFrameModel()->getFrameIndex(modelFrames);
+    if (!index) return;
+    QList<uint64_t> keys = index->keys();
+    for (int i = 0; i < keys.count(); i++)
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        id = thisFrame.frameId();
-        if (!idFilters.contains(id))
-        {
-            idFilters.insert(id, true);
-            QListWidgetItem* listItem = new QListWidgetItem(Utility::formatCANID(id, thisFrame.hasExtendedFrameFormat()), ui->listID);
-            listItem->setFlags(listItem->flags() | Qt::ItemIsUserCheckable); // set checkable flag
-            listItem->setCheckState(Qt::Checked); //default all filters to be set active
-        }
+        int id = static_cast<int>(keys[i] & 0xFFFFFFFFull);
+        if (idFilters.contains(id)) continue;
+        QVector<int> rows = index->rowsFor(static_cast<uint32_t>(id), static_cast<int>(keys[i] >> 32));
+        if (rows.isEmpty()) continue;
+        idFilters.insert(id, true);
+        QListWidgetItem* listItem = new QListWidgetItem(Utility::formatCANID(id, modelFrames->at(rows.first()).hasExtendedFrameFormat()), ui->listID);
+        listItem->setFlags(listItem->flags() | Qt::ItemIsUserCheckable); // set checkable flag
+        listItem->setCheckState(Qt::Checked); //default all filters to be set active
     }
 
     ui->listID->sortItems();
@@ -189,6 +179,10 @@ void DiscreteStateWindow::showEvent(QShowEvent* event)
 void DiscreteStateWindow::closeEvent(QCloseEvent *event)
 {
     Q_UNUSED(event);
+    timer->stop();
+    finder->cancel();
+    operatingState = DWStates::IDLE;
+    ui->btnStart->setEnabled(true);
     writeSettings();
 }
 
@@ -264,17 +258,9 @@ void DiscreteStateWindow::handleStartButton()
 
         currToggleState = 0;
         currIteration = 0;
-
-        for (int i = stateFrames.count() - 1; i > 0; i--)
-        {
-            stateFrames[i]->clear();
-            stateFrames.removeAt(i);
-        }
-
-        for (int j = 0; j <= numToggleStates; j++)
-        {
-            stateFrames.append(new QVector<CANFrame>());
-        }
+        finder->cancel();
+        statePeriods.clear();
+        ui->treeMatches->clear();
 
         timer->start();
     }
@@ -298,6 +284,7 @@ void DiscreteStateWindow::handleTick()
         {
             ticksUntilStateChange = ticksPerStateChange;
             operatingState = DWStates::GETTING_SIGNAL;
+            markState(currToggleState);
         }
         break;
     case DWStates::COUNTDOWN_WAITING:
@@ -308,8 +295,9 @@ void DiscreteStateWindow::handleTick()
             currIteration++;
             if (currIteration > numIterations)
             {
-                operatingState = DWStates::IDLE;
+                operatingState = DWStates::DONE;
                 timer->stop();
+                if (!statePeriods.isEmpty()) statePeriods.last().endTime = latestFrameTime() + 1;
                 calculateResults();
             }
             else operatingState = DWStates::COUNTDOWN_SIGNAL;
@@ -322,50 +310,75 @@ void DiscreteStateWindow::handleTick()
             ticksUntilStateChange = ticksPerStateChange;
             operatingState = DWStates::COUNTDOWN_WAITING;
             currToggleState++;
-            if (currToggleState > numToggleStates) currToggleState = 0;
+            if (currToggleState >= numToggleStates) currToggleState = 0;
         }
         break;
     }
     updateStateLabel();
 }
 
+//newest frame time there is. Frames come in continuously on a live bus so this is as close to "now" in frame time as it gets
+int64_t DiscreteStateWindow::latestFrameTime()
+{
+    if (modelFrames->isEmpty()) return 0;
+    return modelFrames->last().timeStamp().microSeconds();
+}
+
+//the user was just told to go to this state. It lasts until they're told to go to the next one
+void DiscreteStateWindow::markState(int state)
+{
+    int64_t now = latestFrameTime();
+    if (!statePeriods.isEmpty()) statePeriods.last().endTime = now;
+    statePeriods.append(DiscreteStatePeriod(now, now, state));
+}
+
+/*
+ * Realtime runs line the fields of every frame up against the timeline recorded while the user went through the
+ * states. Logged data has no timeline so that looks for fields that take on exactly as many values as there are
+ * states. Either way it runs in the background and the matches show up in the tree, best first, when it's done.
+*/
 void DiscreteStateWindow::calculateResults()
 {
-    int minBits, maxBits;
+    DiscreteStateSettings settings;
+    settings.minBits = ui->spinMinBits->value();
+    settings.maxBits = ui->spinMaxBits->value();
+    settings.numStates = ui->spinStates->value();
+
+    QVector<DiscreteStatePeriod> periods;
     if (isRealtime)
     {
+        periods = statePeriods;
+        //give the user some time to actually get to the new state. Half the toggle time but no more than a second
+        settings.guardTime = qMin(static_cast<int64_t>(1000000), static_cast<int64_t>(ticksPerStateChange) * 50000);
+    }
 
+    QVector<uint32_t> ids;
+    QHash<int, bool>::const_iterator it;
+    for (it = idFilters.constBegin(); it != idFilters.constEnd(); ++it)
+    {
+        if (it.value()) ids.append(static_cast<uint32_t>(it.key()));
     }
-    else //use already loaded frames from main cache
+
+    ui->treeMatches->clear();
+    ui->btnStart->setEnabled(false);
+    finder->start(ids, periods, settings);
+}
+
+void DiscreteStateWindow::searchFinished(QVector<DiscreteStateCandidate> candidates, bool completed)
+{
+    ui->btnStart->setEnabled(true);
+    if (!completed) return;
+
+    for (int i = 0; i < candidates.count(); i++)
     {
-        //basic overview: run through all ID filters and see if it is enabled.
-        //If so add it to a giant list of messages by ID where each ID has its own
-        //list of messages
-        //Then, for each ID start a loop that runs from largest bits to smallest bits for scan
-        //For each value run through the algorithm for all messages. At the end list any matches
-        //the simplest approach seems to be to grab that number of bits and then record every
-        //unique value. IF the # of unique values is the same as the number of states then
-        //we've got a match.It should be noted that the # of states must be at least 2 - the idle
-        //state is 1 and then a second state at the minimum. Turn signals might be 3 states then
-
-        minBits = ui->spinMinBits->value();
-        maxBits = ui->spinMaxBits->value();
-        QHash<int, bool>::const_iterator it;
-        QList<CANFrame> frameCache;
-        for (it = idFilters.begin(); it != idFilters.end(); ++it)
+        const DiscreteStateCandidate &candidate = candidates[i];
+        QTreeWidgetItem *item = new QTreeWidgetItem(ui->treeMatches);
+        item->setText(0, candidate.describe());
+        for (int s = 0; s < candidate.stateValues.count(); s++)
         {
-            if (it.value())
-            {
-                frameCache.clear();
-                for (int i = 0; i < modelFrames->count(); i++)
-                {
-                    if (modelFrames->at(i).frameId() == (unsigned int)it.key()) frameCache.append(modelFrames->at(i));
-                }
-                for (int bits = maxBits; bits >= minBits; bits--)
-                {
-                    QList<int> values;
-                }
-            }
+            QTreeWidgetItem *stateItem = new QTreeWidgetItem(item);
+            QString value = (candidate.stateValues[s] < 0) ? "never seen" : Utility::formatNumber(static_cast<uint64_t>(candidate.stateValues[s]));
+            stateItem->setText(0, "State " + QString::number(s + 1) + ": " + value);
         }
     }
 }
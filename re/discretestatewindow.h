@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QTimer>
 #include "can_structs.h"
+#include "discretestatefinder.h"
 
 namespace Ui {
 class DiscreteStateWindow;
@@ -35,11 +36,13 @@ private slots:
     void handleStartButton();
     void handleTick();
     void typeChanged();
+    void searchFinished(QVector<DiscreteStateCandidate> candidates, bool completed);
 
 private:
     Ui::DiscreteStateWindow *ui;
     const QVector<CANFrame> *modelFrames;
-    QList< QVector<CANFrame> *> stateFrames;
+    QVector<DiscreteStatePeriod> statePeriods; //what the user was told to do and when, in frame time
+    DiscreteStateFinder *finder;
     QTimer *timer;
     DiscreteWindowState operatingState;
     int ticksUntilStateChange;
@@ -58,6 +61,8 @@ private:
     void writeSettings();
     void updateStateLabel();
     void calculateResults();
+    void markState(int state);
+    int64_t latestFrameTime();
 };
 
 #endif // DISCRETESTATEWINDOW_H
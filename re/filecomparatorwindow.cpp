@@ -1,7 +1,10 @@
 #include "filecomparatorwindow.h"
 #include "ui_filecomparatorwindow.h"
 #include "helpwindow.h"
-#include <QProgressDialog>
+#include <QMessageBox>
+#include <QTimer>
+#include <QtMath>
+#include <algorithm>
 #include <QSettings>
 #include <qevent.h>
 
@@ -22,12 +25,26 @@ FileComparatorWindow::FileComparatorWindow(QWidget *parent) :
 
     dbcHandler = DBCHandler::getReference();
 
+    interestedLoader = new FileCompareLoader(dbcHandler, this);
+    referenceLoader = new FileCompareLoader(dbcHandler, this);
+    connect(interestedLoader, &FileCompareLoader::progress, this, &FileComparatorWindow::interestedProgress);
+    connect(interestedLoader, &FileCompareLoader::loadFinished, this, &FileComparatorWindow::interestedLoaded);
+    connect(referenceLoader, &FileCompareLoader::progress, this, &FileComparatorWindow::referenceProgress);
+    connect(referenceLoader, &FileCompareLoader::loadFinished, this, &FileComparatorWindow::referenceLoaded);
+
+    reportPos = 0;
+    reportSerial = 0;
+    reportUniqueInterested = false;
+    interestedOnlyBase = referenceOnlyBase = sharedBase = nullptr;
+
     installEventFilter(this);
 }
 
 FileComparatorWindow::~FileComparatorWindow()
 {
     removeEventFilter(this);
+    interestedLoader->cancel();
+    referenceLoader->cancel();
     delete ui;
 }
 
@@ -83,68 +100,122 @@ void FileComparatorWindow::writeSettings()
 
 void FileComparatorWindow::loadInterestedFile()
 {
-    interestedFrames.clear();
-    QString resultingFileName;
+    QString filename;
+    int fileType;
 
-    qApp->processEvents();
+    if (!FrameFileIO::pickLoadFile(filename, fileType)) return;
 
-    if (FrameFileIO::loadFrameFile(resultingFileName, &interestedFrames))
-    {
-        ui->lblFirstFile->setText(resultingFileName);
-        interestedFilename = resultingFileName;
-        if (interestedFrames.count() > 0 && referenceFrames.count() > 0) calculateDetails();
-    }
+    QStringList fileList = filename.split('/');
+    interestedFilename = fileList[fileList.length() - 1];
+    ui->lblFirstFile->setText("Reading " + interestedFilename + "...");
+    ui->btnInterestedFile->setEnabled(false);
+    reportSerial++; //whatever report was there is out of date now
+    ui->treeDetails->clear();
 
+    interestedLoader->clear();
+    interestedLoader->start(filename, fileType);
 }
 
+//reference files add on to what's already been loaded until the clear button gets hit
 void FileComparatorWindow::loadReferenceFile()
 {
-    //secondFileFrames.clear();
-    QString resultingFileName;
+    QString filename;
+    int fileType;
 
-    qApp->processEvents();
+    if (!FrameFileIO::pickLoadFile(filename, fileType)) return;
 
-    if (FrameFileIO::loadFrameFile(resultingFileName, &referenceFrames))
-    {
-        ui->lblRefFrames->setText("Loaded frames: " + QString::number(referenceFrames.length()));
-        if (interestedFrames.count() > 0 && referenceFrames.count() > 0) calculateDetails();
-    }
+    ui->btnLoadRefFile->setEnabled(false);
+    ui->btnClear->setEnabled(false);
+    reportSerial++;
+    ui->treeDetails->clear();
+
+    referenceLoader->start(filename, fileType);
 }
 
 void FileComparatorWindow::clearReference()
 {
-    referenceFrames.clear();
+    referenceLoader->clear();
+    reportSerial++;
     ui->treeDetails->clear();
-    ui->lblRefFrames->setText("Loaded frames: " + QString::number(referenceFrames.length()));
+    ui->lblRefFrames->setText("Loaded frames: 0");
 }
 
-void FileComparatorWindow::calculateDetails()
+void FileComparatorWindow::interestedProgress(quint64 framesRead)
 {
-    QMap<uint32_t, FrameData> interestedIDs;
-    QMap<uint32_t, FrameData> referenceIDs;
-    QTreeWidgetItem *interestedOnlyBase, *referenceOnlyBase = nullptr, *sharedBase, *bitmapBaseInterested, *bitmapBaseReference = nullptr;
-    QTreeWidgetItem *valuesBase, *detail, *sharedItem, *valuesInterested, *valuesReference = nullptr;
-    uint64_t tmp;
-    const unsigned char *data;
-    int dataLen;
+    ui->lblFirstFile->setText("Reading " + interestedFilename + "... " + QString::number(framesRead) + " frames");
+}
 
-    bool uniqueInterested = ui->ckUniqueToInterested->isChecked();
+void FileComparatorWindow::interestedLoaded(bool ok)
+{
+    ui->btnInterestedFile->setEnabled(true);
+    if (!ok)
+    {
+        ui->lblFirstFile->setText("Could not load " + interestedFilename);
+        interestedLoader->clear();
+        return;
+    }
+    ui->lblFirstFile->setText(interestedFilename);
+    if (bothLoaded()) calculateDetails();
+}
+
+void FileComparatorWindow::referenceProgress(quint64 framesRead)
+{
+    ui->lblRefFrames->setText("Loading frames: " + QString::number(framesRead));
+}
+
+void FileComparatorWindow::referenceLoaded(bool ok)
+{
+    ui->btnLoadRefFile->setEnabled(true);
+    ui->btnClear->setEnabled(true);
+    if (!ok)
+    {
+        QMessageBox msgBox;
+        msgBox.setText("File load completed with errors.\r\nPerhaps you selected the wrong file type?");
+        msgBox.exec();
+    }
+    ui->lblRefFrames->setText("Loaded frames: " + QString::number(referenceLoader->getSide().getFrameCount()));
+    if (bothLoaded()) calculateDetails();
+}
+
+bool FileComparatorWindow::bothLoaded()
+{
+    if (interestedLoader->isRunning() || referenceLoader->isRunning()) return false;
+    return interestedLoader->getSide().getFrameCount() > 0 && referenceLoader->getSide().getFrameCount() > 0;
+}
+
+QString FileComparatorWindow::describeID(uint32_t id)
+{
+    DBC_MESSAGE *msg = dbcHandler->findMessage(id);
+    if (msg) return Utility::formatHexNum(id) + " (" + msg->name + ")";
+    return Utility::formatHexNum(id);
+}
 
-    QProgressDialog progress(this);
-    progress.setWindowModality(Qt::WindowModal);
-    progress.setLabelText("Calculating differences");
-    progress.setCancelButton(nullptr);
-    progress.setRange(0,0);
-    progress.setMinimumDuration(0);
-    progress.show();
+//signals were collected as plain numbers off the GUI thread. This turns them into the same text processAsText gives
+QString FileComparatorWindow::formatSignalValue(uint32_t id, const QString &sigName, double value)
+{
+    DBC_MESSAGE *msg = dbcHandler->findMessage(id);
+    DBC_SIGNAL *sig = msg ? msg->sigHandler->findSignalByName(sigName) : nullptr;
+    if (!sig) return QString::number(value);
+    bool isInteger = false;
+    if (sig->valType == SIGNED_INT || sig->valType == UNSIGNED_INT) isInteger = (sig->factor == qFloor(sig->factor));
+    return sig->makePrettyOutput(value, static_cast<int64_t>(value), false, isInteger);
+}
 
-    qApp->processEvents();
+/*
+ * Both sides have already been boiled down to what each ID did so this is just the report. It gets built a few IDs
+ * at a time off the event loop and fills in while you watch instead of the window locking up until it's all done.
+*/
+void FileComparatorWindow::calculateDetails()
+{
+    reportUniqueInterested = ui->ckUniqueToInterested->isChecked();
+    reportSerial++;
 
     ui->treeDetails->clear();
 
     interestedOnlyBase = new QTreeWidgetItem();
     interestedOnlyBase->setText(0,"IDs found only in " + interestedFilename);
-    if (!uniqueInterested)
+    referenceOnlyBase = nullptr;
+    if (!reportUniqueInterested)
     {
         referenceOnlyBase = new QTreeWidgetItem();
         referenceOnlyBase->setText(0, "IDs found only in Side 2 - Reference frames");
@@ -152,377 +223,198 @@ void FileComparatorWindow::calculateDetails()
     sharedBase = new QTreeWidgetItem();
     sharedBase->setText(0,"IDs found on both sides");
 
-    //first we have to fill out the data structures to get ready to do the report
-    for (int x = 0; x < interestedFrames.count(); x++)
-    {
-        CANFrame frame = interestedFrames.at(x);
-        DBC_MESSAGE *msg = dbcHandler->findMessage(frame.frameId());
-        data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
-        dataLen = frame.payload().count();
+    ui->treeDetails->addTopLevelItem(interestedOnlyBase);
+    if (!reportUniqueInterested) ui->treeDetails->addTopLevelItem(referenceOnlyBase);
+    ui->treeDetails->addTopLevelItem(sharedBase);
 
-        if (interestedIDs.contains(frame.frameId())) //if we saw this ID before then add to the QList in there
-        {
-            for (int y = 0; y < dataLen; y++)
-            {
-                interestedIDs[frame.frameId()].values[y][data[y]]++;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                interestedIDs[frame.frameId()].bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(interestedIDs[frame.frameId()].bitmap, 16);
-            }            
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList = interestedIDs[frame.frameId()].signalInstances[sig->name];
-                                if (!tempList.contains(sigVal)) tempList.append(sigVal);
-                                interestedIDs[frame.frameId()].signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
-                }
-                qApp->processEvents();
-            }
-        }
-        else //never seen this ID before so add one
-        {
-            FrameData *newData = new FrameData();
-            newData->ID = frame.frameId();
-            newData->dataLen = dataLen;
-            //it would be possible to implement a constructor for FrameData
-            //that sets the bitmap and values to zero. That would be cleaner and better.
-            newData->bitmap = 0;
-            for (int x = 0; x < 8; x++)
-            {
-                for (int y = 0; y < 256; y++)
-                {
-                    newData->values[x][y] = 0;
-                }
-            }
-            //memset(newData->values, 0, 256 * 8);
-            for (int y = 0; y < dataLen; y++)
-            {
-                newData->values[y][data[y]] = 1;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                newData->bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(newData->bitmap, 16);
-            }
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList;
-                                tempList.append(sigVal);
-                                newData->signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
-                }
-            }
+    //all IDs from both sides in order. Each one is only in one list or in both
+    QMap<uint32_t, bool> allIDs;
+    for (uint32_t id : interestedLoader->getSide().getIDs().keys()) allIDs.insert(id, true);
+    for (uint32_t id : referenceLoader->getSide().getIDs().keys()) allIDs.insert(id, true);
+    reportIDs = allIDs.keys();
+    reportPos = 0;
 
-            interestedIDs.insert(frame.frameId(), *newData);
-        }
-    }
+    reportNextIDs(reportSerial);
+}
+
+void FileComparatorWindow::reportNextIDs(int serial)
+{
+    if (serial != reportSerial) return; //a newer report started since this one was queued up
 
-    qApp->processEvents();
+    const QMap<uint32_t, FrameCompareID> &interestedIDs = interestedLoader->getSide().getIDs();
+    const QMap<uint32_t, FrameCompareID> &referenceIDs = referenceLoader->getSide().getIDs();
 
-    for (int x = 0; x < referenceFrames.count(); x++)
+    int stop = qMin(reportPos + 50, reportIDs.count());
+    for (; reportPos < stop; reportPos++)
     {
-        CANFrame frame = referenceFrames.at(x);
-        DBC_MESSAGE *msg = dbcHandler->findMessage(frame.frameId());
-        data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
-        dataLen = frame.payload().count();
+        uint32_t id = reportIDs[reportPos];
+        QMap<uint32_t, FrameCompareID>::const_iterator interested = interestedIDs.constFind(id);
+        QMap<uint32_t, FrameCompareID>::const_iterator reference = referenceIDs.constFind(id);
 
-        if (referenceIDs.contains(frame.frameId())) //if we saw this ID before then add to the QList in there
+        if (interested != interestedIDs.constEnd() && reference != referenceIDs.constEnd())
         {
-            for (int y = 0; y < dataLen; y++)
-            {
-                referenceIDs[frame.frameId()].values[y][data[y]]++;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                referenceIDs[frame.frameId()].bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(referenceIDs[frame.frameId()].bitmap, 16);
-            }
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList = referenceIDs[frame.frameId()].signalInstances[sig->name];
-                                if (!tempList.contains(sigVal)) tempList.append(sigVal);
-                                referenceIDs[frame.frameId()].signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
-                }
-            }
+            reportSharedID(interested.value(), reference.value());
         }
-        else //never seen this ID before so add one
+        else if (interested != interestedIDs.constEnd())
         {
-            FrameData *newData = new FrameData();
-            newData->ID = frame.frameId();
-            newData->dataLen = dataLen;
-            newData->bitmap = 0;
-            for (int x = 0; x < 8; x++)
-            {
-                for (int y = 0; y < 256; y++)
-                {
-                    newData->values[x][y] = 0;
-                }
-            }
-            //memset(newData->values, 0, 256 * 8);
-            for (int y = 0; y < dataLen; y++)
-            {
-                newData->values[y][data[y]] = 1;
-                tmp = data[y];
-                tmp = tmp << (8 * y);
-                newData->bitmap |= tmp;
-                //qDebug() << "bitmap: " << QString::number(newData->bitmap, 16);
-            }
-            if (msg)
-            {
-                int numSignals = msg->sigHandler->getCount();
-                for (int i = 0; i < numSignals; i++)
-                {
-                    DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
-                    if (sig)
-                    {
-                        if (sig->isSignalInMessage(frame))
-                        {
-                            QString sigVal;
-                            if (sig->processAsText(frame, sigVal, false))
-                            {
-                                QList<QString> tempList;
-                                tempList.append(sigVal);
-                                newData->signalInstances[sig->name] = tempList;
-                            }
-                        }
-                    }
-                }
-            }
-            referenceIDs.insert(frame.frameId(), *newData);
+            QTreeWidgetItem *valuesBase = new QTreeWidgetItem();
+            valuesBase->setText(0, describeID(id));
+            interestedOnlyBase->addChild(valuesBase);
+        }
+        else if (!reportUniqueInterested)
+        {
+            QTreeWidgetItem *valuesBase = new QTreeWidgetItem();
+            valuesBase->setText(0, describeID(id));
+            referenceOnlyBase->addChild(valuesBase);
         }
     }
 
-    qApp->processEvents();
+    if (reportPos < reportIDs.count())
+    {
+        QTimer::singleShot(0, this, [this, serial]() { reportNextIDs(serial); });
+        return;
+    }
+
+    //ui->treeDetails->setSortingEnabled(true);
+    //ui->treeDetails->sortByColumn(0, Qt::AscendingOrder);
+
+    QSettings settings;
+    if (settings.value("InfoCompare/AutoExpand", false).toBool())
+    {
+        ui->treeDetails->expandAll();
+    }
+}
 
-    //now we iterate through the IDs within both files and see which are unique to one file and which
-    //are shared
+//if the ID was in both files then the bitmaps and value sets tell what has changed between the two files
+void FileComparatorWindow::reportSharedID(const FrameCompareID &interested, const FrameCompareID &reference)
+{
+    QTreeWidgetItem *bitmapBaseInterested, *bitmapBaseReference = nullptr;
+    QTreeWidgetItem *valuesBase, *detail, *sharedItem, *valuesInterested, *valuesReference = nullptr;
+    bool uniqueInterested = reportUniqueInterested;
     bool interestedHadUnique = false;
-    QMap<uint32_t, FrameData>::iterator i;
-    int framesCounter = 0;
-    for (i = interestedIDs.begin(); i != interestedIDs.end(); ++i)
+
+    sharedItem = new QTreeWidgetItem();
+    sharedItem->setText(0, describeID(interested.ID));
+
+    bitmapBaseInterested = new QTreeWidgetItem();
+    bitmapBaseInterested->setText(0, "Bits set only in " + interestedFilename);
+    if (!uniqueInterested)
+    {
+        bitmapBaseReference = new QTreeWidgetItem();
+        bitmapBaseReference->setText(0, "Bits set only in Side 2 - Reference frames");
+    }
+    sharedItem->addChild(bitmapBaseInterested);
+    if (!uniqueInterested) sharedItem->addChild(bitmapBaseReference);
+
+    //first up, which bits were set in one file but not the other
+    for (int b = 0; b < (8 * interested.dataLen); b++)
     {
-        framesCounter++;
-        if (framesCounter > 50)
+        bool interestedBit = interested.bitSet(b);
+        bool referenceBit = reference.bitSet(b);
+        if (interestedBit == referenceBit) continue;
+        if (referenceBit && uniqueInterested) continue;
+
+        detail = new QTreeWidgetItem();
+        detail->setText(0, QString::number(b) + " (" + QString::number(b / 8) + ":" + QString::number(b % 8) + ")");
+        if (interestedBit)
         {
-            framesCounter = 0;
-            qApp->processEvents();
+            bitmapBaseInterested->addChild(detail);
+            interestedHadUnique = true;
         }
+        else bitmapBaseReference->addChild(detail);
+    }
 
-        uint32_t keyone = i.key();
-        if (!referenceIDs.contains(keyone))
+    for (int i = 0; i < qMax(interested.maxLen, reference.maxLen); i++)
+    {
+        valuesBase = new QTreeWidgetItem();
+        valuesBase->setText(0, "Byte " + QString::number(i));
+        sharedItem->addChild(valuesBase);
+        valuesInterested = new QTreeWidgetItem();
+        valuesInterested->setText(0, "Values found only in " + interestedFilename);
+        if (!uniqueInterested)
         {
-            valuesBase = new QTreeWidgetItem();
-            DBC_MESSAGE *msg = dbcHandler->findMessage(keyone);
-            if (msg)
-            {
-                valuesBase->setText(0, Utility::formatHexNum(keyone) + " (" + msg->name + ")");
-            }
-            else valuesBase->setText(0, Utility::formatHexNum(keyone));
-            interestedOnlyBase->addChild(valuesBase);
+            valuesReference = new QTreeWidgetItem();
+            valuesReference->setText(0, "Values found only in Side 2 - Reference frames");
         }
-        else //ID was in both files
+        valuesBase->addChild(valuesInterested);
+        if (!uniqueInterested) valuesBase->addChild(valuesReference);
+        for (int j = 0; j < 256; j++)
         {
-            interestedHadUnique = false;
-            sharedItem = new QTreeWidgetItem();
-            DBC_MESSAGE *msg = dbcHandler->findMessage(keyone);
-            if (msg)
-            {
-                sharedItem->setText(0, Utility::formatHexNum(keyone) + " (" + msg->name + ")");
-            }
-            else sharedItem->setText(0, Utility::formatHexNum(keyone));
-            //if the ID was in both files then we can use the data accumulated above in bitmap
-            //and values to figure out what has changed between the two files
-
-            FrameData interested = interestedIDs[keyone];
-            FrameData reference = referenceIDs[keyone];
-
-            bitmapBaseInterested = new QTreeWidgetItem();
-            bitmapBaseInterested->setText(0, "Bits set only in " + interestedFilename);
-            if (!uniqueInterested)
-            {
-                bitmapBaseReference = new QTreeWidgetItem();
-                bitmapBaseReference->setText(0, "Bits set only in Side 2 - Reference frames");
-            }
-            sharedItem->addChild(bitmapBaseInterested);
-            if (!uniqueInterested) sharedItem->addChild(bitmapBaseReference);
-
-            uint64_t interestedBits = interested.bitmap;
-            uint64_t referenceBits = reference.bitmap;
-
-            //first up, which bits were set in one file but not the other
-            for (int b = 0; b < (8 * interested.dataLen); b++)
+            bool inInterested = interested.sawValue(i, j);
+            bool inReference = reference.sawValue(i, j);
+            if (inInterested && !inReference)
             {
                 detail = new QTreeWidgetItem();
-                detail->setText(0, QString::number(b) + " (" + QString::number(b / 8) + ":" + QString::number(b % 8) + ")");
-                if ( (interestedBits & 1) && !(referenceBits & 1) )
-                {
-                    bitmapBaseInterested->addChild(detail);
-                    interestedHadUnique = true;
-                }
-                else if ( !(interestedBits & 1) && (referenceBits & 1) )
-                {
-                    if (!uniqueInterested) bitmapBaseReference->addChild(detail);
-                }
-                //qDebug() << b << "  " << QString::number(interestedBits, 16) << "  " << QString::number(referenceBits, 16);
-                interestedBits = interestedBits >> 1;
-                referenceBits = referenceBits >> 1;
+                detail->setText(0, Utility::formatHexNum(static_cast<unsigned int>(j)));
+                valuesInterested->addChild(detail);
+                interestedHadUnique = true;
             }
-
-            for (int i = 0; i < qMax(interested.dataLen, reference.dataLen); i++)
+            if (inReference && !inInterested && !uniqueInterested)
             {
-                valuesBase = new QTreeWidgetItem();
-                valuesBase->setText(0, "Byte " + QString::number(i));
-                sharedItem->addChild(valuesBase);
-                valuesInterested = new QTreeWidgetItem();
-                valuesInterested->setText(0, "Values found only in " + interestedFilename);
-                if (!uniqueInterested)
-                {
-                    valuesReference = new QTreeWidgetItem();
-                    valuesReference->setText(0, "Values found only in Side 2 - Reference frames");
-                }
-                valuesBase->addChild(valuesInterested);
-                if (!uniqueInterested) valuesBase->addChild(valuesReference);
-                for (int j = 0; j < 256; j++)
-                {
-                    detail = new QTreeWidgetItem();
-                    detail->setText(0, Utility::formatHexNum(static_cast<unsigned int>(j)));
-                    if ((interested.values[i][j] > 0) && (reference.values[i][j] == 0) )
-                    {
-                        valuesInterested->addChild(detail);
-                        interestedHadUnique = true;
-                    }
-                    if ((reference.values[i][j] > 0) && (interested.values[i][j] == 0) )
-                    {
-                        if (!uniqueInterested) valuesReference->addChild(detail);
-                    }
-                }
+                detail = new QTreeWidgetItem();
+                detail->setText(0, Utility::formatHexNum(static_cast<unsigned int>(j)));
+                valuesReference->addChild(detail);
             }
+        }
+    }
 
-            //presumably both include the same signals so for this first attempt just
-            //take all signals from the reference and then find that same signal in
-            //the interested frames and then see what unique values there were in either one
+    //presumably both include the same signals so for this first attempt just
+    //take all signals from the reference and then find that same signal in
+    //the interested frames and then see what unique values there were in either one
+    QHash<QString, QSet<double>>::const_iterator it = reference.signalValues.constBegin();
+    while (it != reference.signalValues.constEnd())
+    {
+        valuesBase = new QTreeWidgetItem();
+        valuesBase->setText(0, "Signal " + it.key());
+        sharedItem->addChild(valuesBase);
 
-            QHash<QString, QList<QString>>::const_iterator it = reference.signalInstances.constBegin();
-            while (it != reference.signalInstances.constEnd())
-            {
-                valuesBase = new QTreeWidgetItem();
-                valuesBase->setText(0, "Signal " + it.key());
-                sharedItem->addChild(valuesBase);
-                valuesInterested = new QTreeWidgetItem();
-                valuesInterested->setText(0, "Values found only in " + interestedFilename);
-                if (!uniqueInterested)
-                {
-                    valuesReference = new QTreeWidgetItem();
-                    valuesReference->setText(0, "Values found only in Side 2 - Reference frames");
-                }
-                valuesBase->addChild(valuesInterested);
-                if (!uniqueInterested) valuesBase->addChild(valuesReference);
-
-                QList<QString> refVals = it.value();
-                QList<QString> interestedVals = interested.signalInstances[it.key()];
-                foreach (QString str, refVals)
-                {
-                    if (!interestedVals.contains(str))
-                    {
-                        qDebug() << "Interested frames didn't contain value: " << str << " in signal " << it.key();
-                        detail = new QTreeWidgetItem();
-                        detail->setText(0, str);
-                        valuesReference->addChild(detail);
-                    }
-                }
-                qApp->processEvents();
-                foreach (QString str, interestedVals)
-                {
-                    if (!refVals.contains(str))
-                    {
-                        qDebug() << "Reference frames didn't contain value: " << str << " in signal " << it.key();
-                        detail = new QTreeWidgetItem();
-                        detail->setText(0, str);
-                        valuesInterested->addChild(detail);
-                    }
-                }
-                ++it;
-            }
+        //one side or the other had too many different values to keep, there's no telling which are unique
+        if (reference.manySignalValues.contains(it.key()) || interested.manySignalValues.contains(it.key()))
+        {
+            detail = new QTreeWidgetItem();
+            detail->setText(0, "Too many different values to compare (more than " + QString::number(FRAME_COMPARE_SIGNAL_VALUES) + ")");
+            valuesBase->addChild(detail);
+            ++it;
+            continue;
+        }
 
-            if (interestedHadUnique || !uniqueInterested) sharedBase->addChild(sharedItem);
+        valuesInterested = new QTreeWidgetItem();
+        valuesInterested->setText(0, "Values found only in " + interestedFilename);
+        if (!uniqueInterested)
+        {
+            valuesReference = new QTreeWidgetItem();
+            valuesReference->setText(0, "Values found only in Side 2 - Reference frames");
         }
-    }
+        valuesBase->addChild(valuesInterested);
+        if (!uniqueInterested) valuesBase->addChild(valuesReference);
 
-    qApp->processEvents();
+        const QSet<double> &refVals = it.value();
+        const QSet<double> interestedVals = interested.signalValues.value(it.key());
+        QList<double> onlyReference = (refVals - interestedVals).values();
+        QList<double> onlyInterested = (interestedVals - refVals).values();
+        std::sort(onlyReference.begin(), onlyReference.end());
+        std::sort(onlyInterested.begin(), onlyInterested.end());
 
-    if (!uniqueInterested)
-    {
-        QMap<uint32_t, FrameData>::iterator itwo;
-        for (itwo = referenceIDs.begin(); itwo != referenceIDs.end(); ++itwo)
+        if (!uniqueInterested)
         {
-            unsigned int keytwo = itwo.key();
-            if (!interestedIDs.contains(keytwo))
+            for (double value : onlyReference)
             {
-                valuesBase = new QTreeWidgetItem();
-                DBC_MESSAGE *msg = dbcHandler->findMessage(keytwo);
-                if (msg)
-                {
-                    valuesBase->setText(0, Utility::formatHexNum(keytwo) + " (" + msg->name + ")" );
-                }
-                else valuesBase->setText(0, Utility::formatHexNum(keytwo));
-                referenceOnlyBase->addChild(valuesBase);
+                detail = new QTreeWidgetItem();
+                detail->setText(0, formatSignalValue(interested.ID, it.key(), value));
+                valuesReference->addChild(detail);
             }
         }
+        for (double value : onlyInterested)
+        {
+            detail = new QTreeWidgetItem();
+            detail->setText(0, formatSignalValue(interested.ID, it.key(), value));
+            valuesInterested->addChild(detail);
+        }
+        ++it;
     }
 
-    ui->treeDetails->addTopLevelItem(interestedOnlyBase);
-    if (!uniqueInterested) ui->treeDetails->addTopLevelItem(referenceOnlyBase);
-    ui->treeDetails->addTopLevelItem(sharedBase);
-
-    //ui->treeDetails->setSortingEnabled(true);
-    //ui->treeDetails->sortByColumn(0, Qt::AscendingOrder);
-
-    QSettings settings;
-    if (settings.value("InfoCompare/AutoExpand", false).toBool())
-    {
-        ui->treeDetails->expandAll();
-    }
-
-    progress.cancel();
+    if (interestedHadUnique || !uniqueInterested) sharedBase->addChild(sharedItem);
+    else delete sharedItem;
 }
 
 void FileComparatorWindow::saveDetails()
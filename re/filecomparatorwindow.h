@@ -8,20 +8,12 @@
 #include "can_structs.h"
 #include "utility.h"
 #include "dbc/dbchandler.h"
+#include "filecompareloader.h"
 
 namespace Ui {
 class FileComparatorWindow;
 }
 
-struct FrameData
-{
-    uint32_t ID;
-    int dataLen;
-    uint64_t bitmap;
-    int values[8][256]; //first index is the data byte, second is # of times we saw that value
-    QHash<QString, QList<QString>> signalInstances;
-};
-
 class FileComparatorWindow : public QDialog
 {
     Q_OBJECT
@@ -35,15 +27,33 @@ private slots:
     void loadReferenceFile();
     void clearReference();
     void saveDetails();
+    void interestedProgress(quint64 framesRead);
+    void interestedLoaded(bool ok);
+    void referenceProgress(quint64 framesRead);
+    void referenceLoaded(bool ok);
 
 private:
     Ui::FileComparatorWindow *ui;
-    QVector<CANFrame> interestedFrames;
-    QVector<CANFrame> referenceFrames;
+    FileCompareLoader *interestedLoader;
+    FileCompareLoader *referenceLoader;
     QString interestedFilename;
     DBCHandler *dbcHandler;
 
+    //the report gets built a few IDs at a time so the window stays usable while it fills in
+    QList<uint32_t> reportIDs;
+    int reportPos;
+    int reportSerial;
+    bool reportUniqueInterested;
+    QTreeWidgetItem *interestedOnlyBase;
+    QTreeWidgetItem *referenceOnlyBase;
+    QTreeWidgetItem *sharedBase;
+
     void calculateDetails();
+    void reportNextIDs(int serial);
+    void reportSharedID(const FrameCompareID &interested, const FrameCompareID &reference);
+    QString describeID(uint32_t id);
+    QString formatSignalValue(uint32_t id, const QString &sigName, double value);
+    bool bothLoaded();
     void showEvent(QShowEvent *);
     void closeEvent(QCloseEvent *event);
     bool eventFilter(QObject *obj, QEvent *event);
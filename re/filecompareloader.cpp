@@ -0,0 +1,133 @@
+#include "filecompareloader.h"
+#include "framefileio.h"
+#include "dbc/dbchandler.h"
+
+#include <QSet>
+#include <QtConcurrent/QtConcurrentRun>
+
+FileCompareLoader::FileCompareLoader(DBCHandler *dbc, QObject *parent) : QObject(parent)
+{
+    dbcHandler = dbc;
+    serial = 0;
+    running = false;
+    resolveDone = false;
+
+    qRegisterMetaType<QVector<uint32_t>>("QVector<uint32_t>");
+    connect(this, &FileCompareLoader::framesRead, this, &FileCompareLoader::gotFramesRead, Qt::QueuedConnection);
+    connect(this, &FileCompareLoader::loadDone, this, &FileCompareLoader::gotLoadDone, Qt::QueuedConnection);
+    connect(this, &FileCompareLoader::resolveRequest, this, &FileCompareLoader::gotResolveRequest, Qt::QueuedConnection);
+}
+
+FileCompareLoader::~FileCompareLoader()
+{
+    cancel();
+}
+
+void FileCompareLoader::start(const QString &filename, int fileType)
+{
+    cancel();
+
+    serial++;
+    running = true;
+    cancelFlag.storeRelease(0);
+    int loadSerial = serial;
+    future = QtConcurrent::run([this, loadSerial, filename, fileType]() { runLoad(loadSerial, filename, fileType); });
+}
+
+//the loaders check in after every chunk so this doesn't have to wait long
+void FileCompareLoader::cancel()
+{
+    cancelFlag.storeRelease(1);
+    future.waitForFinished();
+    running = false;
+}
+
+void FileCompareLoader::clear()
+{
+    cancel();
+    side.clear();
+}
+
+bool FileCompareLoader::isRunning() const
+{
+    return running;
+}
+
+const FrameCompareSide &FileCompareLoader::getSide() const
+{
+    return side;
+}
+
+//runs on a worker thread
+void FileCompareLoader::runLoad(int loadSerial, QString filename, int fileType)
+{
+    bool ok = FrameFileIO::streamFileOfType(filename, fileType, [&](QVector<CANFrame> &chunk)
+    {
+        if (cancelFlag.loadAcquire()) return false;
+        if (!resolveMessages(loadSerial, chunk)) return false;
+        side.addFrames(chunk);
+        emit framesRead(loadSerial, side.getFrameCount());
+        return true;
+    });
+    emit loadDone(loadSerial, ok && !cancelFlag.loadAcquire());
+}
+
+/*
+ * Runs on the worker thread. DBC messages can only be looked up on the GUI thread so IDs in the chunk that haven't
+ * come up before get sent over there and this waits for the answer. Most chunks don't have any new IDs. It gives up
+ * if the load gets cancelled meanwhile, otherwise cancel() waiting on this thread could wait forever.
+*/
+bool FileCompareLoader::resolveMessages(int loadSerial, const QVector<CANFrame> &chunk)
+{
+    QVector<uint32_t> newIDs;
+    QSet<uint32_t> asked;
+    for (int i = 0; i < chunk.count(); i++)
+    {
+        uint32_t id = chunk[i].frameId();
+        if (side.knowsMessage(id) || asked.contains(id)) continue;
+        asked.insert(id);
+        newIDs.append(id);
+    }
+    if (newIDs.isEmpty()) return true;
+
+    QMutexLocker locker(&resolveMutex);
+    resolveDone = false;
+    emit resolveRequest(loadSerial, newIDs);
+    while (!resolveDone)
+    {
+        if (cancelFlag.loadAcquire()) return false;
+        resolveWait.wait(&resolveMutex, 50);
+    }
+    for (QHash<uint32_t, DBC_MESSAGE *>::const_iterator it = resolvedMessages.constBegin(); it != resolvedMessages.constEnd(); ++it)
+    {
+        side.setMessage(it.key(), it.value());
+    }
+    resolvedMessages.clear();
+    return true;
+}
+
+void FileCompareLoader::gotResolveRequest(int loadSerial, QVector<uint32_t> ids)
+{
+    if (loadSerial != serial) return; //the load that asked was cancelled already
+
+    QHash<uint32_t, DBC_MESSAGE *> found;
+    for (int i = 0; i < ids.count(); i++) found.insert(ids[i], dbcHandler ? dbcHandler->findMessage(ids[i]) : nullptr);
+
+    QMutexLocker locker(&resolveMutex);
+    resolvedMessages = found;
+    resolveDone = true;
+    resolveWait.wakeAll();
+}
+
+void FileCompareLoader::gotFramesRead(int loadSerial, quint64 framesRead)
+{
+    if (loadSerial != serial) return; //left over from a load that's been replaced
+    emit progress(framesRead);
+}
+
+void FileCompareLoader::gotLoadDone(int loadSerial, bool ok)
+{
+    if (loadSerial != serial) return;
+    running = false;
+    emit loadFinished(ok);
+}
@@ -0,0 +1,62 @@
+#ifndef FILECOMPARELOADER_H
+#define FILECOMPARELOADER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include "framecomparison.h"
+
+class DBCHandler;
+
+/*
+ * Reads a capture for one side of the file comparison in the background. The file is streamed through the normal
+ * loaders a chunk at a time and each chunk goes straight into a FrameCompareSide so memory use depends on how many
+ * IDs there are, not how big the file is. Loading more than one file into the same side adds them together.
+ * The side can only be looked at while nothing is loading into it.
+*/
+class FileCompareLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    FileCompareLoader(DBCHandler *dbc, QObject *parent = nullptr);
+    ~FileCompareLoader();
+    void start(const QString &filename, int fileType);
+    void cancel();
+    void clear();
+    bool isRunning() const;
+    const FrameCompareSide &getSide() const;
+
+signals:
+    void progress(quint64 framesRead);
+    void loadFinished(bool ok);
+    //used internally to get results from the loading thread back to the GUI thread
+    void framesRead(int serial, quint64 framesRead);
+    void loadDone(int serial, bool ok);
+    void resolveRequest(int serial, QVector<uint32_t> ids);
+
+private slots:
+    void gotFramesRead(int serial, quint64 framesRead);
+    void gotLoadDone(int serial, bool ok);
+    void gotResolveRequest(int serial, QVector<uint32_t> ids);
+
+private:
+    DBCHandler *dbcHandler;
+    FrameCompareSide side;
+    QFuture<void> future;
+    QAtomicInt cancelFlag;
+    int serial;
+    bool running;
+    QMutex resolveMutex;
+    QWaitCondition resolveWait;
+    QHash<uint32_t, DBC_MESSAGE *> resolvedMessages;
+    bool resolveDone;
+
+    void runLoad(int loadSerial, QString filename, int fileType);
+    bool resolveMessages(int loadSerial, const QVector<CANFrame> &chunk);
+};
+
+#endif // FILECOMPARELOADER_H
@@ -1,6 +1,7 @@
 #include "flowviewwindow.h"
 #include "ui_flowviewwindow.h"
 #include "mainwindow.h"
+#include "guirefreshscheduler.h"
 #include "helpwindow.h"
 #include "filterutility.h"
 #include "qcpaxistickerhex.h"
@@ -19,6 +20,9 @@ FlowViewWindow::FlowViewWindow(const QVector<CANFrame> *frames, QWidget *parent)
     readSettings();
 
     modelFrames = frames;
+    cacheTimeOrdered = true;
+    cacheStale = true;
+    rowsID = 0;
 
     playbackTimer = new QTimer();
 
@@ -127,7 +131,7 @@ FlowViewWindow::FlowViewWindow(const QVector<CANFrame> *frames, QWidget *parent)
             changeID(FilterUtility::getId(itemText));
             } );
 
-    connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    GUIRefreshScheduler::getReference()->addWindow(this, &FlowViewWindow::updatedFrames, REFRESH_NORMAL, 250);
 
     ui->graphView->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui->graphView, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(contextMenuRequestGraph(QPoint)));
@@ -296,7 +300,8 @@ void FlowViewWindow::plottableDoubleClick(QCPAbstractPlottable* plottable, QMous
     int id = 0;
     //apply transforms to get the X axis value where we double clicked
     double coord = plottable->keyAxis()->pixelToCoord(event->localPos().x());
-    if (frameCache.count() > 0) id = frameCache[0].frameId();
+    checkRows();
+    if (frameRows.count() > 0) id = frameRows[0].frameId();
     if (secondsMode) emit sendCenterTimeID(id, coord);
     else emit sendCenterTimeID(id, coord / 1000000.0);
 }
@@ -309,25 +314,37 @@ void FlowViewWindow::gotCenterTimeID(uint32_t ID, double timestamp)
 
     qDebug() << "timestamp: " << t_stamp;
 
-    changeID(QString::number(ID)); //to be sure we're focused on the proper ID
-
-    for (int j = 0; j < ui->listFrameID->count(); j++)
+    checkRows();
+    //to be sure we're focused on the proper ID. Picking it in the list rebuilds the frame cache so only do that if it's
+    //a different ID than the one already loaded
+    if (cacheStale || frameRows.isEmpty() || frameRows[0].frameId() != ID)
     {
-        uint32_t thisNum = FilterUtility::getIdAsInt(ui->listFrameID->item(j));
-        if (thisNum == ID)
+        bool inList = false;
+        for (int j = 0; j < ui->listFrameID->count(); j++)
         {
-            ui->listFrameID->setCurrentRow(j);
-            break;
+            uint32_t thisNum = FilterUtility::getIdAsInt(ui->listFrameID->item(j));
+            if (thisNum == ID)
+            {
+                inList = true;
+                if (ui->listFrameID->currentRow() != j) ui->listFrameID->setCurrentRow(j);
+                else changeID(QString::number(ID));
+                break;
+            }
         }
+        if (!inList) changeID(QString::number(ID));
     }
 
     int bestIdx = -1;
-    for (int i = 0; i < frameCache.count(); i++)
+    if (cacheTimeOrdered) bestIdx = frameRows.lastAtOrBefore(t_stamp);
+    else
     {
-        if (frameCache[i].timeStamp().microSeconds() > t_stamp)
+        for (int i = 0; i < frameRows.count(); i++)
         {
-            bestIdx = i - 1;
-            break;
+            if (frameRows[i].timeStamp().microSeconds() > t_stamp)
+            {
+                bestIdx = i - 1;
+                break;
+            }
         }
     }
     qDebug() << "Best index " << bestIdx;
@@ -341,7 +358,7 @@ void FlowViewWindow::gotCenterTimeID(uint32_t ID, double timestamp)
 
         memset(currBytes, 0, 8); //first zero out all 8 bytes
 
-        memcpy(currBytes, frameCache.at(currentPosition).payload().data(), frameCache.at(currentPosition).payload().length());
+        memcpy(currBytes, frameRows.at(currentPosition).payload().data(), frameRows.at(currentPosition).payload().length());
 
         updateDataView();
     }
@@ -451,6 +468,10 @@ void FlowViewWindow::updatedFrames(int numFrames)
     const CANFrame *thisFrame;
     if (numFrames == -1) //all frames deleted. Kill the display
     {
+        cacheStale = true;
+        frameRows.clear(); //rows point into the old frames so they have to go right away
+        playbackTimer->stop();
+        playbackActive = false;
         ui->listFrameID->clear();
         foundID.clear();
         currentPosition = 0;
@@ -463,6 +484,10 @@ void FlowViewWindow::updatedFrames(int numFrames)
     }
     else if (numFrames == -2) //all new set of frames. Reset
     {
+        cacheStale = true;
+        frameRows.clear();
+        playbackTimer->stop();
+        playbackActive = false;
         ui->listFrameID->clear();
         foundID.clear();
         currentPosition = 0;
@@ -477,52 +502,52 @@ void FlowViewWindow::updatedFrames(int numFrames)
     else //just got some new frames. See if they are relevant.
     {
         if (numFrames > modelFrames->count()) return;
-        unsigned int refID;
-        if (frameCache.count() > 0) refID = frameCache[0].frameId();
-            else refID = 0;
-        bool needRefresh = false;
         for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
         {
             thisFrame = &modelFrames->at(i);
-            data = reinterpret_cast<const unsigned char *>(thisFrame->payload().constData());
-            dataLen = thisFrame->payload().length();
-
             if (!foundID.contains(thisFrame->frameId()))
             {
                 foundID.append(thisFrame->frameId());
                 FilterUtility::createFilterItem(thisFrame->frameId(), ui->listFrameID);
             }
+        }
 
-            if (thisFrame->frameId() == refID)
-            {
-                frameCache.append(*thisFrame);
+        checkRows();
+        //the index has already sorted out which of the new frames are ours. Anything past the old end is new
+        int oldCount = frameRows.count();
+        if (oldCount > 0) loadRows(frameRows[0].frameId());
+        bool needRefresh = false;
+        for (int i = oldCount; i < frameRows.count(); i++)
+        {
+            thisFrame = &frameRows.at(i);
+            data = reinterpret_cast<const unsigned char *>(thisFrame->payload().constData());
+            dataLen = thisFrame->payload().length();
 
-                for (int k = 0; k < dataLen; k++)
+            for (int k = 0; k < dataLen; k++)
+            {
+                if (ui->cbTimeGraph->isChecked())
                 {
-                    if (ui->cbTimeGraph->isChecked())
-                    {
-                        if (secondsMode){
-                            newX[k].append((double)(thisFrame->timeStamp().microSeconds()) / 1000000.0);
-                        }
-                        else
-                        {
-                            newX[k].append(thisFrame->timeStamp().microSeconds());
-                        }
+                    if (secondsMode){
+                        newX[k].append((double)(thisFrame->timeStamp().microSeconds()) / 1000000.0);
                     }
                     else
                     {
-                        newX[k].append(x[k].count());
+                        newX[k].append(thisFrame->timeStamp().microSeconds());
                     }
-                    newY[k].append(data[k]);
-                    needRefresh = true;
                 }
+                else
+                {
+                    newX[k].append(x[k].count());
+                }
+                newY[k].append(data[k]);
+                needRefresh = true;
             }
         }
-        if (ui->cbLiveMode->checkState() == Qt::Checked)
+        if (ui->cbLiveMode->checkState() == Qt::Checked && !frameRows.isEmpty())
         {
-            currentPosition = frameCache.count() - 1;
+            currentPosition = frameRows.count() - 1;
             memset(currBytes, 0, 64);
-            memcpy(currBytes, frameCache.at(currentPosition).payload().data(), frameCache.at(currentPosition).payload().length());
+            memcpy(currBytes, frameRows.at(currentPosition).payload().data(), frameRows.at(currentPosition).payload().length());
             memcpy(refBytes, currBytes, 64);
 
         }
@@ -535,7 +560,7 @@ void FlowViewWindow::updatedFrames(int numFrames)
             }
             ui->graphView->replot();
             updateDataView();
-            if (ui->cbSync->checkState() == Qt::Checked) emit sendCenterTimeID(frameCache[currentPosition].frameId(), frameCache[currentPosition].timeStamp().microSeconds() / 1000000.0);
+            if (ui->cbSync->checkState() == Qt::Checked) emit sendCenterTimeID(frameRows[currentPosition].frameId(), frameRows[currentPosition].timeStamp().microSeconds() / 1000000.0);
         }
     }
     updateFrameLabel();
@@ -558,7 +583,7 @@ void FlowViewWindow::createGraph(int byteNum)
 
     bool graphByTime = ui->cbTimeGraph->isChecked();
 
-    int numEntries = frameCache.count();
+    int numEntries = frameRows.count();
 
     x[byteNum].clear();
     y[byteNum].clear();
@@ -567,9 +592,9 @@ void FlowViewWindow::createGraph(int byteNum)
 
     for (int j = 0; j < numEntries; j++)
     {
-        frame = &frameCache[j];
+        frame = &frameRows[j];
         data = reinterpret_cast<const unsigned char *>(frame->payload().constData());
-        if (byteNum < frameCache[j].payload().length())
+        if (byteNum < frameRows[j].payload().length())
             tempVal = data[byteNum];
         else
             tempVal = 0;
@@ -607,24 +632,47 @@ void FlowViewWindow::createGraph(int byteNum)
 
 void FlowViewWindow::refreshIDList()
 {
-    int id;
-    for (int i = 0; i < modelFrames->count(); i++)
+    const CANFrameIndex *index = MainWindow::getReference()->getCANFrameModel()->getFrameIndex(modelFrames);
+    if (!index) return;
+    QList<uint32_t> ids = index->ids();
+    for (int i = 0; i < ids.count(); i++)
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        id = thisFrame.frameId();
-        if (!foundID.contains(id))
+        if (!foundID.contains(ids[i]))
         {
-            foundID.append(id);
-            FilterUtility::createFilterItem(id, ui->listFrameID);
+            foundID.append(ids[i]);
+            FilterUtility::createFilterItem(ids[i], ui->listFrameID);
         }
     }
     //default is to sort in ascending order
     ui->listFrameID->sortItems();
 }
 
+//points frameRows at the model's rows for this ID. Nothing gets copied so it's fine to do on every update
+void FlowViewWindow::loadRows(uint32_t id)
+{
+    CANFrameModel *model = MainWindow::getReference()->getCANFrameModel();
+    const CANFrameIndex *index = model->getFrameIndex(modelFrames);
+    rowsID = id;
+    if (!index)
+    {
+        frameRows.clear();
+        return;
+    }
+    frameRows = model->getFrameRows(modelFrames, id);
+    cacheTimeOrdered = index->isTimeOrdered();
+}
+
+//the model trims the oldest frames off the front during long captures, which moves every row without a reset.
+//Rows from before that point at the wrong frames (or past the end) so start the ID over before touching them
+void FlowViewWindow::checkRows()
+{
+    if (frameRows.isCurrent()) return;
+    changeID(QString::number(rowsID));
+}
+
 void FlowViewWindow::updateFrameLabel()
 {
-    ui->lblNumFrames->setText(QString::number(currentPosition) + tr(" of ") + QString::number(frameCache.count()));
+    ui->lblNumFrames->setText(QString::number(currentPosition) + tr(" of ") + QString::number(frameRows.count()));
 }
 
 void FlowViewWindow::changeID(QString newID)
@@ -632,30 +680,26 @@ void FlowViewWindow::changeID(QString newID)
     qDebug() << "change id " << newID;
     //parse the ID and then load up the frame cache with just messages with that ID.
     uint32_t id = (uint32_t)Utility::ParseStringToNum(newID);
-    frameCache.clear();
+    frameRows.clear();
 
     if (modelFrames->count() == 0) return;
 
     playbackTimer->stop();
     playbackActive = false;
     int maxBytes = 0;
-    for (int x = 0; x < modelFrames->count(); x++)
+    cacheStale = false;
+    loadRows(id);
+    for (int x = 0; x < frameRows.count(); x++)
     {
-        CANFrame thisFrame = modelFrames->at(x);
-        if (thisFrame.frameId() == id)
-        {
-            thisFrame.payload().clear();
-            frameCache.append(thisFrame);
-            if (thisFrame.payload().length() > maxBytes) maxBytes = thisFrame.payload().length();
-        }
+        if (frameRows[x].payload().length() > maxBytes) maxBytes = frameRows[x].payload().length();
     }
     ui->flowView->setBytesToDraw(maxBytes);
     currentPosition = 0;
 
-    if (frameCache.count() == 0) return;
+    if (frameRows.count() == 0) return;
 
     removeAllGraphs();
-    //for (uint32_t c = 0; c < frameCache.at(0).len; c++)
+    //for (uint32_t c = 0; c < frameRows.at(0).len; c++)
     for (uint32_t c = 0; c < 8; c++)
     {
         createGraph(c);
@@ -664,7 +708,7 @@ void FlowViewWindow::changeID(QString newID)
     updateGraphLocation();
 
     memset(currBytes, 0, 64);
-    memcpy(currBytes, frameCache.at(currentPosition).payload().constData(), frameCache.at(currentPosition).payload().length());
+    memcpy(currBytes, frameRows.at(currentPosition).payload().constData(), frameRows.at(currentPosition).payload().length());
     memcpy(refBytes, currBytes, 64);
 
     updateDataView();
@@ -711,8 +755,9 @@ void FlowViewWindow::btnStopClick()
     playbackActive = false;
     currentPosition = 0;
 
+    checkRows();
     memset(currBytes, 0, 64);
-    memcpy(currBytes, frameCache.at(currentPosition).payload().constData(), frameCache.at(currentPosition).payload().length());
+    if (!frameRows.isEmpty()) memcpy(currBytes, frameRows.at(currentPosition).payload().constData(), frameRows.at(currentPosition).payload().length());
     memcpy(refBytes, currBytes, 64);
 
     updateFrameLabel();
@@ -767,7 +812,7 @@ void FlowViewWindow::timerTriggered()
     if (!ui->cbLoopPlayback->isChecked())
     {
         if (currentPosition == 0) playbackActive = false;
-        if (currentPosition == (frameCache.count() - 1)) playbackActive = false;
+        if (currentPosition == (frameRows.count() - 1)) playbackActive = false;
     }
 }
 
@@ -795,7 +840,7 @@ void FlowViewWindow::updateDataView()
     ui->flowView->setReference(refBytes, false);
     ui->flowView->updateData(currBytes, true);
 
-    ui->timelineSlider->setMaximum(frameCache.count() - 1);
+    ui->timelineSlider->setMaximum(frameRows.count() - 1);
     ui->timelineSlider->setValue(currentPosition);
 
     for (int i = 0; i < 8; i++)
@@ -815,24 +860,28 @@ void FlowViewWindow::updateDataView()
 }
 
 void FlowViewWindow::gotoFrame(int frame) {
-    if (frameCache.count() >= frame) currentPosition = frame;
+    checkRows();
+    if (frameRows.isEmpty()) return;
+    if (frameRows.count() > frame) currentPosition = frame;
     else currentPosition = 0;
 
-    if (ui->cbSync->checkState() == Qt::Checked) emit sendCenterTimeID(frameCache[currentPosition].frameId(), frameCache[currentPosition].timeStamp().microSeconds() / 1000000.0);
+    if (ui->cbSync->checkState() == Qt::Checked) emit sendCenterTimeID(frameRows[currentPosition].frameId(), frameRows[currentPosition].timeStamp().microSeconds() / 1000000.0);
 }
 
 void FlowViewWindow::updatePosition(bool forward)
 {
+    checkRows();
+    if (frameRows.isEmpty()) return;
 
     if (forward)
     {
-        if (currentPosition < (frameCache.count() - 1)) currentPosition++;
+        if (currentPosition < (frameRows.count() - 1)) currentPosition++;
         else if (ui->cbLoopPlayback->isChecked()) currentPosition = 0;
     }
     else
     {
         if (currentPosition > 0) currentPosition--;
-        else if (ui->cbLoopPlayback->isChecked()) currentPosition = frameCache.count() - 1;
+        else if (ui->cbLoopPlayback->isChecked()) currentPosition = frameRows.count() - 1;
     }
 
     if (ui->cbAutoRef->isChecked())
@@ -844,14 +893,14 @@ void FlowViewWindow::updatePosition(bool forward)
     //get through that then they're changed and a trigger so we stop playback at this frame.
     //This is complicated by the fact that CAN-FD frames might have far more than 64 bits. It is necessary
     //to thus process them 64 bits at a time and just move chunk to chunk until done.
-    for (int chunk = 0; chunk < frameCache.at(currentPosition).payload().length(); chunk += 8)
+    for (int chunk = 0; chunk < frameRows.at(currentPosition).payload().length(); chunk += 8)
     {
         uint64_t changedBits = 0;
         uint8_t cngByte;
-        int maxVal = qMin(chunk * 8 + 8, frameCache.at(currentPosition).payload().length());
+        int maxVal = qMin(chunk * 8 + 8, frameRows.at(currentPosition).payload().length());
         for (int i = chunk * 8; i < maxVal; i++)
         {
-            unsigned char thisByte = static_cast<unsigned char>(frameCache.at(currentPosition).payload()[i]);
+            unsigned char thisByte = static_cast<unsigned char>(frameRows.at(currentPosition).payload()[i]);
             cngByte = currBytes[i] ^ thisByte;
             changedBits |= (uint64_t)cngByte << (8ull * (i & 7));
         }
@@ -867,26 +916,27 @@ void FlowViewWindow::updatePosition(bool forward)
         }
     }
     memset(currBytes, 0, 64);
-    memcpy(currBytes, frameCache.at(currentPosition).payload().constData(), frameCache.at(currentPosition).payload().length());
+    memcpy(currBytes, frameRows.at(currentPosition).payload().constData(), frameRows.at(currentPosition).payload().length());
 
-    if (ui->cbSync->checkState() == Qt::Checked) emit sendCenterTimeID(frameCache[currentPosition].frameId(), frameCache[currentPosition].timeStamp().microSeconds() / 1000000.0);
+    if (ui->cbSync->checkState() == Qt::Checked) emit sendCenterTimeID(frameRows[currentPosition].frameId(), frameRows[currentPosition].timeStamp().microSeconds() / 1000000.0);
     ui->timelineSlider->setValue(currentPosition);
 }
 
 void FlowViewWindow::updateGraphLocation()
 {
-    if (frameCache.count() == 0) return;
+    checkRows();
+    if (frameRows.count() == 0) return;
     int start = currentPosition - ui->graphRangeSlider->value();
     if (start < 0) start = 0;
     int end = currentPosition + ui->graphRangeSlider->value();
-    if (end >= frameCache.count()) end = frameCache.count() - 1;
+    if (end >= frameRows.count()) end = frameRows.count() - 1;
     if (ui->cbTimeGraph->isChecked())
     {
         if (secondsMode)
         {
-            ui->graphView->xAxis->setRange(frameCache[start].timeStamp().microSeconds() / 1000000.0, frameCache[end].timeStamp().microSeconds() / 1000000.0);
+            ui->graphView->xAxis->setRange(frameRows[start].timeStamp().microSeconds() / 1000000.0, frameRows[end].timeStamp().microSeconds() / 1000000.0);
             /*
-            ui->graphView->xAxis->setTickStep((frameCache[end].timeStamp().microSeconds() - frameCache[start].timeStamp().microSeconds())/ 3000000.0);
+            ui->graphView->xAxis->setTickStep((frameRows[end].timeStamp().microSeconds() - frameRows[start].timeStamp().microSeconds())/ 3000000.0);
             ui->graphView->xAxis->setSubTickCount(0);
             ui->graphView->xAxis->setNumberFormat("f");
             ui->graphView->xAxis->setNumberPrecision(6);
@@ -894,9 +944,9 @@ void FlowViewWindow::updateGraphLocation()
         }
         else
         {
-            ui->graphView->xAxis->setRange(frameCache[start].timeStamp().microSeconds(), frameCache[end].timeStamp().microSeconds());
+            ui->graphView->xAxis->setRange(frameRows[start].timeStamp().microSeconds(), frameRows[end].timeStamp().microSeconds());
             /*
-            ui->graphView->xAxis->setTickStep((frameCache[end].timeStamp().microSeconds() - frameCache[start].timeStamp().microSeconds())/ 3.0);
+            ui->graphView->xAxis->setTickStep((frameRows[end].timeStamp().microSeconds() - frameRows[start].timeStamp().microSeconds())/ 3.0);
             ui->graphView->xAxis->setSubTickCount(0);
             ui->graphView->xAxis->setNumberFormat("f");
             ui->graphView->xAxis->setNumberPrecision(0); */
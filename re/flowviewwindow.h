@@ -6,6 +6,7 @@
 #include <QSlider>
 #include "qcustomplot.h"
 #include "can_structs.h"
+#include "canframeindex.h"
 
 namespace Ui {
 class FlowViewWindow;
@@ -49,7 +50,10 @@ signals:
 private:
     Ui::FlowViewWindow *ui;
     QList<quint32> foundID;
-    QList<CANFrame> frameCache;
+    CANFrameRows frameRows; //the current ID's rows out of the model's index. Shared with everyone else, not a copy
+    uint32_t rowsID; //the ID frameRows was fetched for
+    bool cacheTimeOrdered; //frames only ever go forward in time so lookups by time can binary search
+    bool cacheStale; //the model's frames got replaced or cleared since the rows were fetched
     const QVector<CANFrame> *modelFrames;
     unsigned char refBytes[64];
     unsigned char currBytes[64];
@@ -67,6 +71,8 @@ private:
     QCPGraph *graphRef[8];
 
     void refreshIDList();
+    void loadRows(uint32_t id);
+    void checkRows();
     void updateFrameLabel();
     void updatePosition(bool forward);
     void gotoFrame(int frame);
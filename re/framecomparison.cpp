@@ -0,0 +1,136 @@
+#include "framecomparison.h"
+#include "dbc/dbchandler.h"
+
+FrameCompareID::FrameCompareID()
+{
+    ID = 0;
+    dataLen = 0;
+    maxLen = 0;
+    frameCount = 0;
+}
+
+void FrameCompareID::addPayload(const QByteArray &payload)
+{
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(payload.constData());
+    int len = qMin(static_cast<int>(payload.length()), 64);
+
+    if (frameCount == 0) dataLen = len;
+    frameCount++;
+    if (len > maxLen)
+    {
+        maxLen = len;
+        bitmap.resize((len + 7) / 8);
+        values.resize(len * 4);
+    }
+
+    uint64_t *bits = bitmap.data();
+    uint64_t *vals = values.data();
+    for (int y = 0; y < len; y++)
+    {
+        bits[y / 8] |= static_cast<uint64_t>(data[y]) << (8 * (y % 8));
+        vals[y * 4 + (data[y] >> 6)] |= 1ULL << (data[y] & 63);
+    }
+}
+
+bool FrameCompareID::bitSet(int bit) const
+{
+    if (bit < 0 || bit / 64 >= bitmap.count()) return false;
+    return (bitmap[bit / 64] >> (bit % 64)) & 1;
+}
+
+bool FrameCompareID::sawValue(int byteNum, int value) const
+{
+    if (byteNum < 0 || byteNum >= maxLen || value < 0 || value > 255) return false;
+    return (values[byteNum * 4 + (value >> 6)] >> (value & 63)) & 1;
+}
+
+void FrameCompareID::addSignalValue(const QString &sigName, double value)
+{
+    if (manySignalValues.contains(sigName)) return;
+    QSet<double> &vals = signalValues[sigName];
+    if (vals.contains(value)) return;
+    if (vals.count() >= FRAME_COMPARE_SIGNAL_VALUES)
+    {
+        manySignalValues.insert(sigName);
+        vals.clear();
+        vals.squeeze();
+        return;
+    }
+    vals.insert(value);
+}
+
+FrameCompareSide::FrameCompareSide()
+{
+    frameCount = 0;
+}
+
+void FrameCompareSide::clear()
+{
+    ids.clear();
+    messages.clear();
+    decodedPayloads.clear();
+    frameCount = 0;
+}
+
+bool FrameCompareSide::knowsMessage(uint32_t id) const
+{
+    return messages.contains(id);
+}
+
+void FrameCompareSide::setMessage(uint32_t id, DBC_MESSAGE *msg)
+{
+    messages.insert(id, msg);
+}
+
+void FrameCompareSide::addFrames(const QVector<CANFrame> &frames)
+{
+    QMap<uint32_t, FrameCompareID>::iterator it = ids.end();
+    uint32_t lastID = 0;
+
+    for (int x = 0; x < frames.count(); x++)
+    {
+        const CANFrame &frame = frames[x];
+        uint32_t id = frame.frameId();
+
+        //captures tend to have runs of the same ID so don't go looking it up again if it's the same as last time
+        if (it == ids.end() || id != lastID)
+        {
+            it = ids.find(id);
+            if (it == ids.end())
+            {
+                it = ids.insert(id, FrameCompareID());
+                it->ID = id;
+            }
+            lastID = id;
+        }
+        it->addPayload(frame.payload());
+
+        DBC_MESSAGE *msg = messages.value(id, nullptr);
+        if (!msg) continue;
+
+        QSet<QByteArray> &seen = decodedPayloads[id];
+        if (seen.contains(frame.payload())) continue;
+        if (seen.count() >= FRAME_COMPARE_PAYLOAD_MEMORY) seen.clear();
+        seen.insert(frame.payload());
+
+        int numSignals = msg->sigHandler->getCount();
+        for (int i = 0; i < numSignals; i++)
+        {
+            DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
+            if (!sig || sig->valType == STRING) continue;
+            double value;
+            if (sig->isPresentIn(frame) && sig->decodeValue(frame, value)) it->addSignalValue(sig->name, value);
+        }
+    }
+    frameCount += frames.count();
+}
+
+uint64_t FrameCompareSide::getFrameCount() const
+{
+    return frameCount;
+}
+
+const QMap<uint32_t, FrameCompareID> &FrameCompareSide::getIDs() const
+{
+    return ids;
+}
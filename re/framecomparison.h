@@ -0,0 +1,64 @@
+#ifndef FRAMECOMPARISON_H
+#define FRAMECOMPARISON_H
+
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QVector>
+#include "can_structs.h"
+
+class DBC_MESSAGE;
+
+//how many different payloads of one ID to remember having decoded before starting over. Keeps the memory use flat
+//on IDs with a counter in them where nearly every payload is new
+#define FRAME_COMPARE_PAYLOAD_MEMORY    4096
+//different values of one signal to keep. Past that the signal is just marked as having many and its values are dropped.
+//Nobody is going to read through a list longer than this anyway
+#define FRAME_COMPARE_SIGNAL_VALUES     1024
+
+//everything one side of a comparison saw of one ID. Stays the same size no matter how many frames there were
+class FrameCompareID
+{
+public:
+    FrameCompareID();
+    void addPayload(const QByteArray &payload);
+    bool bitSet(int bit) const;
+    bool sawValue(int byteNum, int value) const;
+    void addSignalValue(const QString &sigName, double value);
+
+    uint32_t ID;
+    int dataLen;                //length of the first frame seen. The bit report has always gone by that
+    int maxLen;
+    uint64_t frameCount;
+    QVector<uint64_t> bitmap;   //every payload bit that was ever set, 64 to a word
+    QVector<uint64_t> values;   //every value each byte ever had, 256 bits (4 words) per byte
+    QHash<QString, QSet<double>> signalValues;  //up to FRAME_COMPARE_SIGNAL_VALUES for each signal
+    QSet<QString> manySignalValues;             //signals that had more than that. Their entry in signalValues stays empty
+};
+
+/*
+ * One side of the file comparison built up a chunk of frames at a time so the file never has to all be in memory.
+ * DBC signals get decoded only for payloads that haven't been seen lately. Looking up which message an ID belongs to
+ * isn't safe off the GUI thread so that happens over there and gets handed in with setMessage before frames of the ID
+ * are added. IDs that were never given one don't get their signals decoded. The decoding itself only uses the parts
+ * of the signal code that are safe to run off the GUI thread.
+*/
+class FrameCompareSide
+{
+public:
+    FrameCompareSide();
+    void clear();
+    void addFrames(const QVector<CANFrame> &frames);
+    bool knowsMessage(uint32_t id) const;
+    void setMessage(uint32_t id, DBC_MESSAGE *msg);
+    uint64_t getFrameCount() const;
+    const QMap<uint32_t, FrameCompareID> &getIDs() const;
+
+private:
+    QMap<uint32_t, FrameCompareID> ids;
+    QHash<uint32_t, DBC_MESSAGE *> messages;            //looked up once per ID, nullptr if there isn't one
+    QHash<uint32_t, QSet<QByteArray>> decodedPayloads;
+    uint64_t frameCount;
+};
+
+#endif // FRAMECOMPARISON_H
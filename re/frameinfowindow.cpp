@@ -1,11 +1,15 @@
 #include "frameinfowindow.h"
 #include "ui_frameinfowindow.h"
 #include "mainwindow.h"
+#include "guirefreshscheduler.h"
 #include "helpwindow.h"
 #include <QtDebug>
 #include <vector>
 #include "filterutility.h"
 #include "qcpaxistickerhex.h"
+#include "bitactivity.h"
+#include <QVBoxLayout>
+#include <algorithm>
 
 const QColor FrameInfoWindow::byteGraphColors[8] = {Qt::blue, Qt::green,  Qt::black, Qt::red, //0 1 2 3
                                                     Qt::gray, Qt::darkYellow, Qt::cyan,  Qt::darkMagenta}; //4 5 6 7
@@ -23,6 +27,8 @@ FrameInfoWindow::FrameInfoWindow(const QVector<CANFrame> *frames, QWidget *paren
     readSettings();
 
     modelFrames = frames;
+    cacheTimeOrdered = true;
+    tallies.setMaxCost(FRAMEINFO_TALLY_ROWS);
 
     // Using lambda expression to strip away the possible filter label before passing the ID to updateDetailsWindow
     connect(ui->listFrameID, &QListWidget::currentTextChanged, 
@@ -31,8 +37,9 @@ FrameInfoWindow::FrameInfoWindow(const QVector<CANFrame> *frames, QWidget *paren
             FrameInfoWindow::updateDetailsWindow(FilterUtility::getId(itemText));
             } );
 
-    connect(MainWindow::getReference(), &MainWindow::framesUpdated, this, &FrameInfoWindow::updatedFrames);
+    GUIRefreshScheduler::getReference()->addWindow(this, &FrameInfoWindow::updatedFrames, REFRESH_NORMAL, 250);
     connect(ui->btnSave, &QAbstractButton::clicked, this, &FrameInfoWindow::saveDetails);
+    connect(ui->btnBitActivity, &QAbstractButton::clicked, this, &FrameInfoWindow::showBitActivity);
 
     ui->splitter->setStretchFactor(0, 1); //idx, stretch factor
     ui->splitter->setStretchFactor(1, 4); //goal is to make right hand side larger by default
@@ -90,7 +97,7 @@ FrameInfoWindow::FrameInfoWindow(const QVector<CANFrame> *frames, QWidget *paren
     //ui->timeHistogram->axisRect()->setupFullAxesBox();
 
     ui->timeHistogram->xAxis->setLabel("Interval (ms)");
-    ui->timeHistogram->yAxis->setLabel("Occurrences");
+    ui->timeHistogram->yAxis->setLabel("Occurrences (approximate)"); //counted from the interval digest
 
     ui->timeHistogram->legend->setVisible(false);
     ui->timeHistogram->setBufferDevicePixelRatio(1);
@@ -199,6 +206,39 @@ void FrameInfoWindow::mouseWheel()
 }
 
 
+//another window is centering on a time. If it's the ID shown here then line the byte graphs up on the frame
+//that was current at that time. The byte graphs are plotted against frame number, not time.
+void FrameInfoWindow::gotCenterTimeID(uint32_t ID, double timestamp)
+{
+    //the model trimming old frames off the front moves every row. The graphs came from the old rows so redo the lot
+    if (!frameRows.isCurrent())
+    {
+        frameRows.clear();
+        if (ui->listFrameID->currentItem()) updateDetailsWindow(FilterUtility::getId(ui->listFrameID->currentItem()));
+    }
+    if (frameRows.isEmpty() || frameRows[0].frameId() != ID) return;
+
+    int64_t t_stamp = static_cast<int64_t>(timestamp * 1000000.0);
+    int idx = -1;
+    if (cacheTimeOrdered) idx = frameRows.lastAtOrBefore(t_stamp);
+    else
+    {
+        for (int i = 0; i < frameRows.count(); i++)
+        {
+            if (frameRows[i].timeStamp().microSeconds() <= t_stamp) idx = i;
+            else break;
+        }
+    }
+    if (idx < 0) idx = 0;
+
+    for (int i = 0; i < 8; i++)
+    {
+        double offset = graphByte[i]->xAxis->range().size() / 2.0;
+        graphByte[i]->xAxis->setRange(idx - offset, idx + offset);
+        graphByte[i]->replot();
+    }
+}
+
 //two modes here. If none of the 8 sub graphs are hidden then hide all except the one the user
 //just double clicked on. Otherwise unhide the 7 hidden ones
 void FrameInfoWindow::mouseDoubleClick()
@@ -309,6 +349,8 @@ void FrameInfoWindow::updatedFrames(int numFrames)
     if (numFrames == -1) //all frames deleted. Kill the display
     {
         //qDebug() << "Delete all frames in Info Window";
+        frameRows.clear(); //the rows are for frames that are gone now
+        tallies.clear();
         ui->listFrameID->clear();
         ui->treeDetails->clear();
         foundID.clear();
@@ -317,6 +359,8 @@ void FrameInfoWindow::updatedFrames(int numFrames)
     else if (numFrames == -2) //all new set of frames. Reset
     {
         //qDebug() << "All new set of frames in Info Window";
+        frameRows.clear();
+        tallies.clear();
         ui->listFrameID->clear();
         ui->treeDetails->clear();
         foundID.clear();
@@ -371,27 +415,12 @@ void FrameInfoWindow::updatedFrames(int numFrames)
 void FrameInfoWindow::updateDetailsWindow(QString newID)
 {
     int targettedID;
-    int minLen, maxLen, thisLen;
-    int64_t avgInterval;
-    int64_t minInterval;
-    int64_t maxInterval;
-    int64_t thisInterval;
-    int minData[8];
-    int maxData[8];
-    int dataHistogram[256][8];
-    int bitfieldHistogram[64];
     QVector<double> histGraphX, histGraphY;
-    QVector<double> byteGraphX, byteGraphY[8];
+    QVector<double> byteGraphX;
     QVector<double> timeGraphX, timeGraphY;
-    QHash<QString, QHash<QString, int>> signalInstances;
     double maxY = -1000.0;
-    uint8_t changedBits[8];
-    uint8_t referenceBits[8];
     uint8_t heatVals[512];
-
-    //these two used by bitflip heatmap functionality
-    uint8_t refByte[8];
-    double bitFlipHeat[64];
+    CANIDStats stats;
 
     QTreeWidgetItem *baseNode, *dataBase, *histBase, *tempItem;
 
@@ -401,31 +430,35 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 
     qDebug() << "Started update details window with id " << targettedID;
 
-    avgInterval = 0;
-
     if (targettedID > -1)
     {
 
-        frameCache.clear();
-        for (int i = 0; i < modelFrames->count(); i++)
+        //the model's index already knows which rows belong to the ID so this is a lookup, not a pass over every frame
+        CANFrameModel *frameModel = MainWindow::getReference()->getCANFrameModel();
+        const CANFrameIndex *index = frameModel->getFrameIndex(modelFrames);
+        if (!index) return;
+        frameRows = frameModel->getFrameRows(modelFrames, targettedID);
+        cacheTimeOrdered = index->isTimeOrdered();
+
+        if (frameRows.count() == 0) return; //nothing to do if there are no frames!
+
+        //the model keeps statistics up as frames come in so normally they're just read out. Asking for detail has it
+        //keep the histograms for this ID too from now on. If they can't speak for the list this window is looking at
+        //(filter expression, frames trimmed off the front) add them up here instead
+        bool filteredList = (modelFrames != frameModel->getListReference());
+        if (!frameModel->getIDStats(targettedID, -1, stats, filteredList, true) || stats.count != static_cast<uint64_t>(frameRows.count())
+                || !stats.hasDetail())
         {
-            CANFrame thisFrame = modelFrames->at(i);
-            if (thisFrame.frameId() == static_cast<uint32_t>(targettedID)) frameCache.append(thisFrame);
+            stats = CANIDStats();
+            stats.addFrames(frameRows);
         }
 
-        if (frameCache.count() == 0) return; //nothing to do if there are no frames!
-
-        const unsigned char *data = reinterpret_cast<const unsigned char *>(frameCache.at(0).payload().constData());
-        int dataLen = frameCache.at(0).payload().length();
-
         ui->treeDetails->clear();
 
-        if (frameCache.count() == 0) return;
-
         baseNode = new QTreeWidgetItem();
         baseNode->setText(0, QString("ID: ") + newID );
 
-        if (frameCache[0].hasExtendedFrameFormat()) //if these frames seem to be extended then try for J1939 decoding
+        if (frameRows[0].hasExtendedFrameFormat()) //if these frames seem to be extended then try for J1939 decoding
         {
             // ------- J1939 decoding ----------
             J1939ID jid;
@@ -488,98 +521,33 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         }
 
         tempItem = new QTreeWidgetItem();
-        tempItem->setText(0, tr("# of frames: ") + QString::number(frameCache.count(),10));
+        tempItem->setText(0, tr("# of frames: ") + QString::number(stats.count,10));
         baseNode->addChild(tempItem);
 
-        //clear out all the counters and accumulators
-        minLen = 8;
-        maxLen = 0;
-        minInterval = 0x7FFFFFFF;
-        maxInterval = 0;
-        for (int i = 0; i < 8; i++)
+        //the byte graphs and signal values still need the frames themselves. What was counted last time this ID was
+        //shown is kept so only the frames since then get looked at
+        FrameInfoTally *tally = tallies.take(targettedID);
+        if (tally && (!tally->countedFrom.isCurrent() || tally->countedFrom.count() > frameRows.count()
+                      || tally->dbcGeneration != dbcHandler->getChangeCounter()))
         {
-            minData[i] = 256;
-            maxData[i] = -1;
-            for (int k = 0; k < 256; k++) dataHistogram[k][i] = 0;
+            delete tally;
+            tally = nullptr;
         }
-        for (int j = 0; j < 64; j++)
+        if (!tally)
         {
-            bitfieldHistogram[j] = 0;
-            bitFlipHeat[j] = 0;
+            tally = new FrameInfoTally;
+            tally->dbcGeneration = dbcHandler->getChangeCounter();
         }
-        signalInstances.clear();
-
-        data = reinterpret_cast<const unsigned char *>(frameCache.at(0).payload().constData());
-        dataLen = frameCache.at(0).payload().length();
-
-        for (int c = 0; c < dataLen; c++)
-        {
-            changedBits[c] = 0;
-            referenceBits[c] = data[c];
-            refByte[c] = data[c];
-            //qDebug() << referenceBits[c];
-        }
-
-        std::vector<int64_t> sortedIntervals;
-        int64_t intervalSum = 0;
 
         DBC_MESSAGE *msg = dbcHandler->findMessageForFilter(targettedID, nullptr);
-
-        //then find all data points
-        for (int j = 0; j < frameCache.count(); j++)
+        for (int j = tally->countedFrom.count(); j < frameRows.count(); j++)
         {
-            data = reinterpret_cast<const unsigned char *>(frameCache.at(j).payload().constData());
-            dataLen = frameCache.at(j).payload().length();
+            const unsigned char *data = reinterpret_cast<const unsigned char *>(frameRows.at(j).payload().constData());
+            int dataLen = frameRows.at(j).payload().length();
 
-            byteGraphX.append(j);
-            for (int bytcnt = 0; bytcnt < dataLen; bytcnt++)
-            {
-                byteGraphY[bytcnt].append(data[bytcnt]);
-            }
-
-            if (j != 0)
-            {
-                //TODO - we try the interval whichever way doesn't go negative. But, we should probably sort the frame list before
-                //starting so that the intervals are all correct.
-                if (frameCache[j].timeStamp().microSeconds() > frameCache[j-1].timeStamp().microSeconds())
-                    thisInterval = (frameCache[j].timeStamp().microSeconds() - frameCache[j-1].timeStamp().microSeconds());
-                else
-                    thisInterval = (frameCache[j-1].timeStamp().microSeconds() - frameCache[j].timeStamp().microSeconds());
-
-                sortedIntervals.push_back(thisInterval);
-                intervalSum += thisInterval;
-                if (thisInterval > maxInterval) maxInterval = thisInterval;
-                if (thisInterval < minInterval) minInterval = thisInterval;
-                avgInterval += thisInterval;
-            }
-            thisLen = dataLen;
-            if (thisLen > maxLen) maxLen = thisLen;
-            if (thisLen < minLen) minLen = thisLen;
-            for (int c = 0; c < thisLen; c++)
+            for (int bytcnt = 0; bytcnt < dataLen && bytcnt < 8; bytcnt++)
             {
-                unsigned char dat = data[c];
-                if (minData[c] > dat) minData[c] = dat;
-                if (maxData[c] < dat) maxData[c] = dat;
-                dataHistogram[dat][c]++; //add one to count for this
-                for (int l = 0; l < 8; l++)
-                {
-                    int bit = dat & (1 << l);
-                    if (bit == (1 << l))
-                    {
-                        bitfieldHistogram[c * 8 + l]++;
-                    }
-                }
-                changedBits[c] |= referenceBits[c] ^ dat;
-
-                if (refByte[c] != dat) //if this byte doesn't match the value it last had
-                {
-                    uint8_t newBits = refByte[c] ^ dat; //get changed bits since last ref
-                    for (int l = 0; l < 8; l++)
-                    {
-                        if (newBits & (1 << l)) bitFlipHeat[(c * 8) + l]++;
-                    }
-                    refByte[c] = dat; //set the reference to this current byte now that processing is done
-                }
+                tally->byteGraphY[bytcnt].append(data[bytcnt]);
             }
 
             //Search every signal in the selected message and give output of the range the signal took and
@@ -592,80 +560,58 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
                     DBC_SIGNAL *sig = msg->sigHandler->findSignalByIdx(i);
                     if (sig)
                     {
-                        if (sig->isSignalInMessage(frameCache.at(j)))
+                        if (sig->isSignalInMessage(frameRows.at(j)))
                         {
                             QString sigVal;
-                            if (sig->processAsText(frameCache.at(j), sigVal, false))
+                            if (sig->processAsText(frameRows.at(j), sigVal, false))
                             {
-                                signalInstances[sig->name][sigVal] = signalInstances[sig->name][sigVal] + 1;
+                                tally->signalInstances[sig->name][sigVal] = tally->signalInstances[sig->name][sigVal] + 1;
                             }
                         }
                     }
                 }
             }
         }
+        tally->countedFrom = frameRows;
+        byteGraphX.resize(frameRows.count());
+        for (int j = 0; j < byteGraphX.count(); j++) byteGraphX[j] = j;
 
-        //Divide all the bit flip heat values by the number of frames to get a ratio
-        for (int j = 0; j < 64; j++) bitFlipHeat[j] /= (double)frameCache.count();
+        int64_t minInterval = stats.minInterval;
+        int64_t maxInterval = stats.maxInterval;
+        int64_t intervalPctl5 = 0, intervalPctl95 = 0;
 
-        std::sort(sortedIntervals.begin(), sortedIntervals.end());
-        int64_t intervalStdDiv = 0, intervalPctl5 = 0, intervalPctl95 = 0, intervalMean = 0, intervalVariance = 0;
-
-        int maxTimeCounter = -1;
-        if (sortedIntervals.size() > 0)
+        //percentiles and the histogram come out of the interval digest so they're close but not exact
+        if (stats.intervalCount > 0)
         {
-            intervalMean = intervalSum / sortedIntervals.size();
-
-            for(int l = 0; l < static_cast<int>(sortedIntervals.size()); l++) {
-                intervalVariance += ((sortedIntervals[l] - intervalMean) * (sortedIntervals[l] - intervalMean));
-            }
+            intervalPctl5 = static_cast<int64_t>(stats.intervalPercentile(0.05));
+            intervalPctl95 = static_cast<int64_t>(stats.intervalPercentile(0.95));
 
-            intervalVariance /= sortedIntervals.size();
-            intervalStdDiv = static_cast<int>(sqrt(intervalVariance));
-
-            intervalPctl5 = sortedIntervals[static_cast<unsigned int>(floor(0.05 * sortedIntervals.size()))];
-            intervalPctl95 = sortedIntervals[static_cast<unsigned int>(floor(0.95 * sortedIntervals.size()))];
-
-            uint64_t step = static_cast<unsigned int>(ceil((maxInterval - minInterval) / numIntervalHistBars));
+            int64_t step = (maxInterval - minInterval) / numIntervalHistBars;
             qDebug() << "Step: " << step << " minInt: " << minInterval << " maxInt: " << maxInterval;
-            unsigned int index = 0;
-            int counter = 0;
+            uint64_t counted = 0;
             for(int l = 0; l <= numIntervalHistBars; l++) {
                 int64_t currentMax = maxInterval - ((numIntervalHistBars - l) * step);	// avoid missing the biggest value due to rounding errors
-                qDebug() << "CurrentMax: " << currentMax;
-                while(index < sortedIntervals.size()) {
-                    if(sortedIntervals[index] <= currentMax) {
-                        counter++;
-                        index++;
-                    }
-                    else {
-                        break;
-                    }
-                }
+                uint64_t atOrBelow = (l == numIntervalHistBars) ? stats.intervalCount : stats.intervalsAtOrBelow(currentMax);
+                if (atOrBelow < counted) atOrBelow = counted;
                 timeGraphX.append(currentMax / 1000.0);
-                timeGraphY.append(counter);
-                if(counter > maxTimeCounter) maxTimeCounter = counter;
-                counter = 0;
+                timeGraphY.append(atOrBelow - counted);
+                counted = atOrBelow;
             }
         }
 
-        if (frameCache.count() > 1)
-            avgInterval = avgInterval / (frameCache.count() - 1);
-        else avgInterval = 0;
-
         //now that data processing is done, create all of our output
 
         tempItem = new QTreeWidgetItem();
 
-        if (minLen < maxLen)
-            tempItem->setText(0, tr("Data Length: ") + QString::number(minLen) + tr(" to ") + QString::number(maxLen));
+        if (stats.minLen < stats.maxLen)
+            tempItem->setText(0, tr("Data Length: ") + QString::number(stats.minLen) + tr(" to ") + QString::number(stats.maxLen));
         else
-            tempItem->setText(0, tr("Data Length: ") + QString::number(minLen));
+            tempItem->setText(0, tr("Data Length: ") + QString::number(stats.minLen));
 
         baseNode->addChild(tempItem);
 
         tempItem = new QTreeWidgetItem();
-        tempItem->setText(0, tr("Average inter-frame interval: ") + QString::number(avgInterval / 1000.0) + "ms");
+        tempItem->setText(0, tr("Average inter-frame interval: ") + QString::number(static_cast<int64_t>(stats.intervalMean()) / 1000.0) + "ms");
         baseNode->addChild(tempItem);
         tempItem = new QTreeWidgetItem();
         tempItem->setText(0, tr("Minimum inter-frame interval: ") + QString::number(minInterval / 1000.0) + "ms");
@@ -677,14 +623,32 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         tempItem->setText(0, tr("Inter-frame interval variation: ") + QString::number((maxInterval - minInterval) / 1000.0) + "ms");
         baseNode->addChild(tempItem);
         tempItem = new QTreeWidgetItem();
-        tempItem->setText(0, tr("Interval standard deviation: ") + QString::number(intervalStdDiv / 1000.0) + "ms");
+        tempItem->setText(0, tr("Interval standard deviation: ") + QString::number(static_cast<int64_t>(stats.intervalStdDev()) / 1000.0) + "ms");
+        baseNode->addChild(tempItem);
+        tempItem = new QTreeWidgetItem();
+        tempItem->setText(0, tr("Minimum range to fit 90% of inter-frame intervals (approximate): ") + QString::number((intervalPctl95 - intervalPctl5) / 1000.0) + "ms");
         baseNode->addChild(tempItem);
         tempItem = new QTreeWidgetItem();
-        tempItem->setText(0, tr("Minimum range to fit 90% of inter-frame intervals: ") + QString::number((intervalPctl95 - intervalPctl5) / 1000.0) + "ms");
+        tempItem->setText(0, tr("Frames per second: ") + QString::number(stats.rate(), 'f', 2));
         baseNode->addChild(tempItem);
 
+        if (stats.lengthCounts.count() > 1)
+        {
+            dataBase = new QTreeWidgetItem();
+            dataBase->setText(0, tr("Data Length Distribution"));
+            for (int len = 0; len < stats.lengthCounts.count(); len++)
+            {
+                if (stats.lengthCounts[len] == 0) continue;
+                tempItem = new QTreeWidgetItem();
+                tempItem->setText(0, QString::number(len) + " -> " + QString::number(stats.lengthCounts[len]));
+                dataBase->addChild(tempItem);
+            }
+            baseNode->addChild(dataBase);
+        }
+
         //display accumulated data for all the bytes in the message
-        for (int c = 0; c < maxLen; c++)
+        int numBytes = qMin(stats.byteCount(), 64);
+        for (int c = 0; c < numBytes; c++)
         {
             dataBase = new QTreeWidgetItem();
             histBase = new QTreeWidgetItem();
@@ -694,39 +658,45 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 
             tempItem = new QTreeWidgetItem();
             QString builder;
-            builder = tr("Changed bits: 0x") + QString::number(changedBits[c], 16) + "  (" + Utility::formatByteAsBinary(changedBits[c]) + ")";
+            builder = tr("Changed bits: 0x") + QString::number(stats.changedBits[c], 16) + "  (" + Utility::formatByteAsBinary(stats.changedBits[c]) + ")";
             tempItem->setText(0, builder);
             dataBase->addChild(tempItem);
 
             tempItem = new QTreeWidgetItem();
-            tempItem->setText(0, tr("Range: ") + Utility::formatNumber((unsigned int)minData[c]) + tr(" to ") + Utility::formatNumber((unsigned int)maxData[c]));
+            tempItem->setText(0, tr("Range: ") + Utility::formatNumber((unsigned int)stats.minData[c]) + tr(" to ") + Utility::formatNumber((unsigned int)stats.maxData[c]));
             dataBase->addChild(tempItem);
-            histBase->setText(0, tr("Histogram"));
-            dataBase->addChild(histBase);
 
-            for (int d = 0; d < 256; d++)
+            if (c < STATS_HISTOGRAM_BYTES)
             {
-                if (dataHistogram[d][c] > 0)
+                histBase->setText(0, tr("Histogram"));
+                dataBase->addChild(histBase);
+
+                for (int d = 0; d < 256; d++)
                 {
-                    tempItem = new QTreeWidgetItem();
-                    tempItem->setText(0, QString::number(d) + "/0x" + QString::number(d, 16) +" (" + Utility::formatByteAsBinary(static_cast<uint8_t>(d)) +") -> " + QString::number(dataHistogram[d][c]));
-                    histBase->addChild(tempItem);
+                    uint64_t hits = stats.byteHistogram[c * 256 + d];
+                    if (hits > 0)
+                    {
+                        tempItem = new QTreeWidgetItem();
+                        tempItem->setText(0, QString::number(d) + "/0x" + QString::number(d, 16) +" (" + Utility::formatByteAsBinary(static_cast<uint8_t>(d)) +") -> " + QString::number(hits));
+                        histBase->addChild(tempItem);
+                    }
                 }
             }
+            else delete histBase;
         }
 
         dataBase = new QTreeWidgetItem();
         dataBase->setText(0, tr("Bitfield Histogram"));
-        for (int c = 0; c < 8 * maxLen; c++)
+        for (int c = 0; c < 8 * numBytes; c++)
         {
             tempItem = new QTreeWidgetItem();
             tempItem->setText(0, QString::number(c) + " (Byte " + QString::number(c / 8) + " Bit "
-                            + QString::number(c % 8) + ") : " + QString::number(bitfieldHistogram[c]));
+                            + QString::number(c % 8) + ") : " + QString::number(stats.bitSetCounts[c]));
 
             dataBase->addChild(tempItem);
             histGraphX.append(c);
-            histGraphY.append(bitfieldHistogram[c]);
-            if (bitfieldHistogram[c] > maxY) maxY = bitfieldHistogram[c];
+            histGraphY.append(stats.bitSetCounts[c]);
+            if (stats.bitSetCounts[c] > maxY) maxY = stats.bitSetCounts[c];
         }
         baseNode->addChild(dataBase);
 
@@ -734,30 +704,28 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         dataBase = new QTreeWidgetItem();
         dataBase->setText(0, tr("Bitchange Heatmap"));
         memset(heatVals, 0, 512); //always clear the array before populating it.
-        for (int c = 0; c < 8 * maxLen; c++)
+        for (int c = 0; c < 8 * numBytes; c++)
         {
+            double bitFlipHeat = stats.bitFlipCounts[c] / (double)stats.count; //ratio of frames where this bit flipped
             tempItem = new QTreeWidgetItem();
             tempItem->setText(0, QString::number(c) + " (Byte " + QString::number(c / 8) + " Bit "
-                            + QString::number(c % 8) + ") : " + QString::number(bitFlipHeat[c] * 100.0, 'f', 2));
+                            + QString::number(c % 8) + ") : " + QString::number(bitFlipHeat * 100.0, 'f', 2));
 
             dataBase->addChild(tempItem);
-            histGraphX.append(c);
-            histGraphY.append(bitfieldHistogram[c]);
-            if (bitfieldHistogram[c] > maxY) maxY = bitfieldHistogram[c];
-            uint8_t heat = bitFlipHeat[c] * 255;
-            if ((heat < 1) && (bitFlipHeat[c] > 0.0001)) heat = 1; //make sure any little bit of heat causes at least some output
+            uint8_t heat = bitFlipHeat * 255;
+            if ((heat < 1) && (bitFlipHeat > 0.0001)) heat = 1; //make sure any little bit of heat causes at least some output
             //qDebug() << "Heat for bit " << c <<  " is " << heat;
             heatVals[c] = heat;
         }
         baseNode->addChild(dataBase);
         heatmap->setHeat(heatVals);
 
-        QHash<QString, QHash<QString, int>>::const_iterator it = signalInstances.constBegin();
-        while (it != signalInstances.constEnd()) {
+        QHash<QString, QHash<QString, int>>::const_iterator it = tally->signalInstances.constBegin();
+        while (it != tally->signalInstances.constEnd()) {
             dataBase = new QTreeWidgetItem();
             dataBase->setText(0, it.key());
-            QHash<QString,int>::const_iterator itVal = signalInstances[it.key()].constBegin();
-            while (itVal != signalInstances[it.key()].constEnd())
+            QHash<QString,int>::const_iterator itVal = it.value().constBegin();
+            while (itVal != it.value().constEnd())
             {
                 tempItem = new QTreeWidgetItem();
                 tempItem->setText(0, itVal.key() + ": " + QString::number(itVal.value()));
@@ -788,7 +756,7 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         {
             graphByte[graphs]->clearGraphs();
             graphRef[graphs] = graphByte[graphs]->addGraph();
-            graphByte[graphs]->graph()->setData(byteGraphX, byteGraphY[graphs]);
+            graphByte[graphs]->graph()->setData(byteGraphX, tally->byteGraphY[graphs]);
             graphByte[graphs]->graph()->setPen(bytePens[graphs]);
             graphByte[graphs]->xAxis->setRange(0, byteGraphX.count());
             graphByte[graphs]->replot();
@@ -808,6 +776,9 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
         ui->timeHistogram->axisRect()->setupFullAxesBox();
         ui->timeHistogram->rescaleAxes();
         ui->timeHistogram->replot();
+
+        //QCache throws it out right away if it's bigger than the whole cache so nothing can use it after this
+        tallies.insert(targettedID, tally, qMax(1, frameRows.count()));
     }
     else
     {
@@ -822,11 +793,12 @@ void FrameInfoWindow::updateDetailsWindow(QString newID)
 
 void FrameInfoWindow::refreshIDList()
 {
-    int id;
-    for (int i = 0; i < modelFrames->count(); i++)
+    const CANFrameIndex *index = MainWindow::getReference()->getCANFrameModel()->getFrameIndex(modelFrames);
+    if (!index) return;
+    QList<uint32_t> ids = index->ids();
+    for (int i = 0; i < ids.count(); i++)
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        id = (int)thisFrame.frameId();
+        int id = static_cast<int>(ids[i]);
         if (!foundID.contains(id))
         {
             foundID.append(id);
@@ -838,6 +810,90 @@ void FrameInfoWindow::refreshIDList()
     ui->lblUniqueID->setText("(" + QString::number(ui->listFrameID->count()) + tr(" unique ids)"));
 }
 
+/*
+ * How often every bit of every ID changes, all in one picture with a row per ID. The model's running stats get used
+ * wherever they speak for the list this window is looking at and the rest are counted across the thread pool.
+*/
+void FrameInfoWindow::showBitActivity()
+{
+    CANFrameModel *frameModel = MainWindow::getReference()->getCANFrameModel();
+    const CANFrameIndex *index = frameModel->getFrameIndex(modelFrames);
+    if (!index || modelFrames->isEmpty()) return;
+
+    QList<uint32_t> idList = index->ids();
+    std::sort(idList.begin(), idList.end());
+    bool filteredList = (modelFrames != frameModel->getListReference());
+
+    QVector<QVector<double>> flipRatios(idList.count());
+    QVector<uint32_t> toCount;
+    QVector<int> countedRows;
+    int numBits = 8;
+    for (int i = 0; i < idList.count(); i++)
+    {
+        CANIDStats stats;
+        uint32_t id = idList[i];
+        if (frameModel->getIDStats(id, -1, stats, filteredList) && stats.count > 0
+                && stats.count == static_cast<uint64_t>(index->rowsMatching(id, id, -1).count()))
+        {
+            QVector<double> &ratios = flipRatios[i];
+            ratios.resize(stats.bitFlipCounts.count());
+            for (int bit = 0; bit < ratios.count(); bit++) ratios[bit] = stats.bitFlipCounts[bit] / static_cast<double>(stats.count);
+            numBits = qMax(numBits, static_cast<int>(ratios.count()));
+        }
+        else
+        {
+            toCount.append(id);
+            countedRows.append(i);
+        }
+    }
+
+    //the GUI thread is the only thing that changes the frame lists and it waits right here so the workers can read them
+    QVector<BitActivity> counted = BitActivity::forIDs(*modelFrames, *index, toCount);
+    for (int i = 0; i < counted.count(); i++)
+    {
+        QVector<double> &ratios = flipRatios[countedRows[i]];
+        ratios.resize(counted[i].byteCount() * 8);
+        for (int bit = 0; bit < ratios.count(); bit++) ratios[bit] = counted[i].flipRatio(bit);
+        numBits = qMax(numBits, static_cast<int>(ratios.count()));
+    }
+
+    QDialog *dialog = new QDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->setWindowFlags(Qt::Window);
+    dialog->setWindowTitle(tr("Bit activity of all IDs"));
+    QVBoxLayout *layout = new QVBoxLayout(dialog);
+    QCustomPlot *plot = new QCustomPlot(dialog);
+    layout->addWidget(plot);
+    plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+
+    QSharedPointer<QCPAxisTickerText> idTicker(new QCPAxisTickerText);
+    for (int i = 0; i < idList.count(); i++) idTicker->addTick(i, Utility::formatCANID(idList[i]));
+    plot->yAxis->setTicker(idTicker);
+    plot->yAxis->setRangeReversed(true); //lowest ID at the top like the list
+    plot->xAxis->setLabel(tr("Bit (byte * 8 + bit)"));
+
+    QCPColorMap *colorMap = new QCPColorMap(plot->xAxis, plot->yAxis);
+    colorMap->data()->setSize(numBits, idList.count());
+    colorMap->data()->setRange(QCPRange(0, numBits - 1), QCPRange(0, idList.count() - 1));
+    for (int row = 0; row < idList.count(); row++)
+    {
+        for (int bit = 0; bit < flipRatios[row].count(); bit++) colorMap->data()->setCell(bit, row, flipRatios[row][bit]);
+    }
+    colorMap->setGradient(QCPColorGradient::gpHot);
+    colorMap->setDataRange(QCPRange(0.0, 1.0));
+    colorMap->setInterpolate(false);
+
+    QCPColorScale *colorScale = new QCPColorScale(plot);
+    plot->plotLayout()->addElement(0, 1, colorScale);
+    colorScale->setLabel(tr("Fraction of frames the bit changed in"));
+    colorMap->setColorScale(colorScale);
+
+    plot->rescaleAxes();
+    plot->replot();
+    dialog->resize(900, 600);
+    dialog->show();
+}
+
 void FrameInfoWindow::saveDetails()
 {
     QString filename;
@@ -2,20 +2,38 @@
 #define FRAMEINFOWINDOW_H
 
 #include <QDialog>
+#include <QCache>
 #include <QFile>
 #include <QListWidget>
 #include <QTreeWidget>
 #include <candatagrid.h>
 #include "can_structs.h"
+#include "canframeindex.h"
 #include "bus_protocols/j1939_handler.h"
 #include "dbc/dbchandler.h"
 
 #include "qcustomplot.h"
 
+#define FRAMEINFO_TALLY_ROWS    1000000 //frames worth of byte graphs and signal counts kept for IDs already shown
+
 namespace Ui {
 class FrameInfoWindow;
 }
 
+/*
+ * The parts of the details that can only come from going through an ID's frames one by one: the byte graphs and how
+ * often each signal value showed up. Kept for IDs that have been shown so showing one again only has to go through
+ * the frames that came in since. countedFrom says which rows went in and whether the list has been rewritten since.
+*/
+class FrameInfoTally
+{
+public:
+    CANFrameRows countedFrom;
+    int dbcGeneration;
+    QVector<double> byteGraphY[8];
+    QHash<QString, QHash<QString, int>> signalInstances;
+};
+
 class FrameInfoWindow : public QDialog
 {
     Q_OBJECT
@@ -25,10 +43,14 @@ public:
     ~FrameInfoWindow();
     void showEvent(QShowEvent*);
 
+public slots:
+    void gotCenterTimeID(uint32_t ID, double timestamp);
+
 private slots:
     void updateDetailsWindow(QString);
     void updatedFrames(int);
     void saveDetails();
+    void showBitActivity();
     void mousePress();
     void mouseWheel();
     void mouseDoubleClick();
@@ -40,7 +62,9 @@ private:
     CANDataGrid *heatmap;
 
     QList<int> foundID;
-    QList<CANFrame> frameCache;
+    CANFrameRows frameRows; //rows of the ID being shown, straight out of the model's index
+    QCache<int, FrameInfoTally> tallies; //by ID, cost is the number of frames counted
+    bool cacheTimeOrdered;
     const QVector<CANFrame> *modelFrames;
     bool useOpenGL;
     bool useHexTicker;
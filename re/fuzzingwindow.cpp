@@ -4,6 +4,7 @@
 #include <QDebug>
 #include <QRandomGenerator>
 #include "mainwindow.h"
+#include "guirefreshscheduler.h"
 #include "helpwindow.h"
 #include "connections/canconmanager.h"
 #include "filterutility.h"
@@ -37,7 +38,7 @@ FuzzingWindow::FuzzingWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     connect(ui->txtByte7, &QLineEdit::returnPressed, this, [=](){changedDataByteText(7, ui->txtByte7->text());});
 
 
-    connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    GUIRefreshScheduler::getReference()->addWindow(this, &FuzzingWindow::updatedFrames, REFRESH_LOW, 500);
 
     refreshIDList();
 
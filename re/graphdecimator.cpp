@@ -0,0 +1,192 @@
+#include "graphdecimator.h"
+
+#include <algorithm>
+
+GraphDecimator::GraphDecimator()
+{
+    clear();
+}
+
+void GraphDecimator::clear()
+{
+    minIndex.clear();
+    maxIndex.clear();
+    count = 0;
+    sorted = true;
+}
+
+/*
+ * Takes in whatever samples were added to the end of x and y since last time. If they were changed any other way
+ * call clear() first.
+ *
+ * Only whole blocks are ever looked at by rangeMinMax so a block is summed up once the sample that fills it comes in,
+ * from the eight samples or the two blocks below it. That's a bit under two block updates per sample on average.
+*/
+void GraphDecimator::update(const QVector<double> &x, const QVector<double> &y)
+{
+    int total = qMin(x.count(), y.count());
+    if (total < count)
+    {
+        clear(); //they got shorter so this can't be the same samples any more
+    }
+    const double *xData = x.constData();
+    const double *yData = y.constData();
+    const int blockSize = 1 << GRAPH_DECIMATOR_BLOCK_BITS;
+
+    for (int i = count; i < total; i++)
+    {
+        if (i > 0 && xData[i] < xData[i - 1]) sorted = false;
+        if (((i + 1) & (blockSize - 1)) != 0) continue;
+
+        int lo = i - blockSize + 1, hi = lo;
+        for (int j = lo + 1; j <= i; j++)
+        {
+            if (yData[j] < yData[lo]) lo = j;
+            if (yData[j] > yData[hi]) hi = j;
+        }
+        if (minIndex.isEmpty())
+        {
+            minIndex.append(QVector<int>());
+            maxIndex.append(QVector<int>());
+        }
+        minIndex[0].append(lo);
+        maxIndex[0].append(hi);
+
+        //every second block finished on a level finishes one on the level above
+        for (int level = 0; (minIndex[level].count() & 1) == 0; level++)
+        {
+            const QVector<int> &mins = minIndex[level];
+            const QVector<int> &maxes = maxIndex[level];
+            int n = mins.count();
+            int pairLo = (yData[mins[n - 1]] < yData[mins[n - 2]]) ? mins[n - 1] : mins[n - 2];
+            int pairHi = (yData[maxes[n - 1]] > yData[maxes[n - 2]]) ? maxes[n - 1] : maxes[n - 2];
+            if (level + 1 == minIndex.count())
+            {
+                minIndex.append(QVector<int>());
+                maxIndex.append(QVector<int>());
+            }
+            minIndex[level + 1].append(pairLo);
+            maxIndex[level + 1].append(pairHi);
+        }
+    }
+    count = qMax(count, total);
+}
+
+/*
+ * Index of the smallest and largest y in [start, end). Single samples at the ragged ends and the biggest blocks that
+ * fit in between.
+*/
+void GraphDecimator::rangeMinMax(const QVector<double> &y, int start, int end, int &minIdx, int &maxIdx) const
+{
+    const double *yData = y.constData();
+    minIdx = maxIdx = start;
+    int i = start;
+    const int blockSize = 1 << GRAPH_DECIMATOR_BLOCK_BITS;
+    while (i < end)
+    {
+        if ((i & (blockSize - 1)) != 0 || i + blockSize > end || minIndex.isEmpty())
+        {
+            if (yData[i] < yData[minIdx]) minIdx = i;
+            if (yData[i] > yData[maxIdx]) maxIdx = i;
+            i++;
+            continue;
+        }
+
+        int level = 0;
+        while (level + 1 < minIndex.count())
+        {
+            int size = 1 << (level + 1 + GRAPH_DECIMATOR_BLOCK_BITS);
+            if ((i & (size - 1)) != 0 || i + size > end) break;
+            level++;
+        }
+        int block = i >> (level + GRAPH_DECIMATOR_BLOCK_BITS);
+        if (block >= minIndex[level].count()) break; //past what update() has seen
+        int lo = minIndex[level][block];
+        int hi = maxIndex[level][block];
+        if (yData[lo] < yData[minIdx]) minIdx = lo;
+        if (yData[hi] > yData[maxIdx]) maxIdx = hi;
+        i += 1 << (level + GRAPH_DECIMATOR_BLOCK_BITS);
+    }
+}
+
+/*
+ * The points to draw for keys lower to upper across pixelWidth pixels, in time order. Includes the sample just
+ * either side of the range so lines run off the edges properly. If there aren't many more samples in view than
+ * pixels, or pixelWidth is 0, they all come back as they are.
+*/
+void GraphDecimator::visiblePoints(const QVector<double> &x, const QVector<double> &y, double lower, double upper, int pixelWidth,
+                                   QVector<double> &outX, QVector<double> &outY) const
+{
+    outX.clear();
+    outY.clear();
+    int total = qMin(count, qMin(x.count(), y.count()));
+    if (total == 0) return;
+    if (!sorted)
+    {
+        outX = x.mid(0, total);
+        outY = y.mid(0, total);
+        return;
+    }
+
+    const double *xData = x.constData();
+    int visibleStart = static_cast<int>(std::lower_bound(xData, xData + total, lower) - xData);
+    int visibleEnd = static_cast<int>(std::upper_bound(xData + visibleStart, xData + total, upper) - xData);
+    int first = qMax(0, visibleStart - 1);
+    int end = qMin(total, visibleEnd + 1);
+
+    if (pixelWidth <= 0 || end - first <= pixelWidth * 4 || upper <= lower)
+    {
+        outX = x.mid(first, end - first);
+        outY = y.mid(first, end - first);
+        return;
+    }
+
+    outX.reserve(pixelWidth * 4 + 2);
+    outY.reserve(pixelWidth * 4 + 2);
+    auto addPoint = [&](int idx)
+    {
+        outX.append(xData[idx]);
+        outY.append(y[idx]);
+    };
+
+    if (first < visibleStart) addPoint(first);
+    double step = (upper - lower) / pixelWidth;
+    int a = visibleStart;
+    for (int p = 0; p < pixelWidth && a < visibleEnd; p++)
+    {
+        int b = visibleEnd;
+        if (p < pixelWidth - 1)
+        {
+            double edge = lower + (p + 1) * step;
+            b = static_cast<int>(std::lower_bound(xData + a, xData + visibleEnd, edge) - xData);
+        }
+        if (b <= a) continue;
+
+        int minIdx, maxIdx;
+        rangeMinMax(y, a, b, minIdx, maxIdx);
+        int picks[4] = {a, minIdx, maxIdx, b - 1};
+        std::sort(picks, picks + 4);
+        for (int k = 0; k < 4; k++)
+        {
+            if (k > 0 && picks[k] == picks[k - 1]) continue;
+            addPoint(picks[k]);
+        }
+        a = b;
+    }
+    if (visibleEnd < end) addPoint(visibleEnd);
+}
+
+bool GraphDecimator::isSorted() const
+{
+    return sorted;
+}
+
+int GraphDecimator::sampleCount() const
+{
+    return count;
+}
+
+int GraphDecimator::levelCount() const
+{
+    return minIndex.count();
+}
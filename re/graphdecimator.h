@@ -0,0 +1,41 @@
+#ifndef GRAPHDECIMATOR_H
+#define GRAPHDECIMATOR_H
+
+#include <QVector>
+
+#define GRAPH_DECIMATOR_BLOCK_BITS  3   //the finest level sums up 8 samples a block
+
+/*
+ * Cuts a graph's samples down to what can actually be seen at the current zoom. For every pixel column only the
+ * first, last, smallest and largest sample in it get drawn (M4 decimation) so the lines come out exactly the same as
+ * drawing every sample but there are never more than four points per pixel whatever the zoom.
+ *
+ * Finding the smallest and largest sample in a column is a lookup in a pyramid of blocks. Level L holds the index
+ * of the smallest and largest value in each run of 8 << L samples, so any range of samples is covered by a couple
+ * of blocks per level. update() only looks at samples added since the last call so a growing graph costs time for
+ * its new samples and nothing else, and the pyramid is about an eighth the size of the samples.
+ *
+ * The samples have to be in time order for the columns to be found by binary search. If they ever go backwards
+ * the decimator gives up and hands back every sample, which is what the graph got before.
+*/
+class GraphDecimator
+{
+public:
+    GraphDecimator();
+    void clear();
+    void update(const QVector<double> &x, const QVector<double> &y);
+    void visiblePoints(const QVector<double> &x, const QVector<double> &y, double lower, double upper, int pixelWidth,
+                       QVector<double> &outX, QVector<double> &outY) const;
+    void rangeMinMax(const QVector<double> &y, int start, int end, int &minIdx, int &maxIdx) const;
+    bool isSorted() const;
+    int sampleCount() const;
+    int levelCount() const;
+
+private:
+    QVector<QVector<int>> minIndex;    //level, block
+    QVector<QVector<int>> maxIndex;
+    int count;
+    bool sorted;
+};
+
+#endif // GRAPHDECIMATOR_H
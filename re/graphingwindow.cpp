@@ -2,8 +2,10 @@
 #include "ui_graphingwindow.h"
 #include "newgraphdialog.h"
 #include "mainwindow.h"
+#include "guirefreshscheduler.h"
 #include "helpwindow.h"
 #include "utility.h"
+#include "dbc/dbcsignalcache.h"
 #include <QDebug>
 
 #include <algorithm>
@@ -83,7 +85,10 @@ GraphingWindow::GraphingWindow(const QVector<CANFrame> *frames, QWidget *parent)
     connect(ui->graphingView, SIGNAL(legendDoubleClick(QCPLegend*,QCPAbstractLegendItem*,QMouseEvent*)), this, SLOT(legendDoubleClick(QCPLegend*,QCPAbstractLegendItem*)));
     connect(ui->graphingView, SIGNAL(legendClick(QCPLegend*,QCPAbstractLegendItem*,QMouseEvent*)), this, SLOT(legendSingleClick(QCPLegend*,QCPAbstractLegendItem*)));
 
-    connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    //the plot only ever gets the points that can be seen at the current zoom. They're picked right before each replot
+    connect(ui->graphingView, &QCustomPlot::beforeReplot, this, &GraphingWindow::updatePlotData);
+
+    GUIRefreshScheduler::getReference()->addWindow(this, &GraphingWindow::updatedFrames, REFRESH_NORMAL, 250);
 
     // setup policy and connect slot for context menu popup:
     ui->graphingView->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -164,6 +169,7 @@ void GraphingWindow::readSettings()
     }
 
     useOpenGL = settings.value("Main/UseOpenGL", false).toBool();
+    historySeconds = settings.value("Graphing/HistorySeconds", 0.0).toDouble();
 }
 
 void GraphingWindow::writeSettings()
@@ -175,86 +181,243 @@ void GraphingWindow::writeSettings()
         settings.setValue("Graphing/WindowSize", size());
         settings.setValue("Graphing/WindowPos", pos());
     }
+    settings.setValue("Graphing/HistorySeconds", historySeconds);
 }
 
 void GraphingWindow::updatedFrames(int numFrames)
 {
-    CANFrame thisFrame;
-    QVector<double> x, y;
-    bool appendedToGraph = false;
-    bool needReplot = false;
-
-    if (numFrames == -1) //all frames deleted. Kill the display
-    {
-        //removeAllGraphs();
-        //now instead of removing the graphs regenerate them which will blank them out but leave them there in case
-        //more traffic that matches comes in or someone otherwise loads more data
-        ui->graphingView->clearGraphs(); //temporarily remove the graphs from the graph view
-        for (int i = 0; i < graphParams.count(); i++)
-        {
-            createGraph(graphParams[i], false); //regenerate each one
-        }
-        ui->graphingView->replot(); //now, redisplay them all
-
-    }
-    else if (numFrames == -2) //all new set of frames. Reset
+    if (numFrames == -1 || numFrames == -2) //all frames deleted or an all new set of frames
     {
-        //there shouldn't be any need to actually remove the graphs.
-        //regenerate them instead
-        ui->graphingView->clearGraphs(); //temporarily remove the graphs from the graph view
-        //needScaleSetup = true;
+        //the graphs stay where they are with their pens, names and so on. Only what's in them gets redone.
+        //They're left there even with nothing in them in case more traffic that matches comes in or someone
+        //otherwise loads more data
+        double xminval, xmaxval, yminval, ymaxval;
         for (int i = 0; i < graphParams.count(); i++)
         {
-            createGraph(graphParams[i], false); //regenerate each one
+            clearGraphData(graphParams[i]);
+            loadGraphData(graphParams[i], xminval, xmaxval, yminval, ymaxval);
+            ageGraphData(graphParams[i]);
         }
+        if (numFrames == -2 && !graphParams.isEmpty()) rescaleAxis(ui->graphingView->yAxis);
         ui->graphingView->replot(); //now, redisplay them all
     }
     else //just got some new frames. See if they are relevant.
     {  
         if (numFrames > modelFrames->count()) return;
+        if (!appendFrames(modelFrames->count() - numFrames)) return;
 
-        for (int j = 0; j < graphParams.count(); j++)
+        if (followGraphEnd)
         {
-            appendedToGraph = false;
-            x.clear();
-            y.clear();
-            for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
+            //find the current X span and maintain that span but move the end of it over to match the new end
+            //of the actual graph. This causes the view to move with the data to always show the end.
+            //The plot only holds what's on screen so the end has to come from the samples themselves
+            QCPRange range = ui->graphingView->xAxis->range();
+            double size = range.size();
+            bool foundRange = false;
+            double end = 0.0;
+            for (int j = 0; j < graphParams.count(); j++)
             {
-                thisFrame = modelFrames->at(i);
-                if ( graphParams[j].ID == thisFrame.frameId() && ( (graphParams[j].bus == -1) || (graphParams[j].bus == thisFrame.bus) ) )
-                {
-                    appendToGraph(graphParams[j], thisFrame, x, y);
-                    appendedToGraph = true;
-                }
+                if (graphParams[j].x.isEmpty()) continue;
+                if (!foundRange || graphParams[j].x.last() > end) end = graphParams[j].x.last();
+                foundRange = true;
             }
-            if (appendedToGraph)
+            if (foundRange)
             {
-                graphParams[j].ref->addData(x, y);
-                needReplot = true;
+                double start = end - size;
+                ui->graphingView->xAxis->setRange(start, end);
             }
         }
+        //queued so any other replots asked for before the event loop comes back around are done in the same one
+        ui->graphingView->replot(QCustomPlot::rpQueuedReplot);
+    }
+}
+
+/*
+ * Adds the frames from firstRow to the end of the frame list to the graphs. Graphs of a DBC signal take the new
+ * samples the shared signal cache decoded, everything else gets handed the frames for its ID out of a single pass
+ * over the new frames. Either way the cost is in the new frames, not in what's already graphed. Returns whether
+ * anything got added.
+*/
+bool GraphingWindow::appendFrames(int firstRow)
+{
+    bool appended = false;
+    QMultiHash<uint32_t, int> graphsForID;
+
+    for (int j = 0; j < graphParams.count(); j++)
+    {
+        GraphParams &params = graphParams[j];
+        if (params.seriesSamples < 0 || !matchesSignalSeries(params))
+        {
+            graphsForID.insert(params.ID, j);
+            continue;
+        }
 
-        if (needReplot)
+        DBCSignalSeries series = DBCSignalCache::getReference()->getSeries(params.associatedSignal, params.bus, modelFrames);
+        int start = params.seriesSamples;
+        //the cache starts a series over when old frames get trimmed off the front of the list so the count alone
+        //doesn't say where this graph left off. If the sample there isn't the last one it got, find it again by time
+        if (start > series.count() || (start > 0 && series.times[start - 1] != params.seriesLastTime))
+        {
+            start = static_cast<int>(std::upper_bound(series.times.constBegin(), series.times.constEnd(), params.seriesLastTime)
+                                     - series.times.constBegin());
+        }
+        for (int k = start; k < series.count(); k++)
+        {
+            appendSample(params, series.times[k], series.rawValues[k]);
+            params.seriesLastTime = series.times[k];
+            appended = true;
+        }
+        params.seriesSamples = series.count();
+    }
+
+    if (!graphsForID.isEmpty())
+    {
+        for (int i = firstRow; i < modelFrames->count(); i++)
         {
-            if (followGraphEnd)
+            const CANFrame &thisFrame = modelFrames->at(i);
+            QMultiHash<uint32_t, int>::const_iterator it = graphsForID.constFind(thisFrame.frameId());
+            for (; it != graphsForID.constEnd() && it.key() == thisFrame.frameId(); ++it)
             {
-                //find the current X span and maintain that span but move the end of it over to match the new end
-                //of the actual graph. This causes the view to move with the data to always show the end
-                QCPRange range = ui->graphingView->xAxis->range();
-                double size = range.size();
-                bool foundRange;
-                QCPRange keyRange = ui->graphingView->graph()->getKeyRange(foundRange);
-                if (foundRange)
+                GraphParams &params = graphParams[it.value()];
+                if ( (params.bus == -1) || (params.bus == thisFrame.bus) )
                 {
-                    double end, start;
-                    end = keyRange.upper;
-                    start = end - size;
-                    ui->graphingView->xAxis->setRange(start, end);
+                    appendToGraph(params, thisFrame);
+                    appended = true;
                 }
             }
-            ui->graphingView->replot();
         }
     }
+
+    if (appended)
+    {
+        for (int j = 0; j < graphParams.count(); j++) ageGraphData(graphParams[j]);
+    }
+    return appended;
+}
+
+//empties a graph out for loadGraphData to fill it again, value table brackets and all
+void GraphingWindow::clearGraphData(GraphParams &params)
+{
+    foreach (QCPItemBracket* brk, params.brackets)
+    {
+        ui->graphingView->removeItem(brk);
+    }
+    foreach (QCPItemText* txt, params.bracketTexts)
+    {
+        ui->graphingView->removeItem(txt);
+    }
+    params.brackets.clear();
+    params.bracketTexts.clear();
+    params.lastBracket = nullptr;
+    params.prevValTable = 9999999999;
+    params.prevValLocation = QPointF(0,0);
+    params.prevValStr = "";
+    params.x.clear();
+    params.y.clear();
+    params.decimator.clear();
+    params.shownCount = -1;
+}
+
+//Whether the graph pulls the same bits out of the frame as its DBC signal so it can use the shared decoded series.
+//Scale and bias are applied by the graph so those are free to differ.
+bool GraphingWindow::matchesSignalSeries(const GraphParams &params) const
+{
+    DBC_SIGNAL *sig = params.associatedSignal;
+    return (sig && sig->parentMessage && sig->parentMessage->ID == params.ID && sig->startBit == params.startBit
+        && sig->signalSize == params.numBits && sig->intelByteOrder == params.intelFormat
+        && (sig->valType == SIGNED_INT) == params.isSigned);
+}
+
+//frame timestamp in microseconds to where it goes on the time axis
+double GraphingWindow::timeToKey(int64_t timeStamp) const
+{
+    if (Utility::timeStyle == TS_SECONDS) return timeStamp / 1000000.0;
+    if (Utility::timeStyle == TS_CLOCK)
+    {
+        QDateTime dt = QDateTime::fromMSecsSinceEpoch(timeStamp / 1000);
+        return dt.time().msecsSinceStartOfDay() / 1000.0;
+    }
+    return timeStamp;
+}
+
+/*
+ * First sample of a graph that's still within the history length, 0 if everything is kept. Only graphs in time order
+ * can be cut by time. The rest keep everything.
+*/
+int GraphingWindow::firstKeptSample(const GraphParams &params) const
+{
+    if (historySeconds <= 0.0 || params.x.isEmpty() || !params.decimator.isSorted()) return 0;
+    double keySpan = historySeconds;
+    if (Utility::timeStyle != TS_SECONDS && Utility::timeStyle != TS_CLOCK) keySpan *= 1000000.0;
+    double cutoff = params.x.last() - keySpan;
+    return static_cast<int>(std::lower_bound(params.x.constBegin(), params.x.constEnd(), cutoff) - params.x.constBegin());
+}
+
+/*
+ * Drops samples older than the history length from the front of a graph. Taking them off the front means moving
+ * everything after them and redoing the decimator so that only happens once there's at least as much to drop as
+ * there is to keep. That way each sample only gets moved a couple of times on average however long the capture runs.
+ * Until then the old samples are still there, just off screen and left out of the view extents.
+*/
+void GraphingWindow::ageGraphData(GraphParams &params)
+{
+    if (historySeconds <= 0.0) return;
+    params.decimator.update(params.x, params.y);
+    int expired = firstKeptSample(params);
+    if (expired == 0 || expired < params.x.count() - expired) return;
+
+    double cutoff = params.x[expired];
+    params.x.remove(0, expired);
+    params.y.remove(0, expired);
+    params.decimator.clear();
+    params.shownCount = -1;
+
+    while (!params.brackets.isEmpty() && params.brackets.first() != params.lastBracket
+           && params.brackets.first()->right->coords().x() < cutoff)
+    {
+        ui->graphingView->removeItem(params.brackets.takeFirst());
+        if (!params.bracketTexts.isEmpty()) ui->graphingView->removeItem(params.bracketTexts.takeFirst());
+    }
+}
+
+void GraphingWindow::setHistoryLength()
+{
+    bool ok;
+    double seconds = QInputDialog::getDouble(this, "SavvyCAN Graphing", "Seconds of history to keep (0 keeps everything):",
+                                             historySeconds, 0.0, 1000000000.0, 1, &ok);
+    if (!ok) return;
+    historySeconds = seconds;
+    for (int j = 0; j < graphParams.count(); j++) ageGraphData(graphParams[j]);
+    ui->graphingView->replot();
+}
+
+/*
+ * Hands each graph the points the decimator picks for the visible time range and the width of the plot, at most four
+ * a pixel column, instead of every sample. Called before every replot but a graph only gets new points if the range,
+ * the width or its sample count moved since last time. Graphs drawn as just points get every visible sample as a
+ * column of dots isn't the same thing as its top and bottom.
+*/
+void GraphingWindow::updatePlotData()
+{
+    QCPRange range = ui->graphingView->xAxis->range();
+    int width = ui->graphingView->axisRect()->width();
+    QVector<double> x, y;
+
+    for (int i = 0; i < graphParams.count(); i++)
+    {
+        GraphParams &params = graphParams[i];
+        if (!params.ref) continue;
+        params.decimator.update(params.x, params.y);
+        if (params.shownCount == params.x.count() && params.shownWidth == width && params.shownRange == range) continue;
+
+        params.decimator.visiblePoints(params.x, params.y, range.lower, range.upper, params.drawOnlyPoints ? 0 : width, x, y);
+        params.ref->setData(x, y, params.decimator.isSorted());
+        //a selected graph is selected as a whole so stretch the selection over the new points
+        if (params.ref->selected()) params.ref->setSelection(QCPDataSelection(params.ref->data()->dataRange()));
+        params.shownRange = range;
+        params.shownWidth = width;
+        params.shownCount = params.x.count();
+    }
 }
 
 void GraphingWindow::plottableClick(QCPAbstractPlottable* plottable, int dataIdx, QMouseEvent* event)
@@ -294,20 +457,32 @@ void GraphingWindow::plottableDoubleClick(QCPAbstractPlottable* plottable, int d
 
 void GraphingWindow::gotCenterTimeID(uint32_t ID, double timestamp)
 {
-    Q_UNUSED(ID)
-    //its problematic to try to highlight a graph since we get the ID
-    //and timestamp not the signal in question so there is no real way
-    //to know which graph. But, if that changes here is a stub
-    //for (int i = 0; i < graphParams.count(); i++)
-    //{
-    //}
-
     qDebug() << "Trying to center graph on timestamp: " << timestamp;
 
     QCPRange range = ui->graphingView->xAxis->range();
     double offset = range.size() / 2.0;
     if (Utility::timeStyle != TS_SECONDS) timestamp *= 1000000.0; //timestamp is always in seconds when being passed so convert if necessary
     ui->graphingView->xAxis->setRange(timestamp - offset, timestamp + offset);
+
+    //we get the ID and not the signal so there's no telling which graph was meant if there are several from the
+    //same message. Leave the tracer where it is if it's already on one of them, otherwise use the first.
+    //Graph data is kept sorted by time so placing the tracer is a binary search, not a walk through the samples
+    QCPGraph *target = nullptr;
+    for (int i = 0; i < graphParams.count(); i++)
+    {
+        if (graphParams[i].ID != ID) continue;
+        if (!target || graphParams[i].ref == itemTracer->graph()) target = graphParams[i].ref;
+    }
+    if (target)
+    {
+        updatePlotData(); //the tracer reads the plot's points so they have to be the ones for the new range
+        itemTracer->setGraph(target);
+        itemTracer->setGraphKey(timestamp);
+        itemTracer->setVisible(true);
+        itemTracer->updatePosition();
+        locationText->setText("X: " + QString::number(timestamp, 'f', 3) + " Y: " + QString::number(itemTracer->position->value(), 'f', 3));
+    }
+
     ui->graphingView->replot();
 }
 
@@ -500,23 +675,50 @@ bool GraphingWindow::eventFilter(QObject *obj, QEvent *event)
     return false;
 }
 
-void GraphingWindow::resetView()
+//The plot only holds the points picked for what's on screen so the extents of everything have to come from the samples
+bool GraphingWindow::dataExtents(QCPRange &keys, QCPRange &values)
 {
     double yminval=10000000.0, ymaxval = -1000000.0;
     double xminval=100000000000, xmaxval = -10000000000.0;
+    bool found = false;
     for (int i = 0; i < graphParams.count(); i++)
     {
-        for (int j = 0; j < graphParams[i].x.count(); j++)
+        GraphParams &params = graphParams[i];
+        if (params.x.isEmpty()) continue;
+        found = true;
+        params.decimator.update(params.x, params.y);
+        //in time order the ends are the ends and the pyramid already knows the biggest and smallest values
+        if (params.decimator.isSorted())
+        {
+            int minIdx, maxIdx;
+            int first = firstKeptSample(params);
+            params.decimator.rangeMinMax(params.y, first, params.y.count(), minIdx, maxIdx);
+            if (params.x[first] < xminval) xminval = params.x[first];
+            if (params.x.last() > xmaxval) xmaxval = params.x.last();
+            if (params.y[minIdx] < yminval) yminval = params.y[minIdx];
+            if (params.y[maxIdx] > ymaxval) ymaxval = params.y[maxIdx];
+            continue;
+        }
+        for (int j = 0; j < params.x.count(); j++)
         {
-            if (graphParams[i].x[j] < xminval) xminval = graphParams[i].x[j];
-            if (graphParams[i].x[j] > xmaxval) xmaxval = graphParams[i].x[j];
-            if (graphParams[i].y[j] < yminval) yminval = graphParams[i].y[j];
-            if (graphParams[i].y[j] > ymaxval) ymaxval = graphParams[i].y[j];
+            if (params.x[j] < xminval) xminval = params.x[j];
+            if (params.x[j] > xmaxval) xmaxval = params.x[j];
+            if (params.y[j] < yminval) yminval = params.y[j];
+            if (params.y[j] > ymaxval) ymaxval = params.y[j];
         }
     }
+    keys = QCPRange(xminval, xmaxval);
+    values = QCPRange(yminval, ymaxval);
+    return found;
+}
 
-    ui->graphingView->xAxis->setRange(xminval, xmaxval);
-    ui->graphingView->yAxis->setRange(yminval, ymaxval);
+void GraphingWindow::resetView()
+{
+    QCPRange keys, values;
+    dataExtents(keys, values);
+
+    ui->graphingView->xAxis->setRange(keys);
+    ui->graphingView->yAxis->setRange(values);
     ui->graphingView->axisRect()->setupFullAxesBox();
 
     ui->graphingView->replot();
@@ -637,7 +839,10 @@ void GraphingWindow::removeAllGraphs()
 
 void GraphingWindow::rescaleAxis(QCPAxis *axis)
 {
-    axis->rescale(true);
+    QCPRange keys, values;
+    if (!dataExtents(keys, values)) return;
+    if (axis->orientation() == Qt::Horizontal) axis->setRange(keys);
+    else axis->setRange(values);
 }
 
 void GraphingWindow::rescaleToData()
@@ -674,6 +879,7 @@ void GraphingWindow::contextMenuRequest(QPoint pos)
     QAction *act = menu->addAction(tr("Follow end of graph"), this, SLOT(toggleFollowMode()));
     act->setCheckable(true);
     act->setChecked(followGraphEnd);
+    menu->addAction(tr("Set length of history kept"), this, SLOT(setHistoryLength()));
     menu->addAction(tr("Add new graph"), this, SLOT(addNewGraph()));
     if (ui->graphingView->selectedGraphs().size() > 0)
     {
@@ -1219,6 +1425,7 @@ void GraphingWindow::showParamsDialog(int idx = -1)
     {
         if (idx > -1) //if there was an existing graph then delete it
         {
+            clearGraphData(graphParams[idx]);
             graphParams.removeAt(idx);
             ui->graphingView->removeGraph(idx);
         }
@@ -1235,33 +1442,25 @@ void GraphingWindow::addNewGraph()
     showParamsDialog(-1);
 }
 
-void GraphingWindow::appendToGraph(GraphParams &params, CANFrame &frame, QVector<double> &x, QVector<double> &y)
+void GraphingWindow::appendToGraph(GraphParams &params, const CANFrame &frame)
+{
+    int64_t tempVal; //64 bit temp value.
+    tempVal = Utility::processIntegerSignal(frame.payload(), params.startBit, params.numBits, params.intelFormat, params.isSigned); //& params.mask;
+    appendSample(params, frame.timeStamp().microSeconds(), tempVal);
+}
+
+//tempVal is the raw signal value, timeStamp in microseconds like the frames have it
+void GraphingWindow::appendSample(GraphParams &params, int64_t timeStamp, int64_t tempVal)
 {
     params.strideSoFar++;
     if (params.strideSoFar >= params.stride)
     {
         params.strideSoFar = 0;
-        int64_t tempVal; //64 bit temp value.
-        tempVal = Utility::processIntegerSignal(frame.payload(), params.startBit, params.numBits, params.intelFormat, params.isSigned); //& params.mask;
         double xVal, yVal;
-        if (Utility::timeStyle == TS_SECONDS)
-        {
-            xVal = ((double)(frame.timeStamp().microSeconds()) / 1000000.0 - params.xbias);
-        }
-        else if (Utility::timeStyle == TS_CLOCK)
-        {
-            QDateTime dt = QDateTime::fromMSecsSinceEpoch((frame.timeStamp().microSeconds() / 1000) - params.xbias);
-            xVal = (dt.time().second() + dt.time().minute() * 60 + dt.time().hour() * 3600);
-        }
-        else
-        {
-            xVal = (frame.timeStamp().microSeconds() - params.xbias);
-        }
+        xVal = timeToKey(timeStamp);
         yVal = (tempVal * params.scale) + params.bias;
         params.x.append(xVal);
         params.y.append(yVal);
-        x.append(xVal);
-        y.append(yVal);
 
         //now see if we've got to do anything with the brackets and labels for value table stuff
         QString tempStr;
@@ -1313,44 +1512,75 @@ void GraphingWindow::appendToGraph(GraphParams &params, CANFrame &frame, QVector
     }
 }
 
-void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
+/*
+ * Fills in the samples and value table brackets for a graph from everything in the frame list. Used when a graph is
+ * first set up and when the whole frame list gets replaced. From then on new frames are added by appendFrames.
+*/
+void GraphingWindow::loadGraphData(GraphParams &params, double &xminval, double &xmaxval, double &yminval, double &ymaxval)
 {
     int64_t tempVal; //64 bit temp value.
-    double yminval=10000000.0, ymaxval = -1000000.0;
-    double xminval=10000000000.0, xmaxval = -10000000000.0;
-    GraphParams *refParam = &params;
     QString tempStr;
     double x{}, y{};
-
-    qDebug() << "New Graph ID: " << params.ID;
-    qDebug() << "Start bit: " << params.startBit;
-    qDebug() << "Data length: " << params.numBits;
-    qDebug() << "Intel Mode: " << params.intelFormat;
-    qDebug() << "Signed: " << params.isSigned;
-    qDebug() << "Mask: " << params.mask;
-
-    frameCache.clear();
-    for (int i = 0; i < modelFrames->count(); i++)
+    yminval=10000000.0;
+    ymaxval = -1000000.0;
+    xminval=10000000000.0;
+    xmaxval = -10000000000.0;
+
+    //Graphs of a DBC signal can get their values from the shared signal cache so a signal that some other window
+    //already decoded doesn't get decoded all over again. That only works as long as the graph still pulls the same
+    //bits out of the frame as the signal does. Scale and bias are applied down below so those are free to differ.
+    DBCSignalSeries series;
+    bool useSeries = false;
+    params.seriesSamples = -1;
+    params.seriesLastTime = std::numeric_limits<int64_t>::min();
+    if (matchesSignalSeries(params))
     {
-        CANFrame thisFrame = modelFrames->at(i);
-        if ( (thisFrame.frameId() == params.ID) && (thisFrame.frameType() == QCanBusFrame::DataFrame)
-       &&  ( ( params.bus == -1) ||  (params.bus == thisFrame.bus) ) ) frameCache.append(thisFrame);
+        series = DBCSignalCache::getReference()->getSeries(params.associatedSignal, params.bus, modelFrames);
+        useSeries = (series.count() > 0);
+        params.seriesSamples = series.count(); //new frames get picked up from here on
+        if (series.count() > 0) params.seriesLastTime = series.times.last();
     }
 
-    //to fix weirdness where a graph that has no data won't be able to be edited, selected, or deleted properly
-    //we'll check for the condition that there is nothing to graph and add a single dummy frame to the cache
-    //that has all data bytes = 0. This allows the graph to be edited and deleted. No idea why you can't otherwise.
-    if (frameCache.count() == 0)
+    //rows for the ID come straight out of the model's index instead of copying its frames
+    CANFrameRows frameRows;
+    QVector<CANFrame> dummyFrames;
+    if (!useSeries)
     {
-        CANFrame dummy;
-        dummy.setFrameId(params.ID);
-        dummy.bus = 0;
-        dummy.setPayload(QByteArray(8, 0));
-        dummy.setFrameType(QCanBusFrame::DataFrame);
-        frameCache.append(dummy);
+        QVector<int> rows;
+        const CANFrameIndex *index = MainWindow::getReference()->getCANFrameModel()->getFrameIndex(modelFrames);
+        if (index)
+        {
+            if (params.bus == -1) rows = index->rowsMatching(params.ID, params.ID, -1);
+            else rows = index->rowsFor(params.ID, params.bus);
+        }
+
+        //only data frames get graphed. There almost never are any others so only touch the rows if one turns up
+        int dataRows = 0;
+        for (int i = 0; i < rows.count(); i++)
+        {
+            if (modelFrames->at(rows[i]).frameType() != QCanBusFrame::DataFrame) continue;
+            if (dataRows != i) rows[dataRows] = rows[i];
+            dataRows++;
+        }
+        if (dataRows < rows.count()) rows.resize(dataRows);
+        frameRows = CANFrameRows(modelFrames, rows);
+
+        //to fix weirdness where a graph that has no data won't be able to be edited, selected, or deleted properly
+        //we'll check for the condition that there is nothing to graph and add a single dummy frame to the cache
+        //that has all data bytes = 0. This allows the graph to be edited and deleted. No idea why you can't otherwise.
+        if (frameRows.count() == 0)
+        {
+            CANFrame dummy;
+            dummy.setFrameId(params.ID);
+            dummy.bus = 0;
+            dummy.setPayload(QByteArray(8, 0));
+            dummy.setFrameType(QCanBusFrame::DataFrame);
+            dummyFrames.append(dummy);
+            frameRows = CANFrameRows(&dummyFrames, QVector<int>(1, 0));
+        }
     }
 
-    int numEntries = frameCache.count() / params.stride;
+    int numEntries = (useSeries ? series.count() : frameRows.count()) / params.stride;
     if (numEntries < 1) numEntries = 1; //could happen if stride is larger than frame count
 
     params.x.clear();
@@ -1368,35 +1598,32 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
     for (int j = 0; j < numEntries; j++)
     {
         int k = j * params.stride;
-        if (params.associatedSignal)
+        int64_t timeStamp;
+        if (useSeries) //the cache only holds frames the signal was actually in so no need to check that here
         {
-            //skip all the rest of the stuff in this loop and don't add this to the graph if this signal isn't in this frame
-            if (!params.associatedSignal->isSignalInMessage(frameCache[k]))
+            tempVal = series.rawValues[k];
+            timeStamp = series.times[k];
+        }
+        else
+        {
+            if (params.associatedSignal)
             {
-                qDebug() << "Signal was not in this frame";
-                continue;
+                //skip all the rest of the stuff in this loop and don't add this to the graph if this signal isn't in this frame
+                if (!params.associatedSignal->isSignalInMessage(frameRows[k]))
+                {
+                    qDebug() << "Signal was not in this frame";
+                    continue;
+                }
+                else qDebug() << "Signal in the frame!";
             }
-            else qDebug() << "Signal in the frame!";
+            tempVal = Utility::processIntegerSignal(frameRows[k].payload(), sBit, bits, intelFormat, isSigned); //& params.mask;
+            timeStamp = frameRows[k].timeStamp().microSeconds();
         }
-        tempVal = Utility::processIntegerSignal(frameCache[k].payload(), sBit, bits, intelFormat, isSigned); //& params.mask;
         //qDebug() << tempVal;
         y = (tempVal * params.scale) + params.bias;
         params.y.append( y );
 
-        if (Utility::timeStyle == TS_SECONDS)
-        {
-            x = (frameCache[k].timeStamp().microSeconds()) / 1000000.0;
-        }
-        else if (Utility::timeStyle == TS_CLOCK)
-        {
-            QDateTime dt = QDateTime::fromMSecsSinceEpoch((frameCache[k].timeStamp().microSeconds() / 1000) - params.xbias);
-            x = (dt.time().msecsSinceStartOfDay() / 1000.0);
-        }
-        else
-        {
-            x = frameCache[k].timeStamp().microSeconds();
-        }
-
+        x = timeToKey(timeStamp);
         params.x.append( x );
 
         if (params.associatedSignal && numEntries > 1)
@@ -1462,6 +1689,8 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
         valueText->setPositionAlignment(Qt::AlignBottom|Qt::AlignHCenter);
         valueText->setText(params.prevValStr);
         valueText->setFont(QFont(font().family(), 10));
+        params.brackets.append(bracket);
+        params.bracketTexts.append(valueText);
         params.prevValLocation = QPointF(x, y);
         params.prevValStr = tempStr;
         params.prevValTable = tempVal;
@@ -1477,6 +1706,21 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
     }
 
     params.xbias = 0;
+}
+
+void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
+{
+    double yminval, ymaxval, xminval, xmaxval;
+    GraphParams *refParam = &params;
+
+    qDebug() << "New Graph ID: " << params.ID;
+    qDebug() << "Start bit: " << params.startBit;
+    qDebug() << "Data length: " << params.numBits;
+    qDebug() << "Intel Mode: " << params.intelFormat;
+    qDebug() << "Signed: " << params.isSigned;
+    qDebug() << "Mask: " << params.mask;
+
+    loadGraphData(params, xminval, xmaxval, yminval, ymaxval);
 
     ui->graphingView->addGraph();
     params.ref = ui->graphingView->graph();
@@ -1499,7 +1743,10 @@ void GraphingWindow::createGraph(GraphParams &params, bool createGraphParam)
     ui->graphingView->graph()->setName(params.graphName);
     ui->graphingView->graph()->setProperty("id", params.ID);
 
-    ui->graphingView->graph()->setData(refParam->x,refParam->y);
+    //the samples go to the plot through updatePlotData on the replot below
+    refParam->decimator.clear();
+    refParam->shownCount = -1;
+    ageGraphData(*refParam);
 
     ui->graphingView->graph()->setScatterStyle(QCPScatterStyle((QCPScatterStyle::ScatterShape)params.pointType));
 
@@ -1591,4 +1838,8 @@ GraphParams::GraphParams()
     prevValLocation = QPointF(0,0);
     prevValStr = "";
     lastBracket = nullptr;
+    seriesSamples = -1;
+    seriesLastTime = std::numeric_limits<int64_t>::min();
+    shownWidth = -1;
+    shownCount = -1;
 }
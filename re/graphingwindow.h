@@ -4,6 +4,7 @@
 #include "qcustomplot.h"
 #include "can_structs.h"
 #include "dbc/dbchandler.h"
+#include "graphdecimator.h"
 
 #include <QDialog>
 
@@ -44,6 +45,12 @@ public:
     QCPItemBracket *lastBracket;
     QList<QCPItemBracket *> brackets;
     QList<QCPItemText *> bracketTexts;
+    int seriesSamples;      //samples taken from the shared DBC signal series, -1 if the graph decodes frames itself
+    int64_t seriesLastTime; //timestamp of the last of them, to find the place again if the series gets rebuilt
+    GraphDecimator decimator;
+    QCPRange shownRange;    //what the points last handed to the plot were picked for
+    int shownWidth;
+    int shownCount;
 };
 
 class GraphingWindow : public QDialog
@@ -79,10 +86,13 @@ private slots:
     void rescaleAxis(QCPAxis* axis);
     void rescaleToData();
     void toggleFollowMode();
+    void setHistoryLength();
     void addNewGraph();    
-    void appendToGraph(GraphParams &params, CANFrame &frame, QVector<double> &x, QVector<double> &y);
+    void appendToGraph(GraphParams &params, const CANFrame &frame);
+    void appendSample(GraphParams &params, int64_t timeStamp, int64_t tempVal);
     void editSelectedGraph();
     void updatedFrames(int);
+    void updatePlotData();
     void gotCenterTimeID(uint32_t ID, double timestamp);
     void resetView();
     void zoomIn();
@@ -94,7 +104,6 @@ signals:
 private:
     Ui::GraphingWindow *ui;
     DBCHandler *dbcHandler;
-    QList<CANFrame> frameCache;
     const QVector<CANFrame> *modelFrames;
     QList<GraphParams> graphParams;
     QPen selectedPen;
@@ -104,8 +113,17 @@ private:
     bool needScaleSetup; //do we need to set x,y graphing extents?
     bool useOpenGL;
     bool followGraphEnd;
+    double historySeconds; //how much of a graph to keep, 0 for all of it
 
     void showParamsDialog(int idx);
+    bool dataExtents(QCPRange &keys, QCPRange &values);
+    void loadGraphData(GraphParams &params, double &xminval, double &xmaxval, double &yminval, double &ymaxval);
+    void clearGraphData(GraphParams &params);
+    bool appendFrames(int firstRow);
+    void ageGraphData(GraphParams &params);
+    int firstKeptSample(const GraphParams &params) const;
+    bool matchesSignalSeries(const GraphParams &params) const;
+    double timeToKey(int64_t timeStamp) const;
     void closeEvent(QCloseEvent *event);
     void readSettings();
     void writeSettings();
@@ -0,0 +1,100 @@
+#include "rangesignalfinder.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+RangeSignalFinder::RangeSignalFinder(CANFrameModel *model, QObject *parent) : QObject(parent)
+{
+    this->model = model;
+    serial = 0;
+    running = false;
+
+    qRegisterMetaType<QVector<RangeSignalCandidate>>("QVector<RangeSignalCandidate>");
+    connect(this, &RangeSignalFinder::partialResults, this, &RangeSignalFinder::gotPartialResults, Qt::QueuedConnection);
+    connect(this, &RangeSignalFinder::searchDone, this, &RangeSignalFinder::gotSearchDone, Qt::QueuedConnection);
+}
+
+RangeSignalFinder::~RangeSignalFinder()
+{
+    cancel();
+}
+
+void RangeSignalFinder::start(const QVector<uint32_t> &newIDs, const RangeSignalSettings &newSettings)
+{
+    cancel();
+
+    ids = newIDs;
+    settings = newSettings;
+    settings.maxSize = qMin(settings.maxSize, RANGE_SIGNAL_MAX_BITS);
+    settings.granularity = qMax(1, settings.granularity);
+    snapshot = model->snapshotFrameIndex(index);
+
+    serial++;
+    running = true;
+    cancelFlag.storeRelease(0);
+    int searchSerial = serial;
+    emit progress(0, ids.count());
+    future = QtConcurrent::run([this, searchSerial]() { runSearch(searchSerial); });
+}
+
+void RangeSignalFinder::cancel()
+{
+    cancelFlag.storeRelease(1);
+    future.waitForFinished();
+    running = false;
+}
+
+bool RangeSignalFinder::isRunning() const
+{
+    return running;
+}
+
+//runs on a worker thread. One ID at a time, biggest signals first like the window always did them
+void RangeSignalFinder::runSearch(int searchSerial)
+{
+    for (int i = 0; i < ids.count(); i++)
+    {
+        QVector<int> rows = index.rowsMatching(ids[i], ids[i], -1);
+        if (rows.isEmpty())
+        {
+            emit partialResults(searchSerial, QVector<RangeSignalCandidate>(), i + 1);
+            continue;
+        }
+
+        QVector<CANFrame> frames;
+        if (!model->copyFrames(snapshot, rows, frames))
+        {
+            //frames got cleared or rewritten so the rows don't point at the same frames any longer
+            emit searchDone(searchSerial, false);
+            return;
+        }
+        RangeSignalMatrix matrix;
+        matrix.build(ids[i], frames);
+
+        for (int sigSize = settings.maxSize; sigSize >= settings.minSize; sigSize -= settings.granularity)
+        {
+            if (cancelFlag.loadAcquire())
+            {
+                emit searchDone(searchSerial, false);
+                return;
+            }
+            QVector<RangeSignalCandidate> found = matrix.findCandidates(settings, sigSize, &cancelFlag);
+            if (!found.isEmpty()) emit partialResults(searchSerial, found, i);
+        }
+        emit partialResults(searchSerial, QVector<RangeSignalCandidate>(), i + 1);
+    }
+    emit searchDone(searchSerial, !cancelFlag.loadAcquire());
+}
+
+void RangeSignalFinder::gotPartialResults(int searchSerial, QVector<RangeSignalCandidate> candidates, int idsDone)
+{
+    if (searchSerial != serial) return; //left over from a search that's been replaced
+    if (!candidates.isEmpty()) emit candidatesFound(candidates);
+    emit progress(idsDone, ids.count());
+}
+
+void RangeSignalFinder::gotSearchDone(int searchSerial, bool completed)
+{
+    if (searchSerial != serial) return;
+    running = false;
+    emit searchFinished(completed);
+}
@@ -0,0 +1,57 @@
+#ifndef RANGESIGNALFINDER_H
+#define RANGESIGNALFINDER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QAtomicInt>
+#include <QVector>
+#include "canframeindex.h"
+#include "canframemodel.h"
+#include "rangesignalmatrix.h"
+
+/*
+ * Runs the range state signal search in the background over the model's full frame list.
+ *
+ * IDs are done one at a time. Each one's frames get packed into a RangeSignalMatrix once (with the model locked only
+ * for that) and then every candidate of each size is checked across the thread pool. Whatever a size turns up is sent
+ * back ranked as soon as that size is done so the list fills in while the search is still going. cancel() stops it
+ * within one size of one ID.
+*/
+class RangeSignalFinder : public QObject
+{
+    Q_OBJECT
+
+public:
+    RangeSignalFinder(CANFrameModel *model, QObject *parent = nullptr);
+    ~RangeSignalFinder();
+    void start(const QVector<uint32_t> &ids, const RangeSignalSettings &settings);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void candidatesFound(QVector<RangeSignalCandidate> candidates);
+    void progress(int idsDone, int idsTotal);
+    void searchFinished(bool completed);
+    //used internally to get results from the search thread back to the GUI thread
+    void partialResults(int serial, QVector<RangeSignalCandidate> candidates, int idsDone);
+    void searchDone(int serial, bool completed);
+
+private slots:
+    void gotPartialResults(int serial, QVector<RangeSignalCandidate> candidates, int idsDone);
+    void gotSearchDone(int serial, bool completed);
+
+private:
+    CANFrameModel *model;
+    CANFrameIndex index;
+    CANFrameSnapshot snapshot;
+    QVector<uint32_t> ids;
+    RangeSignalSettings settings;
+    QFuture<void> future;
+    QAtomicInt cancelFlag;
+    int serial;
+    bool running;
+
+    void runSearch(int searchSerial);
+};
+
+#endif // RANGESIGNALFINDER_H
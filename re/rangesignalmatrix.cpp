@@ -0,0 +1,296 @@
+#include "rangesignalmatrix.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <vector>
+#include "utility.h"
+
+//one start bit and byte order at one signal size. Whatever it turns up goes in found
+struct RangeSignalTask
+{
+    int startBit;
+    bool bigEndian;
+    QVector<RangeSignalCandidate> found;
+};
+
+QString RangeSignalCandidate::describe() const
+{
+    QString temp = "ID: " + QString::number(id, 16) + " startBit: " + QString::number(startBit) + "  len: " + QString::number(bitLength);
+    temp += isSigned ? " Signed" : " Unsigned";
+    temp += bigEndian ? " BigEndian" : " LittleEndian";
+    return temp;
+}
+
+//best first. Ties go to the lower ID and start bit so the order never depends on which thread finished first
+bool RangeSignalCandidate::ranksAbove(const RangeSignalCandidate &other) const
+{
+    if (score != other.score) return score > other.score;
+    if (id != other.id) return id < other.id;
+    if (startBit != other.startBit) return startBit < other.startBit;
+    if (bigEndian != other.bigEndian) return bigEndian;
+    return isSigned && !other.isSigned;
+}
+
+RangeSignalMatrix::RangeSignalMatrix()
+{
+    id = 0;
+    count = 0;
+    words = 0;
+    firstLength = 0;
+    sameLength = true;
+}
+
+//frames[rows[i]] for every row. rows is usually a posting list out of CANFrameIndex
+void RangeSignalMatrix::build(uint32_t frameID, const CANFrame *frames, const QVector<int> &rows)
+{
+    id = frameID;
+    count = rows.count();
+    int maxLength = 0;
+    for (int i = 0; i < count; i++) maxLength = qMax(maxLength, static_cast<int>(frames[rows[i]].payload().length()));
+    words = (qMin(maxLength, 64) + 7) / 8;
+
+    little.fill(0, count * words);
+    big.fill(0, count * words);
+    lengths.resize(count);
+    for (int i = 0; i < count; i++) addFrame(i, frames[rows[i]]);
+    finish();
+}
+
+//every frame in the list, which should all be the one ID already
+void RangeSignalMatrix::build(uint32_t frameID, const QVector<CANFrame> &frames)
+{
+    QVector<int> rows(frames.count());
+    for (int i = 0; i < rows.count(); i++) rows[i] = i;
+    build(frameID, frames.constData(), rows);
+}
+
+void RangeSignalMatrix::addFrame(int frameNum, const CANFrame &frame)
+{
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
+    int len = qMin(static_cast<int>(frame.payload().length()), words * 8);
+    uint64_t *le = little.data() + frameNum * words;
+    uint64_t *be = big.data() + frameNum * words;
+    for (int b = 0; b < len; b++)
+    {
+        le[b / 8] |= static_cast<uint64_t>(data[b]) << ((b % 8) * 8);
+        be[b / 8] |= static_cast<uint64_t>(data[b]) << ((7 - (b % 8)) * 8);
+    }
+    lengths[frameNum] = static_cast<uint8_t>(len);
+}
+
+void RangeSignalMatrix::finish()
+{
+    changedLittle.fill(0, words);
+    changedBig.fill(0, words);
+    firstLength = (count > 0) ? lengths[0] : 0;
+    sameLength = true;
+
+    for (int i = 1; i < count; i++)
+    {
+        if (lengths[i] != lengths[0]) sameLength = false;
+        const uint64_t *le = little.constData() + i * words;
+        const uint64_t *be = big.constData() + i * words;
+        for (int w = 0; w < words; w++)
+        {
+            changedLittle[w] |= le[w] ^ le[w - words];
+            changedBig[w] |= be[w] ^ be[w - words];
+        }
+    }
+}
+
+uint32_t RangeSignalMatrix::getID() const
+{
+    return id;
+}
+
+int RangeSignalMatrix::frameCount() const
+{
+    return count;
+}
+
+//start bits from 0 up to this get tried
+int RangeSignalMatrix::searchBits() const
+{
+    return firstLength * 8;
+}
+
+/*
+ * Little endian bits count up from bit 0 of byte 0 so they're just a run of bits in the little endian words.
+ * Big endian signals start at their most significant bit and work down through a byte and then on to the top of the
+ * next byte. Numbering the bits from the top of byte 0 instead turns that into a plain run too, in the big endian words.
+*/
+uint64_t RangeSignalMatrix::readBits(const uint64_t *frameWords, int numWords, int startBit, int bitLength, bool bigEndian)
+{
+    uint64_t val;
+    if (!bigEndian)
+    {
+        int w = startBit / 64;
+        int off = startBit % 64;
+        if (w >= numWords) return 0;
+        val = frameWords[w] >> off;
+        if (off + bitLength > 64 && w + 1 < numWords) val |= frameWords[w + 1] << (64 - off);
+        if (bitLength < 64) val &= (1ULL << bitLength) - 1;
+        return val;
+    }
+
+    int pos = (startBit / 8) * 8 + (7 - (startBit % 8));
+    int w = pos / 64;
+    int off = pos % 64;
+    if (w >= numWords) return 0;
+    val = frameWords[w] << off;
+    if (off > 0 && w + 1 < numWords) val |= frameWords[w + 1] >> (64 - off);
+    return val >> (64 - bitLength);
+}
+
+bool RangeSignalMatrix::isConstant(int startBit, int bitLength, bool bigEndian) const
+{
+    if (count < 2) return true;
+    if (!sameLength) return false; //frames that are too short read as 0 so there's no telling from the bits alone
+    return readBits(bigEndian ? changedBig.constData() : changedLittle.constData(), words, startBit, bitLength, bigEndian) == 0;
+}
+
+//raw (not sign extended) value of the signal in every frame. out has to have room for frameCount() values
+void RangeSignalMatrix::extract(int startBit, int bitLength, bool bigEndian, uint64_t *out) const
+{
+    //processIntegerSignal gives up and returns 0 for frames that don't have every byte the signal touches.
+    //Bits past the end of a 64 byte frame are the exception, those just read as 0
+    int lastBit = bigEndian ? (startBit / 8) * 8 + (7 - (startBit % 8)) + bitLength - 1 : startBit + bitLength - 1;
+    int needed = qMax((startBit + bitLength) / 8, qMin(lastBit, 511) / 8 + 1);
+
+    const uint64_t *source = bigEndian ? big.constData() : little.constData();
+    const uint8_t *len = lengths.constData();
+    for (int i = 0; i < count; i++)
+    {
+        if (len[i] < needed) out[i] = 0;
+        else out[i] = readBits(source + i * words, words, startBit, bitLength, bigEndian);
+    }
+}
+
+/*
+ * The range state test on one set of raw values. Same checks the window has always done: the signal has to cover
+ * enough of its possible range and not jump around too much from one frame to the next (first order) or change
+ * direction too hard (second order). Sensitivity slides all of those limits between loose and strict.
+ * Done in two passes over the values instead of building up the difference lists, and it quits as soon as
+ * either limit is blown.
+*/
+bool RangeSignalMatrix::evaluate(const uint64_t *raw, int count, int bitLength, bool isSigned, int sensitivity, double *score)
+{
+    if (count < 2 || bitLength < 1 || bitLength > RANGE_SIGNAL_MAX_BITS) return false;
+
+    uint64_t signBit = 1ULL << (bitLength - 1);
+    uint64_t extend = ~((1ULL << bitLength) - 1);
+    auto value = [&](int i) -> int64_t
+    {
+        uint64_t v = raw[i];
+        if (isSigned && (v & signBit)) v |= extend;
+        return static_cast<int64_t>(v);
+    };
+
+    int64_t lowestValue = value(0);
+    int64_t highestValue = lowestValue;
+    for (int i = 1; i < count; i++)
+    {
+        int64_t v = value(i);
+        if (v < lowestValue) lowestValue = v;
+        if (v > highestValue) highestValue = v;
+    }
+    if (lowestValue == highestValue) return false; //a signal that never changes is worthless and not a range signal
+
+    double lerpPoint = (static_cast<double>(sensitivity) - 10.0) / 240.0;
+    int64_t range = highestValue - lowestValue;
+    int64_t maxRange = isSigned ? (1LL << (bitLength - 1)) : (1LL << bitLength);
+    //at highest sensitivity require signal to at least range 20% of max range
+    //at lowest  sensitivity require signal to at least range 1%  of max range
+    int64_t requiredRange = static_cast<int64_t>(Utility::Lerp(maxRange * 0.01, maxRange * 0.2, lerpPoint));
+    if (range < requiredRange) return false;
+
+    int64_t firstLimit = static_cast<int64_t>(Utility::Lerp(static_cast<double>(range) * 0.55, 0, lerpPoint));
+    int maxFirstOvers = static_cast<int>(Utility::Lerp(count / 30.0, 2, lerpPoint));
+    //really clamp down on second order over limits. There shouldn't be hard acceleration in values for a ranging signal
+    int64_t secondLimit = static_cast<int64_t>(Utility::Lerp(static_cast<double>(range) * 0.20, 1, lerpPoint));
+    int maxSecondOvers = static_cast<int>(Utility::Lerp(8, 2, lerpPoint));
+
+    int firstOvers = 0;
+    int secondOvers = 0;
+    int64_t prev = value(0);
+    int64_t prevDiff = 0;
+    for (int i = 1; i < count; i++)
+    {
+        int64_t v = value(i);
+        int64_t diff = prev - v;
+        if (qAbs(diff) > firstLimit && ++firstOvers > maxFirstOvers) return false;
+        if (i > 1 && qAbs(prevDiff - diff) > secondLimit && ++secondOvers > maxSecondOvers) return false;
+        prevDiff = diff;
+        prev = v;
+    }
+
+    if (score) *score = bitLength + 1.0 / (2.0 + firstOvers + secondOvers);
+    return true;
+}
+
+void RangeSignalMatrix::sortCandidates(QVector<RangeSignalCandidate> &candidates)
+{
+    std::sort(candidates.begin(), candidates.end(),
+              [](const RangeSignalCandidate &a, const RangeSignalCandidate &b) { return a.ranksAbove(b); });
+}
+
+/*
+ * Every candidate of one size the settings ask for, checked in parallel. Each start bit and byte order pulls its raw
+ * values out once and the signed and unsigned readings are both tested from those. Comes back ranked.
+ * Setting cancelFlag makes the remaining checks return right away.
+*/
+QVector<RangeSignalCandidate> RangeSignalMatrix::findCandidates(const RangeSignalSettings &settings, int bitLength, const QAtomicInt *cancelFlag) const
+{
+    QVector<RangeSignalCandidate> out;
+    if (bitLength < 1 || bitLength > RANGE_SIGNAL_MAX_BITS || count < 2) return out;
+
+    QVector<RangeSignalTask> tasks;
+    int granularity = qMax(1, settings.granularity);
+    for (int startBit = 0; startBit < searchBits(); startBit += granularity)
+    {
+        for (int order = 0; order < 2; order++)
+        {
+            bool bigEndian = (order == 0);
+            if (bigEndian && !settings.tryBigEndian) continue;
+            if (!bigEndian && !settings.tryLittleEndian) continue;
+            if (isConstant(startBit, bitLength, bigEndian)) continue;
+            RangeSignalTask task;
+            task.startBit = startBit;
+            task.bigEndian = bigEndian;
+            tasks.append(task);
+        }
+    }
+    if (tasks.isEmpty()) return out;
+
+    QtConcurrent::blockingMap(tasks, [&](RangeSignalTask &task)
+    {
+        if (cancelFlag && cancelFlag->loadAcquire()) return;
+
+        //pool threads keep their buffer between tasks so it's only allocated once per thread
+        static thread_local std::vector<uint64_t> raw;
+        raw.resize(static_cast<size_t>(count));
+        extract(task.startBit, bitLength, task.bigEndian, raw.data());
+
+        for (int s = 0; s < 2; s++)
+        {
+            bool isSigned = (s == 0);
+            if (isSigned && !settings.trySigned) continue;
+            if (!isSigned && !settings.tryUnsigned) continue;
+            double score;
+            if (!evaluate(raw.data(), count, bitLength, isSigned, settings.sensitivity, &score)) continue;
+
+            RangeSignalCandidate candidate;
+            candidate.id = id;
+            candidate.startBit = task.startBit;
+            candidate.bitLength = bitLength;
+            candidate.isSigned = isSigned;
+            candidate.bigEndian = task.bigEndian;
+            candidate.score = score;
+            task.found.append(candidate);
+        }
+    });
+
+    for (int i = 0; i < tasks.count(); i++) out.append(tasks[i].found);
+    sortCandidates(out);
+    return out;
+}
@@ -0,0 +1,87 @@
+#ifndef RANGESIGNALMATRIX_H
+#define RANGESIGNALMATRIX_H
+
+#include <QAtomicInt>
+#include <QString>
+#include <QVector>
+#include "can_structs.h"
+
+//biggest signal the range search will look for. Keeps every value inside an int64 with room to spare for the diffs
+#define RANGE_SIGNAL_MAX_BITS   32
+
+//a stretch of bits in one ID that moves around like a range signal would
+class RangeSignalCandidate
+{
+public:
+    RangeSignalCandidate() : id(0), startBit(0), bitLength(0), isSigned(false), bigEndian(false), score(0.0) {}
+    QString describe() const;
+    bool ranksAbove(const RangeSignalCandidate &other) const;
+
+    uint32_t id;
+    int startBit;
+    int bitLength;
+    bool isSigned;
+    bool bigEndian;
+    double score; //the bit length plus up to 0.5 for how smooth it was. Bigger is better
+};
+
+//what to search for, straight off the range state window
+class RangeSignalSettings
+{
+public:
+    RangeSignalSettings() : minSize(8), maxSize(16), granularity(1), sensitivity(130),
+        tryBigEndian(true), tryLittleEndian(true), trySigned(true), tryUnsigned(true) {}
+
+    int minSize;
+    int maxSize;
+    int granularity;
+    int sensitivity; //10 to 250 like the slider
+    bool tryBigEndian;
+    bool tryLittleEndian;
+    bool trySigned;
+    bool tryUnsigned;
+};
+
+/*
+ * The payloads of every frame of one ID packed into 64 bit words, once in little endian bit order and once in big
+ * endian (Motorola) order. Any candidate signal comes out of either with a shift and a mask instead of
+ * processIntegerSignal going bit by bit. It also keeps which bits ever changed from one frame to the next so candidates
+ * that sit entirely on bits that never move can be thrown out without looking at a single frame.
+ *
+ * Values come out exactly as Utility::processIntegerSignal would give them, including 0 for frames too short
+ * to hold the whole signal.
+*/
+class RangeSignalMatrix
+{
+public:
+    RangeSignalMatrix();
+    void build(uint32_t frameID, const CANFrame *frames, const QVector<int> &rows);
+    void build(uint32_t frameID, const QVector<CANFrame> &frames);
+    uint32_t getID() const;
+    int frameCount() const;
+    int searchBits() const;
+    bool isConstant(int startBit, int bitLength, bool bigEndian) const;
+    void extract(int startBit, int bitLength, bool bigEndian, uint64_t *out) const;
+
+    QVector<RangeSignalCandidate> findCandidates(const RangeSignalSettings &settings, int bitLength, const QAtomicInt *cancelFlag = nullptr) const;
+    static bool evaluate(const uint64_t *raw, int count, int bitLength, bool isSigned, int sensitivity, double *score);
+    static void sortCandidates(QVector<RangeSignalCandidate> &candidates);
+
+private:
+    void addFrame(int frameNum, const CANFrame &frame);
+    void finish();
+    static uint64_t readBits(const uint64_t *words, int numWords, int startBit, int bitLength, bool bigEndian);
+
+    uint32_t id;
+    int count;
+    int words;              //64 bit words per frame, enough for the longest payload
+    int firstLength;        //payload length of the first frame. Sets how far the search goes like it always has
+    bool sameLength;        //every frame is the same length so the changed bits say everything about the values
+    QVector<uint64_t> little;
+    QVector<uint64_t> big;
+    QVector<uint8_t> lengths;
+    QVector<uint64_t> changedLittle;
+    QVector<uint64_t> changedBig;
+};
+
+#endif // RANGESIGNALMATRIX_H
@@ -1,10 +1,13 @@
 #include "rangestatewindow.h"
 #include "ui_rangestatewindow.h"
 #include "mainwindow.h"
+#include "guirefreshscheduler.h"
 #include "utility.h"
 #include "helpwindow.h"
 #include "filterutility.h"
 
+#include <algorithm>
+
 RangeStateWindow::RangeStateWindow(const QVector<CANFrame> *frames, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::RangeStateWindow)
@@ -74,13 +77,19 @@ RangeStateWindow::RangeStateWindow(const QVector<CANFrame> *frames, QWidget *par
                 idFilters[id] = isChecked;
             });
 
+    finder = new RangeSignalFinder(MainWindow::getReference()->getCANFrameModel(), this);
+    connect(finder, &RangeSignalFinder::candidatesFound, this, &RangeStateWindow::gotCandidates);
+    connect(finder, &RangeSignalFinder::progress, this, &RangeStateWindow::searchProgress);
+    connect(finder, &RangeSignalFinder::searchFinished, this, &RangeStateWindow::searchFinished);
+
     connect(ui->btnRecalc, &QAbstractButton::clicked, this, &RangeStateWindow::recalcButton);
-    connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    GUIRefreshScheduler::getReference()->addWindow(this, &RangeStateWindow::updatedFrames, REFRESH_LOW, 1000);
     connect(ui->listCandidates, &QListWidget::currentRowChanged, this, &RangeStateWindow::clickedSignalList);
 }
 
 RangeStateWindow::~RangeStateWindow()
 {
+    finder->cancel();
     delete ui;
 }
 
@@ -98,6 +107,7 @@ void RangeStateWindow::showEvent(QShowEvent* event)
 void RangeStateWindow::closeEvent(QCloseEvent *event)
 {
     Q_UNUSED(event);
+    finder->cancel();
     removeEventFilter(this);
     writeSettings();
 }
@@ -146,11 +156,13 @@ void RangeStateWindow::updatedFrames(int numFrames)
     CANFrame thisFrame;
     if (numFrames == -1) //all frames deleted. We don't need to do a thing on this window but erase everything in the filters section
     {
+        finder->cancel(); //whatever it was looking at is gone
         ui->listFilter->clear();
         idFilters.clear();
     }
     else if (numFrames == -2) //all new set of frames. Reset
     {
+        finder->cancel();
         refreshFilterList();
     }
     else //just got some new frames. See if we need to update the filters list. Otherwise nothing to do - no recalc happens until the button is pressed
@@ -170,226 +182,81 @@ void RangeStateWindow::updatedFrames(int numFrames)
 
 void RangeStateWindow::refreshFilterList()
 {
-    int id;
-
     idFilters.clear();
     ui->listFilter->clear();
 
-    for (int i = 0; i < modelFrames->length(); i++)
+    const CANFrameIndex *index = MainWindow::getReference()->getCANFrameModel()->getFrameIndex(modelFrames);
+    if (!index) return;
+    QList<uint32_t> ids = index->ids();
+    for (int i = 0; i < ids.count(); i++)
     {
-        id = modelFrames->at(i).frameId();
-        if (!idFilters.contains(id))
-        {
-            idFilters.insert(id, true);
-            FilterUtility::createCheckableFilterItem(id, true, ui->listFilter);
-        }
+        idFilters.insert(ids[i], true);
+        FilterUtility::createCheckableFilterItem(ids[i], true, ui->listFilter);
     }
 
     ui->listFilter->sortItems();
 }
 
+/*
+ * Starts the search over every ID that's checked, or stops the one that's running. Candidates show up in the list
+ * as they're found, best first. Bigger signals rank higher since mostly what we're interested in is the largest
+ * signal that matches, then the ones that moved the most smoothly.
+*/
 void RangeStateWindow::recalcButton()
 {
-    QMap<int, bool>::iterator iter;
-    uint32_t id;
+    if (finder->isRunning())
+    {
+        finder->cancel();
+        return;
+    }
 
     ui->listCandidates->clear();
     foundSignals.clear();
     ui->graphSignal->clearGraphs();
 
-    QProgressDialog progress(qApp->activeWindow());
-    progress.setWindowModality(Qt::WindowModal);
-    progress.setLabelText("Calculating");
-    progress.setCancelButton(0);
-    progress.setRange(0,0);
-    progress.setMinimumDuration(0);
-    progress.show();
-
-
+    RangeSignalSettings settings;
+    settings.minSize = ui->spinMinSigSize->value();
+    settings.maxSize = ui->spinMaxSigSize->value();
+    settings.granularity = ui->spinGranularity->value();
+    settings.sensitivity = ui->slideSensitivity->value();
+    int sigType = ui->cbSignalMode->currentIndex() + 1;
+    int signedType = ui->cbSignedMode->currentIndex() + 1;
+    settings.tryBigEndian = (sigType & 1);
+    settings.tryLittleEndian = (sigType & 2);
+    settings.trySigned = (signedType & 1);
+    settings.tryUnsigned = (signedType & 2);
 
-    for (iter = idFilters.begin(); iter != idFilters.end(); ++iter)
+    QVector<uint32_t> ids;
+    for (QMap<int, bool>::const_iterator iter = idFilters.constBegin(); iter != idFilters.constEnd(); ++iter)
     {
-        if (iter.value() == true)
-        {
-            qDebug() << "Processing for ID: " << iter.key();
-            //so, we're supposed to process this frame ID. We'll need to create a frame cache for it
-            frameCache.clear();
-            frameCache.reserve(modelFrames->count()); //block allocate more than enough space
-            id = iter.key();
-            for (int j = 0; j < modelFrames->count(); j++)
-            {
-                if (modelFrames->at(j).frameId() == id) frameCache.append(modelFrames->at(j));
-            }
-            //now we've got a list with all the same ID. Time to send it off for processing
-            signalsFactory();
-        }
+        if (iter.value()) ids.append(static_cast<uint32_t>(iter.key()));
     }
 
-    progress.cancel();
-    qDebug() << "Found " << foundSignals.count() << " signals total.";
+    finder->start(ids, settings);
 }
 
-/*
- * Uses the settings exposed to the user to generate a set of candidate signals that should be checked.
- * The user could specify signal sizes, granularity, endian type and we generate all the permutations from there
- * Should process from max to min and stop when a valid signal is found (at least as an option) to declutter a bit.
- * Mostly what we're interested in is the largest signal that matches
-*/
-void RangeStateWindow::signalsFactory()
+void RangeStateWindow::gotCandidates(QVector<RangeSignalCandidate> candidates)
 {
-    int minSig = ui->spinMinSigSize->value();
-    int maxSig = ui->spinMaxSigSize->value();
-    int granularity = ui->spinGranularity->value();
-    int sigType = ui->cbSignalMode->currentIndex() + 1;
-    int signedType = ui->cbSignedMode->currentIndex() + 1;
-    int maxBits = frameCache.at(0).payload().length() * 8;
-    int sens = ui->slideSensitivity->value();
-
-    for (int sigSize = maxSig; sigSize >= minSig; sigSize -= granularity)
+    for (int i = 0; i < candidates.count(); i++)
     {
-        qApp->processEvents();
-        for (int startBit = 0; startBit < maxBits; startBit += granularity)
-        {
-            if (sigType & 1)
-            {
-                if (signedType & 1) processSignal(startBit, sigSize, sens, true, true);
-                if (signedType & 2) processSignal(startBit, sigSize, sens, true, false);
-            }
-            if (sigType & 2)
-            {
-                if (signedType & 1) processSignal(startBit, sigSize, sens, false, true);
-                if (signedType & 2) processSignal(startBit, sigSize, sens, false, false);
-            }
-            //have to try both types even with 8 bit and smaller signals
-            //because they could cross byte boundaries. Could check whether they
-            //do and not try both types if it is impossible.
-        }
+        const RangeSignalCandidate &candidate = candidates[i];
+        QVector<RangeSignalCandidate>::iterator it = std::upper_bound(foundSignals.begin(), foundSignals.end(), candidate,
+                                    [](const RangeSignalCandidate &a, const RangeSignalCandidate &b) { return a.ranksAbove(b); });
+        int pos = static_cast<int>(it - foundSignals.begin());
+        foundSignals.insert(pos, candidate);
+        ui->listCandidates->insertItem(pos, candidate.describe());
     }
 }
 
-/*
- * Given the signal we generate the relevant data and figure out whether this signal seems to be a smooth range signal
-*/
-bool RangeStateWindow::processSignal(int startBit, int bitLength, int sensitivity, bool bigEndian, bool isSigned)
+void RangeStateWindow::searchProgress(int idsDone, int idsTotal)
 {
-    qDebug() << "";
-    qDebug() << "S:" << startBit << " B:" << bitLength << " Sens:" << sensitivity << " Big E:" << bigEndian << " Signed: " << isSigned;
-
-    QVector<int> scaledVals;
-    QVector<int> diff1;
-    QVector<int> diff2;
-    int64_t valu;
-    int64_t highestValue = -1000000000000LL;
-    int64_t lowestValue = 1000000000000LL;
-    double lerpPoint = ((double)sensitivity - 10.0) / 240.0;
-    int numFrames = frameCache.count();
-
-    scaledVals.reserve(frameCache.count());
-    diff1.reserve(frameCache.count() - 1);
-    diff2.reserve(frameCache.count() - 2);
-
-    int i;
-
-    for (i = 0; i < numFrames; i++)
-    {
-        valu = Utility::processIntegerSignal(frameCache.at(i).payload(), startBit, bitLength, !bigEndian, isSigned);
-        if (valu < lowestValue) lowestValue = valu;
-        if (valu > highestValue) highestValue = valu;
-    }
-
-    qDebug() << "Min: " << lowestValue << " Max: " << highestValue;
-
-    if (lowestValue == highestValue) return false; //a signal that never changes is worthless and not a range signal
-
-    int64_t range = highestValue - lowestValue;
-
-    int64_t maxRange = isSigned?(1<<(bitLength - 1)):(1 << bitLength);
-    //at highest sensitivity require signal to at least range 20% of max range
-    //at lowest  sensitivity require signal to at least range 1%  of max range
-    int64_t requiredRange = Utility::Lerp(maxRange * 0.01, maxRange * 0.2, lerpPoint);
-    if (range < requiredRange)
-        return false; //doesn't range enough.
-
-    for (i = 0; i < numFrames; i++)
-        scaledVals.append((int)((Utility::processIntegerSignal(frameCache.at(i).payload(), startBit, bitLength, !bigEndian, isSigned) - lowestValue)));
-
-    for (i = 1; i < numFrames; i++)
-    {
-        valu = scaledVals[i-1] - scaledVals[i];
-        diff1.append(valu);
-    }
-
-    for (i = 1; i < diff1.count(); i++)
-    {
-        valu = diff1[i-1] - diff1[i];
-        diff2.append(valu);
-    }
-
-    //now the differences are all stored so let's go through and see if first order diffs seem to suggest a ramping sort of signal or not.
-    //for a first test lets let through any signal where the first order diff doesn't seem too large
-    bool isGood = true;
-    int comparisonValue = Utility::Lerp((double)range * 0.55, 0, lerpPoint);
-    qDebug() << " 1st Delta comparisonvalue: " << comparisonValue;
-    int overValues = 0;
-    for (i = 0; i < diff1.count(); i++)
-    {
-        if (abs(diff1[i]) > comparisonValue) overValues++;
-    }
-    int maxOvers = Utility::Lerp(numFrames / 30.0, 2, lerpPoint);
-    qDebug() << "1st order overages: " << overValues << "   Max Overs: " << maxOvers;
-    if (overValues > maxOvers) isGood = false;
-
-    if (isGood)
-    {
-        //now look at the second order differentials. This is acceleration. There shouldn't be hard acceleration in values for a ranging signal
-        comparisonValue = Utility::Lerp((double)range * 0.20, 1, lerpPoint);
-        maxOvers = Utility::Lerp(8, 2, lerpPoint); //really clamp down on second order over limits
-        qDebug() << "2nd Delta comparisonvalue: " << comparisonValue;
-        overValues = 0;
-        for (i = 0; i < diff2.count(); i++)
-        {
-            if (abs(diff2[i]) > comparisonValue) overValues++;
-        }
-        if (overValues > maxOvers) isGood = false;
-        qDebug() << "2nd order overages: " << overValues << "   Max Overs: " << maxOvers;
-        if (overValues > maxOvers) isGood = false;
-    }
-
-    qDebug() << "Is this signal good: " << isGood << " Num overs: " << overValues;
-    if (isGood)
-    {
-        //createGraph(scaledVals);
-        QString temp;
-        temp = "ID: " + QString::number(frameCache.at(0).frameId(), 16) + " startBit: " + QString::number(startBit) + "  len: " + QString::number(bitLength);
-        int64_t foundSig;
-        foundSig = frameCache.at(0).frameId();
-        foundSig += (int64_t)startBit << 32;
-        foundSig += (int64_t)bitLength << 40;
-
-        if (isSigned)
-        {
-            temp += " Signed";
-            foundSig += (int64_t)1 << 48;
-        }
-        else
-        {
-            temp += " Unsigned";
-        }
-
-        if (bigEndian)
-        {
-            temp += " BigEndian";
-            foundSig += (int64_t)1 << 49;
-        }
-        else
-        {
-            temp += " LittleEndian";
-        }
+    ui->btnRecalc->setText(tr("Stop (%1 of %2 IDs done)").arg(idsDone).arg(idsTotal));
+}
 
-        ui->listCandidates->addItem(temp);
-        foundSignals.append(foundSig);
-    }
-    return isGood;
+void RangeStateWindow::searchFinished(bool completed)
+{
+    ui->btnRecalc->setText(tr("Recalculate Candidate Signals"));
+    qDebug() << "Found " << foundSignals.count() << " signals total." << (completed ? "" : "Search was stopped early.");
 }
 
 //graphs the vector such that the X axis is just the index into the vector and Y is perfectly graphed within the window
@@ -449,32 +316,25 @@ void RangeStateWindow::createGraph(QVector<int> values)
 
 void RangeStateWindow::clickedSignalList(int idx)
 {
-    if (idx == -1) return; //just in case...
+    if (idx < 0 || idx >= foundSignals.count()) return; //just in case...
 
     uint32_t id, startBit, bitLength;
     bool isSigned = false, isBigEndian = false;
-    int64_t valu;
 
-    valu = foundSignals.at(idx);
-    id = valu & 0xFFFFFFFFULL;
-    startBit = (valu >> 32) & 0xFF;
-    bitLength = (valu >> 40) & 0xFF;
-    if (valu & (1LL << 48)) isSigned = true;
-    if (valu & (1LL << 49)) isBigEndian = true;
+    const RangeSignalCandidate &candidate = foundSignals.at(idx);
+    id = candidate.id;
+    startBit = candidate.startBit;
+    bitLength = candidate.bitLength;
+    isSigned = candidate.isSigned;
+    isBigEndian = candidate.bigEndian;
 
     qDebug() << "I:" << id << " sb:" << startBit << " len:" << bitLength << " signed:" << isSigned << " big:" << isBigEndian;
 
-    frameCache.clear();
-    frameCache.reserve(modelFrames->count()); //block allocate more than enough space
-
-    for (int j = 0; j < modelFrames->count(); j++)
-    {
-        if (modelFrames->at(j).frameId() == id) frameCache.append(modelFrames->at(j));
-    }
+    CANFrameRows frameRows = MainWindow::getReference()->getCANFrameModel()->getFrameRows(modelFrames, id);
 
-    int numFrames = frameCache.count();
+    int numFrames = frameRows.count();
     QVector<int> values;
     values.reserve(numFrames);
-    for (int i = 0; i < numFrames; i++) values.append((int)((Utility::processIntegerSignal(frameCache.at(i).payload(), startBit, bitLength, !isBigEndian, isSigned))));
+    for (int i = 0; i < numFrames; i++) values.append((int)((Utility::processIntegerSignal(frameRows.at(i).payload(), startBit, bitLength, !isBigEndian, isSigned))));
     createGraph(values);
 }
@@ -4,6 +4,8 @@
 #include <QDialog>
 #include <QMap>
 #include "can_structs.h"
+#include "canframeindex.h"
+#include "rangesignalfinder.h"
 
 namespace Ui {
 class RangeStateWindow;
@@ -22,20 +24,21 @@ private slots:
     void updatedFrames(int);
     void recalcButton();
     void clickedSignalList(int idx);
+    void gotCandidates(QVector<RangeSignalCandidate> candidates);
+    void searchProgress(int idsDone, int idsTotal);
+    void searchFinished(bool completed);
 
 private:
     Ui::RangeStateWindow *ui;
     const QVector<CANFrame> *modelFrames;
-    QVector<CANFrame> frameCache;
-    QList<int64_t> foundSignals;
+    RangeSignalFinder *finder;
+    QVector<RangeSignalCandidate> foundSignals; //same order as listCandidates, best first
     QMap<int, bool> idFilters;
 
     void refreshFilterList();
     void closeEvent(QCloseEvent *event);
     void readSettings();
     void writeSettings();
-    void signalsFactory();
-    bool processSignal(int startBit, int bitLength, int sensitivity, bool bigEndian, bool isSigned);
     void createGraph(QVector<int> values);
     bool eventFilter(QObject *obj, QEvent *event);
 };
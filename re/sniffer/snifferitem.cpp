@@ -1,34 +1,47 @@
 #include <QVariant>
 #include <QDebug>
+#include <cstring>
 #include "snifferitem.h"
 
 
-SnifferItem::SnifferItem(const CANFrame& pFrame, quint32 seq):
-    mID(pFrame.frameId())
+SnifferItem::SnifferItem() :
+    inUse(false),
+    dirty(false),
+    shownStale(false),
+    mID(0),
+    mLen(0),
+    mLastLen(0),
+    mLastTime(0),
+    mCurrentTime(0),
+    mCurrSeqVal(0),
+    mSeenAt(0)
 {
-    const unsigned char *data = reinterpret_cast<const unsigned char *>(pFrame.payload().constData());
-    int dataLen = pFrame.payload().length();
-
-    for (int i = 0; i < dataLen; i++) {
-        mNotch[i] = 0;
-        mMarker.data[i] = 0;
-        mMarker.dataTimestamp[i] = 0;
-        if (i < dataLen) mCurrent.data[i] = data[i];
-        else mCurrent.data[i] = 0;
-        mCurrent.dataTimestamp[i] = seq;
-    }
-    mLastMarker = mMarker;
-    mCurrent.len = dataLen;
-
-    /* that's dirty */
-    update(pFrame, seq, false);
-    update(pFrame, seq, false); //anyone know why we're doing this twice?!
+    memset(mCurrent, 0, sizeof(mCurrent));
+    memset(mLast, 0, sizeof(mLast));
+    memset(mMarker, 0, sizeof(mMarker));
+    memset(mLastMarker, 0, sizeof(mLastMarker));
+    memset(mNotch, 0, sizeof(mNotch));
+    memset(mDataTimestamp, 0, sizeof(mDataTimestamp));
 }
 
-
-SnifferItem::~SnifferItem()
+//Start the slot over for a newly seen ID. Current and last are both the first frame so nothing shows as changed yet
+void SnifferItem::reset(const CANFrame& pFrame, quint32 seq, qint64 now)
 {
+    *this = SnifferItem();
+    inUse = true;
+    dirty = true;
+    mID = pFrame.frameId();
 
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(pFrame.payload().constData());
+    mLen = qMin(static_cast<int>(pFrame.payload().length()), SNIFFER_MAX_BYTES);
+    mLastLen = mLen;
+    memcpy(mCurrent, data, mLen);
+    memcpy(mLast, data, mLen);
+    for (int i = 0; i < SNIFFER_MAX_BYTES; i++) mDataTimestamp[i] = seq;
+
+    mCurrentTime = mLastTime = pFrame.timeStamp().microSeconds();
+    mCurrSeqVal = seq;
+    mSeenAt = now;
 }
 
 quint64 SnifferItem::getId() const
@@ -41,25 +54,30 @@ float SnifferItem::getDelta() const
     return ((float)(mCurrentTime-mLastTime))/1000000;
 }
 
-//Get a data byte by index 0-7 (but not more than the length of the actual frame)
+int SnifferItem::getLength() const
+{
+    return mLen;
+}
+
+//Get a data byte by index (but not more than the length of the actual frame)
 int SnifferItem::getData(uchar i) const
 {
-    return (i >= mCurrent.len) ? -1 : mCurrent.data[i];
+    return (i >= mLen) ? -1 : mCurrent[i];
 }
 
 quint8 SnifferItem::getNotchPattern(uchar i) const
 {
-    return (i >= mCurrent.len) ? -1 : mNotch[i];
+    return (i >= mLen) ? -1 : mNotch[i];
 }
 
 quint8 SnifferItem::getLastData(uchar i) const
 {
-    return (i >= mLast.len) ? -1 : mLast.data[i];
+    return (i >= mLastLen) ? -1 : mLast[i];
 }
 
 quint32 SnifferItem::getDataTimestamp(uchar i) const
 {
-    return (i >= mCurrent.len) ? 0 : mCurrent.dataTimestamp[i];
+    return (i >= mLen) ? 0 : mDataTimestamp[i];
 }
 
 quint32 SnifferItem::getSeqInterval(uchar i) const
@@ -67,19 +85,19 @@ quint32 SnifferItem::getSeqInterval(uchar i) const
     return mCurrSeqVal - getDataTimestamp(i);
 }
 
-//Return whether a given data byte (by index 0-7) has incremented, deincremented, or stayed the same
+//Return whether a given data byte has incremented, deincremented, or stayed the same
 //since the last message
 //The If checks first that we aren't past the actual data length
 // then checks whether lastMarker shows that some bits have changed in the previous 200ms cycle
 // then we check if the byte in mNotch has bits set and if it does we say nothing changed (notched out)
 dc SnifferItem::dataChange(uchar i) const
 {
-    if (i >= mCurrent.len) return dc::NO;
+    if (i >= mLen) return dc::NO;
 
     uchar notch = mNotch[i];
-    uchar byt = mCurrent.data[i];
-    uchar last = mLast.data[i];
-    uchar lastMark = mLastMarker.data[i];
+    uchar byt = mCurrent[i];
+    uchar last = mLast[i];
+    uchar lastMark = mLastMarker[i];
     if( lastMark )
     {
         if (!notch) //if no notching is set
@@ -97,61 +115,64 @@ dc SnifferItem::dataChange(uchar i) const
     return dc::NO;
 }
 
-
-
-int SnifferItem::elapsed() const
+//milliseconds since this ID was last seen. now is the model's clock
+int SnifferItem::elapsed(qint64 now) const
 {
-    return mTime.elapsed();
+    return static_cast<int>(now - mSeenAt);
 }
 
 //called when a new frame comes in that matches our same ID
 //timeSeq is stored so we can figure out the last time a specific byte was updated
 //mute is used to specify whether to mask the byte against the notching filter
 //in order to hide any updates of the notched bits. This is toggleable
-void SnifferItem::update(const CANFrame& pFrame, quint32 timeSeq, bool mute)
+void SnifferItem::update(const CANFrame& pFrame, quint32 timeSeq, bool mute, qint64 now)
 {
     unsigned char maskedCurr, maskedData;
-    //qDebug() << "update with ts: " << timeSeq;
     /* copy current to last */
-    mLast = mCurrent;
+    memcpy(mLast, mCurrent, sizeof(mCurrent));
+    mLastLen = mLen;
     mLastTime = mCurrentTime;
     mCurrSeqVal = timeSeq;
 
     const unsigned char *data = reinterpret_cast<const unsigned char *>(pFrame.payload().constData());
-    int dataLen = pFrame.payload().length();
+    int dataLen = qMin(static_cast<int>(pFrame.payload().length()), SNIFFER_MAX_BYTES);
 
     /* copy new value */
+    //We "OR" our stored marker with the changed bits as we go.
+    //this accumulates changed bits into the marker
     for (int i = 0; i < dataLen; i++)
     {
         maskedData = data[i];
-        if (mute) maskedData &= ~mNotch[i];
-        maskedCurr = mCurrent.data[i];
-        if (mute) maskedCurr &= ~mNotch[i];
+        maskedCurr = mCurrent[i];
+        if (mute)
+        {
+            maskedData &= ~mNotch[i];
+            maskedCurr &= ~mNotch[i];
+        }
         if (maskedCurr != maskedData)
         {
-            mCurrent.data[i] = data[i];
-            mCurrent.dataTimestamp[i] = timeSeq;
+            mCurrent[i] = data[i];
+            mDataTimestamp[i] = timeSeq;
+            mMarker[i] |= mLast[i] ^ mCurrent[i]; //XOR causes only changed bits to be 1's
         }
     }
-    mCurrent.len = dataLen;
+    mLen = dataLen;
     mCurrentTime = pFrame.timeStamp().microSeconds();
 
-    /* update marker */
-    //We "OR" our stored marker with the changed bits.
-    //this accumulates changed bits into the marker
-    for (int i = 0 ; i < 8; i++) mMarker.data[i] |= mLast.data[i] ^ mCurrent.data[i]; //XOR causes only changed bits to be 1's
-    mMarker.len  |= mLast.len ^ mCurrent.len;
-
-    /* restart timeout */
-    mTime.restart();
+    mSeenAt = now;
+    dirty = true;
+    shownStale = false;
 }
 
 //Called in refresh from the model. Interval about 200ms currently.
 //So, this means the marker only accumulates for 200ms then resets
-void SnifferItem::updateMarker()
+//Returns whether that changes what the item looks like
+bool SnifferItem::updateMarker()
 {
-    mLastMarker = mMarker;
-    for (int i = 0; i < 8; i++) mMarker.data[i] = 0;
+    bool changed = (memcmp(mLastMarker, mMarker, sizeof(mMarker)) != 0);
+    memcpy(mLastMarker, mMarker, sizeof(mMarker));
+    memset(mMarker, 0, sizeof(mMarker));
+    return changed;
 }
 
 //Notch or un-notch this snifferitem / frame
@@ -159,9 +180,9 @@ void SnifferItem::notch(bool pNotch)
 {
     if(pNotch)
     {
-        for (int i = 0; i < 8; i++) mNotch[i] |= mLastMarker.data[i]; //add changed bits to notch value
+        for (int i = 0; i < SNIFFER_MAX_BYTES; i++) mNotch[i] |= mLastMarker[i]; //add changed bits to notch value
     }
 
     else
-        for (int i = 0; i < 8; i++) mNotch[i] = 0;
+        memset(mNotch, 0, sizeof(mNotch));
 }
@@ -2,15 +2,9 @@
 #define SNIFFERITEM_H
 
 #include <QVariant>
-#include <QElapsedTimer>
 #include "can_structs.h"
 
-struct fstCan
-{
-    quint8 data[8];
-    quint32 dataTimestamp[8];
-    int len;
-};
+#define SNIFFER_MAX_BYTES   64  //CAN-FD
 
 enum dc
 {
@@ -19,38 +13,52 @@ enum dc
     DEINC
 };
 
-
+/*
+ * Everything the sniffer keeps for one ID. These sit by value in the model's slot table so a new ID doesn't cost an
+ * allocation and all of an ID's state is in one block. Byte values and the sequence number each byte last changed
+ * at are plain arrays sized for CAN-FD; only the first getLength() of them mean anything.
+ *
+ * Time since the ID was last seen comes from a clock the model passes in rather than a timer per ID.
+*/
 class SnifferItem
 {
 public:
-    explicit SnifferItem(const CANFrame& pFrame, quint32 seq);
-    virtual ~SnifferItem();
+    SnifferItem();
 
+    void reset(const CANFrame& pFrame, quint32 seq, qint64 now);
     quint64 getId() const;
     float getDelta() const;
+    int getLength() const;
     int getData(uchar i) const;
     quint8 getNotchPattern(uchar i) const;
     quint8 getLastData(uchar i) const;
     quint32 getDataTimestamp(uchar i) const;
     quint32 getSeqInterval(uchar i) const;
     dc dataChange(uchar) const;
-    int elapsed() const;
-    void update(const CANFrame& pFrame, quint32 timeSeq, bool mute);
-    void updateMarker();
+    int elapsed(qint64 now) const;
+    void update(const CANFrame& pFrame, quint32 timeSeq, bool mute, qint64 now);
+    bool updateMarker();
     void notch(bool);
 
+    //bookkeeping for the model
+    bool            inUse;
+    bool            dirty;      //changed since the view was last told
+    bool            shownStale; //the view has been told this ID went quiet
+
 private:
     quint32         mID;
-    struct fstCan   mLast;
-    struct fstCan   mCurrent;
-    struct fstCan   mLastMarker;
-    struct fstCan   mMarker;
-    quint8          mNotch[8];
+    int             mLen;
+    int             mLastLen;
+    quint8          mCurrent[SNIFFER_MAX_BYTES];
+    quint8          mLast[SNIFFER_MAX_BYTES];
+    quint8          mMarker[SNIFFER_MAX_BYTES];
+    quint8          mLastMarker[SNIFFER_MAX_BYTES];
+    quint8          mNotch[SNIFFER_MAX_BYTES];
+    quint32         mDataTimestamp[SNIFFER_MAX_BYTES];
     quint64         mLastTime;
     quint64         mCurrentTime;
-    quint64         mCurrSeqVal;
-
-    QElapsedTimer   mTime;
+    quint32         mCurrSeqVal;
+    qint64          mSeenAt;    //model clock in ms
 };
 
 #endif // SNIFFERITEM_H
@@ -1,12 +1,14 @@
 #include <QDebug>
 #include <Qt>
 #include <QApplication>
+#include <QPalette>
+#include <algorithm>
 #include "sniffermodel.h"
-#include "snifferwindow.h"
-#include "SnifferDelegate.h"
 
 SnifferModel::SnifferModel(QObject *parent)
     : QAbstractItemModel(parent),
+      mStdSlots(SNIFFER_STD_IDS, -1),
+      mDataColumns(8),
       mFilter(false),
       mNeverExpire(false),
       mFadeInactive(false),
@@ -20,13 +22,11 @@ SnifferModel::SnifferModel(QObject *parent)
         mDarkMode = false;
     }
     else mDarkMode = true;
+    mClock.start();
 }
 
 SnifferModel::~SnifferModel()
 {
-    qDeleteAll(mMap);
-    mMap.clear();
-    mFilters.clear();
 }
 
 void SnifferModel::setExpireInterval(int newVal)
@@ -36,14 +36,25 @@ void SnifferModel::setExpireInterval(int newVal)
 
 int SnifferModel::columnCount(const QModelIndex &parent) const
 {
-    return parent.isValid() ? 0 : tc::LAST+1;
+    //one past the data columns is an empty one that soaks up the rest of the width
+    return parent.isValid() ? 0 : tc::DATA_0 + mDataColumns + 1;
 }
 
 
 int SnifferModel::rowCount(const QModelIndex &parent) const
 {
-    const QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
-    return parent.isValid() ? 0 : map.size();
+    return parent.isValid() ? 0 : mRows.count();
+}
+
+int SnifferModel::dataColumns() const
+{
+    return mDataColumns;
+}
+
+const SnifferItem *SnifferModel::item(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.internalId() >= static_cast<quintptr>(mSlots.count())) return nullptr;
+    return &mSlots[static_cast<int>(index.internalId())];
 }
 
 
@@ -52,8 +63,8 @@ QVariant SnifferModel::data(const QModelIndex &index, int role) const
     if (!index.isValid())
         return QVariant();
 
-    SnifferItem *item = static_cast<SnifferItem*>(index.internalPointer());
-    if(!item) QVariant();
+    const SnifferItem *item = this->item(index);
+    if(!item) return QVariant();
 
     int col = index.column();
 
@@ -66,14 +77,19 @@ QVariant SnifferModel::data(const QModelIndex &index, int role) const
                 case tc::DELTA:
                     return QString::number(item->getDelta(), 'f');
                 case tc::FREQUENCY:
+                {
+                    //the average from the capture's statistics if it has one, it doesn't jump around like the last gap does
+                    double rate = mRates.value(static_cast<quint32>(item->getId()), 0.0);
+                    if (rate > 0.0) return QString("%1 hz").arg(qRound(rate));
                     if (item->getDelta() == 0) return QString("0 hz");
                     return QString("%1 hz").arg(qRound(1.00 / item->getDelta()));
+                }
                 case tc::ID:
                     return "0x" + QString("%1").arg(item->getId(), 5, 16, QLatin1Char('0')).toUpper();
                 default:
                     break;
             }
-            if(tc::DATA_0<=col && col <=tc::DATA_7)
+            if(tc::DATA_0<=col && col < tc::DATA_0 + mDataColumns)
             {
                 int data = item->getData(col-tc::DATA_0);
                 if(data >= 0)
@@ -85,9 +101,8 @@ QVariant SnifferModel::data(const QModelIndex &index, int role) const
         }
         case Qt::ForegroundRole:
         {
-            if (!mFadeInactive ||  col < 2) return QApplication::palette().brush(QPalette::Text);
-            int v = item->getSeqInterval(col - 2) * 10;
-            //qDebug() << "mTS: " << mTimeSequence << " gDT(" << (col - 2) << ") " << item->getDataTimestamp(col - 2);
+            if (!mFadeInactive ||  col < tc::DATA_0) return QApplication::palette().brush(QPalette::Text);
+            int v = item->getSeqInterval(col - tc::DATA_0) * 10;
             if (v > 225) v = 225;
             if (v < 0) v = 0;
 
@@ -105,13 +120,13 @@ QVariant SnifferModel::data(const QModelIndex &index, int role) const
         {
             if(tc::ID==col)
             {
-                if(item->elapsed() > 4000)
+                if(item->elapsed(mClock.elapsed()) > SNIFFER_STALE_MS)
                 {
                     if (!mDarkMode) return QBrush(Qt::red);
                     return QBrush(QColor(128,0,0));
                 }
             }
-            else if(tc::DATA_0<=col && col<=tc::DATA_7)
+            else if(tc::DATA_0<=col && col < tc::DATA_0 + mDataColumns)
             {
                 dc change = item->dataChange(col-tc::DATA_0);
                 switch(change)
@@ -158,7 +173,7 @@ QVariant SnifferModel::headerData(int section, Qt::Orientation orientation, int
             default:
                 break;
         }
-        if(tc::DATA_0<=section && section <=tc::DATA_7)
+        if(tc::DATA_0<=section && section < tc::DATA_0 + mDataColumns)
             return QString::number(section-tc::DATA_0);
     }
 
@@ -171,17 +186,11 @@ QModelIndex SnifferModel::index(int row, int column, const QModelIndex &parent)
     if (parent.isValid())
         return QModelIndex();
 
-    const QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
-
-    if(column>tc::LAST || row>=map.size())
+    if(row < 0 || column < 0 || column >= columnCount() || row >= mRows.count())
         return QModelIndex();
 
-    /* ugly but I can't find best without creating a list to keep indexes */
-    QMap<quint32, SnifferItem*>::const_iterator iter;
-    int i;
-    for(iter = map.begin(), i=0 ; i<row ; ++i, ++iter);
-
-    return createIndex(row, column, iter.value());
+    //the slot rides along in the index. Slots don't move so it stays good for as long as the row does
+    return createIndex(row, column, static_cast<quintptr>(mRows[row]));
 }
 
 
@@ -223,58 +232,78 @@ void SnifferModel::setMuteNotched(bool val)
 void SnifferModel::clear()
 {
     beginResetModel();
-    qDeleteAll(mMap);
-    mMap.clear();
+    mSlots.clear();
+    mFreeSlots.clear();
+    mStdSlots.fill(-1);
+    mExtSlots.clear();
+    mRows.clear();
     mFilters.clear();
+    mRates.clear();
     mFilter = false;
+    mDataColumns = 8;
     endResetModel();
 }
 
-void SnifferModel::updateNotchPoint()
+//taken as they are. The rows show them the next time they get repainted
+void SnifferModel::setRates(const QHash<quint32, double> &rates)
 {
-    QMap<quint32, SnifferItem*>::iterator i;
+    mRates = rates;
+}
 
+void SnifferModel::updateNotchPoint()
+{
     /* update markers */
-    for (i = mMap.begin(); i != mMap.end(); ++i)
+    for (int i = 0; i < mSlots.count(); i++)
     {
-        i.value()->updateMarker();
+        if (!mSlots[i].inUse) continue;
+        if (mSlots[i].updateMarker()) mSlots[i].dirty = true;
     }
 }
 
 //Called from window with a timer (currently 200ms)
 void SnifferModel::refresh()
 {
-    QMap<quint32, SnifferItem*>::iterator i;
-    QVector<quint32> toRemove;
-    SnifferItem* item;
+    QVector<int> toRemove;
+    qint64 now = mClock.elapsed();
 
     mTimeSequence++;
 
-    for (i = mMap.begin(); i != mMap.end(); ++i)
+    for (int i = 0; i < mSlots.count(); i++)
     {
-        //i.value()->updateMarker();
-        if(i.value()->elapsed() > (int)mExpireInterval && !mNeverExpire)
-            toRemove.append(i.key());
+        SnifferItem &item = mSlots[i];
+        if (!item.inUse) continue;
+        int elapsed = item.elapsed(now);
+        if(elapsed > (int)mExpireInterval && !mNeverExpire)
+            toRemove.append(i);
+        else if (elapsed > SNIFFER_STALE_MS && !item.shownStale)
+        {
+            item.shownStale = true;
+            item.dirty = true;
+        }
     }
 
-    if(toRemove.size())
+    foreach(int slot, toRemove) removeSlot(slot);
+
+    /* refresh data */
+    //only rows that changed, a run of neighbouring rows at a time. Fading touches every row on every tick though
+    int lastColumn = columnCount() - 1;
+    int runStart = -1;
+    for (int row = 0; row <= mRows.count(); row++)
     {
-        beginResetModel();
-        foreach(quint32 id, toRemove)
+        bool dirty = false;
+        if (row < mRows.count())
         {
-            /* remove element */
-            item = mMap.take(id);
-            mFilters.remove(id);
-            delete item;
-            /* send notification */
-            emit idChange(id, false);
+            SnifferItem &item = mSlots[mRows[row]];
+            dirty = item.dirty || mFadeInactive;
+            item.dirty = false;
+        }
+        if (dirty && runStart < 0) runStart = row;
+        else if (!dirty && runStart >= 0)
+        {
+            emit dataChanged(index(runStart, 0), index(row - 1, lastColumn));
+            runStart = -1;
         }
-        endResetModel();
     }
-    else
-        /* refresh data */
-        emit dataChanged(createIndex(0, 0),
-                    createIndex(rowCount()-1, columnCount()-1), QVector<int>(Qt::DisplayRole));
 }
 
 
@@ -291,12 +320,15 @@ void SnifferModel::filter(fltType pType, int pId)
         case fltType::ADD:
             /* add filter to list */
             mFilter = true;
-            mFilters[pId] = mMap[pId];
+            if (slotFor(pId) >= 0) mFilters.insert(pId);
             break;
         case fltType::REMOVE:
             /* remove filter */
             if(!mFilter)
-                mFilters = mMap;
+            {
+                mFilters.clear();
+                foreach(int slot, mRows) mFilters.insert(mSlots[slot].getId());
+            }
             mFilter = true;
             mFilters.remove(pId);
             break;
@@ -306,9 +338,96 @@ void SnifferModel::filter(fltType pType, int pId)
             mFilters.clear();
             break;
     }
+    rebuildRows();
     endResetModel();
 }
 
+int SnifferModel::slotFor(quint32 id) const
+{
+    if (id < SNIFFER_STD_IDS) return mStdSlots[id];
+    QHash<quint32, int>::const_iterator it = mExtSlots.constFind(id);
+    return (it == mExtSlots.constEnd()) ? -1 : it.value();
+}
+
+//first row with an ID at or above id
+int SnifferModel::rowFor(quint32 id) const
+{
+    QVector<int>::const_iterator it = std::lower_bound(mRows.constBegin(), mRows.constEnd(), id,
+        [this](int slot, quint32 value) { return mSlots[slot].getId() < value; });
+    return static_cast<int>(it - mRows.constBegin());
+}
+
+bool SnifferModel::isShown(quint32 id) const
+{
+    return !mFilter || mFilters.contains(id);
+}
+
+void SnifferModel::addSlot(const CANFrame &frame, qint64 now)
+{
+    quint32 id = frame.frameId();
+    int slot;
+    if (!mFreeSlots.isEmpty()) slot = mFreeSlots.takeLast();
+    else
+    {
+        slot = mSlots.count();
+        mSlots.append(SnifferItem());
+    }
+    mSlots[slot].reset(frame, mTimeSequence, now);
+    if (id < SNIFFER_STD_IDS) mStdSlots[id] = slot;
+    else mExtSlots.insert(id, slot);
+
+    if (isShown(id))
+    {
+        int row = rowFor(id);
+        beginInsertRows(QModelIndex(), row, row);
+        mRows.insert(row, slot);
+        endInsertRows();
+    }
+
+    emit idChange(id, true);
+}
+
+void SnifferModel::removeSlot(int slot)
+{
+    quint32 id = mSlots[slot].getId();
+    int row = rowFor(id);
+    if (row < mRows.count() && mRows[row] == slot)
+    {
+        beginRemoveRows(QModelIndex(), row, row);
+        mRows.remove(row);
+        endRemoveRows();
+    }
+
+    if (id < SNIFFER_STD_IDS) mStdSlots[id] = -1;
+    else mExtSlots.remove(id);
+    mFilters.remove(id);
+    mSlots[slot].inUse = false;
+    mFreeSlots.append(slot);
+
+    /* send notification */
+    emit idChange(id, false);
+}
+
+void SnifferModel::rebuildRows()
+{
+    mRows.clear();
+    for (int i = 0; i < mSlots.count(); i++)
+    {
+        if (mSlots[i].inUse && isShown(mSlots[i].getId())) mRows.append(i);
+    }
+    std::sort(mRows.begin(), mRows.end(), [this](int a, int b) { return mSlots[a].getId() < mSlots[b].getId(); });
+}
+
+//a longer payload than any so far adds data columns ahead of the empty last one
+void SnifferModel::growColumns(int len)
+{
+    len = qMin(len, SNIFFER_MAX_BYTES);
+    if (len <= mDataColumns) return;
+    beginInsertColumns(QModelIndex(), tc::DATA_0 + mDataColumns, tc::DATA_0 + len - 1);
+    mDataColumns = len;
+    endInsertColumns();
+}
+
 
 /***********************************************/
 /**********         slots       ****************/
@@ -316,39 +435,37 @@ void SnifferModel::filter(fltType pType, int pId)
 
 void SnifferModel::update(CANConnection*, QVector<CANFrame>& pFrames)
 {
+    //one clock read for the whole batch, they all showed up at the same time as far as the window can tell
+    qint64 now = mClock.elapsed();
+
     foreach(const CANFrame& frame, pFrames)
     {
-        if(!mMap.contains(frame.frameId()))
-        {
-            int index = std::distance(mMap.begin(), mMap.lowerBound(frame.frameId()));
-            /* add the frame */
-            beginInsertRows(QModelIndex(), index, index);
-            mMap[frame.frameId()] = new SnifferItem(frame, mTimeSequence);
-            mMap[frame.frameId()]->update(frame, mTimeSequence, mMuteNotched);
-            endInsertRows();
+        if (frame.payload().length() > mDataColumns) growColumns(frame.payload().length());
 
-            emit idChange(frame.frameId(), true);
-        }
+        int slot = slotFor(frame.frameId());
+        if (slot < 0)
+            /* add the frame */
+            addSlot(frame, now);
         else
             //updateData
-            mMap[frame.frameId()]->update(frame, mTimeSequence, mMuteNotched);
+            mSlots[slot].update(frame, mTimeSequence, mMuteNotched, now);
     }
 }
 
 void SnifferModel::notch()
 {
-    QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
-
-    foreach(SnifferItem* item, map)
-        item->notch(true);
+    foreach(int slot, mRows)
+    {
+        mSlots[slot].notch(true);
+        mSlots[slot].dirty = true;
+    }
 }
 
 void SnifferModel::unNotch()
 {
-    QMap<quint32, SnifferItem*>& map = mFilter ? mFilters : mMap;
-
-    foreach(SnifferItem* item, map)
-        item->notch(false);
+    foreach(int slot, mRows)
+    {
+        mSlots[slot].notch(false);
+        mSlots[slot].dirty = true;
+    }
 }
-
-
@@ -5,11 +5,32 @@
 #include <QModelIndex>
 #include <QVariant>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
 
 #include "can_structs.h"
 #include "connections/canconnection.h"
 #include "snifferitem.h"
 
+#define SNIFFER_STALE_MS        4000    //ID turns red when it hasn't been seen for this long
+#define SNIFFER_STD_IDS         0x800   //11 bit IDs go straight to their slot, the rest are hashed
+
+enum tc
+{
+    DELTA = 0,
+    FREQUENCY,
+    ID,
+    DATA_0,
+    DATA_1,
+    DATA_2,
+    DATA_3,
+    DATA_4,
+    DATA_5,
+    DATA_6,
+    DATA_7,
+    LAST    //with 8 byte payloads. A CAN-FD frame adds data columns before it
+};
 
 enum fltType
 {
@@ -19,6 +40,14 @@ enum fltType
     NONE
 };
 
+/*
+ * Every ID gets a slot in a flat table of SnifferItems and keeps it until it expires. Finding the slot for a frame is
+ * an array lookup for 11 bit IDs and a hash lookup for the rest, so a saturated bus costs one lookup and one byte
+ * compare loop per frame. The rows are a separate list of slots sorted by ID, only touched when an ID comes or goes.
+ *
+ * Frames only update the slots and mark them dirty. refresh() then tells the view about the dirty rows in runs of
+ * neighbouring rows, so idle IDs aren't repainted and a busy bus is at most one dataChanged per run per refresh.
+*/
 class SnifferModel : public QAbstractItemModel
 {
     Q_OBJECT
@@ -37,6 +66,8 @@ public:
     QModelIndex parent(const QModelIndex &index) const Q_DECL_OVERRIDE;
     int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
     int columnCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    const SnifferItem *item(const QModelIndex &index) const;
+    int dataColumns() const;
     void refresh();
     void clear();
     void filter(fltType pType, int pId=0);
@@ -48,6 +79,7 @@ public:
     void setMuteNotched(bool val);
     void setExpireInterval(int newVal);
     void updateNotchPoint();
+    void setRates(const QHash<quint32, double> &rates);
 
 
 public slots:
@@ -59,8 +91,23 @@ signals:
     void idChange(int, bool);
 
 private:
-    QMap<quint32, SnifferItem*> mMap;
-    QMap<quint32, SnifferItem*> mFilters;
+    int slotFor(quint32 id) const;
+    void addSlot(const CANFrame &frame, qint64 now);
+    void removeSlot(int slot);
+    int rowFor(quint32 id) const;
+    bool isShown(quint32 id) const;
+    void rebuildRows();
+    void growColumns(int len);
+
+    QVector<SnifferItem>        mSlots;     //a slot keeps its place until its ID expires, then gets reused
+    QVector<int>                mFreeSlots;
+    QVector<int>                mStdSlots;  //11 bit ID to slot, -1 if not seen
+    QHash<quint32, int>         mExtSlots;
+    QVector<int>                mRows;      //slots in view sorted by ID
+    QSet<quint32>               mFilters;
+    QHash<quint32, double>      mRates;     //frames per second per ID from the capture's statistics
+    int                         mDataColumns;
+    QElapsedTimer               mClock;
     bool                        mFilter;
     bool                        mNeverExpire;
     bool                        mFadeInactive;
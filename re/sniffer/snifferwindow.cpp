@@ -6,6 +6,7 @@
 #include "helpwindow.h"
 #include "connections/canconmanager.h"
 #include "SnifferDelegate.h"
+#include "mainwindow.h"
 #include "utility.h"
 
 SnifferWindow::SnifferWindow(QWidget *parent) :
@@ -27,6 +28,17 @@ SnifferWindow::SnifferWindow(QWidget *parent) :
     ui->treeView->setColumnWidth(tc::LAST, 1);
     for(int i=tc::DATA_0 ; i<=tc::DATA_7 ; i++)
         ui->treeView->setColumnWidth(i, 92);
+    //CAN-FD frames add data columns on the fly, they get the same width and the last one stays squashed
+    connect(&mModel, &QAbstractItemModel::columnsInserted, this,
+            [this](const QModelIndex &, int first, int last)
+            {
+                for(int i=first ; i<=last ; i++)
+                    ui->treeView->setColumnWidth(i, 92);
+                ui->treeView->setColumnWidth(mModel.columnCount() - 1, 1);
+            }
+    );
+    connect(&mModel, &QAbstractItemModel::modelReset, this,
+            [this]() { ui->treeView->setColumnWidth(mModel.columnCount() - 1, 1); });
     ui->treeView->setUniformRowHeights(true);
     ui->treeView->header()->setDefaultAlignment(Qt::AlignCenter);
     //ui->treeView->setItemDelegate(new SnifferDelegate());
@@ -167,6 +179,7 @@ bool SnifferWindow::eventFilter(QObject *obj, QEvent *event)
 
 void SnifferWindow::update()
 {
+    mModel.setRates(MainWindow::getReference()->getCANFrameModel()->getIDRates());
     mModel.refresh();
 }
 
@@ -10,23 +10,6 @@ namespace Ui {
 class snifferWindow;
 }
 
-enum tc
-{
-    DELTA = 0,
-    FREQUENCY,
-    ID,
-    DATA_0,
-    DATA_1,
-    DATA_2,
-    DATA_3,
-    DATA_4,
-    DATA_5,
-    DATA_6,
-    DATA_7,
-    LAST
-};
-
-
 class SnifferWindow : public QDialog
 {
     Q_OBJECT
@@ -0,0 +1,395 @@
+#include "temporaldensity.h"
+
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <cmath>
+
+//one slice of the frame list for build()
+struct TemporalDensityChunk
+{
+    int start;
+    int end;
+    int64_t minTime;
+    int64_t maxTime;
+    QSet<uint32_t> ids;
+    int firstColumn;
+    int columnCount;
+    bool tooWide;               //the frames weren't in time order and the slice covers too much time to count on its own
+    QVector<uint32_t> counts;   //row * columnCount + column - firstColumn
+};
+
+TemporalDensity::TemporalDensity()
+{
+    clear();
+}
+
+void TemporalDensity::clear()
+{
+    origin = 0;
+    bucketWidth = TEMPORAL_DENSITY_MIN_BUCKET;
+    columns = 0;
+    rowIDs.clear();
+    rowOf.clear();
+    levels.clear();
+    dirtyLow = 0;
+    dirtyHigh = -1;
+    count = 0;
+    minTime = 0;
+    maxTime = 0;
+    minID = 0;
+    maxID = 0;
+}
+
+/*
+ * Sizes level 0 for the IDs and the time span given. Columns are halved until the cells fit the limit and until
+ * they aren't narrower than TEMPORAL_DENSITY_MIN_BUCKET.
+*/
+void TemporalDensity::setup(int64_t start, int64_t span, const QVector<uint32_t> &ids)
+{
+    origin = start;
+    rowIDs = ids;
+    rowOf.clear();
+    for (int i = 0; i < ids.count(); i++) rowOf.insert(ids[i], i);
+
+    int64_t rows = qMax(1, static_cast<int>(ids.count()));
+    columns = TEMPORAL_DENSITY_MAX_COLUMNS;
+    while (columns > TEMPORAL_DENSITY_MIN_COLUMNS && columns * rows > TEMPORAL_DENSITY_MAX_CELLS) columns /= 2;
+    while (columns > TEMPORAL_DENSITY_MIN_COLUMNS && static_cast<int64_t>(columns / 2) * TEMPORAL_DENSITY_MIN_BUCKET >= span) columns /= 2;
+    bucketWidth = qMax(static_cast<int64_t>(TEMPORAL_DENSITY_MIN_BUCKET), (span + columns - 1) / columns);
+
+    levels.clear();
+    for (int cols = columns; cols >= TEMPORAL_DENSITY_MIN_COLUMNS; cols /= 2)
+    {
+        levels.append(QVector<uint32_t>(ids.count() * cols, 0));
+    }
+    dirtyLow = columns;
+    dirtyHigh = -1;
+}
+
+/*
+ * Counts every frame in the list from scratch. The list gets split into slices that are scanned for their time
+ * range and IDs then counted into their own small grids across the thread pool. Captures are nearly always in time
+ * order so each slice only covers a few columns. A slice that covers too many to be worth a grid of its own gets
+ * counted straight in afterwards instead.
+*/
+void TemporalDensity::build(const QVector<CANFrame> &frames)
+{
+    clear();
+    int numFrames = frames.count();
+    if (numFrames == 0) return;
+
+    int numChunks = qBound(1, numFrames / 65536, qMax(1, QThread::idealThreadCount()) * 4);
+    QVector<TemporalDensityChunk> chunks(numChunks);
+    for (int i = 0; i < numChunks; i++)
+    {
+        chunks[i].start = static_cast<int>(static_cast<int64_t>(numFrames) * i / numChunks);
+        chunks[i].end = static_cast<int>(static_cast<int64_t>(numFrames) * (i + 1) / numChunks);
+        chunks[i].tooWide = false;
+    }
+    const CANFrame *frameData = frames.constData();
+
+    QtConcurrent::blockingMap(chunks, [frameData](TemporalDensityChunk &chunk)
+    {
+        chunk.minTime = chunk.maxTime = frameData[chunk.start].timeStamp().microSeconds();
+        uint32_t lastID = frameData[chunk.start].frameId();
+        chunk.ids.insert(lastID);
+        for (int i = chunk.start; i < chunk.end; i++)
+        {
+            int64_t stamp = frameData[i].timeStamp().microSeconds();
+            if (stamp < chunk.minTime) chunk.minTime = stamp;
+            if (stamp > chunk.maxTime) chunk.maxTime = stamp;
+            uint32_t id = frameData[i].frameId();
+            if (id != lastID)
+            {
+                chunk.ids.insert(id);
+                lastID = id;
+            }
+        }
+    });
+
+    QSet<uint32_t> allIDs;
+    int64_t start = chunks[0].minTime;
+    int64_t end = chunks[0].maxTime;
+    for (const TemporalDensityChunk &chunk : chunks)
+    {
+        allIDs.unite(chunk.ids);
+        start = qMin(start, chunk.minTime);
+        end = qMax(end, chunk.maxTime);
+    }
+    QVector<uint32_t> ids(allIDs.begin(), allIDs.end());
+    std::sort(ids.begin(), ids.end());
+    setup(start, end - start + 1, ids);
+
+    const QHash<uint32_t, int> &rows = rowOf;
+    int64_t numRows = ids.count();
+    int64_t cellsPerChunk = qMax(static_cast<int64_t>(TEMPORAL_DENSITY_MAX_CELLS) * 2 / numChunks, numRows * 2);
+    int64_t originTime = origin;
+    int64_t width = bucketWidth;
+    QtConcurrent::blockingMap(chunks, [frameData, &rows, numRows, cellsPerChunk, originTime, width](TemporalDensityChunk &chunk)
+    {
+        chunk.firstColumn = static_cast<int>((chunk.minTime - originTime) / width);
+        chunk.columnCount = static_cast<int>((chunk.maxTime - originTime) / width) - chunk.firstColumn + 1;
+        if (chunk.columnCount * numRows > cellsPerChunk)
+        {
+            chunk.tooWide = true;
+            return;
+        }
+        chunk.counts.fill(0, static_cast<int>(chunk.columnCount * numRows));
+        uint32_t *cells = chunk.counts.data();
+        uint32_t lastID = frameData[chunk.start].frameId();
+        int row = rows.value(lastID);
+        for (int i = chunk.start; i < chunk.end; i++)
+        {
+            uint32_t id = frameData[i].frameId();
+            if (id != lastID)
+            {
+                row = rows.value(id);
+                lastID = id;
+            }
+            int column = static_cast<int>((frameData[i].timeStamp().microSeconds() - originTime) / width) - chunk.firstColumn;
+            cells[row * chunk.columnCount + column]++;
+        }
+    });
+
+    uint32_t *level0 = levels[0].data();
+    for (const TemporalDensityChunk &chunk : chunks)
+    {
+        if (chunk.tooWide)
+        {
+            for (int i = chunk.start; i < chunk.end; i++)
+            {
+                int column = static_cast<int>((frameData[i].timeStamp().microSeconds() - origin) / bucketWidth);
+                level0[rowOf.value(frameData[i].frameId()) * columns + column]++;
+            }
+            continue;
+        }
+        const uint32_t *cells = chunk.counts.constData();
+        for (int row = 0; row < numRows; row++)
+        {
+            uint32_t *dest = level0 + row * columns + chunk.firstColumn;
+            const uint32_t *src = cells + row * chunk.columnCount;
+            for (int c = 0; c < chunk.columnCount; c++) dest[c] += src[c];
+        }
+    }
+
+    count = static_cast<uint64_t>(numFrames);
+    minTime = start;
+    maxTime = end;
+    minID = ids.first();
+    maxID = ids.last();
+    markDirty(0, columns - 1);
+    refreshLevels();
+}
+
+//frames [start, end) that were just added to the list. Costs only as much as the frames added
+void TemporalDensity::addFrames(const QVector<CANFrame> &frames, int start, int end)
+{
+    for (int i = qMax(0, start); i < end && i < frames.count(); i++)
+    {
+        const CANFrame &frame = frames[i];
+        int64_t stamp = frame.timeStamp().microSeconds();
+        uint32_t id = frame.frameId();
+        if (levels.isEmpty())
+        {
+            //nothing to go on for how long this will run, start fine and let coarsen() widen it
+            setup(stamp, static_cast<int64_t>(TEMPORAL_DENSITY_MAX_COLUMNS) * TEMPORAL_DENSITY_MIN_BUCKET, QVector<uint32_t>());
+            minTime = maxTime = stamp;
+            minID = maxID = id;
+        }
+
+        QHash<uint32_t, int>::const_iterator it = rowOf.constFind(id);
+        int row = (it != rowOf.constEnd()) ? it.value() : addRow(id);
+        int column = bucketFor(stamp);
+        levels[0][row * columns + column]++;
+        markDirty(column, column);
+
+        count++;
+        if (stamp < minTime) minTime = stamp;
+        if (stamp > maxTime) maxTime = stamp;
+    }
+}
+
+int TemporalDensity::addRow(uint32_t id)
+{
+    while (levels.count() > 1 && static_cast<int64_t>(rowIDs.count() + 1) * columns > TEMPORAL_DENSITY_MAX_CELLS) dropFinest();
+
+    int row = rowIDs.count();
+    rowIDs.append(id);
+    rowOf.insert(id, row);
+    for (int i = 0; i < levels.count(); i++) levels[i].resize((row + 1) * (columns >> i));
+    if (id < minID) minID = id;
+    if (id > maxID) maxID = id;
+    return row;
+}
+
+//level 0 column for a time, widening the buckets until it fits. Anything before the first frame goes in column 0
+int TemporalDensity::bucketFor(int64_t time)
+{
+    if (time < origin) return 0;
+    while ((time - origin) / bucketWidth >= columns) coarsen();
+    return static_cast<int>((time - origin) / bucketWidth);
+}
+
+//doubles the bucket width. Every level folds its columns together in pairs into its first half
+void TemporalDensity::coarsen()
+{
+    int rows = rowIDs.count();
+    for (int i = 0; i < levels.count(); i++)
+    {
+        int cols = columns >> i;
+        uint32_t *cells = levels[i].data();
+        for (int row = 0; row < rows; row++)
+        {
+            uint32_t *line = cells + row * cols;
+            for (int c = 0; c < cols / 2; c++) line[c] = line[c * 2] + line[c * 2 + 1];
+            std::fill(line + cols / 2, line + cols, 0);
+        }
+    }
+    bucketWidth *= 2;
+    if (dirtyLow <= dirtyHigh)
+    {
+        dirtyLow /= 2;
+        dirtyHigh /= 2;
+    }
+}
+
+//level 1 becomes level 0. Same time covered with half the columns and half the memory
+void TemporalDensity::dropFinest()
+{
+    refreshLevels();
+    levels.removeFirst();
+    columns /= 2;
+    bucketWidth *= 2;
+}
+
+void TemporalDensity::markDirty(int low, int high)
+{
+    if (low < dirtyLow) dirtyLow = low;
+    if (high > dirtyHigh) dirtyHigh = high;
+}
+
+//works the coarser levels out again from level 0 but only over the columns that changed
+void TemporalDensity::refreshLevels()
+{
+    if (dirtyLow > dirtyHigh) return;
+
+    int rows = rowIDs.count();
+    for (int i = 1; i < levels.count(); i++)
+    {
+        int cols = columns >> i;
+        int low = dirtyLow >> i;
+        int high = dirtyHigh >> i;
+        const uint32_t *prev = levels[i - 1].constData();
+        uint32_t *cells = levels[i].data();
+        for (int row = 0; row < rows; row++)
+        {
+            const uint32_t *src = prev + row * cols * 2;
+            uint32_t *dest = cells + row * cols;
+            for (int c = low; c <= high; c++) dest[c] = src[c * 2] + src[c * 2 + 1];
+        }
+    }
+    dirtyLow = columns;
+    dirtyHigh = -1;
+}
+
+/*
+ * Counts for the time and ID range given, with no more than maxColumns columns (unless even the coarsest level has
+ * more than that in range) and maxBands bands. The columns line up with the buckets of whatever level got used so
+ * the first one can start a little before startTime.
+*/
+TemporalDensityView TemporalDensity::query(double startTime, double endTime, double lowID, double highID, int maxColumns, int maxBands)
+{
+    TemporalDensityView view;
+    if (levels.isEmpty() || rowIDs.isEmpty() || maxColumns < 1 || maxBands < 1) return view;
+    refreshLevels();
+
+    int64_t start = static_cast<int64_t>(std::floor(startTime * 1000000.0));
+    int64_t end = static_cast<int64_t>(std::ceil(endTime * 1000000.0));
+    if (end < origin || end < start || start >= origin + columns * bucketWidth) return view;
+    int first = (start <= origin) ? 0 : static_cast<int>((start - origin) / bucketWidth);
+    int last = static_cast<int>(qMin(static_cast<int64_t>(columns - 1), (end - origin) / bucketWidth));
+
+    int level = 0;
+    while (level < levels.count() - 1 && (last >> level) - (first >> level) + 1 > maxColumns) level++;
+    int levelFirst = first >> level;
+    int levelCols = columns >> level;
+    int64_t width = bucketWidth << level;
+    view.columns = (last >> level) - levelFirst + 1;
+    view.startTime = (origin + levelFirst * width) / 1000000.0;
+    view.columnWidth = width / 1000000.0;
+
+    double low = std::floor(qMax(0.0, lowID));
+    double high = std::ceil(highID);
+    if (high < low) high = low;
+    double span = high - low + 1.0;
+    view.bands = static_cast<int>(qMin(static_cast<double>(maxBands), span));
+    view.bandHeight = span / view.bands;
+    view.lowID = low;
+    view.counts.fill(0.0, view.columns * view.bands);
+
+    const uint32_t *cells = levels[level].constData();
+    double *out = view.counts.data();
+    for (int row = 0; row < rowIDs.count(); row++)
+    {
+        double id = rowIDs[row];
+        if (id < low || id > high) continue;
+        int band = qMin(view.bands - 1, static_cast<int>((id - low) / view.bandHeight));
+        const uint32_t *src = cells + row * levelCols + levelFirst;
+        double *dest = out + band * view.columns;
+        for (int c = 0; c < view.columns; c++)
+        {
+            if (!src[c]) continue;
+            dest[c] += src[c];
+            view.frames += src[c];
+        }
+    }
+    return view;
+}
+
+bool TemporalDensity::isEmpty() const
+{
+    return count == 0;
+}
+
+uint64_t TemporalDensity::frameCount() const
+{
+    return count;
+}
+
+int64_t TemporalDensity::firstTime() const
+{
+    return minTime;
+}
+
+int64_t TemporalDensity::lastTime() const
+{
+    return maxTime;
+}
+
+uint32_t TemporalDensity::lowestID() const
+{
+    return minID;
+}
+
+uint32_t TemporalDensity::highestID() const
+{
+    return maxID;
+}
+
+int TemporalDensity::levelCount() const
+{
+    return levels.count();
+}
+
+int TemporalDensity::columnsAt(int level) const
+{
+    if (level < 0 || level >= levels.count()) return 0;
+    return columns >> level;
+}
+
+int64_t TemporalDensity::bucketWidthAt(int level) const
+{
+    return bucketWidth << level;
+}
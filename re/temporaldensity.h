@@ -0,0 +1,86 @@
+#ifndef TEMPORALDENSITY_H
+#define TEMPORALDENSITY_H
+
+#include <QHash>
+#include <QVector>
+#include "can_structs.h"
+
+#define TEMPORAL_DENSITY_MAX_CELLS      (1 << 23)   //finest level tops out around 32MB of counters
+#define TEMPORAL_DENSITY_MAX_COLUMNS    (1 << 16)
+#define TEMPORAL_DENSITY_MIN_COLUMNS    64          //the coarsest level is never narrower than this
+#define TEMPORAL_DENSITY_MIN_BUCKET     100         //microseconds. Finer than this is better shown as the frames themselves
+
+//counts for the part of a capture that's on screen. Time is in seconds like the graph axis
+class TemporalDensityView
+{
+public:
+    TemporalDensityView() : columns(0), bands(0), startTime(0.0), columnWidth(0.0), lowID(0.0), bandHeight(1.0), frames(0) {}
+
+    int columns;
+    int bands;
+    double startTime;       //left edge of the first column
+    double columnWidth;
+    double lowID;           //bottom edge of the first band
+    double bandHeight;
+    uint64_t frames;        //everything counted in the view
+    QVector<double> counts; //band * columns + column
+};
+
+/*
+ * Frame counts for every ID over time at several resolutions so the temporal graph can show any part of any size
+ * capture by drawing a bounded grid of cells.
+ *
+ * Each ID gets a row. Level 0 splits time into columns of bucketWidth microseconds from the first frame. Every level
+ * after that has half as many columns, each the sum of two from the level before, down to
+ * TEMPORAL_DENSITY_MIN_COLUMNS. A query picks the finest level that doesn't have more columns in the visible time
+ * than there's room for and adds the rows in the visible ID range into bands.
+ *
+ * The finest level is sized so rows * columns stays under TEMPORAL_DENSITY_MAX_CELLS. Frames that come in past the
+ * last column double the bucket width (every level folds pairs of its columns together) and new IDs that push it
+ * over the cell limit drop the finest level. Either way adding frames only ever costs time for the frames added.
+ * The coarser levels are brought up to date from level 0 lazily, only over the columns that changed.
+*/
+class TemporalDensity
+{
+public:
+    TemporalDensity();
+    void clear();
+    void build(const QVector<CANFrame> &frames);
+    void addFrames(const QVector<CANFrame> &frames, int start, int end);
+    TemporalDensityView query(double startTime, double endTime, double lowID, double highID, int maxColumns, int maxBands);
+
+    bool isEmpty() const;
+    uint64_t frameCount() const;
+    int64_t firstTime() const;  //microseconds
+    int64_t lastTime() const;
+    uint32_t lowestID() const;
+    uint32_t highestID() const;
+    int levelCount() const;
+    int columnsAt(int level) const;
+    int64_t bucketWidthAt(int level) const;
+
+private:
+    void setup(int64_t start, int64_t span, const QVector<uint32_t> &ids);
+    int addRow(uint32_t id);
+    int bucketFor(int64_t time);
+    void coarsen();
+    void dropFinest();
+    void refreshLevels();
+    void markDirty(int low, int high);
+
+    int64_t origin;
+    int64_t bucketWidth;    //level 0
+    int columns;            //level 0
+    QVector<uint32_t> rowIDs;
+    QHash<uint32_t, int> rowOf;
+    QVector<QVector<uint32_t>> levels;  //row * columns + column
+    int dirtyLow;           //level 0 columns that changed since the coarser levels were last worked out
+    int dirtyHigh;
+    uint64_t count;
+    int64_t minTime;
+    int64_t maxTime;
+    uint32_t minID;
+    uint32_t maxID;
+};
+
+#endif // TEMPORALDENSITY_H
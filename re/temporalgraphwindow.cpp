@@ -2,6 +2,8 @@
 #include "ui_temporalgraphwindow.h"
 #include "helpwindow.h"
 #include "mainwindow.h"
+#include "guirefreshscheduler.h"
+#include <cmath>
 
 QString HexTicker::getTickLabel (double tick, const QLocale& locale, QChar formatChar, int precision)
 {
@@ -46,11 +48,27 @@ TemporalGraphWindow::TemporalGraphWindow(const QVector<CANFrame> *frames, QWidge
     connect(ui->graphingView, SIGNAL(selectionChangedByUser()), this, SLOT(selectionChanged()));
     connect(ui->graphingView, SIGNAL(mousePress(QMouseEvent*)), this, SLOT(mousePress()));
     connect(ui->graphingView, SIGNAL(mouseWheel(QWheelEvent*)), this, SLOT(mouseWheel()));
-    connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    GUIRefreshScheduler::getReference()->addWindow(this, &TemporalGraphWindow::updatedFrames, REFRESH_LOW, 500);
     // make bottom and left axes transfer their ranges to top and right axes:
     connect(ui->graphingView->xAxis, SIGNAL(rangeChanged(QCPRange)), ui->graphingView->xAxis2, SLOT(setRange(QCPRange)));
     connect(ui->graphingView->yAxis, SIGNAL(rangeChanged(QCPRange)), ui->graphingView->yAxis2, SLOT(setRange(QCPRange)));
 
+    //density goes underneath, the individual frames get drawn over it once zoomed in far enough
+    colorMap = new QCPColorMap(ui->graphingView->xAxis, ui->graphingView->yAxis);
+    colorMap->setGradient(QCPColorGradient::gpJet);
+    colorMap->setInterpolate(false);
+    graph = ui->graphingView->addGraph();
+    graph->setLineStyle(QCPGraph::lsNone); //no lines
+    graph->setScatterStyle(QCPScatterStyle::ssCircle);
+    QPen graphPen;
+    graphPen.setColor(Qt::blue);
+    graphPen.setWidth(2);
+    graph->setPen(graphPen);
+    followGraphEnd = false;
+    xminval = xmaxval = yminval = ymaxval = 0.0;
+    shownFrames = 0;
+    connect(ui->graphingView, &QCustomPlot::beforeReplot, this, &TemporalGraphWindow::updateView);
+
     if (useOpenGL)
     {
         ui->graphingView->setAntialiasedElements(QCP::aeAll);
@@ -109,158 +127,122 @@ void TemporalGraphWindow::writeSettings()
 
 void TemporalGraphWindow::updatedFrames(int numFrames)
 {
-    CANFrame thisFrame;
-    QVector<double> x, y;
-    bool appendedToGraph = false;
-    bool needReplot = false;
-
     if (numFrames == -1) //all frames deleted. Kill the display
     {
-        //removeAllGraphs();
-        //now instead of removing the graphs regenerate them which will blank them out but leave them there in case
-        //more traffic that matches comes in or someone otherwise loads more data
-        ui->graphingView->clearGraphs(); //temporarily remove the graphs from the graph view
-        ui->graphingView->clearPlottables();
-        ui->graphingView->replot(); //now, redisplay them all
-
+        density.clear();
+        shownSize = QSize(); //makes updateView fill in again even if nothing else looks different
+        ui->graphingView->replot();
     }
     else if (numFrames == -2) //all new set of frames. Reset
     {
-        //there shouldn't be any need to actually remove the graphs.
-        //regenerate them instead
-        ui->graphingView->clearGraphs(); //temporarily remove the graphs from the graph view
-        //needScaleSetup = true;
         generateGraph();
-        //ui->graphingView->replot(); //now, redisplay them all
     }
-    else //just got some new frames. See if they are relevant.
+    else //just got some new frames. Only they need counting
     {
         if (numFrames > modelFrames->count()) return;
 
-            appendedToGraph = false;
-            x.clear();
-            y.clear();
-            for (int i = modelFrames->count() - numFrames; i < modelFrames->count(); i++)
-            {
-                thisFrame = modelFrames->at(i);
-                /*
-                if (graphParams[j].ID == thisFrame.ID)
-                {
-                    appendToGraph(graphParams[j], thisFrame, x, y);
-                    appendedToGraph = true;
-                }*/
-            }
-            if (appendedToGraph)
-            {
-                //graphParams[j].ref->addData(x, y);
-                needReplot = true;
-            }
-
-        if (needReplot)
+        bool wasEmpty = density.isEmpty();
+        density.addFrames(*modelFrames, modelFrames->count() - numFrames, modelFrames->count());
+        if (density.isEmpty()) return;
+        updateExtents();
+        if (wasEmpty)
+        {
+            resetView();
+            return;
+        }
+
+        if (followGraphEnd)
         {
-            if (followGraphEnd)
-            {
-                //find the current X span and maintain that span but move the end of it over to match the new end
-                //of the actual graph. This causes the view to move with the data to always show the end
-                QCPRange range = ui->graphingView->xAxis->range();
-                double size = range.size();
-                bool foundRange;
-                QCPRange keyRange = ui->graphingView->graph()->getKeyRange(foundRange);
-                if (foundRange)
-                {
-                    double end, start;
-                    end = keyRange.upper;
-                    start = end - size;
-                    ui->graphingView->xAxis->setRange(start, end);
-                }
-            }
-            ui->graphingView->replot();
+            //keep the current X span but slide it over so it ends where the frames do now
+            QCPRange range = ui->graphingView->xAxis->range();
+            ui->graphingView->xAxis->setRange(xmaxval - range.size(), xmaxval);
         }
+        ui->graphingView->replot();
     }
 }
 
-void TemporalGraphWindow::generateGraph()
+void TemporalGraphWindow::updateExtents()
 {
-    if (modelFrames->count() == 0) return;
-
-    ui->graphingView->clearGraphs();
-    ui->graphingView->clearPlottables();
-
-    qDebug() << "Regenerating the graph";
-    ui->graphingView->addGraph();
-    graph = ui->graphingView->graph();
-
-    QVector<double> x, y;
-    int frameCount = modelFrames->count();
-
-    x.reserve(frameCount);
-    y.reserve(frameCount);
+    xminval = density.firstTime() / 1000000.0;
+    xmaxval = density.lastTime() / 1000000.0;
+    yminval = density.lowestID();
+    ymaxval = density.highestID();
+}
 
-    xminval = xmaxval = modelFrames->at(0).timeStamp().microSeconds() / 1000000.0;
-    yminval = ymaxval = modelFrames->at(0).frameId();
+/*
+ * Counts the whole list into the density pyramid. After this zooming and panning only ever looks at the pyramid
+ * so it costs the same however big the capture is.
+*/
+void TemporalGraphWindow::generateGraph()
+{
+    density.build(*modelFrames);
+    shownSize = QSize();
 
-    for (int i = 0; i < frameCount; i++)
+    if (density.isEmpty())
     {
-        x.append(modelFrames->at(i).timeStamp().microSeconds() / 1000000.0);
-        y.append(modelFrames->at(i).frameId());
-        if (x[i] > xmaxval) xmaxval = x[i];
-        if (x[i] < xminval) xminval = x[i];
-        if (y[i] > ymaxval) ymaxval = y[i];
-        if (y[i] < yminval) yminval = y[i];
+        ui->graphingView->replot();
+        return;
     }
+    updateExtents();
+    resetView();
+}
 
-    ui->graphingView->graph()->setData(x,y);
-    ui->graphingView->graph()->setLineStyle(QCPGraph::lsNone); //no lines
-    ui->graphingView->graph()->setScatterStyle(QCPScatterStyle::ssCircle);
-    QPen graphPen;
-    graphPen.setColor(Qt::blue);
-    graphPen.setWidth(2);
-    ui->graphingView->graph()->setPen(graphPen);
-
-    qDebug() << "xmin: " << xminval;
-    qDebug() << "xmax: " << xmaxval;
-    qDebug() << "ymin: " << yminval;
-    qDebug() << "ymax: " << ymaxval;
-
-    ui->graphingView->xAxis->setRange(xminval, xmaxval);
-    ui->graphingView->yAxis->setRange(yminval, ymaxval);
-    ui->graphingView->axisRect()->setupFullAxesBox();
-
-    ui->graphingView->replot();
-
-
-    QCPColorMap *colorMap = new QCPColorMap(ui->graphingView->xAxis, ui->graphingView->yAxis);
-
-    int ySize = static_cast<int>(ymaxval - yminval) / 30 + 1;
-    int xSize = static_cast<int>((xmaxval - xminval) * 4.0) + 1;
-    colorMap->data()->setSize(xSize, ySize);
-    colorMap->data()->setRange(QCPRange(xminval, xmaxval), QCPRange(yminval, ymaxval));
-    for (int x = 0; x < xSize; ++x)
+/*
+ * Fills the color map with counts for whatever is on screen at about a cell every couple of pixels. Once few enough
+ * frames are in view they get drawn as points on top. Runs right before every replot so zooming and panning always
+ * get the right detail, and only does the work when the view or the frames actually changed.
+*/
+void TemporalGraphWindow::updateView()
+{
+    QCPRange xRange = ui->graphingView->xAxis->range();
+    QCPRange yRange = ui->graphingView->yAxis->range();
+    QRect rect = ui->graphingView->axisRect()->rect();
+    if (xRange == shownXRange && yRange == shownYRange && rect.size() == shownSize && density.frameCount() == shownFrames) return;
+    shownXRange = xRange;
+    shownYRange = yRange;
+    shownSize = rect.size();
+    shownFrames = density.frameCount();
+
+    TemporalDensityView view = density.query(xRange.lower, xRange.upper, yRange.lower, yRange.upper,
+                                             qMax(1, rect.width() / 2), qMax(1, rect.height() / 2));
+    if (view.columns == 0 || view.frames == 0)
     {
-      for (int y = 0; y < ySize; ++y)
-      {
-        colorMap->data()->setAlpha(x, y, 180);
-        colorMap->data()->setCell(x, y, 0.0);
-      }
+        colorMap->data()->clear();
+        graph->data()->clear();
+        return;
     }
 
-    for (int i = 0; i < frameCount; i++)
+    colorMap->data()->setSize(view.columns, view.bands);
+    colorMap->data()->setRange(QCPRange(view.startTime + view.columnWidth / 2, view.startTime + (view.columns - 0.5) * view.columnWidth),
+                               QCPRange(view.lowID + view.bandHeight / 2, view.lowID + (view.bands - 0.5) * view.bandHeight));
+    for (int band = 0; band < view.bands; band++)
     {
-        int x = static_cast<int>(((modelFrames->at(i).timeStamp().microSeconds() / 1000000.0) - xminval) * 4.0);
-        int y = static_cast<int>(modelFrames->at(i).frameId() - yminval) / 30;
-        double val = colorMap->data()->cell(x, y);
-        double inc;
-        inc = 1 / (val + 1); //logarithmic decay
-        inc = inc * inc; //square the increment to make it even more stark
-        val = val + inc;
-        qDebug() << "X: " << x << " Y: " << y << "Val: " << val;
-        colorMap->data()->setCell(x, y, val);
+        for (int column = 0; column < view.columns; column++)
+        {
+            //log scale so the odd frame still shows up next to IDs sent every few milliseconds
+            colorMap->data()->setCell(column, band, std::log1p(view.counts[band * view.columns + column]));
+        }
     }
-
-    colorMap->setGradient(QCPColorGradient::gpJet);
     colorMap->rescaleDataRange(true);
-    ui->graphingView->rescaleAxes();
-    ui->graphingView->replot();
+
+    QVector<double> x, y;
+    int firstRow, lastRow;
+    const CANFrameIndex *index = MainWindow::getReference()->getCANFrameModel()->getFrameIndex(modelFrames);
+    int64_t startTime = static_cast<int64_t>(std::floor(xRange.lower * 1000000.0));
+    int64_t endTime = static_cast<int64_t>(std::ceil(xRange.upper * 1000000.0));
+    if (view.frames <= TEMPORAL_MAX_POINTS && index && index->rowsInTimeRange(*modelFrames, startTime, endTime, firstRow, lastRow))
+    {
+        x.reserve(static_cast<int>(view.frames));
+        y.reserve(static_cast<int>(view.frames));
+        for (int i = firstRow; i <= lastRow && i < modelFrames->count(); i++)
+        {
+            double id = modelFrames->at(i).frameId();
+            if (id < yRange.lower || id > yRange.upper) continue;
+            x.append(modelFrames->at(i).timeStamp().microSeconds() / 1000000.0);
+            y.append(id);
+        }
+    }
+    graph->setData(x, y, true);
 }
 
 void TemporalGraphWindow::selectionChanged()
@@ -359,8 +341,11 @@ bool TemporalGraphWindow::eventFilter(QObject *obj, QEvent *event)
 
 void TemporalGraphWindow::resetView()
 {
-    ui->graphingView->xAxis->setRange(xminval, xmaxval);
-    ui->graphingView->yAxis->setRange(yminval, ymaxval);
+    //a little room around the edges so the first and last frames and the lowest and highest IDs aren't on the border
+    double xPad = qMax((xmaxval - xminval) * 0.01, 0.001);
+    double yPad = qMax((ymaxval - yminval) * 0.02, 1.0);
+    ui->graphingView->xAxis->setRange(xminval - xPad, xmaxval + xPad);
+    ui->graphingView->yAxis->setRange(yminval - yPad, ymaxval + yPad);
     ui->graphingView->axisRect()->setupFullAxesBox();
 
     ui->graphingView->replot();
@@ -4,6 +4,10 @@
 #include <QDialog>
 #include "qcustomplot.h"
 #include "can_structs.h"
+#include "temporaldensity.h"
+
+//frames in view at or under this get drawn as points as well as counted into the background
+#define TEMPORAL_MAX_POINTS     20000
 
 namespace Ui {
 class TemporalGraphWindow;
@@ -31,6 +35,7 @@ private slots:
     void zoomIn();
     void zoomOut();
     void selectionChanged();
+    void updateView();
 
 private:
     Ui::TemporalGraphWindow *ui;    
@@ -38,12 +43,18 @@ private:
     bool useOpenGL;
     bool followGraphEnd;
     QCPGraph *graph;
+    QCPColorMap *colorMap;
+    TemporalDensity density;
     double xminval, xmaxval, yminval, ymaxval;
+    QCPRange shownXRange, shownYRange;  //what updateView last filled in for
+    QSize shownSize;
+    uint64_t shownFrames;
     void closeEvent(QCloseEvent *event);
     bool eventFilter(QObject *obj, QEvent *event);
     void readSettings();
     void writeSettings();
     void generateGraph();
+    void updateExtents();
 
 };
 
@@ -213,15 +213,61 @@ void CANScriptHelper::setFilter(QJSValue id, QJSValue mask, QJSValue bus)
     filter.setFilter(idVal, maskVal, busVal);
     filters.append(filter);
 
-    CANConManager::getInstance()->addTargettedFrame(busVal, idVal, maskVal, this);
+    //with an expression set we already get every frame. Registering again would deliver some of them twice
+    if (filterExpression.isEmpty()) CANConManager::getInstance()->addTargettedFrame(busVal, idVal, maskVal, this);
+}
+
+/*
+ * The expression has to see every frame from every bus and sort them out itself so it swaps the ID/mask targets
+ * for one catch all target while it's set. The ID/mask filters still count, a frame gets delivered if it passes
+ * either one. A bad expression returns false and leaves the old one in place.
+*/
+bool CANScriptHelper::setFilterExpression(QJSValue expression)
+{
+    qDebug() << "Called set filter expression " << expression.toString();
+    CANFilterExpression newExpression;
+    if (!newExpression.compile(expression.toString()))
+    {
+        qDebug() << "Filter expression didn't compile: " << newExpression.getLastError();
+        return false;
+    }
+
+    bool hadExpression = !filterExpression.isEmpty();
+    filterExpression = newExpression;
+
+    if (!hadExpression && !filterExpression.isEmpty())
+    {
+        foreach (CANFilter filter, filters)
+        {
+            CANConManager::getInstance()->removeTargettedFrame(filter.bus, filter.ID, filter.mask, this);
+        }
+        CANConManager::getInstance()->addTargettedFrame(-1, 0, 0, this);
+    }
+    else if (hadExpression && filterExpression.isEmpty())
+    {
+        CANConManager::getInstance()->removeTargettedFrame(-1, 0, 0, this);
+        foreach (CANFilter filter, filters)
+        {
+            CANConManager::getInstance()->addTargettedFrame(filter.bus, filter.ID, filter.mask, this);
+        }
+    }
+    return true;
 }
 
 void CANScriptHelper::clearFilters()
 {
     qDebug() << "Called clear filters";
-    foreach (CANFilter filter, filters)
+    if (!filterExpression.isEmpty())
     {
-        CANConManager::getInstance()->removeTargettedFrame(filter.bus, filter.ID, filter.mask, this);
+        CANConManager::getInstance()->removeTargettedFrame(-1, 0, 0, this);
+        filterExpression.clear();
+    }
+    else
+    {
+        foreach (CANFilter filter, filters)
+        {
+            CANConManager::getInstance()->removeTargettedFrame(filter.bus, filter.ID, filter.mask, this);
+        }
     }
 
     filters.clear();
@@ -258,20 +304,27 @@ void CANScriptHelper::gotTargettedFrame(const CANFrame &frame)
     const unsigned char *data = reinterpret_cast<const unsigned char *>(frame.payload().constData());
     int dataLen = frame.payload().length();
 
-    for (int i = 0; i < filters.length(); i++)
+    //as soon as one filter matches we're done looking
+    bool matched = false;
+    for (int i = 0; i < filters.length() && !matched; i++)
     {
-        if (filters[i].checkFilter(frame.frameId(), frame.bus))
-        {
-            QJSValueList args;
-            args << frame.bus << frame.frameId() << static_cast<uint>(frame.payload().length());
-            QJSValue dataBytes = scriptEngine->newArray(dataLen);
-
-            for (int j = 0; j < dataLen; j++) dataBytes.setProperty(j, QJSValue(data[j]));
-            args.append(dataBytes);
-            gotFrameFunction.call(args);
-            return; //as soon as one filter matches we jump out
-        }
+        matched = filters[i].checkFilter(frame.frameId(), frame.bus);
     }
+    if (!matched && !filterExpression.isEmpty())
+    {
+        if (filterExpression.needsResolve()) filterExpression.resolveSignals();
+        matched = filterExpression.matches(frame);
+    }
+
+    if (!matched) return;
+
+    QJSValueList args;
+    args << frame.bus << frame.frameId() << static_cast<uint>(frame.payload().length());
+    QJSValue dataBytes = scriptEngine->newArray(dataLen);
+
+    for (int j = 0; j < dataLen; j++) dataBytes.setProperty(j, QJSValue(data[j]));
+    args.append(dataBytes);
+    gotFrameFunction.call(args);
 }
 
 
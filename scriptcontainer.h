@@ -3,6 +3,7 @@
 
 #include "can_structs.h"
 #include "canfilter.h"
+#include "canfilterexpression.h"
 #include "bus_protocols/isotp_handler.h"
 #include "bus_protocols/isotp_message.h"
 #include "bus_protocols/uds_handler.h"
@@ -22,6 +23,7 @@ public:
 
 public slots:
     void setFilter(QJSValue id, QJSValue mask, QJSValue bus);
+    bool setFilterExpression(QJSValue expression);
     void clearFilters();
     void sendFrame(QJSValue bus, QJSValue id, QJSValue length, QJSValue data);
     void setRxCallback(QJSValue cb);
@@ -31,6 +33,7 @@ private slots:
 
 private:
     QList<CANFilter> filters;
+    CANFilterExpression filterExpression; //frames matching this get delivered too, on top of the ID/mask filters
     QJSValue gotFrameFunction;
     QJSEngine *scriptEngine;
 };
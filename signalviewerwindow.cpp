@@ -2,7 +2,9 @@
 #include "ui_signalviewerwindow.h"
 #include "helpwindow.h"
 #include "mainwindow.h"
+#include "guirefreshscheduler.h"
 #include "utility.h"
+#include "dbc/dbcsignalcache.h"
 #include <QDebug>
 
 #define MSG_COL     1
@@ -46,7 +48,7 @@ SignalViewerWindow::SignalViewerWindow(const QVector<CANFrame> *frames, QWidget
     connect(ui->cbNodes, SIGNAL(currentIndexChanged(int)), this, SLOT(loadMessages(int)));
     connect(ui->cbMessages, SIGNAL(currentIndexChanged(int)), this, SLOT(loadSignals(int)));
     connect(ui->btnAdd, SIGNAL(clicked(bool)), this, SLOT(addSignal()));
-    connect(MainWindow::getReference(), SIGNAL(framesUpdated(int)), this, SLOT(updatedFrames(int)));
+    GUIRefreshScheduler::getReference()->addWindow(this, &SignalViewerWindow::updatedFrames, REFRESH_HIGH, 250);
     connect(ui->btnRemove, SIGNAL(clicked(bool)), this, SLOT(removeSelectedSignal()));
     connect(ui->btnSave, SIGNAL(clicked(bool)), this, SLOT(saveSignalsFile()));
     connect(ui->btnLoad, SIGNAL(clicked(bool)), this, SLOT(loadSignalsFile()));
@@ -70,10 +72,9 @@ void SignalViewerWindow::updatedFrames(int numFrames)
     }
     else if (numFrames == -2) //all new set of frames. Reset
     {
-        for (int i = 0; i < modelFrames->count(); i++)
+        for (int i = 0; i < signalList.count(); i++)
         {
-            thisFrame = modelFrames->at(i);
-            processFrame(thisFrame);
+            showLatestValue(i);
         }
     }
     else //just got some new frames. See if they are relevant.
@@ -102,19 +103,41 @@ void SignalViewerWindow::processFrame(CANFrame &frame)
             {
                 if (sig->processAsText(frame, sigString, false)) //if true we could interpret the signal so update it in the list
                 {
-                    QTableWidgetItem *item = ui->tableViewer->item(i, VALUE_COL);
-                    if (!item)
-                    {
-                        item = new QTableWidgetItem(sigString);
-                        ui->tableViewer->setItem(i, VALUE_COL, item);
-                    }
-                    else item->setText(sigString);
+                    setValueText(i, sigString);
                 }
             }
         }
     }
 }
 
+//Only the newest value matters here. The signal cache already knows which frame that came from
+//so there's no need to run every frame in the list through processFrame to find it.
+void SignalViewerWindow::showLatestValue(int row)
+{
+    QString sigString;
+    DBC_SIGNAL *sig = signalList.at(row);
+    if (!sig) return;
+
+    DBCSignalSeries series = DBCSignalCache::getReference()->getSeries(sig, -1, modelFrames);
+    if (series.count() == 0) return;
+
+    if (sig->processAsText(modelFrames->at(series.frameIndexes.last()), sigString, false))
+    {
+        setValueText(row, sigString);
+    }
+}
+
+void SignalViewerWindow::setValueText(int row, const QString &text)
+{
+    QTableWidgetItem *item = ui->tableViewer->item(row, VALUE_COL);
+    if (!item)
+    {
+        item = new QTableWidgetItem(text);
+        ui->tableViewer->setItem(row, VALUE_COL, item);
+    }
+    else item->setText(text);
+}
+
 void SignalViewerWindow::removeSelectedSignal()
 {
     int selRow = ui->tableViewer->currentRow();
@@ -232,6 +255,8 @@ void SignalViewerWindow::addSignal(DBC_SIGNAL *sig)
     ui->tableViewer->setItem(rowIdx, 0, nodeitem);
     QTableWidgetItem *msgitem = new QTableWidgetItem(sig->name);
     ui->tableViewer->setItem(rowIdx, 1, msgitem);
+
+    showLatestValue(rowIdx);
 }
 
 void SignalViewerWindow::saveSignalsFile()
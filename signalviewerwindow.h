@@ -42,6 +42,8 @@ private:
     const QVector<CANFrame> *modelFrames;
 
     void processFrame(CANFrame &frame);
+    void showLatestValue(int row);
+    void setValueText(int row, const QString &text);
 };
 
 #endif // SIGNALVIEWERWINDOW_H
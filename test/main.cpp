@@ -2,11 +2,27 @@
 
 #include "tst_lfqueue.h"
 #include "tst_cancon.h"
+#include "tst_dbcroundtrip.h"
+#include "tst_canfilterexpression.h"
+#include "tst_canfilterlistmodel.h"
+#include "tst_canframestats.h"
+#include "tst_canframeindex.h"
+#include "tst_frameselection.h"
+#include "tst_rangesignalmatrix.h"
+#include "tst_discretestatecorrelator.h"
+#include "tst_framecomparison.h"
+#include "tst_bitactivity.h"
+#include "tst_temporaldensity.h"
+#include "tst_graphdecimator.h"
+#include "tst_sniffermodel.h"
+#include "tst_guirefreshscheduler.h"
+#include "tst_framecaptureobject.h"
 
 
 int main(int argc, char** argv)
 {
-   QCoreApplication app(argc, argv);
+   //the DBC code pulls default colors out of the application palette so this has to be a full QApplication
+   QApplication app(argc, argv);
 
    int status = 0;
    auto ASSERT_TEST = [&status, argc, argv](QObject* obj) {
@@ -16,6 +32,21 @@ int main(int argc, char** argv)
 
    ASSERT_TEST(new TestLFQueue());
    ASSERT_TEST(new TestCanCon(CANCon::SOCKETCAN, "vcan0", 1));
+   ASSERT_TEST(new TestDBCRoundTrip());
+   ASSERT_TEST(new TestCANFilterExpression());
+   ASSERT_TEST(new TestCANFilterListModel());
+   ASSERT_TEST(new TestCANFrameStats());
+   ASSERT_TEST(new TestCANFrameIndex());
+   ASSERT_TEST(new TestFrameSelection());
+   ASSERT_TEST(new TestRangeSignalMatrix());
+   ASSERT_TEST(new TestDiscreteStateCorrelator());
+   ASSERT_TEST(new TestFrameComparison());
+   ASSERT_TEST(new TestBitActivity());
+   ASSERT_TEST(new TestTemporalDensity());
+   ASSERT_TEST(new TestGraphDecimator());
+   ASSERT_TEST(new TestSnifferModel());
+   ASSERT_TEST(new TestGUIRefreshScheduler());
+   ASSERT_TEST(new TestFrameCaptureObject());
 
    return status;
 }
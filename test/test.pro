@@ -1,4 +1,4 @@
-QT += core gui serialbus widgets testlib serialbus
+QT += core gui serialbus widgets testlib serialbus concurrent
 
 
 CONFIG += c++11
@@ -9,6 +9,43 @@ SOURCES += \
     tst_lfqueue.cpp \
     main.cpp \
     tst_cancon.cpp \
+    tst_dbcroundtrip.cpp \
+    tst_canfilterexpression.cpp \
+    tst_canfilterlistmodel.cpp \
+    tst_canframestats.cpp \
+    tst_canframeindex.cpp \
+    tst_frameselection.cpp \
+    tst_rangesignalmatrix.cpp \
+    tst_discretestatecorrelator.cpp \
+    tst_framecomparison.cpp \
+    tst_bitactivity.cpp \
+    tst_temporaldensity.cpp \
+    tst_graphdecimator.cpp \
+    tst_sniffermodel.cpp \
+    tst_guirefreshscheduler.cpp \
+    tst_framecaptureobject.cpp \
+    ../canfilterexpression.cpp \
+    ../canfilterlistmodel.cpp \
+    ../canframeindex.cpp \
+    ../frameselection.cpp \
+    ../canframestats.cpp \
+    ../bitactivity.cpp \
+    ../guirefreshscheduler.cpp \
+    ../framecaptureobject.cpp \
+    ../re/rangesignalmatrix.cpp \
+    ../re/discretestatecorrelator.cpp \
+    ../re/framecomparison.cpp \
+    ../re/temporaldensity.cpp \
+    ../re/graphdecimator.cpp \
+    ../re/sniffer/snifferitem.cpp \
+    ../re/sniffer/sniffermodel.cpp \
+    ../utils/tdigest.cpp \
+    ../filterutility.cpp \
+    ../dbc/dbc_classes.cpp \
+    ../dbc/dbchandler.cpp \
+    ../dbc/dbccache.cpp \
+    ../dbc/dbcwriter.cpp \
+    ../utility.cpp \
     ../connections/canconfactory.cpp \
     ../connections/canconnection.cpp \
     ../connections/gvretserial.cpp \
@@ -25,6 +62,43 @@ INSTALLS += target
 HEADERS += \
     tst_lfqueue.h \
     tst_cancon.h \
+    tst_dbcroundtrip.h \
+    tst_canfilterexpression.h \
+    tst_canfilterlistmodel.h \
+    tst_canframestats.h \
+    tst_canframeindex.h \
+    tst_frameselection.h \
+    tst_rangesignalmatrix.h \
+    tst_discretestatecorrelator.h \
+    tst_framecomparison.h \
+    tst_bitactivity.h \
+    tst_temporaldensity.h \
+    tst_graphdecimator.h \
+    tst_sniffermodel.h \
+    tst_guirefreshscheduler.h \
+    tst_framecaptureobject.h \
+    ../canfilterexpression.h \
+    ../canfilterlistmodel.h \
+    ../canframeindex.h \
+    ../frameselection.h \
+    ../canframestats.h \
+    ../bitactivity.h \
+    ../guirefreshscheduler.h \
+    ../framecaptureobject.h \
+    ../re/rangesignalmatrix.h \
+    ../re/discretestatecorrelator.h \
+    ../re/framecomparison.h \
+    ../re/temporaldensity.h \
+    ../re/graphdecimator.h \
+    ../re/sniffer/snifferitem.h \
+    ../re/sniffer/sniffermodel.h \
+    ../utils/tdigest.h \
+    ../filterutility.h \
+    ../dbc/dbc_classes.h \
+    ../dbc/dbchandler.h \
+    ../dbc/dbccache.h \
+    ../dbc/dbcwriter.h \
+    ../utility.h \
     ../connections/canconconst.h \
     ../connections/canconfactory.h \
     ../connections/canconnection.h \
@@ -0,0 +1,121 @@
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include "bitactivity.h"
+#include "canframeindex.h"
+#include "canframestats.h"
+#include "tst_bitactivity.h"
+
+
+/*
+ * Byte 0 counts, byte 1 is random, byte 2 only ever flips its top bit now and then and the rest hold still. With
+ * pVaryLength some frames are short and some are CAN-FD so bytes come and go.
+*/
+QVector<CANFrame> TestBitActivity::pMakeFrames(int pNumFrames, bool pVaryLength, quint32 pSeed)
+{
+    QRandomGenerator rng(pSeed);
+    QVector<CANFrame> frames;
+    frames.reserve(pNumFrames);
+    for (int i = 0; i < pNumFrames; i++)
+    {
+        int len = 8;
+        if (pVaryLength) len = (i % 7 == 0) ? 64 : static_cast<int>(rng.bounded(9));
+        QByteArray data(len, 0x33);
+        if (len > 0) data[0] = static_cast<char>(i);
+        if (len > 1) data[1] = static_cast<char>(rng.bounded(256));
+        if (len > 2) data[2] = static_cast<char>((rng.bounded(10) == 0) ? 0x85 : 0x05);
+        for (int b = 8; b < len; b++) data[b] = static_cast<char>(rng.bounded(256));
+
+        CANFrame frame;
+        frame.setFrameId(0x200 + (i % 3));
+        frame.bus = 0;
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, i * 1000));
+        frame.setPayload(data);
+        frames.append(frame);
+    }
+    return frames;
+}
+
+//word at a time counting has to come out exactly the same as the bit by bit code, flushes and length changes included
+void TestBitActivity::matchesAddFrame()
+{
+    for (int pass = 0; pass < 2; pass++)
+    {
+        QVector<CANFrame> frames = pMakeFrames(3000, pass == 1, 7 + pass);
+        CANIDStats stats;
+        for (const CANFrame &frame : frames) stats.addFrame(frame);
+        BitActivity activity;
+        //split in two so the state carried between calls gets checked too
+        activity.addFrames(frames.mid(0, 1234));
+        activity.addFrames(frames.mid(1234));
+
+        QCOMPARE(activity.frameCount(), stats.count);
+        QCOMPARE(activity.byteCount(), stats.byteCount());
+        QCOMPARE(activity.minData, stats.minData);
+        QCOMPARE(activity.maxData, stats.maxData);
+        QCOMPARE(activity.changedBits, stats.changedBits);
+        QCOMPARE(activity.bitSetCounts, stats.bitSetCounts);
+        QCOMPARE(activity.bitFlipCounts, stats.bitFlipCounts);
+        QCOMPARE(activity.byteHistogram, stats.byteHistogram);
+    }
+
+    //the counter's low bit changes every frame, the constant bytes never do
+    BitActivity activity;
+    activity.addFrames(pMakeFrames(1000, false, 1));
+    QCOMPARE(activity.bitFlipCounts[0], static_cast<uint64_t>(999));
+    QCOMPARE(activity.bitFlipCounts[1], static_cast<uint64_t>(499));
+    QCOMPARE(activity.flipRatio(3 * 8), 0.0);
+    QCOMPARE(activity.changedBits[2], static_cast<uint8_t>(0x80));
+    uint8_t heat[64];
+    activity.heat(heat, 64);
+    QCOMPARE(heat[0], static_cast<uint8_t>(254));
+    QCOMPARE(heat[40], static_cast<uint8_t>(0));
+}
+
+void TestBitActivity::statsFromRows()
+{
+    QVector<CANFrame> frames = pMakeFrames(5000, true, 3);
+    CANFrameIndex index;
+    index.update(frames);
+    CANFrameRows rows(&frames, index.rowsMatching(0x201, 0x201, -1));
+
+    CANIDStats oneByOne;
+    for (int i = 0; i < rows.count(); i++) oneByOne.addFrame(rows[i]);
+    CANIDStats together;
+    together.addFrames(rows);
+
+    QCOMPARE(together.count, oneByOne.count);
+    QCOMPARE(together.minLen, oneByOne.minLen);
+    QCOMPARE(together.maxLen, oneByOne.maxLen);
+    QCOMPARE(together.lengthCounts, oneByOne.lengthCounts);
+    QCOMPARE(together.minInterval, oneByOne.minInterval);
+    QCOMPARE(together.maxInterval, oneByOne.maxInterval);
+    QCOMPARE(together.intervalMean(), oneByOne.intervalMean());
+    QCOMPARE(together.minData, oneByOne.minData);
+    QCOMPARE(together.maxData, oneByOne.maxData);
+    QCOMPARE(together.changedBits, oneByOne.changedBits);
+    QCOMPARE(together.bitSetCounts, oneByOne.bitSetCounts);
+    QCOMPARE(together.bitFlipCounts, oneByOne.bitFlipCounts);
+    QCOMPARE(together.byteHistogram, oneByOne.byteHistogram);
+}
+
+void TestBitActivity::perID()
+{
+    QVector<CANFrame> frames = pMakeFrames(9000, false, 5);
+    CANFrameIndex index;
+    index.update(frames);
+    QVector<uint32_t> ids;
+    ids << 0x200 << 0x201 << 0x202 << 0x7FF;
+
+    QVector<BitActivity> activity = BitActivity::forIDs(frames, index, ids);
+    QCOMPARE(activity.count(), 4);
+    for (int i = 0; i < 3; i++)
+    {
+        QCOMPARE(activity[i].id, ids[i]);
+        QCOMPARE(activity[i].frameCount(), static_cast<uint64_t>(3000));
+        BitActivity single;
+        single.addFrames(frames.constData(), index.rowsMatching(ids[i], ids[i], -1));
+        QCOMPARE(activity[i].bitFlipCounts, single.bitFlipCounts);
+    }
+    QCOMPARE(activity[3].frameCount(), static_cast<uint64_t>(0));
+}
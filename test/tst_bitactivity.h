@@ -0,0 +1,20 @@
+#ifndef TST_BITACTIVITY_H
+#define TST_BITACTIVITY_H
+
+#include <QObject>
+
+#include "can_structs.h"
+
+class TestBitActivity: public QObject
+{
+    Q_OBJECT
+private:
+    QVector<CANFrame> pMakeFrames(int pNumFrames, bool pVaryLength, quint32 pSeed);
+
+private slots:
+    void matchesAddFrame();
+    void statsFromRows();
+    void perID();
+};
+
+#endif // TST_BITACTIVITY_H
@@ -0,0 +1,237 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+
+#include "canfilterexpression.h"
+#include "dbc/dbchandler.h"
+#include "tst_canfilterexpression.h"
+
+
+static const char sampleDBC[] =
+    "VERSION \"\"\n"
+    "\n"
+    "BS_:\n"
+    "\n"
+    "BU_: ECU1 ECU2\n"
+    "\n"
+    "BO_ 256 EngineData: 8 ECU1\n"
+    " SG_ EngineSpeed : 0|16@1+ (0.25,0) [0|16383.75] \"rpm\" ECU2\n"
+    " SG_ CoolantTemp : 16|8@1- (1,-40) [-40|215] \"degC\" ECU2\n"
+    "\n"
+    "BO_ 2566844926 DiagFrame: 8 ECU2\n"
+    " SG_ Mode M : 0|8@1+ (1,0) [0|255] \"\" ECU1\n"
+    " SG_ Voltage m1 : 8|16@1+ (0.001,0) [0|65.535] \"V\" ECU1\n"
+    " SG_ Current m2 : 8|16@1- (0.01,0) [-327.68|327.67] \"A\" ECU1\n";
+
+
+CANFrame TestCANFilterExpression::pMakeFrame(uint32_t pId, int pBus, QByteArray pData)
+{
+    CANFrame frame;
+    frame.setFrameId(pId);
+    frame.setExtendedFrameFormat(pId > 0x7FF);
+    frame.bus = pBus;
+    frame.setPayload(pData);
+    return frame;
+}
+
+
+void TestCANFilterExpression::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    QVERIFY(mDir.isValid());
+    QString name = mDir.filePath("filter.dbc");
+    QFile file(name);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(sampleDBC);
+    file.close();
+
+    QVERIFY(DBCHandler::getReference()->loadDBCFile(name));
+}
+
+
+void TestCANFilterExpression::cleanupTestCase()
+{
+    DBCHandler::getReference()->removeAllFiles();
+}
+
+
+void TestCANFilterExpression::badExpressions()
+{
+    CANFilterExpression expr;
+
+    QVERIFY(!expr.compile("id =="));
+    QVERIFY(!expr.compile("(id == 1"));
+    QVERIFY(!expr.compile("id == 1 bus == 0"));
+    QVERIFY(!expr.compile("byte[0] == 1.5"));
+    QVERIFY(!expr.compile("byte == 1"));
+    QVERIFY(!expr.compile("id $ 4"));
+    QVERIFY(!expr.compile("NoSuchSignal > 1"));
+    QVERIFY(!expr.compile("EngineSpeed & 0xFF == 1"));
+    QVERIFY(!expr.getLastError().isEmpty());
+    QVERIFY(expr.isEmpty());
+
+    //nothing at all is fine and lets everything through
+    QVERIFY(expr.compile("   "));
+    QVERIFY(expr.isEmpty());
+    QVERIFY(expr.matches(pMakeFrame(0x123, 0, QByteArray(8, 0))));
+}
+
+
+void TestCANFilterExpression::frameFields()
+{
+    CANFilterExpression expr;
+    CANFrame frame = pMakeFrame(0x7E8, 1, QByteArray::fromHex("02410C1AF8000000"));
+
+    QVERIFY(expr.compile("id == 0x7E8"));
+    QVERIFY(expr.matches(frame));
+    QVERIFY(expr.compile("id == 2024"));
+    QVERIFY(expr.matches(frame));
+    QVERIFY(expr.compile("id in 0x700..0x7FF"));
+    QVERIFY(expr.matches(frame));
+    QVERIFY(expr.compile("id in 0x100..0x1FF"));
+    QVERIFY(!expr.matches(frame));
+    QVERIFY(expr.compile("id & 0x7F0 == 0x7E0"));
+    QVERIFY(expr.matches(frame));
+
+    QVERIFY(expr.compile("bus == 1"));
+    QVERIFY(expr.matches(frame));
+    QVERIFY(expr.compile("bus != 1"));
+    QVERIFY(!expr.matches(frame));
+
+    QVERIFY(expr.compile("dlc == 8"));
+    QVERIFY(expr.matches(frame));
+    QVERIFY(expr.compile("len < 8"));
+    QVERIFY(!expr.matches(frame));
+
+    QVERIFY(expr.compile("byte[1] == 0x41"));
+    QVERIFY(expr.matches(frame));
+    QVERIFY(expr.compile("byte[3] & 0xF0 == 0x10"));
+    QVERIFY(expr.matches(frame));
+    QVERIFY(expr.compile("bit[1] == 1"));
+    QVERIFY(expr.matches(frame));
+    QVERIFY(expr.compile("bit[0] == 1"));
+    QVERIFY(!expr.matches(frame));
+
+    //asking for a byte a short frame doesn't have never matches
+    QVERIFY(expr.compile("byte[3] == 0"));
+    QVERIFY(!expr.matches(pMakeFrame(0x7E8, 1, QByteArray(2, 0))));
+
+    QVERIFY(expr.compile("rx"));
+    QVERIFY(expr.matches(frame));
+    QVERIFY(expr.compile("dir == tx"));
+    QVERIFY(!expr.matches(frame));
+    QVERIFY(expr.compile("ext"));
+    QVERIFY(!expr.matches(frame));
+    QVERIFY(expr.matches(pMakeFrame(0x18FEF1FE, 0, QByteArray(8, 0))));
+
+    CANFrame remote = frame;
+    remote.setFrameType(QCanBusFrame::RemoteRequestFrame);
+    QVERIFY(expr.compile("rtr"));
+    QVERIFY(expr.matches(remote));
+    QVERIFY(!expr.matches(frame));
+}
+
+
+void TestCANFilterExpression::combining()
+{
+    CANFilterExpression expr;
+    CANFrame one = pMakeFrame(1, 0, QByteArray(8, 0));
+    CANFrame two = pMakeFrame(2, 0, QByteArray(8, 0));
+    CANFrame twoBus1 = pMakeFrame(2, 1, QByteArray(8, 0));
+
+    //and binds tighter than or
+    QVERIFY(expr.compile("id == 1 or id == 2 and bus == 1"));
+    QVERIFY(expr.matches(one));
+    QVERIFY(!expr.matches(two));
+    QVERIFY(expr.matches(twoBus1));
+
+    QVERIFY(expr.compile("(id == 1 || id == 2) && bus == 1"));
+    QVERIFY(!expr.matches(one));
+    QVERIFY(!expr.matches(two));
+    QVERIFY(expr.matches(twoBus1));
+
+    QVERIFY(expr.compile("not id == 1"));
+    QVERIFY(!expr.matches(one));
+    QVERIFY(expr.matches(two));
+
+    QVERIFY(expr.compile("!(id == 1 or bus == 1) and !!rx"));
+    QVERIFY(!expr.matches(one));
+    QVERIFY(expr.matches(two));
+    QVERIFY(!expr.matches(twoBus1));
+}
+
+
+void TestCANFilterExpression::dbcSignals()
+{
+    CANFilterExpression expr;
+
+    //3000 rpm is 12000 raw, coolant 0x50 is 80 - 40 = 40 degrees
+    CANFrame engine = pMakeFrame(256, 0, QByteArray::fromHex("E02E500000000000"));
+    QVERIFY(expr.compile("EngineSpeed == 3000"));
+    QVERIFY(expr.matches(engine));
+    QVERIFY(expr.compile("EngineSpeed > 3000"));
+    QVERIFY(!expr.matches(engine));
+    QVERIFY(expr.compile("EngineSpeed in 2999.5..3000.5 and CoolantTemp >= 40"));
+    QVERIFY(expr.matches(engine));
+    QVERIFY(expr.compile("CoolantTemp > -10"));
+    QVERIFY(expr.matches(engine));
+
+    //signals only match frames from the message they belong to
+    QVERIFY(expr.compile("EngineSpeed > 0"));
+    QVERIFY(!expr.matches(pMakeFrame(257, 0, QByteArray::fromHex("E02E500000000000"))));
+
+    //multiplexed signals only exist when the multiplexor says so. 12.0 V with mode 1
+    CANFrame diag = pMakeFrame(0x18FEF1FE, 0, QByteArray::fromHex("01E02E0000000000"));
+    QVERIFY(expr.compile("Voltage > 11.5"));
+    QVERIFY(expr.matches(diag));
+    QVERIFY(expr.compile("Current != 0"));
+    QVERIFY(!expr.matches(diag));
+    diag.setPayload(QByteArray::fromHex("02E02E0000000000"));
+    QVERIFY(expr.matches(diag));
+}
+
+
+/*
+ * Not a pass/fail test. Runs a spread of typical filters over a block of synthetic traffic and reports the cost
+ * per frame so changes to the evaluator can be compared.
+*/
+void TestCANFilterExpression::benchmark()
+{
+    const int numFrames = 200000;
+    QVector<CANFrame> frames;
+    frames.reserve(numFrames);
+    for (int i = 0; i < numFrames; i++)
+    {
+        QByteArray data(8, 0);
+        for (int b = 0; b < 8; b++) data[b] = static_cast<char>((i * 31 + b * 7) & 0xFF);
+        uint32_t id = (i % 5 == 0) ? 256 : (0x100 + (i * 13) % 0x700);
+        frames.append(pMakeFrame(id, i % 2, data));
+    }
+
+    const char *filters[] = {
+        "id == 0x7E8",
+        "id in 0x700..0x7FF and bus == 0",
+        "(id == 0x7E8 || id == 0x7E0 || id == 0x7DF) && byte[0] & 0xF0 == 0x40",
+        "not (bus == 1 or dlc < 8) and bit[3] == 1",
+        "EngineSpeed > 3000",
+        "EngineSpeed > 3000 and CoolantTemp < 90 or id & 0x700 == 0x300",
+    };
+
+    for (const char *text : filters)
+    {
+        CANFilterExpression expr;
+        QVERIFY2(expr.compile(text), qPrintable(expr.getLastError()));
+
+        int matched = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (const CANFrame &frame : frames)
+        {
+            if (expr.matches(frame)) matched++;
+        }
+        qint64 elapsed = timer.nsecsElapsed();
+
+        qInfo("%8.1f ns/frame  %7d matched  %s", static_cast<double>(elapsed) / numFrames, matched, text);
+    }
+}
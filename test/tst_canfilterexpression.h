@@ -0,0 +1,27 @@
+#ifndef TST_CANFILTEREXPRESSION_H
+#define TST_CANFILTEREXPRESSION_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+#include "can_structs.h"
+
+class TestCANFilterExpression: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir mDir;
+
+    CANFrame pMakeFrame(uint32_t pId, int pBus, QByteArray pData);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void badExpressions();
+    void frameFields();
+    void combining();
+    void dbcSignals();
+    void benchmark();
+};
+
+#endif // TST_CANFILTEREXPRESSION_H
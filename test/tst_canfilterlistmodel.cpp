@@ -0,0 +1,122 @@
+#include <QtTest>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QStandardPaths>
+
+#include "canfilterlistmodel.h"
+#include "tst_canfilterlistmodel.h"
+
+
+void TestCANFilterListModel::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QSettings settings;
+    settings.setValue("Main/FilterLabeling", false);
+}
+
+void TestCANFilterListModel::incrementalInserts()
+{
+    CANFilterListModel listModel(CANFilterListModel::FILTER_IDS);
+    QSignalSpy inserted(&listModel, &QAbstractItemModel::rowsInserted);
+    QSignalSpy reset(&listModel, &QAbstractItemModel::modelReset);
+
+    QMap<int, bool> filters;
+    filters.insert(0x100, true);
+    filters.insert(0x200, true);
+    listModel.sync(filters);
+    QCOMPARE(listModel.rowCount(), 2);
+    QCOMPARE(inserted.count(), 1);
+
+    //nothing new so the view shouldn't hear anything
+    listModel.sync(filters);
+    QCOMPARE(inserted.count(), 1);
+
+    //one ID in the middle and two on the end are two separate inserts
+    filters.insert(0x150, true);
+    filters.insert(0x300, true);
+    filters.insert(0x301, true);
+    listModel.sync(filters);
+    QCOMPARE(inserted.count(), 3);
+    QCOMPARE(inserted[1].at(1).toInt(), 1);
+    QCOMPARE(inserted[1].at(2).toInt(), 1);
+    QCOMPARE(inserted[2].at(1).toInt(), 3);
+    QCOMPARE(inserted[2].at(2).toInt(), 4);
+    QCOMPARE(reset.count(), 0);
+
+    QCOMPARE(listModel.rowCount(), 5);
+    uint32_t expected[] = {0x100, 0x150, 0x200, 0x300, 0x301};
+    for (int i = 0; i < 5; i++) QCOMPARE(listModel.idForRow(i), expected[i]);
+    QCOMPARE(listModel.data(listModel.index(1)).toString(), QString("0x150"));
+}
+
+void TestCANFilterListModel::checkStates()
+{
+    CANFilterListModel listModel(CANFilterListModel::FILTER_IDS);
+    QSignalSpy toggled(&listModel, &CANFilterListModel::filterToggled);
+
+    QMap<int, bool> filters;
+    filters.insert(0x10, true);
+    filters.insert(0x20, false);
+    listModel.sync(filters);
+    QCOMPARE(listModel.data(listModel.index(0), Qt::CheckStateRole).toInt(), static_cast<int>(Qt::Checked));
+    QCOMPARE(listModel.data(listModel.index(1), Qt::CheckStateRole).toInt(), static_cast<int>(Qt::Unchecked));
+
+    //the user clicking a box gets passed on
+    QVERIFY(listModel.setData(listModel.index(1), Qt::Checked, Qt::CheckStateRole));
+    QCOMPARE(toggled.count(), 1);
+    QCOMPARE(toggled[0].at(0).toUInt(), 0x20u);
+    QCOMPARE(toggled[0].at(1).toBool(), true);
+
+    //but changes coming from the frame model don't echo back to it
+    filters[0x10] = false;
+    listModel.sync(filters);
+    QCOMPARE(listModel.data(listModel.index(0), Qt::CheckStateRole).toInt(), static_cast<int>(Qt::Unchecked));
+    listModel.setAllChecked(true);
+    QCOMPARE(listModel.data(listModel.index(0), Qt::CheckStateRole).toInt(), static_cast<int>(Qt::Checked));
+    QCOMPARE(toggled.count(), 1);
+}
+
+void TestCANFilterListModel::removalsReset()
+{
+    CANFilterListModel listModel(CANFilterListModel::FILTER_BUSES);
+    QSignalSpy reset(&listModel, &QAbstractItemModel::modelReset);
+
+    QMap<int, bool> filters;
+    filters.insert(0, true);
+    filters.insert(1, true);
+    listModel.sync(filters);
+    QCOMPARE(reset.count(), 0);
+
+    filters.clear();
+    listModel.sync(filters);
+    QCOMPARE(reset.count(), 1);
+    QCOMPARE(listModel.rowCount(), 0);
+
+    filters.insert(2, true);
+    listModel.sync(filters);
+    QCOMPARE(listModel.rowCount(), 1);
+    QCOMPARE(listModel.data(listModel.index(0)).toString(), QString("2"));
+}
+
+void TestCANFilterListModel::countsAndRates()
+{
+    CANFilterListModel listModel(CANFilterListModel::FILTER_IDS);
+    QMap<int, bool> filters;
+    filters.insert(0x100, true);
+    listModel.sync(filters);
+
+    QHash<uint32_t, uint64_t> counts;
+    counts.insert(0x100, 50);
+    listModel.updateCounts(counts, 1000);
+    counts[0x100] = 250;
+    listModel.updateCounts(counts, 2000);
+
+    QCOMPARE(listModel.data(listModel.index(0)).toString(), QString("0x100"));
+    listModel.setShowCounts(true);
+    QCOMPARE(listModel.data(listModel.index(0)).toString(), QString("0x100  250 @ 100/s"));
+
+    //counts going backwards means they were cleared
+    counts[0x100] = 5;
+    listModel.updateCounts(counts, 1000);
+    QCOMPARE(listModel.data(listModel.index(0)).toString(), QString("0x100  5 @ 0.0/s"));
+}
@@ -0,0 +1,18 @@
+#ifndef TST_CANFILTERLISTMODEL_H
+#define TST_CANFILTERLISTMODEL_H
+
+#include <QObject>
+
+class TestCANFilterListModel: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void incrementalInserts();
+    void checkStates();
+    void removalsReset();
+    void countsAndRates();
+};
+
+#endif // TST_CANFILTERLISTMODEL_H
@@ -0,0 +1,140 @@
+#include <QtTest>
+
+#include "canframeindex.h"
+#include "tst_canframeindex.h"
+
+
+CANFrame TestCANFrameIndex::pMakeFrame(uint32_t pId, int pBus, int64_t pTime)
+{
+    CANFrame frame;
+    frame.setFrameId(pId);
+    frame.bus = pBus;
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, pTime));
+    frame.setPayload(QByteArray(1, static_cast<char>(pTime & 0xFF)));
+    return frame;
+}
+
+void TestCANFrameIndex::postingLists()
+{
+    QVector<CANFrame> frames;
+    for (int i = 0; i < 3000; i++) frames.append(pMakeFrame(0x100 + (i % 3), i % 2, i * 10));
+
+    CANFrameIndex index;
+    index.update(frames);
+    QCOMPARE(index.indexedCount(), 3000);
+    QVERIFY(index.isTimeOrdered());
+
+    QList<uint32_t> ids = index.ids();
+    std::sort(ids.begin(), ids.end());
+    QCOMPARE(ids, QList<uint32_t>({0x100, 0x101, 0x102}));
+    QCOMPARE(index.keys().count(), 6);
+
+    //0x100 lands on every third row so it alternates buses
+    QVector<int> bus0 = index.rowsFor(0x100, 0);
+    QVector<int> bus1 = index.rowsFor(0x100, 1);
+    QCOMPARE(bus0.count(), 500);
+    QCOMPARE(bus1.count(), 500);
+    QCOMPARE(bus0.first(), 0);
+    QCOMPARE(bus1.first(), 3);
+
+    QVector<int> both = index.rowsMatching(0x100, 0x100, -1);
+    QCOMPARE(both.count(), 1000);
+    for (int i = 0; i < both.count(); i++) QCOMPARE(both[i], i * 3);
+
+    QVERIFY(index.rowsFor(0x200, 0).isEmpty());
+    QCOMPARE(index.rowForIDAtTime(frames, 0x101, 45), 4);
+}
+
+void TestCANFrameIndex::incremental()
+{
+    QVector<CANFrame> frames;
+    for (int i = 0; i < 100; i++) frames.append(pMakeFrame(0x7E8, 0, i));
+
+    CANFrameIndex index;
+    index.update(frames);
+    //a copy handed out before more frames come in has to stay the way it was
+    QVector<int> before = index.rowsFor(0x7E8, 0);
+
+    for (int i = 100; i < 150; i++) frames.append(pMakeFrame(i < 120 ? 0x7E8 : 0x7DF, 0, i));
+    index.update(frames);
+    QCOMPARE(before.count(), 100);
+    QCOMPARE(index.rowsFor(0x7E8, 0).count(), 120);
+    QCOMPARE(index.rowsFor(0x7DF, 0).count(), 30);
+    QCOMPARE(index.rowsFor(0x7DF, 0).first(), 120);
+
+    //going back in time is noticed
+    frames.append(pMakeFrame(0x7E8, 0, 5));
+    index.update(frames);
+    QVERIFY(!index.isTimeOrdered());
+
+    index.reset();
+    QCOMPARE(index.indexedCount(), 0);
+    QVERIFY(index.ids().isEmpty());
+    index.update(frames);
+    QCOMPARE(index.rowsFor(0x7E8, 0).count(), 121);
+}
+
+void TestCANFrameIndex::frameRows()
+{
+    QVector<CANFrame> frames;
+    for (int i = 0; i < 1000; i++) frames.append(pMakeFrame((i % 4) ? 0x200 : 0x300, 0, i * 100));
+
+    CANFrameIndex index;
+    index.update(frames);
+    CANFrameRows rows(&frames, index.rowsFor(0x300, 0));
+
+    QCOMPARE(rows.count(), 250);
+    QVERIFY(!rows.isEmpty());
+    QCOMPARE(rows.rowAt(1), 4);
+    QCOMPARE(rows.at(1).frameId(), 0x300u);
+    QCOMPARE(rows[2].timeStamp().microSeconds(), int64_t(800));
+    //reads the frame in place, nothing was copied
+    QCOMPARE(&rows.last(), &frames[996]);
+
+    QCOMPARE(rows.lastAtOrBefore(850), 2);
+    QCOMPARE(rows.lastAtOrBefore(800), 2);
+    QCOMPARE(rows.lastAtOrBefore(-1), -1);
+    QCOMPARE(rows.lastAtOrBefore(1000000), 249);
+
+    rows.clear();
+    QVERIFY(rows.isEmpty());
+    QCOMPARE(CANFrameRows().count(), 0);
+
+    //rows tied to a generation go stale as soon as the list is rewritten, trimmed included
+    int generation = 5;
+    CANFrameRows tracked(&frames, index.rowsFor(0x300, 0), &generation);
+    QVERIFY(tracked.isCurrent());
+    frames.remove(0, 100);
+    generation++;
+    QVERIFY(!tracked.isCurrent());
+    QVERIFY(rows.isCurrent());
+}
+
+void TestCANFrameIndex::longestRows()
+{
+    QVector<CANFrame> frames;
+    for (int i = 0; i < 50; i++) frames.append(pMakeFrame(0x400, 0, i));
+    frames[17].setPayload(QByteArray(8, 0));
+    frames[30].setPayload(QByteArray(8, 0));
+
+    CANFrame err = pMakeFrame(0x400, 0, 50);
+    err.setFrameType(QCanBusFrame::ErrorFrame);
+    err.setError(QCanBusFrame::TransmissionTimeoutError | QCanBusFrame::BusOffError);
+    frames.append(err);
+
+    CANFrameIndex index;
+    index.update(frames);
+    uint64_t key = CANFrameIndex::makeKey(0x400, 0);
+    QCOMPARE(index.longestRowFor(key), 17);
+    QCOMPARE(index.maxErrorFlagsFor(key), 2);
+
+    //a longer payload showing up later takes over
+    CANFrame big = pMakeFrame(0x400, 0, 51);
+    big.setPayload(QByteArray(64, 0));
+    frames.append(big);
+    index.update(frames);
+    QCOMPARE(index.longestRowFor(key), 51);
+
+    QCOMPARE(index.longestRowFor(CANFrameIndex::makeKey(0x401, 0)), -1);
+    QCOMPARE(index.maxErrorFlagsFor(CANFrameIndex::makeKey(0x401, 0)), 0);
+}
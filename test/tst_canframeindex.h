@@ -0,0 +1,21 @@
+#ifndef TST_CANFRAMEINDEX_H
+#define TST_CANFRAMEINDEX_H
+
+#include <QObject>
+
+#include "can_structs.h"
+
+class TestCANFrameIndex: public QObject
+{
+    Q_OBJECT
+private:
+    CANFrame pMakeFrame(uint32_t pId, int pBus, int64_t pTime);
+
+private slots:
+    void postingLists();
+    void incremental();
+    void frameRows();
+    void longestRows();
+};
+
+#endif // TST_CANFRAMEINDEX_H
@@ -0,0 +1,195 @@
+#include <QtTest>
+
+#include "canframestats.h"
+#include "canframeindex.h"
+#include "utils/tdigest.h"
+#include "tst_canframestats.h"
+
+
+CANFrame TestCANFrameStats::pMakeFrame(uint32_t pId, int pBus, int64_t pTime, QByteArray pData)
+{
+    CANFrame frame;
+    frame.setFrameId(pId);
+    frame.bus = pBus;
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, pTime));
+    frame.setPayload(pData);
+    return frame;
+}
+
+void TestCANFrameStats::digestPercentiles()
+{
+    TDigest digest;
+    for (int i = 1; i <= 100000; i++) digest.add(i);
+
+    QCOMPARE(digest.totalWeight(), 100000.0);
+    QCOMPARE(digest.quantile(0.0), 1.0);
+    QCOMPARE(digest.quantile(1.0), 100000.0);
+    QVERIFY(qAbs(digest.quantile(0.5) - 50000.0) < 500.0);
+    QVERIFY(qAbs(digest.quantile(0.05) - 5000.0) < 100.0);
+    QVERIFY(qAbs(digest.quantile(0.99) - 99000.0) < 100.0);
+    QVERIFY(qAbs(digest.cdf(25000.0) - 0.25) < 0.005);
+
+    //two halves merged should look like the whole thing
+    TDigest low, high;
+    for (int i = 1; i <= 50000; i++) low.add(i);
+    for (int i = 50001; i <= 100000; i++) high.add(i);
+    low.merge(high);
+    QCOMPARE(low.totalWeight(), 100000.0);
+    QVERIFY(qAbs(low.quantile(0.5) - 50000.0) < 500.0);
+}
+
+void TestCANFrameStats::intervals()
+{
+    CANIDStats stats;
+    //10ms apart with every tenth one late by 2ms
+    int64_t time = 0;
+    for (int i = 0; i < 1001; i++)
+    {
+        stats.addFrame(pMakeFrame(0x100, 0, time, QByteArray(8, 0)));
+        time += (i % 10 == 9) ? 12000 : 10000;
+    }
+
+    QCOMPARE(stats.count, uint64_t(1001));
+    QCOMPARE(stats.intervalCount, uint64_t(1000));
+    QCOMPARE(stats.minInterval, int64_t(10000));
+    QCOMPARE(stats.maxInterval, int64_t(12000));
+    QVERIFY(qAbs(stats.intervalMean() - 10200.0) < 0.001);
+    QVERIFY(qAbs(stats.intervalStdDev() - 600.0) < 0.001);
+    QCOMPARE(stats.intervalPercentile(0.5), 10000.0);
+    QVERIFY(qAbs(stats.rate() - 1000.0 / 10.2) < 0.01);
+}
+
+void TestCANFrameStats::bytesAndBits()
+{
+    CANIDStats stats;
+    stats.addFrame(pMakeFrame(0x200, 0, 0, QByteArray::fromHex("0100")));
+    stats.addFrame(pMakeFrame(0x200, 0, 1000, QByteArray::fromHex("0300")));
+    stats.addFrame(pMakeFrame(0x200, 0, 2000, QByteArray::fromHex("01")));
+    stats.addFrame(pMakeFrame(0x200, 0, 3000, QByteArray::fromHex("0180FF")));
+
+    QCOMPARE(stats.minLen, 1);
+    QCOMPARE(stats.maxLen, 3);
+    QCOMPARE(stats.lengthCounts[2], uint64_t(2));
+    QCOMPARE(stats.byteCount(), 3);
+
+    QCOMPARE(stats.minData[0], (uint8_t)1);
+    QCOMPARE(stats.maxData[0], (uint8_t)3);
+    QCOMPARE(stats.changedBits[0], (uint8_t)0x02);
+    QCOMPARE(stats.changedBits[1], (uint8_t)0x80);
+    QCOMPARE(stats.changedBits[2], (uint8_t)0x00); //only seen once so nothing to change from
+
+    QCOMPARE(stats.bitSetCounts[0], uint64_t(4));
+    QCOMPARE(stats.bitSetCounts[1], uint64_t(1));
+    QCOMPARE(stats.bitSetCounts[15], uint64_t(1));
+    QCOMPARE(stats.bitFlipCounts[1], uint64_t(2));  //0x01 -> 0x03 -> 0x01
+    QCOMPARE(stats.bitFlipCounts[15], uint64_t(1)); //byte 1 wasn't in the short frame so it's compared to the one before
+    QCOMPARE(stats.byteHistogram[0 * 256 + 1], uint64_t(3));
+    QCOMPARE(stats.byteHistogram[2 * 256 + 0xFF], uint64_t(1));
+}
+
+void TestCANFrameStats::busesAndMerging()
+{
+    CANFrameStats all;
+    for (int i = 0; i < 10; i++)
+    {
+        all.addFrame(pMakeFrame(0x300, 0, i * 1000, QByteArray::fromHex("00")));
+        all.addFrame(pMakeFrame(0x300, 1, i * 3000, QByteArray::fromHex("0F")));
+        all.addFrame(pMakeFrame(0x301, 1, i * 1000, QByteArray::fromHex("00")));
+    }
+
+    QCOMPARE(all.count(), 3);
+    QCOMPARE(all.busesFor(0x300).count(), 2);
+
+    CANIDStats stats;
+    QVERIFY(all.statsFor(0x300, 1, stats));
+    QCOMPARE(stats.count, uint64_t(10));
+    QCOMPARE(stats.minInterval, int64_t(3000));
+    QVERIFY(!all.statsFor(0x300, 2, stats));
+    QVERIFY(!all.statsFor(0x302, -1, stats));
+
+    QVERIFY(all.statsFor(0x300, -1, stats));
+    QCOMPARE(stats.count, uint64_t(20));
+    QCOMPARE(stats.intervalCount, uint64_t(18));
+    QCOMPARE(stats.minInterval, int64_t(1000));
+    QCOMPARE(stats.maxInterval, int64_t(3000));
+    QVERIFY(qAbs(stats.intervalMean() - 2000.0) < 0.001);
+    QCOMPARE(stats.changedBits[0], (uint8_t)0x0F);
+    QCOMPARE(stats.maxData[0], (uint8_t)0x0F);
+
+    QHash<uint32_t, uint64_t> counts = all.countsByID();
+    QCOMPARE(counts.value(0x300), uint64_t(20));
+    QCOMPARE(counts.value(0x301), uint64_t(10));
+
+    QHash<uint32_t, double> rates = all.ratesByID();
+    QVERIFY(qAbs(rates.value(0x300) - 19 * 1000000.0 / 27000) < 0.001);
+    QVERIFY(qAbs(rates.value(0x301) - 1000.0) < 0.001);
+}
+
+//the table skips the histograms until detail gets handed over. Carrying on from there has to match counting it all at once
+void TestCANFrameStats::detailLater()
+{
+    QVector<CANFrame> frames;
+    for (int i = 0; i < 500; i++)
+    {
+        QByteArray data(8, 0);
+        data[0] = static_cast<char>(i & 0xFF);
+        data[3] = static_cast<char>((i / 7) & 0x0F);
+        frames.append(pMakeFrame(0x400, 0, i * 1000 + (i % 3) * 100, data));
+    }
+    QVector<CANFrame> head = frames.mid(0, 300);
+
+    CANFrameStats all;
+    for (const CANFrame &frame : head) all.addFrame(frame);
+    CANIDStats lean;
+    QVERIFY(all.statsFor(0x400, 0, lean));
+    QVERIFY(!lean.hasDetail());
+    QVERIFY(lean.byteHistogram.isEmpty());
+    QVERIFY(lean.bitSetCounts.isEmpty());
+    QCOMPARE(lean.bitFlipCounts.count(), 64);
+
+    CANFrameIndex index;
+    index.update(head);
+    CANIDStats counted;
+    counted.addFrames(CANFrameRows(&head, index.rowsFor(0x400, 0)));
+    QVERIFY(all.setDetail(counted));
+    QVERIFY(all.hasDetail(0x400, 0));
+
+    //counted from fewer frames than the table has seen so it doesn't fit
+    CANIDStats stale;
+    stale.addFrames(CANFrameRows(&head, index.rowsFor(0x400, 0).mid(0, 299)));
+    CANFrameStats other;
+    for (const CANFrame &frame : head) other.addFrame(frame);
+    QVERIFY(!other.setDetail(stale));
+    QVERIFY(!other.hasDetail(0x400, 0));
+
+    for (int i = 300; i < frames.count(); i++) all.addFrame(frames[i]);
+    CANIDStats full;
+    for (const CANFrame &frame : frames) full.addFrame(frame);
+    CANIDStats kept;
+    QVERIFY(all.statsFor(0x400, 0, kept));
+    QVERIFY(kept.hasDetail());
+    QCOMPARE(kept.count, full.count);
+    QCOMPARE(kept.bitSetCounts, full.bitSetCounts);
+    QCOMPARE(kept.byteHistogram, full.byteHistogram);
+    QCOMPARE(kept.bitFlipCounts, full.bitFlipCounts);
+    QCOMPARE(kept.intervalCount, full.intervalCount);
+    QCOMPARE(kept.intervalPercentile(0.5), full.intervalPercentile(0.5));
+
+    //only so many pairs keep detail, the one that got it first loses it
+    for (uint32_t id = 0x500; id < 0x500 + STATS_DETAILED_KEYS; id++)
+    {
+        QVector<CANFrame> one;
+        one.append(pMakeFrame(id, 0, 0, QByteArray(2, 0)));
+        all.addFrame(one[0]);
+        CANFrameIndex oneIndex;
+        oneIndex.update(one);
+        CANIDStats oneCounted;
+        oneCounted.addFrames(CANFrameRows(&one, oneIndex.rowsFor(id, 0)));
+        QVERIFY(all.setDetail(oneCounted));
+    }
+    QVERIFY(!all.hasDetail(0x400, 0));
+    QVERIFY(all.hasDetail(0x500, 0));
+    QVERIFY(all.statsFor(0x400, 0, kept));
+    QVERIFY(kept.byteHistogram.isEmpty());
+    QCOMPARE(kept.count, full.count);
+}
@@ -0,0 +1,22 @@
+#ifndef TST_CANFRAMESTATS_H
+#define TST_CANFRAMESTATS_H
+
+#include <QObject>
+
+#include "can_structs.h"
+
+class TestCANFrameStats: public QObject
+{
+    Q_OBJECT
+private:
+    CANFrame pMakeFrame(uint32_t pId, int pBus, int64_t pTime, QByteArray pData);
+
+private slots:
+    void digestPercentiles();
+    void intervals();
+    void bytesAndBits();
+    void busesAndMerging();
+    void detailLater();
+};
+
+#endif // TST_CANFRAMESTATS_H
@@ -0,0 +1,233 @@
+#include <QtTest>
+#include <QStandardPaths>
+
+#include "dbc/dbchandler.h"
+#include "dbc/dbcwriter.h"
+#include "tst_dbcroundtrip.h"
+
+
+static const char sampleDBC[] =
+    "VERSION \"\"\n"
+    "\n"
+    "NS_ :\n"
+    "    CM_\n"
+    "    BA_DEF_\n"
+    "    BA_\n"
+    "    VAL_\n"
+    "\n"
+    "BS_:\n"
+    "\n"
+    "BU_: ECU1 ECU2\n"
+    "\n"
+    "BO_ 256 EngineData: 8 ECU1\n"
+    " SG_ EngineSpeed : 0|16@1+ (0.25,0) [0|16383.75] \"rpm\" ECU2\n"
+    " SG_ CoolantTemp : 16|8@1- (1,-40) [-40|215] \"degC\" ECU2\n"
+    " SG_ ThrottlePos : 31|8@0+ (0.4,0) [0|100] \"%\" ECU2\n"
+    "\n"
+    "BO_ 2566844926 DiagFrame: 8 ECU2\n"
+    " SG_ Mode M : 0|8@1+ (1,0) [0|255] \"\" ECU1\n"
+    " SG_ Voltage m1 : 8|16@1+ (0.001,0) [0|65.535] \"V\" ECU1\n"
+    " SG_ Current m2 : 8|16@1- (0.01,0) [-327.68|327.67] \"A\" ECU1\n"
+    " SG_ Gear : 24|4@1+ (1,0) [0|15] \"\" ECU1\n"
+    "\n"
+    "CM_ BU_ ECU1 \"Engine controller\";\n"
+    "CM_ BO_ 256 \"Main engine status\";\n"
+    "CM_ SG_ 256 EngineSpeed \"Crankshaft speed\";\n"
+    "BA_DEF_ BO_ \"GenMsgCycleTime\" INT 0 10000;\n"
+    "BA_DEF_ SG_ \"SigStartValue\" INT 0 1000;\n"
+    "BA_DEF_DEF_ \"GenMsgCycleTime\" 100;\n"
+    "BA_DEF_DEF_ \"SigStartValue\" 0;\n"
+    "BA_ \"GenMsgCycleTime\" BO_ 256 20;\n"
+    "BA_ \"SigStartValue\" SG_ 256 CoolantTemp 40;\n"
+    "VAL_ 2566844926 Gear 3 \"Drive\" 0 \"Park\" 2 \"Neutral\" 1 \"Reverse\";\n"
+    "VAL_ 2566844926 Mode 1 \"Voltage\" 2 \"Current\";\n";
+
+
+void TestDBCRoundTrip::initTestCase()
+{
+    //keep the parsed DBC cache out of the real user cache directory
+    QStandardPaths::setTestModeEnabled(true);
+
+    QVERIFY(mDir.isValid());
+    mSourceName = mDir.filePath("source.dbc");
+
+    QFile file(mSourceName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(sampleDBC);
+    file.close();
+}
+
+
+void TestDBCRoundTrip::pCompareFiles(DBCFile& pA, DBCFile& pB)
+{
+    QCOMPARE(pA.dbc_nodes.count(), pB.dbc_nodes.count());
+    for (int i = 0; i < pA.dbc_nodes.count(); i++)
+    {
+        QCOMPARE(pA.dbc_nodes[i].name, pB.dbc_nodes[i].name);
+        QCOMPARE(pA.dbc_nodes[i].comment, pB.dbc_nodes[i].comment);
+    }
+
+    QCOMPARE(pA.dbc_attributes.count(), pB.dbc_attributes.count());
+    for (int i = 0; i < pA.dbc_attributes.count(); i++)
+    {
+        QCOMPARE(pA.dbc_attributes[i].name, pB.dbc_attributes[i].name);
+        QCOMPARE(pA.dbc_attributes[i].valType, pB.dbc_attributes[i].valType);
+        QCOMPARE(pA.dbc_attributes[i].attrType, pB.dbc_attributes[i].attrType);
+        QCOMPARE(pA.dbc_attributes[i].lower, pB.dbc_attributes[i].lower);
+        QCOMPARE(pA.dbc_attributes[i].upper, pB.dbc_attributes[i].upper);
+        QCOMPARE(pA.dbc_attributes[i].defaultValue.toString(), pB.dbc_attributes[i].defaultValue.toString());
+    }
+
+    QCOMPARE(pA.messageHandler->getCount(), pB.messageHandler->getCount());
+    for (int m = 0; m < pA.messageHandler->getCount(); m++)
+    {
+        DBC_MESSAGE* msgA_p = pA.messageHandler->findMsgByIdx(m);
+        DBC_MESSAGE* msgB_p = pB.messageHandler->findMsgByIdx(m);
+
+        QCOMPARE(msgA_p->ID, msgB_p->ID);
+        QCOMPARE(msgA_p->extendedID, msgB_p->extendedID);
+        QCOMPARE(msgA_p->name, msgB_p->name);
+        QCOMPARE(msgA_p->comment, msgB_p->comment);
+        QCOMPARE(msgA_p->len, msgB_p->len);
+        QCOMPARE(msgA_p->sender->name, msgB_p->sender->name);
+        QCOMPARE(msgA_p->bgColor, msgB_p->bgColor);
+        QCOMPARE(msgA_p->fgColor, msgB_p->fgColor);
+        QCOMPARE(msgA_p->attributes.count(), msgB_p->attributes.count());
+        for (int i = 0; i < msgA_p->attributes.count(); i++)
+        {
+            QCOMPARE(msgA_p->attributes[i].attrName(), msgB_p->attributes[i].attrName());
+            QCOMPARE(msgA_p->attributes[i].value.toString(), msgB_p->attributes[i].value.toString());
+        }
+        QCOMPARE(msgA_p->multiplexorSignal == nullptr, msgB_p->multiplexorSignal == nullptr);
+
+        QCOMPARE(msgA_p->sigHandler->getCount(), msgB_p->sigHandler->getCount());
+        for (int s = 0; s < msgA_p->sigHandler->getCount(); s++)
+        {
+            DBC_SIGNAL* sigA_p = msgA_p->sigHandler->findSignalByIdx(s);
+            DBC_SIGNAL* sigB_p = msgB_p->sigHandler->findSignalByIdx(s);
+
+            QCOMPARE(sigA_p->name, sigB_p->name);
+            QCOMPARE(sigA_p->startBit, sigB_p->startBit);
+            QCOMPARE(sigA_p->signalSize, sigB_p->signalSize);
+            QCOMPARE(sigA_p->intelByteOrder, sigB_p->intelByteOrder);
+            QCOMPARE(sigA_p->valType, sigB_p->valType);
+            QCOMPARE(sigA_p->factor, sigB_p->factor);
+            QCOMPARE(sigA_p->bias, sigB_p->bias);
+            QCOMPARE(sigA_p->min, sigB_p->min);
+            QCOMPARE(sigA_p->max, sigB_p->max);
+            QCOMPARE(sigA_p->unitName, sigB_p->unitName);
+            QCOMPARE(sigA_p->comment, sigB_p->comment);
+            QCOMPARE(sigA_p->receiver->name, sigB_p->receiver->name);
+            QCOMPARE(sigA_p->isMultiplexor, sigB_p->isMultiplexor);
+            QCOMPARE(sigA_p->isMultiplexed, sigB_p->isMultiplexed);
+            QCOMPARE(sigA_p->multiplexLowValue, sigB_p->multiplexLowValue);
+            QCOMPARE(sigA_p->multiplexHighValue, sigB_p->multiplexHighValue);
+            QCOMPARE(sigA_p->multiplexParent == nullptr, sigB_p->multiplexParent == nullptr);
+            if (sigA_p->multiplexParent) QCOMPARE(sigA_p->multiplexParent->name, sigB_p->multiplexParent->name);
+            QCOMPARE(sigA_p->multiplexedChildren.count(), sigB_p->multiplexedChildren.count());
+
+            QCOMPARE(sigA_p->attributes.count(), sigB_p->attributes.count());
+            for (int i = 0; i < sigA_p->attributes.count(); i++)
+            {
+                QCOMPARE(sigA_p->attributes[i].attrName(), sigB_p->attributes[i].attrName());
+                QCOMPARE(sigA_p->attributes[i].value.toString(), sigB_p->attributes[i].value.toString());
+            }
+
+            QCOMPARE(sigA_p->valList.count(), sigB_p->valList.count());
+            for (int v = 0; v < sigA_p->valList.count(); v++)
+            {
+                QCOMPARE(sigA_p->valList[v].value, sigB_p->valList[v].value);
+                QCOMPARE(sigA_p->valList[v].descript, sigB_p->valList[v].descript);
+            }
+        }
+    }
+}
+
+
+void TestDBCRoundTrip::loadSaveLoad()
+{
+    DBCFile first;
+    QVERIFY(first.loadFile(mSourceName));
+    QCOMPARE(first.messageHandler->getCount(), 2);
+    DBC_MESSAGE* diag_p = first.messageHandler->findMsgByName("DiagFrame");
+    QVERIFY(diag_p);
+    QVERIFY(diag_p->extendedID);
+    QCOMPARE(diag_p->sigHandler->getCount(), 4);
+
+    //value tables come back sorted no matter what order the file had them in
+    DBC_SIGNAL* gear_p = diag_p->sigHandler->findSignalByName("Gear");
+    QVERIFY(gear_p);
+    QCOMPARE(gear_p->valList.count(), 4);
+    QCOMPARE(gear_p->valList[0].descript, QString("Park"));
+    QCOMPARE(gear_p->valList[3].descript, QString("Drive"));
+
+    QString savedName = mDir.filePath("loadSaveLoad.dbc");
+    QVERIFY(first.saveFile(savedName));
+
+    DBCFile second;
+    QVERIFY(second.loadFile(savedName));
+    pCompareFiles(first, second);
+}
+
+
+void TestDBCRoundTrip::resaveIsStable()
+{
+    DBCFile first;
+    QVERIFY(first.loadFile(mSourceName));
+    QByteArray firstOutput = DBCWriter::serialize(&first);
+
+    QString savedName = mDir.filePath("resaveIsStable.dbc");
+    QVERIFY(first.saveFile(savedName));
+
+    DBCFile second;
+    QVERIFY(second.loadFile(savedName));
+    QCOMPARE(DBCWriter::serialize(&second), firstOutput);
+}
+
+
+void TestDBCRoundTrip::incrementalSave()
+{
+    DBCFile file;
+    QVERIFY(file.loadFile(mSourceName));
+
+    QByteArray before = DBCWriter::serialize(&file);
+    QCOMPARE(file.savedSections.count(), file.messageHandler->getCount());
+
+    DBC_MESSAGE* msg_p = file.messageHandler->findMsgByName("EngineData");
+    QVERIFY(msg_p);
+    int oldStamp = msg_p->changeStamp;
+    msg_p->comment = "Edited comment";
+    msg_p->sigHandler->findSignalByIdx(0)->factor = 0.5;
+    file.setDirtyFlag(msg_p); //same as the editors do
+    QVERIFY(msg_p->changeStamp != oldStamp);
+    QCOMPARE(file.savedSections.count(), file.messageHandler->getCount());
+
+    QByteArray incremental = DBCWriter::serialize(&file);
+    QVERIFY(incremental != before);
+    QVERIFY(incremental.contains("Edited comment"));
+
+    //a change that could have touched any message leaves nothing to reuse
+    file.setDirtyFlag();
+    QVERIFY(file.savedSections.isEmpty());
+
+    //formatting everything from scratch has to give exactly the same thing
+    file.savedSections.clear();
+    QCOMPARE(DBCWriter::serialize(&file), incremental);
+}
+
+
+void TestDBCRoundTrip::incrementalRemove()
+{
+    DBCFile file;
+    QVERIFY(file.loadFile(mSourceName));
+
+    DBCWriter::serialize(&file);
+    QVERIFY(file.messageHandler->removeMessage(QString("EngineData")));
+
+    QByteArray incremental = DBCWriter::serialize(&file);
+    QCOMPARE(file.savedSections.count(), 1);
+    QVERIFY(!incremental.contains("EngineData"));
+
+    file.savedSections.clear();
+    QCOMPARE(DBCWriter::serialize(&file), incremental);
+}
@@ -0,0 +1,26 @@
+#ifndef TST_DBCROUNDTRIP_H
+#define TST_DBCROUNDTRIP_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class DBCFile;
+
+class TestDBCRoundTrip: public QObject
+{
+    Q_OBJECT
+private:
+    QTemporaryDir mDir;
+    QString       mSourceName;
+
+    void pCompareFiles(DBCFile& pA, DBCFile& pB);
+
+private slots:
+    void initTestCase();
+    void loadSaveLoad();
+    void resaveIsStable();
+    void incrementalSave();
+    void incrementalRemove();
+};
+
+#endif // TST_DBCROUNDTRIP_H
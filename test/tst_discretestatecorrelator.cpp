@@ -0,0 +1,146 @@
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include "tst_discretestatecorrelator.h"
+
+
+//two states back and forth, one period each per iteration
+QVector<DiscreteStatePeriod> TestDiscreteStateCorrelator::pMakePeriods(int pIterations, int64_t pPeriodLength)
+{
+    QVector<DiscreteStatePeriod> periods;
+    for (int i = 0; i < pIterations * 2; i++)
+    {
+        periods.append(DiscreteStatePeriod(i * pPeriodLength, (i + 1) * pPeriodLength, i % 2));
+    }
+    return periods;
+}
+
+/*
+ * One ID sent every pFrameGap microseconds across the whole timeline:
+ *  byte 0 is a counter that wraps every 16 frames
+ *  bit 13 (byte 1) follows the state but only 300ms after each change, like a person would
+ *  byte 3 is random
+ * Everything else stays 0.
+*/
+QVector<CANFrame> TestDiscreteStateCorrelator::pMakeCapture(const QVector<DiscreteStatePeriod> &pPeriods, int64_t pFrameGap)
+{
+    QRandomGenerator rng(42);
+    QVector<CANFrame> frames;
+    int64_t endTime = pPeriods.last().endTime;
+    int p = 0;
+    for (int64_t t = 0, i = 0; t < endTime; t += pFrameGap, i++)
+    {
+        while (t >= pPeriods[p].endTime) p++;
+        int state = pPeriods[p].state;
+        if (t < pPeriods[p].startTime + 300000 && p > 0) state = pPeriods[p - 1].state;
+
+        QByteArray data(8, 0);
+        data[0] = static_cast<char>(i % 16);
+        data[1] = static_cast<char>(state << 5);
+        data[3] = static_cast<char>(rng.bounded(256));
+
+        CANFrame frame;
+        frame.setFrameId(0x2F0);
+        frame.bus = 0;
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, t));
+        frame.setPayload(data);
+        frames.append(frame);
+    }
+    return frames;
+}
+
+void TestDiscreteStateCorrelator::labelFrames()
+{
+    QVector<DiscreteStatePeriod> periods;
+    periods.append(DiscreteStatePeriod(1000, 2000, 0));
+    periods.append(DiscreteStatePeriod(2000, 3000, 1));
+    QVector<int64_t> times = { 0, 1000, 1099, 1100, 1999, 2000, 2150, 2999, 3000 };
+
+    QVector<int> labels = DiscreteStateCorrelator::labelFrames(times, periods, 0);
+    QCOMPARE(labels, QVector<int>({ -1, 0, 0, 0, 0, 1, 1, 1, -1 }));
+
+    //the guard leaves out the start of each period
+    labels = DiscreteStateCorrelator::labelFrames(times, periods, 100);
+    QCOMPARE(labels, QVector<int>({ -1, -1, -1, 0, 0, -1, 1, 1, -1 }));
+}
+
+void TestDiscreteStateCorrelator::correlate()
+{
+    QVector<DiscreteStatePeriod> periods = pMakePeriods(3, 3000000);
+    QVector<CANFrame> capture = pMakeCapture(periods, 10000);
+
+    QVector<int64_t> times;
+    for (const CANFrame &frame : capture) times.append(frame.timeStamp().microSeconds());
+    QVector<int> labels = DiscreteStateCorrelator::labelFrames(times, periods, 1000000);
+
+    RangeSignalMatrix matrix;
+    matrix.build(0x2F0, capture);
+
+    DiscreteStateSettings settings;
+    QVector<DiscreteStateCandidate> found = DiscreteStateCorrelator::correlate(matrix, labels, periods, settings);
+    QVERIFY(!found.isEmpty());
+    QCOMPARE(found.first().id, 0x2F0u);
+    QCOMPARE(found.first().startBit, 13);
+    QCOMPARE(found.first().bitLength, 1);
+    QCOMPARE(found.first().stateValues, QVector<int>({ 0, 1 }));
+    QVERIFY(found.first().score > 0.99);
+
+    //nothing built out of the counter or the random byte should have made it in
+    for (const DiscreteStateCandidate &c : found)
+    {
+        QVERIFY(c.bigEndian || c.startBit >= 8);
+        QVERIFY(c.bigEndian || c.startBit + c.bitLength <= 24);
+    }
+
+    //without the guard the frames from before the user reacted count against it but it's still the best
+    labels = DiscreteStateCorrelator::labelFrames(times, periods, 0);
+    found = DiscreteStateCorrelator::correlate(matrix, labels, periods, settings);
+    QVERIFY(!found.isEmpty());
+    QCOMPARE(found.first().startBit, 13);
+    QVERIFY(found.first().score < 0.99);
+}
+
+void TestDiscreteStateCorrelator::loggedData()
+{
+    QVector<DiscreteStatePeriod> periods = pMakePeriods(3, 3000000);
+    QVector<CANFrame> capture = pMakeCapture(periods, 10000);
+
+    RangeSignalMatrix matrix;
+    matrix.build(0x2F0, capture);
+
+    DiscreteStateSettings settings;
+    settings.numStates = 2;
+    QVector<DiscreteStateCandidate> found = DiscreteStateCorrelator::findStateFields(matrix, settings);
+
+    bool foundState = false;
+    for (const DiscreteStateCandidate &c : found)
+    {
+        if (c.startBit == 13 && c.bitLength == 1 && !c.bigEndian)
+        {
+            foundState = true;
+            QCOMPARE(c.stateValues, QVector<int>({ 0, 1 }));
+            QCOMPARE(c.score, 1.0 / 5.0); //five changes between six periods
+        }
+    }
+    QVERIFY(foundState);
+    //and it beats every bit of the counter
+    QCOMPARE(found.first().startBit, 13);
+}
+
+//a couple of minutes of a fast ID still turns up the state field
+void TestDiscreteStateCorrelator::largeCapture()
+{
+    QVector<DiscreteStatePeriod> periods = pMakePeriods(10, 6000000);
+    QVector<CANFrame> capture = pMakeCapture(periods, 1000);
+
+    QVector<int64_t> times;
+    times.reserve(capture.count());
+    for (const CANFrame &frame : capture) times.append(frame.timeStamp().microSeconds());
+    QVector<int> labels = DiscreteStateCorrelator::labelFrames(times, periods, 1000000);
+    RangeSignalMatrix matrix;
+    matrix.build(0x2F0, capture);
+    QVector<DiscreteStateCandidate> found = DiscreteStateCorrelator::correlate(matrix, labels, periods, DiscreteStateSettings());
+
+    QVERIFY(!found.isEmpty());
+    QCOMPARE(found.first().startBit, 13);
+}
@@ -0,0 +1,23 @@
+#ifndef TST_DISCRETESTATECORRELATOR_H
+#define TST_DISCRETESTATECORRELATOR_H
+
+#include <QObject>
+
+#include "can_structs.h"
+#include "re/discretestatecorrelator.h"
+
+class TestDiscreteStateCorrelator: public QObject
+{
+    Q_OBJECT
+private:
+    QVector<DiscreteStatePeriod> pMakePeriods(int pIterations, int64_t pPeriodLength);
+    QVector<CANFrame> pMakeCapture(const QVector<DiscreteStatePeriod> &pPeriods, int64_t pFrameGap);
+
+private slots:
+    void labelFrames();
+    void correlate();
+    void loggedData();
+    void largeCapture();
+};
+
+#endif // TST_DISCRETESTATECORRELATOR_H
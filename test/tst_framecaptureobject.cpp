@@ -0,0 +1,143 @@
+#include <QtTest>
+
+#include "framecaptureobject.h"
+#include "tst_framecaptureobject.h"
+
+
+CANFrame TestFrameCaptureObject::pMakeFrame(uint32_t pId, int pBus, int64_t pTime, QByteArray pData)
+{
+    CANFrame frame;
+    frame.setFrameId(pId);
+    frame.bus = pBus;
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(0, pTime));
+    frame.setPayload(pData);
+    return frame;
+}
+
+void TestFrameCaptureObject::filtersAndNewIDs()
+{
+    FrameCaptureObject capture;
+    QList<CANFrameBatch> batches;
+    connect(&capture, &FrameCaptureObject::framesProcessed, [&batches](const CANFrameBatch &batch) { batches.append(batch); });
+
+    QMap<int, bool> filters;
+    filters.insert(0x100, true);
+    filters.insert(0x200, false);
+    QMap<int, bool> busFilters;
+    busFilters.insert(0, true);
+    capture.setFilters(filters, busFilters, CANFilterExpression(), 3);
+
+    QVector<CANFrame> frames;
+    frames << pMakeFrame(0x100, 0, 10, QByteArray(8, 0)) << pMakeFrame(0x200, 0, 20, QByteArray(8, 0))
+           << pMakeFrame(0x300, 0, 30, QByteArray(8, 0)) << pMakeFrame(0x100, 1, 40, QByteArray(8, 0));
+    capture.processFrames(frames);
+
+    QCOMPARE(batches.count(), 1);
+    const CANFrameBatch &batch = batches[0];
+    QCOMPARE(batch.filterGeneration, 3);
+    QVERIFY(batch.filtersApplied);
+    QCOMPARE(batch.frames.count(), 4);
+    //0x200 is switched off which means new IDs start off too. No bus is switched off so bus 1 starts on
+    QCOMPARE(batch.passed, QVector<bool>() << true << false << false << true);
+    QCOMPARE(batch.newIDs.count(), 1);
+    QCOMPARE(batch.newIDs[0].first, uint32_t(0x300));
+    QCOMPARE(batch.newIDs[0].second, false);
+    QCOMPARE(batch.newBuses.count(), 1);
+    QCOMPARE(batch.newBuses[0].first, 1);
+    QCOMPARE(batch.newBuses[0].second, true);
+
+    //now known so they aren't reported again
+    capture.processFrames(frames);
+    QCOMPARE(batches.count(), 2);
+    QVERIFY(batches[1].newIDs.isEmpty());
+    QVERIFY(batches[1].newBuses.isEmpty());
+}
+
+void TestFrameCaptureObject::expressions()
+{
+    FrameCaptureObject capture;
+    QList<CANFrameBatch> batches;
+    connect(&capture, &FrameCaptureObject::framesProcessed, [&batches](const CANFrameBatch &batch) { batches.append(batch); });
+
+    CANFilterExpression expression;
+    QVERIFY(expression.compile("byte[0] == 0x11 and bus == 0"));
+    QVERIFY(!expression.usesSignals());
+    capture.setFilters(QMap<int, bool>(), QMap<int, bool>(), expression, 1);
+
+    QVector<CANFrame> frames;
+    frames << pMakeFrame(0x100, 0, 10, QByteArray(1, 0x11)) << pMakeFrame(0x100, 0, 20, QByteArray(1, 0x12))
+           << pMakeFrame(0x100, 1, 30, QByteArray(1, 0x11));
+    capture.processFrames(frames);
+
+    QCOMPARE(batches.count(), 1);
+    QVERIFY(batches[0].filtersApplied);
+    QCOMPARE(batches[0].passed, QVector<bool>() << true << false << false);
+}
+
+void TestFrameCaptureObject::offsetStatsAndReset()
+{
+    FrameCaptureObject capture;
+    QList<CANFrameBatch> batches;
+    connect(&capture, &FrameCaptureObject::framesProcessed, [&batches](const CANFrameBatch &batch) { batches.append(batch); });
+
+    capture.setTimeOffset(1000);
+    QVector<CANFrame> frames;
+    for (int i = 0; i < 10; i++) frames << pMakeFrame(0x7E8, 0, 5000 + i * 100, QByteArray(8, 0));
+    capture.processFrames(frames);
+
+    QCOMPARE(batches[0].timeOffset, int64_t(1000));
+    QCOMPARE(batches[0].frames[0].timeStamp().microSeconds(), qint64(4000));
+
+    uint64_t count = 0;
+    int64_t firstTime = 0;
+    capture.readStats([&](const CANFrameStats &stats)
+    {
+        CANIDStats idStats;
+        if (stats.statsFor(0x7E8, 0, idStats))
+        {
+            count = idStats.count;
+            firstTime = idStats.firstTime;
+        }
+    });
+    QCOMPARE(count, uint64_t(10));
+    QCOMPARE(firstTime, int64_t(4000));
+
+    //frames added some other way still count
+    capture.addStats(QVector<CANFrame>(1, pMakeFrame(0x7E8, 0, 9000, QByteArray(8, 0))));
+    capture.readStats([&](const CANFrameStats &stats) { count = stats.countsByID().value(0x7E8); });
+    QCOMPARE(count, uint64_t(11));
+
+    capture.resetCapture(5);
+    capture.readStats([&](const CANFrameStats &stats) { count = stats.count(); });
+    QCOMPARE(count, uint64_t(0));
+    capture.processFrames(frames);
+    QCOMPARE(batches.last().captureGeneration, 5);
+}
+
+void TestFrameCaptureObject::captureThread()
+{
+    FrameCaptureObject *capture = new FrameCaptureObject();
+    QList<CANFrameBatch> batches;
+    bool onThisThread = true;
+    connect(capture, &FrameCaptureObject::framesProcessed, this, [&](const CANFrameBatch &batch)
+    {
+        if (QThread::currentThread() != thread()) onThisThread = false;
+        batches.append(batch);
+    });
+    capture->initialize();
+
+    QVector<CANFrame> frames;
+    for (int i = 0; i < 1000; i++) frames << pMakeFrame(i & 0xFF, 0, i, QByteArray(8, 0));
+    for (int i = 0; i < 5; i++)
+    {
+        QMetaObject::invokeMethod(capture, "processFrames", Qt::QueuedConnection, Q_ARG(QVector<CANFrame>, frames));
+    }
+
+    QTRY_COMPARE(batches.count(), 5);
+    QVERIFY(onThisThread);
+    QCOMPARE(batches[4].frames.count(), 1000);
+    QCOMPARE(batches[0].newIDs.count(), 256);
+    QVERIFY(batches[1].newIDs.isEmpty());
+
+    delete capture;
+}
@@ -0,0 +1,21 @@
+#ifndef TST_FRAMECAPTUREOBJECT_H
+#define TST_FRAMECAPTUREOBJECT_H
+
+#include <QObject>
+
+#include "can_structs.h"
+
+class TestFrameCaptureObject: public QObject
+{
+    Q_OBJECT
+private:
+    CANFrame pMakeFrame(uint32_t pId, int pBus, int64_t pTime, QByteArray pData);
+
+private slots:
+    void filtersAndNewIDs();
+    void expressions();
+    void offsetStatsAndReset();
+    void captureThread();
+};
+
+#endif // TST_FRAMECAPTUREOBJECT_H
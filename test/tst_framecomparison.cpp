@@ -0,0 +1,128 @@
+#include <QtTest>
+
+#include "re/framecomparison.h"
+#include "tst_framecomparison.h"
+
+
+CANFrame TestFrameComparison::pMakeFrame(uint32_t pId, QByteArray pData)
+{
+    CANFrame frame;
+    frame.setFrameId(pId);
+    frame.bus = 0;
+    frame.setPayload(pData);
+    return frame;
+}
+
+void TestFrameComparison::bitsAndValues()
+{
+    QVector<CANFrame> frames;
+    frames.append(pMakeFrame(0x100, QByteArray::fromHex("0102")));
+    frames.append(pMakeFrame(0x100, QByteArray::fromHex("80FF")));
+    frames.append(pMakeFrame(0x200, QByteArray::fromHex("00")));
+
+    FrameCompareSide side;
+    side.addFrames(frames);
+    QCOMPARE(side.getFrameCount(), static_cast<uint64_t>(3));
+    QCOMPARE(side.getIDs().count(), 2);
+
+    const FrameCompareID &id = side.getIDs()[0x100];
+    QCOMPARE(id.ID, 0x100u);
+    QCOMPARE(id.dataLen, 2);
+    QCOMPARE(id.frameCount, static_cast<uint64_t>(2));
+
+    //byte 0 had 0x01 and 0x80, byte 1 had 0x02 and 0xFF
+    QVERIFY(id.bitSet(0));
+    QVERIFY(!id.bitSet(1));
+    QVERIFY(id.bitSet(7));
+    for (int b = 8; b < 16; b++) QVERIFY(id.bitSet(b));
+    QVERIFY(!id.bitSet(16));
+
+    QVERIFY(id.sawValue(0, 0x01));
+    QVERIFY(id.sawValue(0, 0x80));
+    QVERIFY(!id.sawValue(0, 0x02));
+    QVERIFY(id.sawValue(1, 0x02));
+    QVERIFY(id.sawValue(1, 0xFF));
+    QVERIFY(!id.sawValue(1, 0x80));
+    QVERIFY(!id.sawValue(2, 0x00));
+
+    //a byte of all zeros sets no bits but the value still counts
+    const FrameCompareID &zeros = side.getIDs()[0x200];
+    QVERIFY(!zeros.bitSet(0));
+    QVERIFY(zeros.sawValue(0, 0));
+
+    side.clear();
+    QCOMPARE(side.getFrameCount(), static_cast<uint64_t>(0));
+    QVERIFY(side.getIDs().isEmpty());
+}
+
+//feeding a capture through in pieces has to come out the same as all at once
+void TestFrameComparison::chunksAddUp()
+{
+    QVector<CANFrame> frames;
+    for (int i = 0; i < 5000; i++)
+    {
+        QByteArray data(8, 0);
+        for (int b = 0; b < 8; b++) data[b] = static_cast<char>((i * (b + 3)) & 0xFF);
+        frames.append(pMakeFrame(0x100 + (i % 7), data));
+    }
+
+    FrameCompareSide whole;
+    whole.addFrames(frames);
+
+    FrameCompareSide pieces;
+    for (int i = 0; i < frames.count(); i += 333) pieces.addFrames(frames.mid(i, 333));
+
+    QCOMPARE(pieces.getFrameCount(), whole.getFrameCount());
+    QCOMPARE(pieces.getIDs().keys(), whole.getIDs().keys());
+    for (uint32_t id : whole.getIDs().keys())
+    {
+        QCOMPARE(pieces.getIDs()[id].bitmap, whole.getIDs()[id].bitmap);
+        QCOMPARE(pieces.getIDs()[id].values, whole.getIDs()[id].values);
+        QCOMPARE(pieces.getIDs()[id].frameCount, whole.getIDs()[id].frameCount);
+    }
+}
+
+//CAN-FD frames go past the 8 bytes a single 64 bit bitmap could hold
+void TestFrameComparison::longPayloads()
+{
+    QByteArray data(64, 0);
+    data[63] = static_cast<char>(0x80);
+    QVector<CANFrame> frames;
+    frames.append(pMakeFrame(0x300, QByteArray(8, 0)));
+    frames.append(pMakeFrame(0x300, data));
+
+    FrameCompareSide side;
+    side.addFrames(frames);
+    const FrameCompareID &id = side.getIDs()[0x300];
+    QCOMPARE(id.dataLen, 8);
+    QCOMPARE(id.maxLen, 64);
+    QVERIFY(id.bitSet(511));
+    QVERIFY(!id.bitSet(510));
+    QVERIFY(id.sawValue(63, 0x80));
+    QVERIFY(id.sawValue(10, 0x00));
+}
+
+//a signal with a counter in it would otherwise keep every value it ever had
+void TestFrameComparison::signalValueCap()
+{
+    FrameCompareID id;
+    for (int i = 0; i < FRAME_COMPARE_SIGNAL_VALUES; i++)
+    {
+        id.addSignalValue("Counter", i);
+        id.addSignalValue("State", i % 2);
+    }
+    QCOMPARE(id.signalValues["Counter"].count(), FRAME_COMPARE_SIGNAL_VALUES);
+    QVERIFY(id.manySignalValues.isEmpty());
+
+    //same value again doesn't count, a new one tips it over
+    id.addSignalValue("Counter", 0);
+    QVERIFY(id.manySignalValues.isEmpty());
+    id.addSignalValue("Counter", FRAME_COMPARE_SIGNAL_VALUES);
+    QVERIFY(id.manySignalValues.contains("Counter"));
+    QVERIFY(id.signalValues["Counter"].isEmpty());
+    id.addSignalValue("Counter", -1.0);
+    QVERIFY(id.signalValues["Counter"].isEmpty());
+
+    QCOMPARE(id.signalValues["State"].count(), 2);
+    QVERIFY(!id.manySignalValues.contains("State"));
+}
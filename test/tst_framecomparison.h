@@ -0,0 +1,21 @@
+#ifndef TST_FRAMECOMPARISON_H
+#define TST_FRAMECOMPARISON_H
+
+#include <QObject>
+
+#include "can_structs.h"
+
+class TestFrameComparison: public QObject
+{
+    Q_OBJECT
+private:
+    CANFrame pMakeFrame(uint32_t pId, QByteArray pData);
+
+private slots:
+    void bitsAndValues();
+    void chunksAddUp();
+    void longPayloads();
+    void signalValueCap();
+};
+
+#endif // TST_FRAMECOMPARISON_H
@@ -0,0 +1,99 @@
+#include <QtTest>
+
+#include "frameselection.h"
+#include "tst_frameselection.h"
+
+
+//IDs 0x100 to 0x10F round robin, bus 0 and 1 alternating, the row number in the timestamp
+QVector<CANFrame> TestFrameSelection::pMakeFrames(int pNumFrames)
+{
+    QVector<CANFrame> frames;
+    frames.reserve(pNumFrames);
+    for (int i = 0; i < pNumFrames; i++)
+    {
+        CANFrame frame;
+        frame.setFrameId(0x100 + (i % 16));
+        frame.bus = i & 1;
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, i));
+        frame.setPayload(QByteArray(8, static_cast<char>(i)));
+        frames.append(frame);
+    }
+    return frames;
+}
+
+void TestFrameSelection::ranges()
+{
+    FrameSelection selection;
+    selection.selectRange(100, 30, 100);
+    QCOMPARE(selection.total(), 100);
+    QCOMPARE(selection.count(), 70);
+    QVERIFY(!selection.contains(29));
+    QVERIFY(selection.contains(30));
+    QCOMPARE(selection.next(0), 30);
+    QCOMPARE(selection.next(50), 50);
+    QCOMPARE(selection.next(100), 100);
+
+    //out of range edges get clamped to the list
+    selection.selectRange(100, -5, 500);
+    QCOMPARE(selection.count(), 100);
+    selection.selectRange(100, 0, 0);
+    QCOMPARE(selection.count(), 0);
+    QCOMPARE(selection.next(0), 100);
+}
+
+//big enough to be split over several threads, the answer has to be exactly what one pass gets
+void TestFrameSelection::matchingAcrossChunks()
+{
+    const int numFrames = FRAME_SELECTION_MIN_CHUNK * 3 + 77;
+    QVector<CANFrame> frames = pMakeFrames(numFrames);
+
+    FrameSelection selection;
+    selection.selectMatching(frames, numFrames, [](const CANFrame &frame) { return frame.frameId() >= 0x104 && frame.frameId() <= 0x106; });
+
+    int expected = 0;
+    for (int i = 0; i < numFrames; i++)
+    {
+        bool inside = frames[i].frameId() >= 0x104 && frames[i].frameId() <= 0x106;
+        if (inside) expected++;
+        if (selection.contains(i) != inside) QFAIL(qPrintable(QString("row %1 picked wrong").arg(i)));
+    }
+    QCOMPARE(selection.count(), expected);
+
+    int walked = 0;
+    for (int r = selection.next(0); r < selection.total(); r = selection.next(r + 1)) walked++;
+    QCOMPARE(walked, expected);
+
+    //only the rows asked for are looked at
+    selection.selectMatching(frames, 10, [](const CANFrame &) { return true; });
+    QCOMPARE(selection.total(), 10);
+    QCOMPARE(selection.count(), 10);
+    QCOMPARE(selection.next(10), 10);
+}
+
+void TestFrameSelection::keepInPlace()
+{
+    QVector<CANFrame> frames = pMakeFrames(1000);
+    FrameSelection selection;
+    selection.selectMatching(frames, 1000, [](const CANFrame &frame) { return frame.bus == 1; });
+
+    QVector<CANFrame> copied;
+    selection.copyTo(frames, copied);
+    QCOMPARE(copied.count(), 500);
+
+    const CANFrame *before = frames.constData();
+    QCOMPARE(selection.keepIn(frames), 500);
+    QCOMPARE(frames.constData(), before);   //same storage, nothing was allocated
+    for (int i = 0; i < frames.count(); i++)
+    {
+        QCOMPARE(frames[i].timeStamp().microSeconds(), static_cast<qint64>(i * 2 + 1));
+        QCOMPARE(frames[i].timeStamp().microSeconds(), copied[i].timeStamp().microSeconds());
+        QCOMPARE(frames[i].payload(), copied[i].payload());
+    }
+
+    //ranges keep their order too, and frames past what the selection covered go
+    frames = pMakeFrames(1000);
+    selection.selectRange(900, 400, 900);
+    QCOMPARE(selection.keepIn(frames), 500);
+    QCOMPARE(frames.first().timeStamp().microSeconds(), static_cast<qint64>(400));
+    QCOMPARE(frames.last().timeStamp().microSeconds(), static_cast<qint64>(899));
+}
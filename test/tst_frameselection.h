@@ -0,0 +1,20 @@
+#ifndef TST_FRAMESELECTION_H
+#define TST_FRAMESELECTION_H
+
+#include <QObject>
+
+#include "can_structs.h"
+
+class TestFrameSelection: public QObject
+{
+    Q_OBJECT
+private:
+    QVector<CANFrame> pMakeFrames(int pNumFrames);
+
+private slots:
+    void ranges();
+    void matchingAcrossChunks();
+    void keepInPlace();
+};
+
+#endif // TST_FRAMESELECTION_H
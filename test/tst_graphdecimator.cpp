@@ -0,0 +1,150 @@
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include "re/graphdecimator.h"
+#include "tst_graphdecimator.h"
+
+
+//a random walk with uneven gaps between samples, some of them zero, like a signal pulled out of a capture
+void TestGraphDecimator::pMakeSeries(int pNumSamples, quint32 pSeed, QVector<double> &pX, QVector<double> &pY)
+{
+    QRandomGenerator rng(pSeed);
+    pX.clear();
+    pY.clear();
+    pX.reserve(pNumSamples);
+    pY.reserve(pNumSamples);
+    double time = 10.0;
+    double value = 0.0;
+    for (int i = 0; i < pNumSamples; i++)
+    {
+        time += rng.bounded(100) * 0.0001;
+        value += rng.bounded(2.0) - 1.0;
+        pX.append(time);
+        pY.append(value);
+    }
+}
+
+//every pixel column has to come out with the same top and bottom as drawing every sample would give it
+void TestGraphDecimator::envelopeExact()
+{
+    QVector<double> x, y;
+    pMakeSeries(300000, 1, x, y);
+    GraphDecimator decimator;
+    decimator.update(x, y);
+    QRandomGenerator rng(2);
+
+    for (int trial = 0; trial < 20; trial++)
+    {
+        double lower = x.first(), upper = x.last();
+        if (trial > 0)
+        {
+            lower = x[rng.bounded(x.count())];
+            upper = x[rng.bounded(x.count())];
+            if (lower > upper) qSwap(lower, upper);
+        }
+        int width = 100 + rng.bounded(1900);
+
+        QVector<double> outX, outY;
+        decimator.visiblePoints(x, y, lower, upper, width, outX, outY);
+        QVERIFY(outX.count() <= width * 4 + 2);
+        QVERIFY(std::is_sorted(outX.constBegin(), outX.constEnd()));
+
+        if (upper <= lower) continue;
+        double step = (upper - lower) / width;
+        auto column = [&](double key) { return qBound(0, static_cast<int>((key - lower) / step), width - 1); };
+        QVector<double> allMin(width, 1e300), allMax(width, -1e300), shownMin(width, 1e300), shownMax(width, -1e300);
+        for (int i = 0; i < x.count(); i++)
+        {
+            if (x[i] < lower || x[i] > upper) continue;
+            int c = column(x[i]);
+            allMin[c] = qMin(allMin[c], y[i]);
+            allMax[c] = qMax(allMax[c], y[i]);
+        }
+        for (int i = 0; i < outX.count(); i++)
+        {
+            if (outX[i] < lower || outX[i] > upper) continue;
+            int c = column(outX[i]);
+            shownMin[c] = qMin(shownMin[c], outY[i]);
+            shownMax[c] = qMax(shownMax[c], outY[i]);
+        }
+        QCOMPARE(shownMin, allMin);
+        QCOMPARE(shownMax, allMax);
+    }
+}
+
+//taking the samples in a few at a time has to give the same pyramid as taking them all at once
+void TestGraphDecimator::appendMatchesBulk()
+{
+    QVector<double> x, y;
+    pMakeSeries(100000, 3, x, y);
+    GraphDecimator bulk;
+    bulk.update(x, y);
+
+    GraphDecimator growing;
+    QVector<double> partX, partY;
+    for (int i = 0; i < x.count(); i++)
+    {
+        partX.append(x[i]);
+        partY.append(y[i]);
+        if (i % 613 == 0) growing.update(partX, partY);
+    }
+    growing.update(partX, partY);
+
+    QCOMPARE(growing.sampleCount(), bulk.sampleCount());
+    QCOMPARE(growing.levelCount(), bulk.levelCount());
+    for (double width : {50.0, 700.0, 3000.0})
+    {
+        QVector<double> bulkX, bulkY, growX, growY;
+        bulk.visiblePoints(x, y, x[1000], x[90000], static_cast<int>(width), bulkX, bulkY);
+        growing.visiblePoints(x, y, x[1000], x[90000], static_cast<int>(width), growX, growY);
+        QCOMPARE(growX, bulkX);
+        QCOMPARE(growY, bulkY);
+    }
+
+    int minIdx, maxIdx;
+    bulk.rangeMinMax(y, 0, y.count(), minIdx, maxIdx);
+    QCOMPARE(y[minIdx], *std::min_element(y.constBegin(), y.constEnd()));
+    QCOMPARE(y[maxIdx], *std::max_element(y.constBegin(), y.constEnd()));
+}
+
+//zoomed in far enough there's nothing to cut, just the samples in view and one either side
+void TestGraphDecimator::fewSamplesPassThrough()
+{
+    QVector<double> x, y;
+    for (int i = 0; i < 1000; i++)
+    {
+        x.append(i);
+        y.append(i % 7);
+    }
+    GraphDecimator decimator;
+    decimator.update(x, y);
+
+    QVector<double> outX, outY;
+    decimator.visiblePoints(x, y, 100.5, 199.5, 1000, outX, outY);
+    QCOMPARE(outX.count(), 101);
+    QCOMPARE(outX.first(), 100.0);
+    QCOMPARE(outX.last(), 200.0);
+    QCOMPARE(outY, y.mid(100, 101));
+
+    //no width means no decimating
+    decimator.visiblePoints(x, y, 0, 999, 0, outX, outY);
+    QCOMPARE(outX, x);
+}
+
+void TestGraphDecimator::unsortedFallsBack()
+{
+    QVector<double> x = {0, 2, 1, 3, 4, 5, 6, 7, 8, 9};
+    QVector<double> y = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    GraphDecimator decimator;
+    decimator.update(x, y);
+    QVERIFY(!decimator.isSorted());
+
+    QVector<double> outX, outY;
+    decimator.visiblePoints(x, y, 0, 9, 1, outX, outY);
+    QCOMPARE(outX, x);
+    QCOMPARE(outY, y);
+
+    decimator.clear();
+    QVERIFY(decimator.isSorted());
+    QCOMPARE(decimator.sampleCount(), 0);
+}
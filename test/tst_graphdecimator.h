@@ -0,0 +1,20 @@
+#ifndef TST_GRAPHDECIMATOR_H
+#define TST_GRAPHDECIMATOR_H
+
+#include <QObject>
+#include <QVector>
+
+class TestGraphDecimator: public QObject
+{
+    Q_OBJECT
+private:
+    void pMakeSeries(int pNumSamples, quint32 pSeed, QVector<double> &pX, QVector<double> &pY);
+
+private slots:
+    void envelopeExact();
+    void appendMatchesBulk();
+    void fewSamplesPassThrough();
+    void unsortedFallsBack();
+};
+
+#endif // TST_GRAPHDECIMATOR_H
@@ -0,0 +1,134 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QWidget>
+
+#include "guirefreshscheduler.h"
+#include "tst_guirefreshscheduler.h"
+
+
+void TestGUIRefreshScheduler::batching()
+{
+    GUIRefreshScheduler scheduler;
+    QWidget window;
+    QList<int> received;
+    scheduler.addWindow(&window, [&received](int numFrames) { received.append(numFrames); });
+    window.show();
+
+    scheduler.framesUpdated(10);
+    scheduler.framesUpdated(5);
+    scheduler.runPending();
+    QCOMPARE(received, QList<int>() << 15);
+
+    //resets go out to visible windows right away and throw away whatever was waiting
+    scheduler.framesUpdated(3);
+    scheduler.framesUpdated(-1);
+    QCOMPARE(received, QList<int>() << 15 << -1);
+    scheduler.runPending();
+    QCOMPARE(received.count(), 2);
+
+    //inside the interval nothing goes out no matter how often it's asked
+    scheduler.framesUpdated(4);
+    scheduler.runPending();
+    scheduler.runPending();
+    QCOMPARE(received.count(), 2);
+    QTest::qWait(300);
+    scheduler.runPending();
+    QCOMPARE(received.last(), 4);
+}
+
+void TestGUIRefreshScheduler::hiddenWindows()
+{
+    GUIRefreshScheduler scheduler;
+    QWidget window;
+    QList<int> received;
+    scheduler.addWindow(&window, [&received](int numFrames) { received.append(numFrames); });
+
+    //never shown so it's paused
+    scheduler.framesUpdated(20);
+    scheduler.framesUpdated(-1);
+    scheduler.framesUpdated(7);
+    scheduler.runPending();
+    QVERIFY(received.isEmpty());
+
+    //clear then more frames. The clear has to come first and the new frames still get delivered after it
+    window.show();
+    scheduler.runPending();
+    QCOMPARE(received, QList<int>() << -1);
+    QTest::qWait(300);
+    scheduler.runPending();
+    QCOMPARE(received, QList<int>() << -1 << 7);
+
+    //a full reload covers anything that came in before or after it
+    received.clear();
+    window.hide();
+    scheduler.framesUpdated(5);
+    scheduler.framesUpdated(-2);
+    scheduler.framesUpdated(9);
+    window.show();
+    scheduler.runPending();
+    QTest::qWait(300);
+    scheduler.runPending();
+    QCOMPARE(received, QList<int>() << -2);
+
+    //windows that go away just drop off the list
+    QWidget *temporary = new QWidget;
+    int tempCalls = 0;
+    scheduler.addWindow(temporary, [&tempCalls](int) { tempCalls++; });
+    temporary->show();
+    delete temporary;
+    scheduler.framesUpdated(1);
+    QTest::qWait(300);
+    scheduler.runPending();
+    QCOMPARE(tempCalls, 0);
+}
+
+void TestGUIRefreshScheduler::fallenBehind()
+{
+    GUIRefreshScheduler scheduler;
+    QVector<CANFrame> frames(10);
+    scheduler.setFrameSource(&frames);
+
+    QWidget window;
+    QList<int> received;
+    scheduler.addWindow(&window, [&received](int numFrames) { received.append(numFrames); });
+
+    //more frames pending than exist in the list means the start of them got trimmed off. Has to start over
+    scheduler.framesUpdated(25);
+    window.show();
+    scheduler.runPending();
+    QCOMPARE(received, QList<int>() << -2);
+}
+
+void TestGUIRefreshScheduler::budgetThrottling()
+{
+    GUIRefreshScheduler scheduler;
+    scheduler.setBudget(5);
+
+    QWidget cheap, expensive;
+    scheduler.addWindow(&cheap, [](int) {}, REFRESH_HIGH, 250);
+    scheduler.addWindow(&expensive, [](int)
+    {
+        QElapsedTimer busy;
+        busy.start();
+        while (busy.elapsed() < 30) {}
+    }, REFRESH_LOW, 250);
+    cheap.show();
+    expensive.show();
+
+    scheduler.framesUpdated(1);
+    scheduler.runPending();
+    scheduler.rebalance();
+
+    //way over a 5% budget. Only the low priority window that cost something gets slowed down
+    QVERIFY(scheduler.getInterval(&expensive) > 250);
+    QCOMPARE(scheduler.getInterval(&cheap), 250);
+    QVERIFY(scheduler.getCostSummary().contains("5% budget"));
+
+    //nothing going on now so the interval comes back down, but never faster than asked for
+    for (int i = 0; i < 10; i++)
+    {
+        QTest::qWait(20);
+        scheduler.rebalance();
+    }
+    QCOMPARE(scheduler.getInterval(&expensive), 250);
+}
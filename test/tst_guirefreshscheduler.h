@@ -0,0 +1,17 @@
+#ifndef TST_GUIREFRESHSCHEDULER_H
+#define TST_GUIREFRESHSCHEDULER_H
+
+#include <QObject>
+
+class TestGUIRefreshScheduler: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void batching();
+    void hiddenWindows();
+    void fallenBehind();
+    void budgetThrottling();
+};
+
+#endif // TST_GUIREFRESHSCHEDULER_H
@@ -0,0 +1,192 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <cmath>
+
+#include "re/rangesignalmatrix.h"
+#include "utility.h"
+#include "tst_rangesignalmatrix.h"
+
+
+/*
+ * One ID with two signals planted in otherwise noisy data:
+ *  a 16 bit little endian ramp up and down starting at bit 8 (bytes 1-2)
+ *  a 12 bit big endian sine wave starting at bit 39 (byte 4 and the top of byte 5)
+ * Byte 0 is a counter that wraps every 16 frames, byte 7 is random and the rest never change.
+*/
+QVector<CANFrame> TestRangeSignalMatrix::pMakeCapture(int pNumFrames)
+{
+    QRandomGenerator rng(1234);
+    QVector<CANFrame> frames;
+    frames.reserve(pNumFrames);
+    for (int i = 0; i < pNumFrames; i++)
+    {
+        QByteArray data(8, 0);
+        data[0] = static_cast<char>(i % 16);
+
+        int ramp = (i % 2000 < 1000) ? (i % 2000) * 40 : (2000 - (i % 2000)) * 40;
+        data[1] = static_cast<char>(ramp & 0xFF);
+        data[2] = static_cast<char>((ramp >> 8) & 0xFF);
+
+        int sine = static_cast<int>(2047.0 + 2000.0 * std::sin(i / 300.0));
+        data[4] = static_cast<char>((sine >> 4) & 0xFF);
+        data[5] = static_cast<char>(((sine & 0x0F) << 4) | 0x05);
+
+        data[6] = static_cast<char>(0x5A);
+        data[7] = static_cast<char>(rng.bounded(256));
+
+        CANFrame frame;
+        frame.setFrameId(0x3A0);
+        frame.bus = 0;
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, i * 10000));
+        frame.setPayload(data);
+        frames.append(frame);
+    }
+    return frames;
+}
+
+//packed extraction has to give exactly what the old bit by bit code does, short frames and CAN-FD included
+void TestRangeSignalMatrix::matchesProcessIntegerSignal()
+{
+    QRandomGenerator rng(99);
+    QVector<CANFrame> frames;
+    for (int i = 0; i < 200; i++)
+    {
+        int len = (i % 5 == 0) ? 64 : static_cast<int>(rng.bounded(9));
+        QByteArray data(len, 0);
+        for (int b = 0; b < len; b++) data[b] = static_cast<char>(rng.bounded(256));
+        CANFrame frame;
+        frame.setFrameId(0x100);
+        frame.setPayload(data);
+        frames.append(frame);
+    }
+
+    RangeSignalMatrix matrix;
+    matrix.build(0x100, frames);
+    QCOMPARE(matrix.frameCount(), 200);
+    QCOMPARE(matrix.searchBits(), 512);
+
+    QVector<uint64_t> raw(frames.count());
+    for (int startBit = 0; startBit < 512; startBit += 3)
+    {
+        for (int bitLength = 1; bitLength <= RANGE_SIGNAL_MAX_BITS; bitLength += 5)
+        {
+            for (int be = 0; be < 2; be++)
+            {
+                matrix.extract(startBit, bitLength, be, raw.data());
+                for (int i = 0; i < frames.count(); i++)
+                {
+                    uint64_t expected = static_cast<uint64_t>(Utility::processIntegerSignal(frames[i].payload(), startBit, bitLength, !be, false));
+                    if (raw[i] != expected)
+                    {
+                        QFAIL(qPrintable(QString("frame %1 start %2 len %3 big endian %4: got %5 wanted %6").arg(i).arg(startBit)
+                                         .arg(bitLength).arg(be).arg(raw[i], 0, 16).arg(expected, 0, 16)));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void TestRangeSignalMatrix::plantedSignals()
+{
+    QVector<CANFrame> frames = pMakeCapture(20000);
+    RangeSignalMatrix matrix;
+    matrix.build(0x3A0, frames);
+
+    //nothing in byte 3 or 6 ever moves
+    QVERIFY(matrix.isConstant(24, 8, false));
+    QVERIFY(matrix.isConstant(48, 8, false));
+    QVERIFY(!matrix.isConstant(8, 16, false));
+
+    RangeSignalSettings settings;
+    settings.granularity = 1;
+    settings.trySigned = false;
+
+    QVector<RangeSignalCandidate> ramp = matrix.findCandidates(settings, 16);
+    bool foundRamp = false;
+    for (const RangeSignalCandidate &c : ramp)
+    {
+        if (c.startBit == 8 && !c.bigEndian) foundRamp = true;
+        //the random byte jumps all over so nothing that takes it in should look like a range signal
+        QVERIFY(c.bigEndian || c.startBit + 16 <= 56);
+    }
+    QVERIFY(foundRamp);
+
+    QVector<RangeSignalCandidate> sine = matrix.findCandidates(settings, 12);
+    bool foundSine = false;
+    for (const RangeSignalCandidate &c : sine)
+    {
+        if (c.startBit == 39 && c.bigEndian) foundSine = true;
+    }
+    QVERIFY(foundSine);
+
+    //comes back ranked
+    for (int i = 1; i < sine.count(); i++) QVERIFY(!sine[i].ranksAbove(sine[i - 1]));
+}
+
+void TestRangeSignalMatrix::cancel()
+{
+    QVector<CANFrame> frames = pMakeCapture(5000);
+    RangeSignalMatrix matrix;
+    matrix.build(0x3A0, frames);
+
+    QAtomicInt flag(1);
+    QVERIFY(matrix.findCandidates(RangeSignalSettings(), 16, &flag).isEmpty());
+    flag.storeRelease(0);
+    QVERIFY(!matrix.findCandidates(RangeSignalSettings(), 16, &flag).isEmpty());
+}
+
+/*
+ * The full search the range state window does with its default sort of settings (8 to 16 bits, every start bit,
+ * both byte orders and signedness) against the same thing done the old way, processIntegerSignal per frame per candidate.
+*/
+void TestRangeSignalMatrix::benchmark()
+{
+    const int numFrames = 100000;
+    QVector<CANFrame> frames = pMakeCapture(numFrames);
+
+    RangeSignalSettings settings;
+    settings.minSize = 8;
+    settings.maxSize = 16;
+    settings.granularity = 1;
+
+    QElapsedTimer timer;
+    timer.start();
+    RangeSignalMatrix matrix;
+    matrix.build(0x3A0, frames);
+    int found = 0;
+    bool foundRamp = false, foundSine = false;
+    for (int sigSize = settings.maxSize; sigSize >= settings.minSize; sigSize--)
+    {
+        QVector<RangeSignalCandidate> candidates = matrix.findCandidates(settings, sigSize);
+        found += candidates.count();
+        for (const RangeSignalCandidate &c : candidates)
+        {
+            if (c.bitLength == 16 && c.startBit == 8 && !c.bigEndian && !c.isSigned) foundRamp = true;
+            if (c.bitLength == 12 && c.startBit == 39 && c.bigEndian && !c.isSigned) foundSine = true;
+        }
+    }
+    qint64 fastMS = timer.elapsed();
+    QVERIFY(foundRamp);
+    QVERIFY(foundSine);
+
+    //the old way gets a slice of the same work and is scaled up so this doesn't take minutes
+    timer.restart();
+    QVector<uint64_t> raw(numFrames);
+    int sigSize = 16;
+    for (int startBit = 0; startBit < 64; startBit += 8)
+    {
+        for (int i = 0; i < numFrames; i++)
+        {
+            raw[i] = static_cast<uint64_t>(Utility::processIntegerSignal(frames[i].payload(), startBit, sigSize, true, false));
+        }
+        RangeSignalMatrix::evaluate(raw.constData(), numFrames, sigSize, false, settings.sensitivity, nullptr);
+    }
+    qint64 oldMS = timer.elapsed();
+    //full search is 9 sizes * 64 start bits * 2 byte orders * 2 signed modes, the slice above was 8 of those
+    qint64 oldEstimate = oldMS * (9 * 64 * 2 * 2) / 8;
+
+    qInfo() << "range signal search over" << numFrames << "frames:" << fastMS << "ms for" << found << "candidates."
+            << "Bit by bit extraction would take about" << oldEstimate << "ms";
+}
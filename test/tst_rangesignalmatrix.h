@@ -0,0 +1,21 @@
+#ifndef TST_RANGESIGNALMATRIX_H
+#define TST_RANGESIGNALMATRIX_H
+
+#include <QObject>
+
+#include "can_structs.h"
+
+class TestRangeSignalMatrix: public QObject
+{
+    Q_OBJECT
+private:
+    QVector<CANFrame> pMakeCapture(int pNumFrames);
+
+private slots:
+    void matchesProcessIntegerSignal();
+    void plantedSignals();
+    void cancel();
+    void benchmark();
+};
+
+#endif // TST_RANGESIGNALMATRIX_H
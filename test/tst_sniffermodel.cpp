@@ -0,0 +1,140 @@
+#include <QtTest>
+#include <QSignalSpy>
+
+#include "re/sniffer/sniffermodel.h"
+#include "tst_sniffermodel.h"
+
+
+CANFrame TestSnifferModel::pMakeFrame(quint32 pID, int pLen, int pValue)
+{
+    CANFrame frame;
+    frame.setFrameId(pID);
+    frame.setExtendedFrameFormat(pID > 0x7FF);
+    frame.bus = 0;
+    frame.setPayload(QByteArray(pLen, static_cast<char>(pValue)));
+    return frame;
+}
+
+//standard and extended IDs in any order come out as one sorted list, each ID once
+void TestSnifferModel::rowsSortedByID()
+{
+    SnifferModel model;
+    QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy ids(&model, &SnifferModel::idChange);
+
+    QVector<CANFrame> frames;
+    quint32 order[] = {0x300, 0x18FEF100, 0x100, 0x7FF, 0x800, 0x200, 0x100, 0x18FEF100};
+    for (quint32 id : order) frames.append(pMakeFrame(id, 8, 1));
+    model.update(nullptr, frames);
+
+    QCOMPARE(model.rowCount(), 6);
+    QCOMPARE(inserted.count(), 6);
+    QCOMPARE(ids.count(), 6);
+    quint32 expected[] = {0x100, 0x200, 0x300, 0x7FF, 0x800, 0x18FEF100};
+    for (int i = 0; i < 6; i++)
+    {
+        const SnifferItem *item = model.item(model.index(i, tc::ID));
+        QVERIFY(item);
+        QCOMPARE(static_cast<quint32>(item->getId()), expected[i]);
+    }
+    QCOMPARE(model.data(model.index(5, tc::ID), Qt::DisplayRole).toString(), QString("0x18FEF100"));
+
+    //frequency comes from the capture's statistics when they have a rate for the ID
+    QHash<quint32, double> rates;
+    rates.insert(0x100, 99.6);
+    model.setRates(rates);
+    QCOMPARE(model.data(model.index(0, tc::FREQUENCY), Qt::DisplayRole).toString(), QString("100 hz"));
+
+    model.clear();
+    QCOMPARE(model.rowCount(), 0);
+    model.update(nullptr, frames);
+    QCOMPARE(model.rowCount(), 6);
+}
+
+void TestSnifferModel::filtering()
+{
+    SnifferModel model;
+    QVector<CANFrame> frames;
+    for (quint32 id = 0x100; id < 0x105; id++) frames.append(pMakeFrame(id, 8, 1));
+    model.update(nullptr, frames);
+
+    //unticking one ID out of all of them leaves the rest
+    model.filter(fltType::REMOVE, 0x102);
+    QCOMPARE(model.rowCount(), 4);
+    QCOMPARE(static_cast<quint32>(model.item(model.index(2, 0))->getId()), 0x103u);
+
+    model.filter(fltType::NONE);
+    QCOMPARE(model.rowCount(), 0);
+    model.filter(fltType::ADD, 0x104);
+    model.filter(fltType::ADD, 0x101);
+    QCOMPARE(model.rowCount(), 2);
+    QCOMPARE(static_cast<quint32>(model.item(model.index(0, 0))->getId()), 0x101u);
+
+    //new IDs that are filtered out don't show up but are there once filtering stops
+    QVector<CANFrame> more;
+    more.append(pMakeFrame(0x050, 8, 1));
+    model.update(nullptr, more);
+    QCOMPARE(model.rowCount(), 2);
+    model.filter(fltType::ALL);
+    QCOMPARE(model.rowCount(), 6);
+}
+
+//a 64 byte frame grows the data columns, once, and they stay until the model is cleared
+void TestSnifferModel::fdColumns()
+{
+    SnifferModel model;
+    QSignalSpy columns(&model, &QAbstractItemModel::columnsInserted);
+    QCOMPARE(model.columnCount(), static_cast<int>(tc::LAST) + 1);
+
+    QVector<CANFrame> frames;
+    frames.append(pMakeFrame(0x100, 8, 1));
+    frames.append(pMakeFrame(0x101, 64, 0xAB));
+    frames.append(pMakeFrame(0x102, 12, 2));
+    model.update(nullptr, frames);
+
+    QCOMPARE(columns.count(), 1);
+    QCOMPARE(model.dataColumns(), 64);
+    QCOMPARE(model.columnCount(), tc::DATA_0 + 64 + 1);
+    QCOMPARE(model.headerData(tc::DATA_0 + 63, Qt::Horizontal).toString(), QString("63"));
+    QCOMPARE(model.data(model.index(1, tc::DATA_0 + 63), Qt::DisplayRole).toString(), QString("AB"));
+    QVERIFY(!model.data(model.index(0, tc::DATA_0 + 8), Qt::DisplayRole).isValid());
+
+    model.clear();
+    QCOMPARE(model.dataColumns(), 8);
+}
+
+//frames only mark rows, refresh() tells the view about runs of them and nothing about rows that sat still
+void TestSnifferModel::batchedRepaint()
+{
+    SnifferModel model;
+    QVector<CANFrame> frames;
+    for (quint32 id = 0x100; id < 0x110; id++) frames.append(pMakeFrame(id, 8, 1));
+    model.update(nullptr, frames);
+
+    QSignalSpy changed(&model, &QAbstractItemModel::dataChanged);
+    model.refresh();
+    QCOMPARE(changed.count(), 1);   //every row is new, one run
+    model.refresh();
+    QCOMPARE(changed.count(), 1);   //nothing happened since
+
+    QVector<CANFrame> some;
+    for (int i = 0; i < 100; i++)
+    {
+        some.append(pMakeFrame(0x101, 8, i));
+        some.append(pMakeFrame(0x102, 8, i));
+        some.append(pMakeFrame(0x108, 8, i));
+    }
+    model.update(nullptr, some);
+    QCOMPARE(changed.count(), 1);
+    model.refresh();
+    QCOMPARE(changed.count(), 3);
+    QCOMPARE(changed[1].at(0).value<QModelIndex>().row(), 1);
+    QCOMPARE(changed[1].at(1).value<QModelIndex>().row(), 2);
+    QCOMPARE(changed[2].at(0).value<QModelIndex>().row(), 8);
+    QCOMPARE(changed[2].at(1).value<QModelIndex>().row(), 8);
+    QCOMPARE(changed[2].at(1).value<QModelIndex>().column(), model.columnCount() - 1);
+
+    //bytes that just changed are flagged which way they went
+    QCOMPARE(model.item(model.index(1, 0))->getData(0), 99);
+    QCOMPARE(model.item(model.index(1, 0))->getLastData(0), static_cast<quint8>(98));
+}
@@ -0,0 +1,21 @@
+#ifndef TST_SNIFFERMODEL_H
+#define TST_SNIFFERMODEL_H
+
+#include <QObject>
+#include "can_structs.h"
+
+class TestSnifferModel: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rowsSortedByID();
+    void filtering();
+    void fdColumns();
+    void batchedRepaint();
+
+private:
+    CANFrame pMakeFrame(quint32 pID, int pLen, int pValue);
+};
+
+#endif // TST_SNIFFERMODEL_H
@@ -0,0 +1,100 @@
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include "re/temporaldensity.h"
+#include "tst_temporaldensity.h"
+
+
+//IDs spaced 8 apart from 0x100 up, frames in time order pMaxGap microseconds apart at most
+QVector<CANFrame> TestTemporalDensity::pMakeCapture(int pNumFrames, int pNumIDs, int64_t pMaxGap, quint32 pSeed)
+{
+    QRandomGenerator rng(pSeed);
+    QVector<CANFrame> frames;
+    frames.reserve(pNumFrames);
+    int64_t time = 5000000;
+    for (int i = 0; i < pNumFrames; i++)
+    {
+        time += rng.bounded(static_cast<int>(pMaxGap));
+        CANFrame frame;
+        frame.setFrameId(0x100 + rng.bounded(pNumIDs) * 8);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, time));
+        frames.append(frame);
+    }
+    return frames;
+}
+
+//counting everything at once and a batch at a time have to agree on what's where
+void TestTemporalDensity::buildMatchesAppend()
+{
+    QVector<CANFrame> frames = pMakeCapture(300000, 40, 200, 1);
+    TemporalDensity built;
+    built.build(frames);
+    TemporalDensity appended;
+    for (int start = 0; start < frames.count(); start += 7777) appended.addFrames(frames, start, qMin(start + 7777, frames.count()));
+
+    QCOMPARE(built.frameCount(), static_cast<uint64_t>(frames.count()));
+    QCOMPARE(appended.frameCount(), built.frameCount());
+    QCOMPARE(appended.firstTime(), built.firstTime());
+    QCOMPARE(appended.lastTime(), built.lastTime());
+    QCOMPARE(appended.lowestID(), static_cast<uint32_t>(0x100));
+    QCOMPARE(appended.highestID(), built.highestID());
+
+    //every level of both holds every frame
+    for (int maxColumns : {100000, 1000, 100, 1})
+    {
+        TemporalDensityView whole = built.query(0.0, 1.0e9, 0.0, 4096.0, maxColumns, 64);
+        QCOMPARE(whole.frames, built.frameCount());
+        QVERIFY(whole.columns <= qMax(maxColumns, TEMPORAL_DENSITY_MIN_COLUMNS));
+        QCOMPARE(appended.query(0.0, 1.0e9, 0.0, 4096.0, maxColumns, 64).frames, built.frameCount());
+    }
+}
+
+void TestTemporalDensity::queryCounts()
+{
+    QVector<CANFrame> frames = pMakeCapture(200000, 40, 200, 2);
+    TemporalDensity density;
+    density.build(frames);
+
+    TemporalDensityView view = density.query(5.5, 6.0, 0x100, 0x120, 500, 100);
+    QVERIFY(view.columns > 0 && view.columns <= 500);
+    QCOMPARE(view.bands, 33);
+
+    //the columns start and end on bucket edges so count what's between those
+    int64_t start = qRound64(view.startTime * 1000000.0);
+    int64_t end = qRound64((view.startTime + view.columns * view.columnWidth) * 1000000.0);
+    uint64_t expected = 0;
+    for (const CANFrame &frame : frames)
+    {
+        int64_t t = frame.timeStamp().microSeconds();
+        if (t >= start && t < end && frame.frameId() >= 0x100 && frame.frameId() <= 0x120) expected++;
+    }
+    QCOMPARE(view.frames, expected);
+
+    double total = 0;
+    for (double c : view.counts) total += c;
+    QCOMPARE(static_cast<uint64_t>(total), expected);
+
+    //nothing there before the capture started
+    QCOMPARE(density.query(0.0, 1.0, 0, 0x1000, 100, 100).frames, static_cast<uint64_t>(0));
+}
+
+//lots of IDs and a long capture added a bit at a time can't run away with memory
+void TestTemporalDensity::staysBounded()
+{
+    TemporalDensity density;
+    QVector<CANFrame> frames;
+    for (int i = 0; i < 20000; i++)
+    {
+        CANFrame frame;
+        frame.setFrameId(i);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp(0, static_cast<int64_t>(i) * 360000)); //two hours
+        frames.append(frame);
+    }
+    for (int start = 0; start < frames.count(); start += 500) density.addFrames(frames, start, start + 500);
+
+    QCOMPARE(density.frameCount(), static_cast<uint64_t>(20000));
+    QVERIFY(static_cast<int64_t>(density.columnsAt(0)) * 20000 <= TEMPORAL_DENSITY_MAX_CELLS);
+    QVERIFY(density.columnsAt(0) >= TEMPORAL_DENSITY_MIN_COLUMNS);
+    QVERIFY(density.bucketWidthAt(0) * density.columnsAt(0) > density.lastTime() - density.firstTime());
+    QCOMPARE(density.query(0.0, 1.0e9, 0.0, 20000.0, 1000, 1000).frames, static_cast<uint64_t>(20000));
+}
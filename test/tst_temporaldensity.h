@@ -0,0 +1,20 @@
+#ifndef TST_TEMPORALDENSITY_H
+#define TST_TEMPORALDENSITY_H
+
+#include <QObject>
+
+#include "can_structs.h"
+
+class TestTemporalDensity: public QObject
+{
+    Q_OBJECT
+private:
+    QVector<CANFrame> pMakeCapture(int pNumFrames, int pNumIDs, int64_t pMaxGap, quint32 pSeed);
+
+private slots:
+    void buildMatchesAppend();
+    void queryCounts();
+    void staysBounded();
+};
+
+#endif // TST_TEMPORALDENSITY_H
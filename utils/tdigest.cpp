@@ -0,0 +1,179 @@
+#include "tdigest.h"
+
+#include <algorithm>
+
+TDigest::TDigest(double compression)
+{
+    this->compression = compression;
+    bufferLimit = static_cast<int>(compression) * 4;
+    weight = 0.0;
+    minVal = 0.0;
+    maxVal = 0.0;
+}
+
+void TDigest::clear()
+{
+    centroids.clear();
+    buffer.clear();
+    weight = 0.0;
+    minVal = 0.0;
+    maxVal = 0.0;
+}
+
+void TDigest::add(double value, double w)
+{
+    if (w <= 0.0) return;
+    if (weight == 0.0)
+    {
+        minVal = value;
+        maxVal = value;
+    }
+    else
+    {
+        if (value < minVal) minVal = value;
+        if (value > maxVal) maxVal = value;
+    }
+    weight += w;
+
+    Centroid c;
+    c.mean = value;
+    c.weight = w;
+    buffer.append(c);
+    if (buffer.count() >= bufferLimit) flush();
+}
+
+void TDigest::merge(const TDigest &other)
+{
+    if (other.weight == 0.0) return;
+    other.flush();
+    if (weight == 0.0)
+    {
+        minVal = other.minVal;
+        maxVal = other.maxVal;
+    }
+    else
+    {
+        minVal = qMin(minVal, other.minVal);
+        maxVal = qMax(maxVal, other.maxVal);
+    }
+    weight += other.weight;
+    buffer += other.centroids;
+    flush();
+}
+
+/*
+ * Sorts the buffer in with the existing centroids then walks them in order merging neighbours for as long as the
+ * merged centroid stays under the size limit for where it sits. The limit is 4 * n * q * (1 - q) / compression
+ * so centroids near the median get big and ones near either end stay at or close to single values.
+*/
+void TDigest::flush() const
+{
+    if (buffer.isEmpty()) return;
+
+    buffer += centroids;
+    std::sort(buffer.begin(), buffer.end());
+
+    double total = 0.0;
+    for (int i = 0; i < buffer.count(); i++) total += buffer[i].weight;
+
+    centroids.clear();
+    Centroid cur = buffer[0];
+    double soFar = 0.0;
+    for (int i = 1; i < buffer.count(); i++)
+    {
+        const Centroid &next = buffer[i];
+        double proposed = cur.weight + next.weight;
+        double q = (soFar + proposed / 2.0) / total;
+        double limit = 4.0 * total * q * (1.0 - q) / compression;
+        if (proposed <= limit)
+        {
+            cur.mean += (next.mean - cur.mean) * next.weight / proposed;
+            cur.weight = proposed;
+        }
+        else
+        {
+            soFar += cur.weight;
+            centroids.append(cur);
+            cur = next;
+        }
+    }
+    centroids.append(cur);
+    buffer.clear();
+}
+
+//q is 0 to 1. Interpolates between centroid centres and uses the true min and max at the ends
+double TDigest::quantile(double q) const
+{
+    if (weight == 0.0) return 0.0;
+    flush();
+    if (q <= 0.0) return minVal;
+    if (q >= 1.0) return maxVal;
+    if (centroids.count() == 1) return centroids[0].mean;
+
+    double target = q * weight;
+    double cumulative = 0.0;
+    double prevCentre = 0.0;
+    double prevMean = minVal;
+    for (int i = 0; i < centroids.count(); i++)
+    {
+        double centre = cumulative + centroids[i].weight / 2.0;
+        if (target < centre)
+        {
+            if (centre <= prevCentre) return centroids[i].mean;
+            double frac = (target - prevCentre) / (centre - prevCentre);
+            return prevMean + (centroids[i].mean - prevMean) * frac;
+        }
+        cumulative += centroids[i].weight;
+        prevCentre = centre;
+        prevMean = centroids[i].mean;
+    }
+
+    //past the centre of the last centroid
+    if (weight <= prevCentre) return maxVal;
+    double frac = (target - prevCentre) / (weight - prevCentre);
+    return prevMean + (maxVal - prevMean) * frac;
+}
+
+//fraction of the weight at or below value. The reverse of quantile, using the same interpolation
+double TDigest::cdf(double value) const
+{
+    if (weight == 0.0 || value < minVal) return 0.0;
+    if (value >= maxVal) return 1.0;
+    flush();
+
+    double cumulative = 0.0;
+    double prevCentre = 0.0;
+    double prevMean = minVal;
+    for (int i = 0; i < centroids.count(); i++)
+    {
+        double centre = cumulative + centroids[i].weight / 2.0;
+        if (value < centroids[i].mean)
+        {
+            if (centroids[i].mean <= prevMean) return prevCentre / weight;
+            double frac = (value - prevMean) / (centroids[i].mean - prevMean);
+            return (prevCentre + (centre - prevCentre) * frac) / weight;
+        }
+        cumulative += centroids[i].weight;
+        prevCentre = centre;
+        prevMean = centroids[i].mean;
+    }
+
+    if (maxVal <= prevMean) return 1.0;
+    double frac = (value - prevMean) / (maxVal - prevMean);
+    return (prevCentre + (weight - prevCentre) * frac) / weight;
+}
+
+double TDigest::totalWeight() const
+{
+    return weight;
+}
+
+double TDigest::minValue() const
+{
+    return minVal;
+}
+
+double TDigest::maxValue() const
+{
+    return maxVal;
+}
@@ -0,0 +1,46 @@
+#ifndef TDIGEST_H
+#define TDIGEST_H
+
+#include <QVector>
+
+/*
+ * Merging t-digest (Dunning). Keeps a small sorted list of weighted centroids that stays accurate at the ends
+ * of the distribution, which is where the interesting percentiles are. Values go into a buffer first and get folded
+ * into the centroids once it fills up so adding a value is nearly always just an append.
+ *
+ * Compression is roughly how many centroids to keep. 100 is plenty for percentiles of frame intervals.
+*/
+class TDigest
+{
+public:
+    explicit TDigest(double compression = 100.0);
+    void add(double value, double w = 1.0);
+    void merge(const TDigest &other);
+    void clear();
+    double quantile(double q) const;
+    double cdf(double value) const;
+    double totalWeight() const;
+    double minValue() const;
+    double maxValue() const;
+
+private:
+    struct Centroid
+    {
+        double mean;
+        double weight;
+        bool operator<(const Centroid &other) const { return mean < other.mean; }
+    };
+
+    void flush() const;
+
+    double compression;
+    int bufferLimit;
+    //folding the buffer in doesn't change what the digest represents so queries are allowed to do it
+    mutable QVector<Centroid> centroids;
+    mutable QVector<Centroid> buffer;
+    double weight;
+    double minVal;
+    double maxVal;
+};
+
+#endif // TDIGEST_H